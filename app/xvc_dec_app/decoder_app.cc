@@ -93,6 +93,8 @@ void DecoderApp::ReadArguments(int argc, const char *argv[]) {
       std::stringstream(argv[++i]) >> cli_.simd_mask;
     } else if (arg == "-dither") {
       std::stringstream(argv[++i]) >> cli_.dither;
+    } else if (arg == "-max-memory") {
+      std::stringstream(argv[++i]) >> cli_.max_memory_mb;
     } else if (arg == "-loop") {
       std::stringstream(argv[++i]) >> cli_.loop;
     } else if (arg == "-verbose") {
@@ -174,6 +176,10 @@ void DecoderApp::CreateAndConfigureApi() {
   if (cli_.dither != -1) {
     params_->dither = cli_.dither;
   }
+  if (cli_.max_memory_mb > 0) {
+    params_->max_memory_bytes =
+      static_cast<size_t>(cli_.max_memory_mb) * 1024 * 1024;
+  }
   if (xvc_api_->parameters_check(params_) != XVC_DEC_OK) {
     std::cerr << "Error. Invalid parameters. Please check the values of the"
       " command line parameters." << std::endl;
@@ -191,8 +197,28 @@ void DecoderApp::PrintDecoderSettings() {
   GetLog() << "Output:           " << cli_.output_filename << std::endl;
 }
 
+std::vector<uint8_t>* DecoderApp::GetFreeNalBuffer() {
+  if (free_nal_buffers_.empty()) {
+    nal_buffers_.emplace_back(new std::vector<uint8_t>());
+    return nal_buffers_.back().get();
+  }
+  std::vector<uint8_t> *nal_buffer = free_nal_buffers_.back();
+  free_nal_buffers_.pop_back();
+  return nal_buffer;
+}
+
+void DecoderApp::ReleaseNalBuffer(void *opaque, const uint8_t *nal_unit) {
+  DecoderApp *app = reinterpret_cast<DecoderApp*>(opaque);
+  for (auto &nal_buffer : app->nal_buffers_) {
+    if (nal_buffer->data() == nal_unit) {
+      app->free_nal_buffers_.push_back(nal_buffer.get());
+      return;
+    }
+  }
+  assert(0);
+}
+
 void DecoderApp::MainDecoderLoop() {
-  std::vector<uint8_t> nal_bytes_;
   xvc_decoded_picture decoded_pic;
   xvc_dec_return_code ret;
   num_pictures_decoded_ = 0;
@@ -225,15 +251,18 @@ void DecoderApp::MainDecoderLoop() {
     }
 
     // Read next Nal Unit from file.
-    nal_bytes_.resize(nal_size);
-    input_stream_.read(reinterpret_cast<char *>(&nal_bytes_[0]), nal_size);
+    std::vector<uint8_t> &nal_bytes = *GetFreeNalBuffer();
+    nal_bytes.resize(nal_size);
+    input_stream_.read(reinterpret_cast<char *>(&nal_bytes[0]), nal_size);
     if (static_cast<size_t>(input_stream_.gcount()) < nal_size) {
       std::cerr << "Unable to read nal." << std::endl;
       std::exit(1);
     }
 
-    // Decode next Nal Unit.
-    ret = xvc_api_->decoder_decode_nal(decoder_, &nal_bytes_[0], nal_size, 0);
+    // Decode next Nal Unit, the decoder keeps the buffer until released.
+    ret = xvc_api_->decoder_decode_nal_ref(decoder_, &nal_bytes[0], nal_size,
+                                           0, &DecoderApp::ReleaseNalBuffer,
+                                           this);
     if (ret == XVC_DEC_BITSTREAM_VERSION_LOWER_THAN_SUPPORTED_BY_DECODER) {
       std::cerr << xvc_api_->xvc_dec_get_error_text(ret) << std::endl;
       std::exit(XVC_DEC_BITSTREAM_VERSION_LOWER_THAN_SUPPORTED_BY_DECODER);
@@ -243,6 +272,8 @@ void DecoderApp::MainDecoderLoop() {
     } else if (ret == XVC_DEC_BITSTREAM_BITDEPTH_TOO_HIGH) {
       std::cerr << xvc_api_->xvc_dec_get_error_text(ret) << std::endl;
       std::exit(XVC_DEC_BITSTREAM_BITDEPTH_TOO_HIGH);
+    } else if (ret == XVC_DEC_TAIL_PICTURES_LOST_AT_BITDEPTH_SWITCH) {
+      std::cerr << xvc_api_->xvc_dec_get_error_text(ret) << std::endl;
     }
 
     // Check if there is a decoded picture ready to be output.
@@ -352,6 +383,8 @@ void DecoderApp::PrintUsage() {
   GetLog() << "  -max-framerate <int>" << std::endl;
   GetLog() << "  -threads <int> default is -1 (auto-detect)" << std::endl;
   GetLog() << "  -dither <0..1>" << std::endl;
+  GetLog() << "  -max-memory <int> in MiB, default is 0 (no limit)"
+    << std::endl;
   GetLog() << "  -loop <int>" << std::endl;
   GetLog() << "  -verbose <0..1>" << std::endl;
 }
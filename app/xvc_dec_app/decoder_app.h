@@ -27,7 +27,9 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "xvc_dec_lib/xvcdec.h"
 
@@ -49,6 +51,8 @@ public:
 private:
   void PrintUsage();
   size_t ReadNextNalSize(std::istream *input);
+  std::vector<uint8_t>* GetFreeNalBuffer();
+  static void ReleaseNalBuffer(void *opaque, const uint8_t *nal_unit);
   void PrintPictureInfo(xvc_dec_pic_stats pic_stats);
   std::ostream& GetLog() {
     return !log_to_stderr_ ? std::cout : std::cerr;
@@ -63,6 +67,10 @@ private:
   int num_pictures_decoded_ = 0;
   int segment_info_printed_ = 0;
   bool all_pictures_baseline_ = true;
+  // Nal units are read into these buffers and held by the decoder until
+  // released, buffers are then reused for later nal units
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> nal_buffers_;
+  std::vector<std::vector<uint8_t>*> free_nal_buffers_;
 
   // command line arguments
   struct {
@@ -78,6 +86,7 @@ private:
     int threads = -1;
     int simd_mask = -1;
     int dither = -1;
+    int max_memory_mb = -1;
     int loop = -1;
     int verbose = 0;
   } cli_;
@@ -27,7 +27,6 @@
 #endif
 
 #include <algorithm>
-#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
@@ -135,6 +134,16 @@ void EncoderApp::ReadArguments(int argc, const char *argv[]) {
       std::stringstream(argv[++i]) >> cli_.flat_lambda;
     } else if (arg == "-multi-passes") {
       std::stringstream(argv[++i]) >> cli_.multipass_rd;
+    } else if (arg == "-lookahead") {
+      std::stringstream(argv[++i]) >> cli_.lookahead;
+    } else if (arg == "-lookahead-depth") {
+      std::stringstream(argv[++i]) >> cli_.lookahead_depth;
+    } else if (arg == "-bitrate") {
+      std::stringstream(argv[++i]) >> cli_.target_bitrate;
+    } else if (arg == "-max-bitrate") {
+      std::stringstream(argv[++i]) >> cli_.max_bitrate;
+    } else if (arg == "-vbv-size") {
+      std::stringstream(argv[++i]) >> cli_.vbv_buffer_size;
     } else if (arg == "-speed-mode") {
       std::stringstream(argv[++i]) >> cli_.speed_mode;
     } else if (arg == "-tune") {
@@ -147,6 +156,8 @@ void EncoderApp::ReadArguments(int argc, const char *argv[]) {
       std::stringstream(argv[++i]) >> cli_.simd_mask;
     } else if (arg == "-explicit-encoder-settings") {
       cli_.explicit_encoder_settings = argv[++i];
+    } else if (arg == "-cu-split-stats-file") {
+      cli_.cu_split_stats_file = argv[++i];
     } else if (arg == "-verbose") {
       std::stringstream(argv[++i]) >> cli_.verbose;
     } else {
@@ -255,6 +266,15 @@ void EncoderApp::CheckParameters() {
     }
   }
 
+  if (!cli_.cu_split_stats_file.empty()) {
+    cu_split_stats_stream_.open(cli_.cu_split_stats_file);
+    if (!cu_split_stats_stream_) {
+      std::cerr << "Failed to open cu split statistics file for writing: "
+        << cli_.cu_split_stats_file << std::endl;
+      std::exit(1);
+    }
+  }
+
   if ((cli_.sub_gop_length > 0 && cli_.max_keypic_distance > 0)
       && (cli_.sub_gop_length > cli_.max_keypic_distance)) {
     std::cerr << "Error: Sub Gop length cannot be greater than Max"
@@ -269,9 +289,9 @@ void EncoderApp::CheckParameters() {
     std::exit(1);
   }
 
-  if (cli_.multipass_rd > 0 && !input_seekable_) {
-    std::cerr << "Warning: Disabling multi-pass and lookahead on "
-      "non-seekable input-streams" << std::endl;
+  if (cli_.multipass_rd > 1 && !input_seekable_) {
+    std::cerr << "Warning: Disabling multi-pass on non-seekable input-streams"
+      << std::endl;
     cli_.multipass_rd = 0;
   }
 
@@ -352,6 +372,30 @@ EncoderApp::ConfigureApiParams(xvc_encoder_parameters *params) {
   if (cli_.flat_lambda >= 0) {
     params->flat_lambda = cli_.flat_lambda;
   }
+  if (cli_.lookahead != -1) {
+    params->lookahead = cli_.lookahead;
+  }
+  if (cli_.lookahead_depth != -1) {
+    params->lookahead_depth = cli_.lookahead_depth;
+  }
+  if (cli_.multipass_rd == 1) {
+    // Start picture determined from the lookahead of the first sub-gop
+    const int sub_gop_length = params->sub_gop_length > 0 ?
+      static_cast<int>(params->sub_gop_length) : kDefaultSubGopSize;
+    params->leading_pictures = -1;
+    params->lookahead = 1;
+    params->lookahead_depth =
+      std::max(params->lookahead_depth, sub_gop_length - 1);
+  }
+  if (cli_.target_bitrate != -1) {
+    params->target_bitrate = cli_.target_bitrate;
+  }
+  if (cli_.max_bitrate != -1) {
+    params->max_bitrate = cli_.max_bitrate;
+  }
+  if (cli_.vbv_buffer_size != -1) {
+    params->vbv_buffer_size = cli_.vbv_buffer_size;
+  }
   if (cli_.speed_mode != -1) {
     params->speed_mode = cli_.speed_mode;
   }
@@ -402,17 +446,26 @@ void EncoderApp::MainEncoderLoop() {
   picture_bytes_.resize(params_->input_bitdepth == 8 ?
                         picture_samples : (picture_samples << 1));
 
-  if (cli_.multipass_rd == 1) {
-    StartPictureDetermination(params_);
-  } else if (cli_.multipass_rd > 1) {
+  if (cli_.multipass_rd > 1) {
     MultiPass(params_);
   }
+  if (cu_split_stats_stream_.is_open()) {
+    // Only collected for the final pass
+    cu_split_stats_stream_ << "intra_pic,log2_area,num_smaller_neighbors,"
+      "skip,cost_per_sample,variance,split_gain,full_cu_termination,"
+      "early_skip_termination\n";
+    params_->cu_split_stats = &EncoderApp::WriteCuSplitStats;
+    params_->cu_split_stats_opaque = &cu_split_stats_stream_;
+  }
   EncodeOnePass(params_, true);
 
   // Cleanup
   if (rec_stream_.is_open()) {
     rec_stream_.close();
   }
+  if (cu_split_stats_stream_.is_open()) {
+    cu_split_stats_stream_.close();
+  }
   file_output_stream_.close();
   file_input_stream_.close();
 }
@@ -590,76 +643,6 @@ void EncoderApp::PrintStatistics() {
   std::cout << std::endl;
 }
 
-void EncoderApp::StartPictureDetermination(xvc_encoder_parameters *out_params) {
-  static const double kPocRatio = 0.6875;
-  const auto param_delete = [this](xvc_encoder_parameters *p) {
-    xvc_api_->parameters_destroy(p);
-  };
-  const auto encoder_delete = [this](xvc_encoder *p) {
-    xvc_api_->encoder_destroy(p);
-  };
-  const std::streampos required_size = start_skip_ +
-    (picture_skip_ + picture_bytes_.size()) * kDefaultSubGopSize;
-  const int sub_gop_length = params_->sub_gop_length < 1 ?
-    kDefaultSubGopSize : params_->sub_gop_length;
-  const int middle_poc = static_cast<int>(kPocRatio * sub_gop_length + 0.5);
-  const std::array<std::array<int, 2>, 2> test_positions = { {
-    { 0, middle_poc },
-    { (sub_gop_length - 1), middle_poc }
-  } };
-  if (!input_seekable_ || sub_gop_length < 4 ||
-      input_file_size_ < required_size) {
-    std::cout << "Warning: Singlepass lookahead not attempted" << std::endl;
-    return;
-  }
-
-  std::unique_ptr<xvc_encoder_parameters, decltype(param_delete)>
-    lookahead_params(xvc_api_->parameters_create(), param_delete);
-  std::unique_ptr<xvc_encoder, decltype(encoder_delete)>
-    lookahead_encoder(nullptr, encoder_delete);
-  xvc_enc_return_code ret =
-    ConfigureApiParams(lookahead_params.get());
-  if (ret != XVC_ENC_OK) {
-    return;
-  }
-  lookahead_params->speed_mode = 2;
-  lookahead_params->sub_gop_length = 2;
-  std::array<size_t, 2> result = { 0, 0 };
-  const auto time_start = std::chrono::steady_clock::now();
-
-  for (int i = 0; i < static_cast<int>(test_positions.size()); i++) {
-    lookahead_encoder.reset(xvc_api_->encoder_create(lookahead_params.get()));
-    assert(lookahead_encoder);
-    xvc_enc_nal_unit *nal_units;
-    int num_nal_units;
-    for (int poc : test_positions[i]) {
-      std::streamoff seek_pos = start_skip_ +
-        (picture_skip_ + picture_bytes_.size()) * poc;
-      input_stream_->seekg(seek_pos, std::ifstream::beg);
-      if (!ReadNextPicture(&picture_bytes_)) {
-        input_stream_->seekg(0, std::ifstream::beg);
-        return;
-      }
-      ret =
-        xvc_api_->encoder_encode(lookahead_encoder.get(), &picture_bytes_[0],
-                                 &nal_units, &num_nal_units, nullptr);
-      assert(ret == XVC_ENC_OK);
-    }
-    ret = xvc_api_->encoder_flush(lookahead_encoder.get(), &nal_units,
-                                  &num_nal_units, nullptr);
-    assert(ret == XVC_ENC_OK || ret == XVC_ENC_NO_MORE_OUTPUT);
-    result[i] = nal_units[0].size;
-  }
-  const auto time_end = std::chrono::steady_clock::now();
-
-  out_params->leading_pictures = result[1] <= result[0];
-  std::cout << "Leading Picture:  " << out_params->leading_pictures << "\n";
-  std::cout << "Lookahead time:   "
-    << std::chrono::duration<float>(time_end - time_start).count() << " s"
-    << std::endl;
-  input_stream_->seekg(0, std::ifstream::beg);
-}
-
 void EncoderApp::MultiPass(xvc_encoder_parameters *out_params) {
   const auto param_delete = [this](xvc_encoder_parameters *p) {
     xvc_api_->parameters_destroy(p);
@@ -827,13 +810,24 @@ void EncoderApp::PrintUsage() {
   std::cout << "  -flat-lambda <0..1> (default: 0)" << std::endl;
   std::cout << "  -multi-passes <0..2>" << std::endl;
   std::cout << "      0: Single pass (default)" << std::endl;
-  std::cout << "      1: Single pass with start picture determination"
+  std::cout << "      1: Single pass with start picture determined by lookahead"
     << std::endl;
   std::cout << "      2: Multi-pass" << std::endl;
-  std::cout << "  -speed-mode <0..2>" << std::endl;
+  std::cout << "  -lookahead <0..1>" << std::endl;
+  std::cout << "      0: disabled (default)" << std::endl;
+  std::cout << "      1: scene cut detection and qp adaptation" << std::endl;
+  std::cout << "  -lookahead-depth <0..256> (default: 0)" << std::endl;
+  std::cout << "      number of pictures encoding is delayed by" << std::endl;
+  std::cout << "  -bitrate <kbit/s> (default: 0, constant qp)" << std::endl;
+  std::cout << "  -max-bitrate <kbit/s> (default: 0, unconstrained)"
+    << std::endl;
+  std::cout << "  -vbv-size <kbit> (default: max bitrate for one second)"
+    << std::endl;
+  std::cout << "  -speed-mode <0..3>" << std::endl;
   std::cout << "      0: Placebo" << std::endl;
   std::cout << "      1: Slow (default)" << std::endl;
   std::cout << "      2: Fast" << std::endl;
+  std::cout << "      3: Ultrafast" << std::endl;
   std::cout << "  -tune <0..1>" << std::endl;
   std::cout << "      0: Visual quality (default)" << std::endl;
   std::cout << "      1: PSNR" << std::endl;
@@ -851,9 +845,24 @@ void EncoderApp::PrintUsage() {
     << std::endl;
   std::cout << "      ParseExplicitSettings in encoder_settings.cc"
     << std::endl;
+  std::cout << "  -cu-split-stats-file <string>" << std::endl;
+  std::cout << "      Write features and outcome of the split evaluation of"
+    " each CU," << std::endl;
+  std::cout << "      all split termination heuristics are disabled"
+    << std::endl;
   std::cout << "  -verbose <0..1>" << std::endl;
 }
 
+void EncoderApp::WriteCuSplitStats(void *opaque,
+                                   const xvc_enc_cu_split_stats *stats) {
+  std::ofstream *stream = static_cast<std::ofstream*>(opaque);
+  *stream << stats->intra_pic << ',' << stats->log2_area << ','
+    << stats->num_smaller_neighbors << ',' << stats->skip << ','
+    << stats->cost_per_sample << ',' << stats->variance << ','
+    << stats->split_gain << ',' << stats->full_cu_termination << ','
+    << stats->early_skip_termination << '\n';
+}
+
 void EncoderApp::PrintNalInfo(xvc_enc_nal_unit nal_unit) {
   std::cout << "NUT:" << std::setw(6) << nal_unit.stats.nal_unit_type;
   if (nal_unit.stats.nal_unit_type < 16) {
@@ -49,18 +49,20 @@ private:
   xvc_enc_return_code ConfigureApiParams(xvc_encoder_parameters *params);
   std::pair<uint64_t, int> EncodeOnePass(xvc_encoder_parameters *params,
                                          bool last = false);
-  void StartPictureDetermination(xvc_encoder_parameters *out_params);
   void MultiPass(xvc_encoder_parameters *out_params);
   void ResetStreams();
   bool ReadNextPicture(std::vector<uint8_t> *picture_bytes);
   void PrintUsage();
   void PrintNalInfo(xvc_enc_nal_unit nal_unit);
+  static void WriteCuSplitStats(void *opaque,
+                                const xvc_enc_cu_split_stats *stats);
 
   std::istream *input_stream_ = nullptr;
   bool input_seekable_ = true;
   std::ifstream file_input_stream_;
   std::ofstream file_output_stream_;
   std::ofstream rec_stream_;
+  std::ofstream cu_split_stats_stream_;
   std::streamoff start_skip_;
   std::streamoff picture_skip_;
   std::streamsize input_file_size_;
@@ -104,12 +106,18 @@ private:
     int qp = -1;
     int flat_lambda = -1;
     int multipass_rd = 0;
+    int lookahead = -1;
+    int lookahead_depth = -1;
+    int target_bitrate = -1;
+    int max_bitrate = -1;
+    int vbv_buffer_size = -1;
     int speed_mode = -1;
     int tune_mode = -1;
     int threads = -1;
     int profile = -1;
     int simd_mask = -1;
     std::string explicit_encoder_settings;
+    std::string cu_split_stats_file;
     int verbose = 0;
   } cli_;
 
@@ -301,14 +301,14 @@ inline static void Init(int qp, int slice_type,
   }
 }
 
-template<typename ContextModel>
-CabacContexts<ContextModel>::CabacContexts()
-  : restrictions_(&Restrictions::Get()) {
+template<typename Ctx, typename R>
+CabacContexts<Ctx, R>::CabacContexts()
+  : restrictions_(&R::Get()) {
 }
 
-template<typename Ctx>
-void
-CabacContexts<Ctx>::ResetStates(const Qp &qp, PicturePredictionType pic_type) {
+template<typename Ctx, typename R>
+void CabacContexts<Ctx, R>::ResetStates(const Qp &qp,
+                                        PicturePredictionType pic_type) {
   int q = qp.GetQpRaw(YuvComponent::kY);
   if (restrictions_->disable_cabac_init_per_qp) {
     q = 32;
@@ -357,8 +357,8 @@ CabacContexts<Ctx>::ResetStates(const Qp &qp, PicturePredictionType pic_type) {
   Init(q, s, &transform_select_idx, kInitTransformSelectIdx);
 }
 
-template<typename Ctx>
-Ctx& CabacContexts<Ctx>::GetAffineCtx(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+Ctx& CabacContexts<Ctx, R>::GetAffineCtx(const CodingUnit &cu) {
   int offset = 0;
   const CodingUnit *tmp;
   if ((tmp = cu.GetCodingUnitLeft()) != nullptr && tmp->GetUseAffine()) {
@@ -370,8 +370,8 @@ Ctx& CabacContexts<Ctx>::GetAffineCtx(const CodingUnit &cu) {
   return affine_flag[offset];
 }
 
-template<typename Ctx>
-Ctx& CabacContexts<Ctx>::GetSkipFlagCtx(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+Ctx& CabacContexts<Ctx, R>::GetSkipFlagCtx(const CodingUnit &cu) {
   int offset = 0;
   if (!restrictions_->disable_cabac_skip_flag_ctx) {
     const CodingUnit *tmp;
@@ -385,8 +385,8 @@ Ctx& CabacContexts<Ctx>::GetSkipFlagCtx(const CodingUnit &cu) {
   return cu_skip_flag[offset];
 }
 
-template<typename Ctx>
-Ctx& CabacContexts<Ctx>::GetSplitBinaryCtx(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+Ctx& CabacContexts<Ctx, R>::GetSplitBinaryCtx(const CodingUnit &cu) {
   const CodingUnit *left = cu.GetCodingUnitLeft();
   const CodingUnit *above = cu.GetCodingUnitAbove();
   int depth = (cu.GetDepth() << 1) + cu.GetBinaryDepth();
@@ -402,9 +402,9 @@ Ctx& CabacContexts<Ctx>::GetSplitBinaryCtx(const CodingUnit &cu) {
   return cu_split_binary[offset];
 }
 
-template<typename Ctx>
-Ctx& CabacContexts<Ctx>::GetSplitFlagCtx(const CodingUnit &cu,
-                                         int pic_max_depth) {
+template<typename Ctx, typename R>
+Ctx& CabacContexts<Ctx, R>::GetSplitFlagCtx(const CodingUnit &cu,
+                                            int pic_max_depth) {
   int offset = 0;
   const CodingUnit *left = cu.GetCodingUnitLeft();
   const CodingUnit *above = cu.GetCodingUnitAbove();
@@ -442,8 +442,8 @@ Ctx& CabacContexts<Ctx>::GetSplitFlagCtx(const CodingUnit &cu,
   return cu_split_quad_flag[offset];
 }
 
-template<typename Ctx>
-Ctx& CabacContexts<Ctx>::GetIntraPredictorCtx(IntraMode intra_mode) {
+template<typename Ctx, typename R>
+Ctx& CabacContexts<Ctx, R>::GetIntraPredictorCtx(IntraMode intra_mode) {
   assert(!restrictions_->disable_ext2_intra_6_predictors);
   static const std::array<uint8_t, kNbrIntraModesExt> kModeToCtxMapExt = {
     1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
@@ -460,8 +460,8 @@ Ctx& CabacContexts<Ctx>::GetIntraPredictorCtx(IntraMode intra_mode) {
   return intra_pred_luma[kModeToCtxMapExt[intra_mode]];
 }
 
-template<typename Ctx>
-Ctx& CabacContexts<Ctx>::GetInterDirBiCtx(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+Ctx& CabacContexts<Ctx, R>::GetInterDirBiCtx(const CodingUnit &cu) {
   if (restrictions_->disable_cabac_inter_dir_ctx) {
     return inter_dir[0];
   }
@@ -475,8 +475,8 @@ Ctx& CabacContexts<Ctx>::GetInterDirBiCtx(const CodingUnit &cu) {
   return inter_dir[idx];
 }
 
-template<typename Ctx>
-Ctx& CabacContexts<Ctx>::GetInterFullpelMvCtx(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+Ctx& CabacContexts<Ctx, R>::GetInterFullpelMvCtx(const CodingUnit &cu) {
   int offset = 0;
   const CodingUnit *tmp;
   if ((tmp = cu.GetCodingUnitLeft()) != nullptr && tmp->GetFullpelMv()) {
@@ -488,16 +488,18 @@ Ctx& CabacContexts<Ctx>::GetInterFullpelMvCtx(const CodingUnit &cu) {
   return inter_fullpel_mv[offset];
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
+template<typename RS>
 Ctx&
-CabacContexts<Ctx>::GetSubblockCsbfCtx(YuvComponent comp,
-                                       const uint8_t *sublock_csbf,
-                                       int posx, int posy, int width,
-                                       int height, int *pattern_sig_ctx) {
+CabacContexts<Ctx, R>::GetSubblockCsbfCtx(const RS &restrictions,
+                                          YuvComponent comp,
+                                          const uint8_t *sublock_csbf,
+                                          int posx, int posy, int width,
+                                          int height, int *pattern_sig_ctx) {
   int below = false;
   int right = false;
   Ctx *ctx_base;
-  if (!restrictions_->disable_ext2_cabac_alt_residual_ctx) {
+  if (!restrictions.disable_ext2_cabac_alt_residual_ctx) {
     ctx_base = util::IsLuma(comp) ?
       &coeff_ext.csbf_luma[0] : &coeff_ext.csbf_chroma[0];
   } else {
@@ -510,28 +512,30 @@ CabacContexts<Ctx>::GetSubblockCsbfCtx(YuvComponent comp,
     below = sublock_csbf[(posy + 1) * width + posx] != 0;
   }
   *pattern_sig_ctx = right + (below << 1);
-  if (restrictions_->disable_cabac_subblock_csbf_ctx) {
+  if (restrictions.disable_cabac_subblock_csbf_ctx) {
     return ctx_base[0];
   }
   return ctx_base[right | below];
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
+template<typename RS>
 Ctx&
-CabacContexts<Ctx>::GetCoeffSigCtx(YuvComponent comp, int pattern_sig_ctx,
-                                   ScanOrder scan_order, int posx, int posy,
-                                   const Coeff *in_coeff,
-                                   ptrdiff_t in_coeff_stride,
-                                   int width_log2, int height_log2) {
+CabacContexts<Ctx, R>::GetCoeffSigCtx(const RS &restrictions,
+                                      YuvComponent comp, int pattern_sig_ctx,
+                                      ScanOrder scan_order, int posx, int posy,
+                                      const Coeff *in_coeff,
+                                      ptrdiff_t in_coeff_stride,
+                                      int width_log2, int height_log2) {
   static const uint8_t kCtxIndexMap[16] = {
     0, 1, 4, 5, 2, 3, 4, 5, 6, 6, 8, 8, 7, 7, 8, 8
   };
-  if (!restrictions_->disable_ext2_cabac_alt_residual_ctx) {
+  if (!restrictions.disable_ext2_cabac_alt_residual_ctx) {
     const int width = 1 << width_log2;
     const int height = 1 << height_log2;
     const int size = (width_log2 + height_log2) >> 1;
     const int posxy = posx + posy;
-    if (restrictions_->disable_cabac_coeff_sig_ctx) {
+    if (restrictions.disable_cabac_coeff_sig_ctx) {
       return coeff_ext.sig_luma[0];
     }
     in_coeff += posx + posy * in_coeff_stride;
@@ -561,7 +565,7 @@ CabacContexts<Ctx>::GetCoeffSigCtx(YuvComponent comp, int pattern_sig_ctx,
   } else {
     Ctx *ctx_base = util::IsLuma(comp) ?
       &coeff.sig_luma[0] : &coeff.sig_chroma[0];
-    if ((!posx && !posy) || restrictions_->disable_cabac_coeff_sig_ctx) {
+    if ((!posx && !posy) || restrictions.disable_cabac_coeff_sig_ctx) {
       return ctx_base[0];
     }
     if (width_log2 == 2 && height_log2 == 2) {
@@ -590,16 +594,19 @@ CabacContexts<Ctx>::GetCoeffSigCtx(YuvComponent comp, int pattern_sig_ctx,
   }
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
+template<typename RS>
 Ctx&
-CabacContexts<Ctx>::GetCoeffGreater1Ctx(YuvComponent comp, int ctx_set, int c1,
-                                        int posx, int posy, bool is_last_coeff,
-                                        const Coeff *in_coeff,
-                                        ptrdiff_t in_coeff_stride,
-                                        int width, int height) {
-  if (!restrictions_->disable_ext2_cabac_alt_residual_ctx) {
+CabacContexts<Ctx, R>::GetCoeffGreater1Ctx(const RS &restrictions,
+                                           YuvComponent comp, int ctx_set,
+                                           int c1, int posx, int posy,
+                                           bool is_last_coeff,
+                                           const Coeff *in_coeff,
+                                           ptrdiff_t in_coeff_stride,
+                                           int width, int height) {
+  if (!restrictions.disable_ext2_cabac_alt_residual_ctx) {
     const int posxy = posx + posy;
-    if (is_last_coeff || restrictions_->disable_cabac_coeff_greater1_ctx) {
+    if (is_last_coeff || restrictions.disable_cabac_coeff_greater1_ctx) {
       return util::IsLuma(comp) ?
         coeff_ext.greater1_luma[0] : coeff_ext.greater1_chroma[0];
     }
@@ -626,7 +633,7 @@ CabacContexts<Ctx>::GetCoeffGreater1Ctx(YuvComponent comp, int ctx_set, int c1,
     return util::IsLuma(comp) ? coeff_ext.greater1_luma[start_offset + offset] :
       coeff_ext.greater1_chroma[start_offset + offset];
   } else {
-    if (restrictions_->disable_cabac_coeff_greater1_ctx) {
+    if (restrictions.disable_cabac_coeff_greater1_ctx) {
       return util::IsLuma(comp) ?
         coeff.greater1_luma[0] : coeff.greater1_chroma[0];
     }
@@ -636,16 +643,19 @@ CabacContexts<Ctx>::GetCoeffGreater1Ctx(YuvComponent comp, int ctx_set, int c1,
   }
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
+template<typename RS>
 Ctx&
-CabacContexts<Ctx>::GetCoeffGreater2Ctx(YuvComponent comp, int ctx_set,
-                                        int posx, int posy, bool is_last_coeff,
-                                        const Coeff *in_coeff,
-                                        ptrdiff_t in_coeff_stride,
-                                        int width, int height) {
-  if (!restrictions_->disable_ext2_cabac_alt_residual_ctx) {
+CabacContexts<Ctx, R>::GetCoeffGreater2Ctx(const RS &restrictions,
+                                           YuvComponent comp, int ctx_set,
+                                           int posx, int posy,
+                                           bool is_last_coeff,
+                                           const Coeff *in_coeff,
+                                           ptrdiff_t in_coeff_stride,
+                                           int width, int height) {
+  if (!restrictions.disable_ext2_cabac_alt_residual_ctx) {
     const int posxy = posx + posy;
-    if (is_last_coeff || restrictions_->disable_cabac_coeff_greater2_ctx) {
+    if (is_last_coeff || restrictions.disable_cabac_coeff_greater2_ctx) {
       return util::IsLuma(comp) ?
         coeff_ext.greater1_luma[0] : coeff_ext.greater1_chroma[0];
     }
@@ -673,7 +683,7 @@ CabacContexts<Ctx>::GetCoeffGreater2Ctx(YuvComponent comp, int ctx_set,
       coeff_ext.greater1_chroma[start_offset + offset];
   } else {
     static_assert(1 == constants::kMaxNumC2Flags, "Assumes only 1 c2 flag");
-    if (restrictions_->disable_cabac_coeff_greater2_ctx) {
+    if (restrictions.disable_cabac_coeff_greater2_ctx) {
       return util::IsLuma(comp) ?
         coeff_ext.greater1_luma[0] : coeff_ext.greater1_chroma[0];
     }
@@ -682,13 +692,15 @@ CabacContexts<Ctx>::GetCoeffGreater2Ctx(YuvComponent comp, int ctx_set,
   }
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
+template<typename RS>
 uint32_t
-CabacContexts<Ctx>::GetCoeffGolombRiceK(int posx, int posy,
-                                        int width, int height,
-                                        const Coeff *in_coeff,
-                                        ptrdiff_t in_coeff_stride) {
-  assert(!restrictions_->disable_ext2_cabac_alt_residual_ctx);
+CabacContexts<Ctx, R>::GetCoeffGolombRiceK(const RS &restrictions,
+                                           int posx, int posy,
+                                           int width, int height,
+                                           const Coeff *in_coeff,
+                                           ptrdiff_t in_coeff_stride) {
+  assert(!restrictions.disable_ext2_cabac_alt_residual_ctx);
   in_coeff += posx + posy * in_coeff_stride;
   int offset = 0;
   int num = 0;
@@ -723,19 +735,22 @@ CabacContexts<Ctx>::GetCoeffGolombRiceK(int posx, int posy,
   return static_cast<uint32_t>(TransformHelper::kGolombRiceRangeExt.size() - 1);
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
+template<typename RS>
 Ctx&
-CabacContexts<Ctx>::GetCoeffLastPosCtx(YuvComponent comp, int width, int height,
-                                       int pos, bool is_pos_x) {
+CabacContexts<Ctx, R>::GetCoeffLastPosCtx(const RS &restrictions,
+                                          YuvComponent comp, int width,
+                                          int height, int pos,
+                                          bool is_pos_x) {
   const int size = is_pos_x ? width : height;
   if (util::IsLuma(comp)) {
     auto &ctx_base = is_pos_x ? coeff_last_pos_x_luma : coeff_last_pos_y_luma;
-    if (restrictions_->disable_cabac_coeff_last_pos_ctx &&
-        restrictions_->disable_ext_cabac_alt_last_pos_ctx) {
+    if (restrictions.disable_cabac_coeff_last_pos_ctx &&
+        restrictions.disable_ext_cabac_alt_last_pos_ctx) {
       return ctx_base[0];
     }
     int offset, shift;
-    if (!restrictions_->disable_ext_cabac_alt_last_pos_ctx) {
+    if (!restrictions.disable_ext_cabac_alt_last_pos_ctx) {
       static const std::array<uint8_t, 8> kOffsetMappingExt = {
         0, 0, 0, 3, 6, 10, 15, 21   // 1, 2, 4, 8, 16, 32, 64, 128
       };
@@ -751,13 +766,13 @@ CabacContexts<Ctx>::GetCoeffLastPosCtx(YuvComponent comp, int width, int height,
   } else {
     auto &ctx_base =
       is_pos_x ? coeff_last_pos_x_chroma : coeff_last_pos_y_chroma;
-    if (restrictions_->disable_cabac_coeff_last_pos_ctx &&
-        restrictions_->disable_ext_cabac_alt_last_pos_ctx) {
+    if (restrictions.disable_cabac_coeff_last_pos_ctx &&
+        restrictions.disable_ext_cabac_alt_last_pos_ctx) {
       return ctx_base[0];
     }
     int offset = 0;
     int shift;
-    if (!restrictions_->disable_ext_cabac_alt_last_pos_ctx) {
+    if (!restrictions.disable_ext_cabac_alt_last_pos_ctx) {
       shift = util::Clip3(size >> 3, 0, 2);
     } else {
       shift = util::SizeLog2Bits(size);
@@ -766,8 +781,122 @@ CabacContexts<Ctx>::GetCoeffLastPosCtx(YuvComponent comp, int width, int height,
   }
 }
 
+template<typename Ctx, typename R>
+Ctx&
+CabacContexts<Ctx, R>::GetSubblockCsbfCtx(YuvComponent comp,
+                                          const uint8_t *sublock_csbf,
+                                          int posx, int posy, int width,
+                                          int height, int *pattern_sig_ctx) {
+  return GetSubblockCsbfCtx(*restrictions_, comp, sublock_csbf, posx, posy,
+                            width, height, pattern_sig_ctx);
+}
+
+template<typename Ctx, typename R>
+Ctx&
+CabacContexts<Ctx, R>::GetCoeffSigCtx(YuvComponent comp, int pattern_sig_ctx,
+                                      ScanOrder scan_order, int posx, int posy,
+                                      const Coeff *in_coeff,
+                                      ptrdiff_t in_coeff_stride,
+                                      int width_log2, int height_log2) {
+  return GetCoeffSigCtx(*restrictions_, comp, pattern_sig_ctx, scan_order,
+                        posx, posy, in_coeff, in_coeff_stride, width_log2,
+                        height_log2);
+}
+
+template<typename Ctx, typename R>
+Ctx&
+CabacContexts<Ctx, R>::GetCoeffGreater1Ctx(YuvComponent comp, int ctx_set,
+                                           int c1, int posx, int posy,
+                                           bool is_last_coeff,
+                                           const Coeff *in_coeff,
+                                           ptrdiff_t in_coeff_stride,
+                                           int width, int height) {
+  return GetCoeffGreater1Ctx(*restrictions_, comp, ctx_set, c1, posx, posy,
+                             is_last_coeff, in_coeff, in_coeff_stride, width,
+                             height);
+}
+
+template<typename Ctx, typename R>
+Ctx&
+CabacContexts<Ctx, R>::GetCoeffGreater2Ctx(YuvComponent comp, int ctx_set,
+                                           int posx, int posy,
+                                           bool is_last_coeff,
+                                           const Coeff *in_coeff,
+                                           ptrdiff_t in_coeff_stride,
+                                           int width, int height) {
+  return GetCoeffGreater2Ctx(*restrictions_, comp, ctx_set, posx, posy,
+                             is_last_coeff, in_coeff, in_coeff_stride, width,
+                             height);
+}
+
+template<typename Ctx, typename R>
+uint32_t
+CabacContexts<Ctx, R>::GetCoeffGolombRiceK(int posx, int posy,
+                                           int width, int height,
+                                           const Coeff *in_coeff,
+                                           ptrdiff_t in_coeff_stride) {
+  return GetCoeffGolombRiceK(*restrictions_, posx, posy, width, height,
+                             in_coeff, in_coeff_stride);
+}
+
+template<typename Ctx, typename R>
+Ctx&
+CabacContexts<Ctx, R>::GetCoeffLastPosCtx(YuvComponent comp, int width,
+                                          int height, int pos,
+                                          bool is_pos_x) {
+  return GetCoeffLastPosCtx(*restrictions_, comp, width, height, pos, is_pos_x);
+}
+
 template struct CabacContexts<ContextModel>;
 template struct CabacContexts<ContextModelDynamic>;
 template struct CabacContexts<ContextModelStatic>;
+template struct CabacContexts<ContextModelDynamic, NoRestrictions>;
+
+// Used by the encoder syntax writer, resolved per segment restrictions
+template ContextModel&
+CabacContexts<ContextModel>::GetSubblockCsbfCtx(
+  const Restrictions&, YuvComponent, const uint8_t*, int, int, int, int,
+  int*);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffSigCtx(
+  const Restrictions&, YuvComponent, int, ScanOrder, int, int, const Coeff*,
+  ptrdiff_t, int, int);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffGreater1Ctx(
+  const Restrictions&, YuvComponent, int, int, int, int, bool, const Coeff*,
+  ptrdiff_t, int, int);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffGreater2Ctx(
+  const Restrictions&, YuvComponent, int, int, int, bool, const Coeff*,
+  ptrdiff_t, int, int);
+template uint32_t
+CabacContexts<ContextModel>::GetCoeffGolombRiceK(
+  const Restrictions&, int, int, int, int, const Coeff*, ptrdiff_t);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffLastPosCtx(
+  const Restrictions&, YuvComponent, int, int, int, bool);
+// Used by the encoder syntax writer for unrestricted segments
+template ContextModel&
+CabacContexts<ContextModel>::GetSubblockCsbfCtx(
+  const NoRestrictions&, YuvComponent, const uint8_t*, int, int, int, int,
+  int*);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffSigCtx(
+  const NoRestrictions&, YuvComponent, int, ScanOrder, int, int, const Coeff*,
+  ptrdiff_t, int, int);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffGreater1Ctx(
+  const NoRestrictions&, YuvComponent, int, int, int, int, bool, const Coeff*,
+  ptrdiff_t, int, int);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffGreater2Ctx(
+  const NoRestrictions&, YuvComponent, int, int, int, bool, const Coeff*,
+  ptrdiff_t, int, int);
+template uint32_t
+CabacContexts<ContextModel>::GetCoeffGolombRiceK(
+  const NoRestrictions&, int, int, int, int, const Coeff*, ptrdiff_t);
+template ContextModel&
+CabacContexts<ContextModel>::GetCoeffLastPosCtx(
+  const NoRestrictions&, YuvComponent, int, int, int, bool);
 
 }   // namespace xvc
@@ -27,6 +27,7 @@
 #include "xvc_common_lib/common.h"
 #include "xvc_common_lib/context_model.h"
 #include "xvc_common_lib/picture_types.h"
+#include "xvc_common_lib/restrictions.h"
 #include "xvc_common_lib/transform.h"
 #include "xvc_common_lib/quantize.h"
 
@@ -84,7 +85,7 @@ struct CabacCommon {
   static const int kNumTransformSelectIdxCtx = 4;
 };
 
-template<typename ContextModel>
+template<typename ContextModel, typename RestrictionSet = Restrictions>
 struct CabacContexts : public CabacCommon {
 public:
   CabacContexts();
@@ -118,7 +119,42 @@ public:
   ContextModel& GetCoeffLastPosCtx(YuvComponent comp, int width, int height,
                                    int pos, bool is_pos_x);
 
-  const Restrictions *restrictions_;
+  // Residual context derivation with an explicit restriction set, allows
+  // users of the generic contexts to resolve restriction checks at compile
+  // time by passing NoRestrictions
+  template<typename R>
+  ContextModel& GetSubblockCsbfCtx(const R &restrictions, YuvComponent comp,
+                                   const uint8_t *sig_sublock, int posx,
+                                   int posy, int width, int height,
+                                   int *pattern_sig_ctx);
+  template<typename R>
+  ContextModel& GetCoeffSigCtx(const R &restrictions, YuvComponent comp,
+                               int pattern_sig_ctx, ScanOrder scan_order,
+                               int posx, int posy, const Coeff *coeff,
+                               ptrdiff_t coeff_stride, int width_log2,
+                               int height_log2);
+  template<typename R>
+  ContextModel& GetCoeffGreater1Ctx(const R &restrictions, YuvComponent comp,
+                                    int ctx_set, int c1, int posx, int posy,
+                                    bool is_last_coeff, const Coeff *coeff,
+                                    ptrdiff_t coeff_stride, int width_log2,
+                                    int height_log2);
+  template<typename R>
+  ContextModel& GetCoeffGreater2Ctx(const R &restrictions, YuvComponent comp,
+                                    int ctx_set, int posx, int posy,
+                                    bool is_last_coeff, const Coeff *coeff,
+                                    ptrdiff_t coeff_stride, int width_log2,
+                                    int height_log2);
+  template<typename R>
+  uint32_t GetCoeffGolombRiceK(const R &restrictions, int posx, int posy,
+                               int width, int height, const Coeff *coeff,
+                               ptrdiff_t coeff_stride);
+  template<typename R>
+  ContextModel& GetCoeffLastPosCtx(const R &restrictions, YuvComponent comp,
+                                   int width, int height, int pos,
+                                   bool is_pos_x);
+
+  const RestrictionSet *restrictions_;
   std::array<ContextModel, kNumCuCbfCtxLuma> cu_cbf_luma;
   std::array<ContextModel, kNumCuCbfCtxChroma> cu_cbf_chroma;
   std::array<ContextModel, kNumPartSizeCtx> cu_part_size;
@@ -171,6 +207,7 @@ public:
 extern template struct CabacContexts<ContextModel>;
 extern template struct CabacContexts<ContextModelDynamic>;
 extern template struct CabacContexts<ContextModelStatic>;
+extern template struct CabacContexts<ContextModelDynamic, NoRestrictions>;
 
 }   // namespace xvc
 
@@ -45,20 +45,30 @@ CodingUnit::CodingUnit(PictureData *pic_data, CoeffCtuBuffer *ctu_coeff,
                        CuTree cu_tree, int depth, int pic_x, int pic_y,
                        int width, int height)
   : pic_data_(pic_data),
-  ctu_coeff_(ctu_coeff),
-  cu_tree_(cu_tree),
+  qp_(pic_data->GetPicQp()),
   pos_x_(pic_x),
   pos_y_(pic_y),
-  width_(width),
-  height_(height),
-  depth_(depth),
+  width_(static_cast<int16_t>(width)),
+  height_(static_cast<int16_t>(height)),
+  depth_(static_cast<int8_t>(depth)),
+  cu_tree_(cu_tree),
   split_state_(SplitType::kNone),
   pred_mode_(PredictionMode::kIntra),
-  sub_cu_list_({ { nullptr, nullptr, nullptr, nullptr } }),
-  qp_(pic_data->GetPicQp()),
-  tx_(),
+  inter_(),
   intra_(),
-  inter_() {
+  tx_(),
+  ctu_coeff_(ctu_coeff),
+  sub_cu_list_({ { nullptr, nullptr, nullptr, nullptr } }) {
+}
+
+void CodingUnit::ReconstructionState::Reserve(int width, int height) {
+  const size_t num_samples = static_cast<size_t>(width) * height;
+  if (num_samples <= comp_capacity_) {
+    return;
+  }
+  comp_capacity_ = num_samples;
+  reco_.resize(constants::kMaxYuvComponents * comp_capacity_);
+  coeff_.resize(constants::kMaxYuvComponents * comp_capacity_);
 }
 
 CodingUnit& CodingUnit::operator=(const CodingUnit &cu) {
@@ -533,17 +543,17 @@ void CodingUnit::UnSplit() {
 void CodingUnit::SaveStateTo(ReconstructionState *dst_state,
                              const YuvPicture &rec_pic,
                              YuvComponent comp) const {
-  const int c = static_cast<int>(comp);
   int posx = GetPosX(comp);
   int posy = GetPosY(comp);
+  dst_state->Reserve(width_, height_);
   // Reco
   SampleBufferConst reco_src = rec_pic.GetSampleBuffer(comp, posx, posy);
-  SampleBuffer reco_dst(&dst_state->reco[c][0], GetWidth(comp));
+  SampleBuffer reco_dst(dst_state->GetReco(comp), GetWidth(comp));
   reco_dst.CopyFrom(GetWidth(comp), GetHeight(comp), reco_src);
   // Coeff
   CoeffBufferConst coeff_src =
     ctu_coeff_->GetBuffer(comp, GetPosX(comp), GetPosY(comp));
-  CoeffBuffer coeff_dst(&dst_state->coeff[c][0], GetWidth(comp));
+  CoeffBuffer coeff_dst(dst_state->GetCoeff(comp), GetWidth(comp));
   coeff_dst.CopyFrom(GetWidth(comp), GetHeight(comp), coeff_src);
 }
 
@@ -585,15 +595,14 @@ void CodingUnit::SaveStateTo(InterState *state) const {
 
 void CodingUnit::LoadStateFrom(const ReconstructionState &src_state,
                                YuvPicture *rec_pic, YuvComponent comp) {
-  const int c = static_cast<int>(comp);
   int posx = GetPosX(comp);
   int posy = GetPosY(comp);
   // Reco
-  SampleBufferConst reco_src(&src_state.reco[c][0], GetWidth(comp));
+  SampleBufferConst reco_src(src_state.GetReco(comp), GetWidth(comp));
   SampleBuffer reco_dst = rec_pic->GetSampleBuffer(comp, posx, posy);
   reco_dst.CopyFrom(GetWidth(comp), GetHeight(comp), reco_src);
   // Coeff
-  CoeffBufferConst coeff_src(&src_state.coeff[c][0], GetWidth(comp));
+  CoeffBufferConst coeff_src(src_state.GetCoeff(comp), GetWidth(comp));
   CoeffBuffer coeff_dst =
     ctu_coeff_->GetBuffer(comp, GetPosX(comp), GetPosY(comp));
   coeff_dst.CopyFrom(GetWidth(comp), GetHeight(comp), coeff_src);
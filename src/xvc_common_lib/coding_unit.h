@@ -25,6 +25,7 @@
 #include <array>
 #include <cassert>
 #include <memory>
+#include <vector>
 
 #include "xvc_common_lib/common.h"
 #include "xvc_common_lib/cu_types.h"
@@ -39,11 +40,28 @@ class Qp;
 
 class CodingUnit {
 public:
-  struct ReconstructionState {
-    std::array<std::array<Sample, constants::kMaxBlockSamples>,
-      constants::kMaxYuvComponents> reco;
-    std::array<std::array<Coeff, constants::kMaxBlockSamples>,
-      constants::kMaxYuvComponents> coeff;
+  // Samples and coefficients of one cu stored without padding, the storage
+  // grows to the largest cu saved so a state kept for small cus stays small
+  class ReconstructionState {
+  public:
+    void Reserve(int width, int height);
+    Sample* GetReco(YuvComponent comp) {
+      return reco_.data() + static_cast<int>(comp) * comp_capacity_;
+    }
+    const Sample* GetReco(YuvComponent comp) const {
+      return reco_.data() + static_cast<int>(comp) * comp_capacity_;
+    }
+    Coeff* GetCoeff(YuvComponent comp) {
+      return coeff_.data() + static_cast<int>(comp) * comp_capacity_;
+    }
+    const Coeff* GetCoeff(YuvComponent comp) const {
+      return coeff_.data() + static_cast<int>(comp) * comp_capacity_;
+    }
+
+  private:
+    size_t comp_capacity_ = 0;
+    std::vector<Sample> reco_;
+    std::vector<Coeff> coeff_;
   };
   struct TransformState {
     TransformState();
@@ -311,21 +329,23 @@ public:
   void LoadStateFrom(const InterState &state, RefPicList ref_list);
 
 private:
+  // Hot data used by neighborhood derivation and prediction first
   PictureData *pic_data_ = nullptr;
-  CoeffCtuBuffer *ctu_coeff_ = nullptr;   // Coefficient storage for this CU
-  CuTree cu_tree_;
+  const Qp *qp_;
   int pos_x_;
   int pos_y_;
-  int width_;
-  int height_;
-  int depth_;
+  int16_t width_;
+  int16_t height_;
+  int8_t depth_;
+  CuTree cu_tree_;
   SplitType split_state_;
   PredictionMode pred_mode_;
-  std::array<CodingUnit*, constants::kQuadSplit> sub_cu_list_;
-  const Qp *qp_;
-  TransformState tx_;
-  IntraState intra_;
   InterState inter_;
+  IntraState intra_;
+  // Residual coding and split related data
+  TransformState tx_;
+  CoeffCtuBuffer *ctu_coeff_ = nullptr;   // Coefficient storage for this CU
+  std::array<CodingUnit*, constants::kQuadSplit> sub_cu_list_;
 };
 
 }   // namespace xvc
@@ -34,7 +34,7 @@ enum class NeighborDir {
   kLeftBelow,
 };
 
-enum class SplitType {
+enum class SplitType : uint8_t {
   kNone,
   kQuad,
   kHorizontal,
@@ -47,7 +47,7 @@ enum class SplitRestriction {
   kNoVertical,
 };
 
-enum class PredictionMode {
+enum class PredictionMode : uint8_t {
   kIntra = 0,
   kInter = 1,
 };
@@ -64,7 +64,7 @@ enum class PartitionType {
   kSizeNone = 15,
 };
 
-enum class TransformType {
+enum class TransformType : uint8_t {
   kDefault,
   kDct2,
   kDct5,
@@ -96,7 +96,7 @@ enum class IntraAngle {
 static const int kNbrIntraDirs = kNbrIntraModes;
 
 // chroma modes maps directly to intra modes except for kDmChroma
-enum class IntraChromaMode {
+enum class IntraChromaMode : int8_t {
   kLmChroma = -2,
   kDmChroma = -1,
   kPlanar = 0,
@@ -115,7 +115,7 @@ enum class IntraChromaAngle {
   kInvalid = 99,
 };
 
-enum class InterDir {
+enum class InterDir : uint8_t {
   kL0 = 0,
   kL1 = 1,
   kBi = 2,
@@ -23,10 +23,12 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <type_traits>
 
 #include "xvc_common_lib/utils.h"
+#include "xvc_common_lib/motion_field.h"
 #include "xvc_common_lib/reference_picture_lists.h"
 #include "xvc_common_lib/restrictions.h"
 #include "xvc_common_lib/simd_cpu.h"
@@ -944,22 +946,21 @@ InterPrediction::GetTemporalMvPredictor(const CodingUnit &cu,
   RefPicList tmvp_mv_ref_list = ref_pic_list->HasOnlyBackReferences() ?
     ref_list : ReferencePictureLists::Inverse(tmvp_cu_ref_list);
 
-  auto get_temporal_mv = [this, &cu_poc, &cu_ref_poc](const CodingUnit *col_cu,
-                                                      RefPicList col_ref_list,
-                                                      int x, int y,
-                                                      MotionVector *col_mv) {
-    if (!col_cu->IsInter()) {
+  const MotionField *col_field =
+    ref_pic_list->GetMotionField(tmvp_cu_ref_list, tmvp_cu_ref_idx);
+  auto get_temporal_mv = [this, &cu_poc, &cu_ref_poc, col_field](
+    const MotionField::Motion *col, RefPicList col_ref_list,
+    MotionVector *col_mv) {
+    if (!col || !col->IsInter()) {
       return false;
     }
-    if (!col_cu->HasMv(col_ref_list)) {
+    if (!col->HasMv(col_ref_list)) {
       col_ref_list = ReferencePictureLists::Inverse(col_ref_list);
     }
-    MvCorner mv_corner = col_cu->GetMvCorner(x, y);
-    int col_ref_idx = col_cu->GetRefIdx(col_ref_list);
-    PicNum col_poc = col_cu->GetPoc();
+    PicNum col_poc = col_field->GetPoc();
     PicNum col_ref_poc =
-      col_cu->GetRefPicLists()->GetRefPoc(col_ref_list, col_ref_idx);
-    *col_mv = col_cu->GetMv(col_ref_list, mv_corner);
+      col_field->GetRefPoc(col_ref_list, col->GetRefIdx(col_ref_list));
+    *col_mv = col->GetMv(col_ref_list);
     ScaleMv(cu_poc, cu_ref_poc, col_poc, col_ref_poc, col_mv);
     return true;
   };
@@ -977,13 +978,10 @@ InterPrediction::GetTemporalMvPredictor(const CodingUnit &cu,
       col_y = ((col_y >> 4) << 4);
     }
     // Including picture out of bounds check
-    const CodingUnit *col_cu =
-      ref_pic_list->GetCodingUnitAt(tmvp_cu_ref_list, tmvp_cu_ref_idx,
-                                    cu.GetCuTree(), col_x, col_y);
-    if (valid && col_cu && get_temporal_mv(col_cu, tmvp_mv_ref_list,
-                                           col_x, col_y, mv_out)) {
+    const MotionField::Motion *col = col_field->GetMotionAt(col_x, col_y);
+    if (valid && get_temporal_mv(col, tmvp_mv_ref_list, mv_out)) {
       if (use_lic) {
-        *use_lic |= col_cu->GetUseLic();
+        *use_lic |= col->use_lic;
       }
       return true;
     }
@@ -996,12 +994,10 @@ InterPrediction::GetTemporalMvPredictor(const CodingUnit &cu,
     col_x = ((col_x >> 4) << 4);
     col_y = ((col_y >> 4) << 4);
   }
-  const CodingUnit *col_cu =
-    ref_pic_list->GetCodingUnitAt(tmvp_cu_ref_list, tmvp_cu_ref_idx,
-                                  cu.GetCuTree(), col_x, col_y);
-  if (get_temporal_mv(col_cu, tmvp_mv_ref_list, col_x, col_y, mv_out)) {
+  const MotionField::Motion *col = col_field->GetMotionAt(col_x, col_y);
+  if (get_temporal_mv(col, tmvp_mv_ref_list, mv_out)) {
     if (use_lic) {
-      *use_lic |= col_cu->GetUseLic();
+      *use_lic |= col->use_lic;
     }
     return true;
   }
@@ -1384,6 +1380,39 @@ static void FilterVerShortShort(int width, int height, int bitdepth,
   }
 }
 
+void InterPrediction::InterpolateLumaPlane(const YuvPicture &ref_pic,
+                                           int frac_x, int frac_y, int margin,
+                                           Sample *dst, ptrdiff_t dst_stride) {
+  const YuvComponent comp = YuvComponent::kY;
+  const int width = ref_pic.GetWidth(comp) + 2 * margin;
+  const int height = ref_pic.GetHeight(comp) + 2 * margin;
+  const ptrdiff_t ref_stride = ref_pic.GetStride(comp);
+  const Sample *ref = ref_pic.GetSamplePtr(comp, -margin, -margin);
+  if (restrictions_.disable_ext2_inter_high_precision_mv) {
+    frac_x >>= MotionVector::kHighToNormalShiftDelta;
+    frac_y >>= MotionVector::kHighToNormalShiftDelta;
+  }
+  // Filtered in blocks since the intermediate buffer is limited in size
+  const int block_size = constants::kMaxBlockSize;
+  for (int y = 0; y < height; y += block_size) {
+    const int block_height = std::min(block_size, height - y);
+    for (int x = 0; x < width; x += block_size) {
+      const int block_width = std::min(block_size, width - x);
+      const Sample *src = ref + y * ref_stride + x;
+      Sample *out = dst + y * dst_stride + x;
+      if (frac_x == 0 && frac_y == 0) {
+        for (int i = 0; i < block_height; i++) {
+          std::memcpy(out + i * dst_stride, src + i * ref_stride,
+                      block_width * sizeof(Sample));
+        }
+      } else {
+        FilterLuma(block_width, block_height, frac_x, frac_y, src, ref_stride,
+                   out, dst_stride);
+      }
+    }
+  }
+}
+
 void InterPrediction::FilterLuma(int width, int height, int frac_x, int frac_y,
                                  const Sample *ref, ptrdiff_t ref_stride,
                                  Sample *pred, ptrdiff_t pred_stride) {
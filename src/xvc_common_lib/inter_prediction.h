@@ -96,6 +96,12 @@ public:
   void DetermineMinMaxMv(const CodingUnit &cu, const YuvPicture &ref_pic,
                          const MotionVector &center, int search_range,
                          MvFullpel *mv_min, MvFullpel *mv_max) const;
+  // Interpolates the luma of a padded reference picture at a subpel phase
+  // given in motion vector units, including margin samples outside of the
+  // picture on each side. Samples are identical to those of uni-prediction
+  // motion compensation of any block inside the area.
+  void InterpolateLumaPlane(const YuvPicture &ref_pic, int frac_x, int frac_y,
+                            int margin, Sample *dst, ptrdiff_t dst_stride);
   template<typename SrcT, bool Clip>
   static int GetFilterShift(int bitdepth);
   template<typename SrcT, bool Clip>
@@ -0,0 +1,77 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include "xvc_common_lib/motion_field.h"
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/picture_data.h"
+
+namespace xvc {
+
+void MotionField::Build(const PictureData &pic_data) {
+  const YuvComponent luma = YuvComponent::kY;
+  width_ = pic_data.GetPictureWidth(luma);
+  height_ = pic_data.GetPictureHeight(luma);
+  poc_ = pic_data.GetPoc();
+  intra_ = pic_data.IsIntraPic();
+  if (intra_) {
+    return;
+  }
+  const ReferencePictureLists *ref_pic_lists = pic_data.GetRefPicLists();
+  for (int i = 0; i < static_cast<int>(RefPicList::kTotalNumber); i++) {
+    const RefPicList ref_list = static_cast<RefPicList>(i);
+    for (int ref_idx = 0; ref_idx < ref_pic_lists->GetNumRefPics(ref_list);
+         ref_idx++) {
+      ref_poc_[i][ref_idx] = ref_pic_lists->GetRefPoc(ref_list, ref_idx);
+    }
+  }
+
+  const int block_size = 1 << kBlockSizeLog2;
+  const int num_x = (width_ + block_size - 1) >> kBlockSizeLog2;
+  const int num_y = (height_ + block_size - 1) >> kBlockSizeLog2;
+  stride_ = num_x;
+  motion_.resize(num_x * num_y);
+  Motion *motion = &motion_[0];
+  for (int y = 0; y < num_y * block_size; y += block_size) {
+    for (int x = 0; x < num_x * block_size; x += block_size, motion++) {
+      const CodingUnit *cu = pic_data.GetCuAt(CuTree::Primary, x, y);
+      motion->ref_idx = { { -1, -1 } };
+      motion->use_lic = false;
+      if (!cu || !cu->IsInter()) {
+        continue;
+      }
+      // Affine cus have one mv per quadrant, the quadrant boundaries are
+      // always aligned with the grid
+      const MvCorner mv_corner = cu->GetMvCorner(x, y);
+      for (int i = 0; i < static_cast<int>(RefPicList::kTotalNumber); i++) {
+        const RefPicList ref_list = static_cast<RefPicList>(i);
+        if (cu->HasMv(ref_list)) {
+          motion->mv[i] = cu->GetMv(ref_list, mv_corner);
+          motion->ref_idx[i] = static_cast<int8_t>(cu->GetRefIdx(ref_list));
+        }
+      }
+      motion->use_lic = cu->GetUseLic();
+    }
+  }
+}
+
+}   // namespace xvc
@@ -0,0 +1,90 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#ifndef XVC_COMMON_LIB_MOTION_FIELD_H_
+#define XVC_COMMON_LIB_MOTION_FIELD_H_
+
+#include <array>
+#include <vector>
+
+#include "xvc_common_lib/common.h"
+#include "xvc_common_lib/cu_types.h"
+#include "xvc_common_lib/reference_picture_lists.h"
+
+namespace xvc {
+
+class PictureData;
+
+// Motion of a fully coded picture kept for temporal mv prediction, stored
+// on a regular grid so that the cu tree of the picture can be released
+class MotionField {
+public:
+  struct Motion {
+    bool IsInter() const { return ref_idx[0] >= 0 || ref_idx[1] >= 0; }
+    bool HasMv(RefPicList ref_list) const {
+      return ref_idx[static_cast<int>(ref_list)] >= 0;
+    }
+    const MotionVector& GetMv(RefPicList ref_list) const {
+      return mv[static_cast<int>(ref_list)];
+    }
+    int GetRefIdx(RefPicList ref_list) const {
+      return ref_idx[static_cast<int>(ref_list)];
+    }
+    std::array<MotionVector, 2> mv;
+    std::array<int8_t, 2> ref_idx;   // negative if list is not used
+    bool use_lic;
+  };
+
+  // Sampled at the smallest block size, readers that are restricted to
+  // 16x16 positions align the position before the lookup
+  void Build(const PictureData &pic_data);
+  // Returns nullptr for positions outside of the picture
+  const Motion* GetMotionAt(int posx, int posy) const {
+    if (intra_ || posx >= width_ || posy >= height_) {
+      return nullptr;
+    }
+    return &motion_[(posy >> kBlockSizeLog2) * stride_ +
+      (posx >> kBlockSizeLog2)];
+  }
+  PicNum GetPoc() const { return poc_; }
+  PicNum GetRefPoc(RefPicList ref_list, int ref_idx) const {
+    return ref_poc_[static_cast<int>(ref_list)][ref_idx];
+  }
+
+private:
+  static const int kBlockSizeLog2 = 2;
+  static_assert(1 << kBlockSizeLog2 == constants::kMinBlockSize,
+                "Motion field is sampled at the smallest block size");
+
+  int width_ = 0;
+  int height_ = 0;
+  ptrdiff_t stride_ = 0;
+  bool intra_ = true;
+  PicNum poc_ = static_cast<PicNum>(-1);
+  std::array<std::array<PicNum, constants::kMaxNumRefPics>,
+    static_cast<int>(RefPicList::kTotalNumber)> ref_poc_;
+  std::vector<Motion> motion_;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_COMMON_LIB_MOTION_FIELD_H_
@@ -0,0 +1,224 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include "xvc_common_lib/picture_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace xvc {
+
+// Buffers of at least this size are aligned to huge page boundaries
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+// Default upper limit of memory kept in the pool for later reuse
+static const size_t kDefaultPoolLimit = 512 * 1024 * 1024;
+
+const size_t PictureAllocator::kAlignment;
+
+static void* AllocateAligned(size_t size, size_t alignment) {
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  void *ptr = nullptr;
+  if (posix_memalign(&ptr, alignment, size) != 0) {
+    return nullptr;
+  }
+  return ptr;
+#endif
+}
+
+static void FreeAligned(void *ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+// Rounds up to one of four size classes per power of two so that pictures
+// of similar size can share buffers with at most 25% overhead
+static size_t GetSizeClass(size_t size, bool huge_pages) {
+  if (huge_pages && size >= kHugePageSize) {
+    return (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  }
+  int log2_size = 0;
+  for (size_t s = size - 1; s > 1; s >>= 1) {
+    log2_size++;
+  }
+  size_t step = std::max(PictureAllocator::kAlignment,
+                         (static_cast<size_t>(1) << log2_size) >> 2);
+  return (size + step - 1) & ~(step - 1);
+}
+
+namespace {
+
+// Freed buffers of the built-in allocator grouped by size class, shared by
+// all decoder and encoder instances in the process
+class BufferPool {
+public:
+  static BufferPool& Get() {
+    // Intentionally never destroyed, buffers may be released during exit
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+  }
+
+  void* Acquire(size_t size_class, bool huge_pages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = free_lists_.find(std::make_pair(size_class, huge_pages));
+    if (it == free_lists_.end() || it->second.empty()) {
+      return nullptr;
+    }
+    void *ptr = it->second.back();
+    it->second.pop_back();
+    pooled_bytes_ -= size_class;
+    return ptr;
+  }
+
+  bool Release(void *ptr, size_t size_class, bool huge_pages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (num_references_ == 0 || pooled_bytes_ + size_class > pool_limit_) {
+      return false;
+    }
+    free_lists_[std::make_pair(size_class, huge_pages)].push_back(ptr);
+    pooled_bytes_ += size_class;
+    return true;
+  }
+
+  void SetLimit(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pool_limit_ = max_bytes;
+    Trim(pool_limit_);
+  }
+
+  void AddReference() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_references_++;
+  }
+
+  void RemoveReference() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(num_references_ > 0);
+    if (--num_references_ == 0) {
+      Trim(0);
+    }
+  }
+
+  size_t GetPooledBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pooled_bytes_;
+  }
+
+private:
+  void Trim(size_t max_bytes) {
+    for (auto it = free_lists_.begin(); it != free_lists_.end();) {
+      std::vector<void*> &free_list = it->second;
+      while (pooled_bytes_ > max_bytes && !free_list.empty()) {
+        FreeAligned(free_list.back());
+        free_list.pop_back();
+        pooled_bytes_ -= it->first.first;
+      }
+      it = free_list.empty() ? free_lists_.erase(it) : std::next(it);
+    }
+  }
+
+  std::mutex mutex_;
+  std::map<std::pair<size_t, bool>, std::vector<void*>> free_lists_;
+  size_t pooled_bytes_ = 0;
+  size_t pool_limit_ = kDefaultPoolLimit;
+  int num_references_ = 0;
+};
+
+}   // namespace
+
+void* PictureAllocator::Allocate(size_t size) const {
+  void *ptr;
+  if (alloc_func) {
+    ptr = alloc_func(opaque, size, kAlignment);
+  } else {
+    const bool huge = huge_pages && size >= kHugePageSize;
+    const size_t size_class = GetSizeClass(size, huge);
+    ptr = BufferPool::Get().Acquire(size_class, huge);
+    if (!ptr) {
+      ptr = AllocateAligned(size_class, huge ? kHugePageSize : kAlignment);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+      if (ptr && huge) {
+        // Only a hint, failure means regular pages are used
+        madvise(ptr, size_class, MADV_HUGEPAGE);
+      }
+#endif
+    }
+  }
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  assert(reinterpret_cast<uintptr_t>(ptr) % kAlignment == 0);
+  if (allocated_bytes) {
+    *allocated_bytes += size;
+  }
+  return ptr;
+}
+
+void PictureAllocator::Free(void *ptr, size_t size) const {
+  if (allocated_bytes) {
+    *allocated_bytes -= size;
+  }
+  if (free_func) {
+    free_func(opaque, ptr);
+    return;
+  }
+  const bool huge = huge_pages && size >= kHugePageSize;
+  if (!BufferPool::Get().Release(ptr, GetSizeClass(size, huge), huge)) {
+    FreeAligned(ptr);
+  }
+}
+
+void PictureAllocator::SetPoolLimit(size_t max_bytes) {
+  BufferPool::Get().SetLimit(max_bytes);
+}
+
+size_t PictureAllocator::GetPooledBytes() {
+  return BufferPool::Get().GetPooledBytes();
+}
+
+void PictureAllocator::AddPoolReference() {
+  BufferPool::Get().AddReference();
+}
+
+void PictureAllocator::RemovePoolReference() {
+  BufferPool::Get().RemoveReference();
+}
+
+}   // namespace xvc
@@ -0,0 +1,118 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#ifndef XVC_COMMON_LIB_PICTURE_ALLOCATOR_H_
+#define XVC_COMMON_LIB_PICTURE_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace xvc {
+
+// Allocator for picture sized buffers. All allocations are aligned to at
+// least kAlignment bytes. The application may provide its own allocation
+// functions, otherwise a built-in aligned allocator is used that optionally
+// requests transparent huge pages for large buffers. Buffers freed by the
+// built-in allocator are kept in a process wide pool grouped by size class
+// and reused by all decoder and encoder instances. Buffers are only pooled
+// while at least one BufferPoolReference exists, the pool is emptied when
+// the last reference goes away.
+struct PictureAllocator {
+  using AllocFunc = void*(*)(void *opaque, size_t size, size_t alignment);
+  using FreeFunc = void(*)(void *opaque, void *ptr);
+  static const size_t kAlignment = 64;
+
+  void* Allocate(size_t size) const;
+  void Free(void *ptr, size_t size) const;
+  // Limits the amount of memory kept in the pool, excess buffers are freed
+  static void SetPoolLimit(size_t max_bytes);
+  static size_t GetPooledBytes();
+  static void AddPoolReference();
+  static void RemovePoolReference();
+
+  AllocFunc alloc_func = nullptr;
+  FreeFunc free_func = nullptr;
+  void *opaque = nullptr;
+  bool huge_pages = false;
+  // Optional running total of bytes currently allocated through this
+  // allocator and its copies
+  std::atomic<size_t> *allocated_bytes = nullptr;
+};
+
+// Keeps the buffer pool in use for the lifetime of a decoder or encoder
+class BufferPoolReference {
+public:
+  BufferPoolReference() { PictureAllocator::AddPoolReference(); }
+  BufferPoolReference(const BufferPoolReference&) = delete;
+  ~BufferPoolReference() { PictureAllocator::RemovePoolReference(); }
+  BufferPoolReference& operator=(const BufferPoolReference&) = delete;
+};
+
+// Uninitialized aligned storage of trivial elements owned by a
+// PictureAllocator
+template<typename T>
+class AlignedBuffer {
+public:
+  AlignedBuffer() = default;
+  AlignedBuffer(const PictureAllocator &allocator, size_t size)
+    : allocator_(allocator),
+    size_(size) {
+    data_ = size > 0 ?
+      static_cast<T*>(allocator_.Allocate(size * sizeof(T))) : nullptr;
+  }
+  AlignedBuffer(AlignedBuffer &&other) noexcept { *this = std::move(other); }
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  ~AlignedBuffer() { Release(); }
+  AlignedBuffer& operator=(AlignedBuffer &&other) noexcept {
+    if (this != &other) {
+      Release();
+      allocator_ = other.allocator_;
+      data_ = other.data_;
+      size_ = other.size_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  void Release() {
+    if (data_) {
+      allocator_.Free(data_, size_ * sizeof(T));
+      data_ = nullptr;
+    }
+  }
+
+  PictureAllocator allocator_;
+  T *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_COMMON_LIB_PICTURE_ALLOCATOR_H_
@@ -24,6 +24,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <new>
+#include <type_traits>
 
 #include "xvc_common_lib/coding_unit.h"
 #include "xvc_common_lib/common.h"
@@ -32,10 +34,76 @@
 
 namespace xvc {
 
+// Typical number of CodingUnit objects allocated per ctu and chunk
+static const int kCuArenaFirstChunkPerCtu = 16;
+static const int kCuArenaChunkPerCtu = 4;
+
+static size_t GetNumCtu(int width, int height) {
+  const int num_ctu_x = (width + constants::kCtuSize - 1) / constants::kCtuSize;
+  const int num_ctu_y =
+    (height + constants::kCtuSize - 1) / constants::kCtuSize;
+  return static_cast<size_t>(std::max(1, num_ctu_x * num_ctu_y));
+}
+
+CuArena::CuArena(const PictureAllocator &allocator, size_t first_chunk_size,
+                 size_t chunk_size)
+  : allocator_(allocator),
+  first_chunk_size_(first_chunk_size),
+  chunk_size_(chunk_size) {
+  static_assert(sizeof(CodingUnit) >= sizeof(FreeEntry) &&
+                alignof(CodingUnit) >= alignof(FreeEntry),
+                "CodingUnit storage must fit a free list entry");
+}
+
+void* CuArena::Allocate() {
+  if (free_list_) {
+    void *cu = free_list_;
+    free_list_ = free_list_->next;
+    return cu;
+  }
+  if (bump_ptr_ == bump_end_) {
+    NextChunk();
+  }
+  return bump_ptr_++;
+}
+
+void CuArena::Free(CodingUnit *cu) {
+  free_list_ = new (cu) FreeEntry{ free_list_ };
+}
+
+void CuArena::Reset() {
+  free_list_ = nullptr;
+  chunk_idx_ = 0;
+  bump_ptr_ = nullptr;
+  bump_end_ = nullptr;
+}
+
+void CuArena::ReleaseMemory() {
+  Reset();
+  chunks_.clear();
+}
+
+void CuArena::NextChunk() {
+  if (bump_end_) {
+    chunk_idx_++;
+  }
+  if (chunk_idx_ == chunks_.size()) {
+    // The first chunk holds the majority of cus, extra chunks are typically
+    // only needed for intra pictures
+    chunks_.emplace_back(allocator_,
+                         chunks_.empty() ? first_chunk_size_ : chunk_size_);
+  }
+  bump_ptr_ = chunks_[chunk_idx_].data();
+  bump_end_ = bump_ptr_ + chunks_[chunk_idx_].size();
+}
+
 PictureData::PictureData(ChromaFormat chroma_format, int width, int height,
-                         int bitdepth)
-  : ctu_coeff_(new CoeffCtuBuffer(util::GetChromaShiftX(chroma_format),
-                                  util::GetChromaShiftY(chroma_format))),
+                         int bitdepth, const PictureAllocator &allocator)
+  : cu_arena_(allocator, GetNumCtu(width, height) * kCuArenaFirstChunkPerCtu,
+              GetNumCtu(width, height) * kCuArenaChunkPerCtu),
+  ctu_coeff_(new CoeffCtuBuffer(util::GetChromaShiftX(chroma_format),
+                                  util::GetChromaShiftY(chroma_format),
+                                  allocator)),
   pic_width_(width),
   pic_height_(height),
   bitdepth_(bitdepth),
@@ -48,22 +116,14 @@ PictureData::PictureData(ChromaFormat chroma_format, int width, int height,
              constants::kCtuSize),
   ctu_num_y_((pic_height_ + constants::kCtuSize - 1) /
              constants::kCtuSize),
-  cu_alloc_batch_size_(std::max(1, ctu_num_x_ * ctu_num_y_) * 4) {
-  int num_cu_pic_x = (pic_width_ + constants::kMaxBlockSize - 1) /
-    constants::kMinBlockSize;
-  int num_cu_pic_y = (pic_height_ + constants::kMaxBlockSize - 1) /
-    constants::kMinBlockSize;
-  cu_pic_stride_ = num_cu_pic_x + 1;
-  // Initial CU buffer allocation, includes majority of allocated CUs
-  cu_alloc_buffers_.emplace_back(cu_alloc_batch_size_ * 4);
-  for (int tree_idx = 0; tree_idx < constants::kMaxNumCuTrees; tree_idx++) {
-    cu_pic_table_[tree_idx].resize(cu_pic_stride_ * (num_cu_pic_y + 1));
-    std::fill(cu_pic_table_[tree_idx].begin(),
-              cu_pic_table_[tree_idx].end(), nullptr);
-  }
+  allocator_(allocator) {
+  AllocateCuStorage();
 }
 
 PictureData::~PictureData() {
+  // CU objects are released together with their allocation buffers
+  static_assert(std::is_trivially_destructible<CodingUnit>::value,
+                "CodingUnit must not require destruction");
 }
 
 void PictureData::Init(const SegmentHeader &segment, const Qp &pic_qp,
@@ -106,11 +166,12 @@ void PictureData::Init(const SegmentHeader &segment, const Qp &pic_qp,
   }
 
   // Initialize CU allocator / object pool
-  // Buffer pointers are reset to first entry without any deconstruction
+  // Storage is rewound without any deconstruction
   // this requires that no object are reused across pictures
-  cu_alloc_free_list_.clear();
-  cu_alloc_list_index_ = 0;
-  cu_alloc_item_index_ = 0;
+  cu_arena_.Reset();
+  if (cu_pic_table_[0].empty()) {
+    AllocateCuStorage();
+  }
 
   // CTU initialization
   for (int tree_idx = 0; tree_idx < constants::kMaxNumCuTrees; tree_idx++) {
@@ -134,6 +195,17 @@ void PictureData::Init(const SegmentHeader &segment, const Qp &pic_qp,
     pic_type == PicturePredictionType::kBi;
 }
 
+void PictureData::AllocateCuStorage() {
+  int num_cu_pic_x = (pic_width_ + constants::kMaxBlockSize - 1) /
+    constants::kMinBlockSize;
+  int num_cu_pic_y = (pic_height_ + constants::kMaxBlockSize - 1) /
+    constants::kMinBlockSize;
+  cu_pic_stride_ = num_cu_pic_x + 1;
+  for (int tree_idx = 0; tree_idx < constants::kMaxNumCuTrees; tree_idx++) {
+    cu_pic_table_[tree_idx].resize(cu_pic_stride_ * (num_cu_pic_y + 1));
+  }
+}
+
 CodingUnit* PictureData::SetCtu(CuTree cu_tree, int rsaddr, CodingUnit *cu) {
   if (ctu_rs_list_[static_cast<int>(cu_tree)][rsaddr] == cu) {
     return nullptr;
@@ -156,36 +228,30 @@ CodingUnit *PictureData::CreateCu(CuTree cu_tree, int depth, int posx,
   if (posx >= pic_width_ || posy >= pic_height_) {
     return nullptr;
   }
-  CodingUnit *cu;
-  if (!cu_alloc_free_list_.empty()) {
-    cu = cu_alloc_free_list_.back();
-    cu_alloc_free_list_.pop_back();
-  } else {
-    assert(!cu_alloc_buffers_.empty());
-    if (cu_alloc_item_index_ ==
-        cu_alloc_buffers_[cu_alloc_list_index_].size()) {
-      cu_alloc_list_index_++;
-      cu_alloc_item_index_ = 0;
-    }
-    if (cu_alloc_list_index_ == cu_alloc_buffers_.size()) {
-      // Allocate an extra buffer (typically needed for intra pictures)
-      cu_alloc_buffers_.emplace_back(cu_alloc_batch_size_);
-    }
-    cu = &cu_alloc_buffers_[cu_alloc_list_index_][cu_alloc_item_index_];
-    cu_alloc_item_index_++;
-  }
+  void *cu = cu_arena_.Allocate();
   // Reinitialize memory to a known state
   return new (cu) CodingUnit(this, ctu_coeff_.get(), cu_tree, depth,
                              posx, posy, width, height);
 }
 
+void PictureData::ReleaseCuTree() {
+  motion_field_.Build(*this);
+  for (int tree_idx = 0; tree_idx < constants::kMaxNumCuTrees; tree_idx++) {
+    ctu_rs_list_[tree_idx].clear();
+    cu_pic_table_[tree_idx].clear();
+    cu_pic_table_[tree_idx].shrink_to_fit();
+  }
+  // Chunks are handed back to the allocator and picked up again by Init
+  cu_arena_.ReleaseMemory();
+}
+
 void PictureData::ReleaseCu(CodingUnit *cu) {
   for (CodingUnit *sub_cu : cu->GetSubCu()) {
     if (sub_cu) {
       ReleaseCu(sub_cu);
     }
   }
-  cu_alloc_free_list_.push_back(cu);
+  cu_arena_.Free(cu);
 }
 
 void PictureData::MarkUsedInPic(CodingUnit *cu) {
@@ -25,6 +25,8 @@
 #include <memory>
 #include <vector>
 
+#include "xvc_common_lib/motion_field.h"
+#include "xvc_common_lib/picture_allocator.h"
 #include "xvc_common_lib/picture_types.h"
 #include "xvc_common_lib/reference_picture_lists.h"
 #include "xvc_common_lib/segment_header.h"
@@ -35,9 +37,50 @@ namespace xvc {
 
 class CodingUnit;
 
+// Storage for the CodingUnit objects of one picture. Objects are handed out
+// in memory order by bumping a pointer through large chunks, objects
+// released during rdo are linked through their own storage and handed out
+// again first. Reset rewinds the arena in O(1) without touching any object.
+// The arena is owned by the picture and only used by the thread coding it,
+// so it also serves as the rdo arena of that thread without any locking.
+class CuArena {
+public:
+  CuArena(const PictureAllocator &allocator, size_t first_chunk_size,
+          size_t chunk_size);
+  CuArena(const CuArena&) = delete;
+  CuArena& operator=(const CuArena&) = delete;
+
+  // Returns uninitialized storage for one CodingUnit
+  void* Allocate();
+  // The storage of cu may be handed out again by the next Allocate call
+  void Free(CodingUnit *cu);
+  // Makes all storage available again, previously allocated objects
+  // must no longer be used
+  void Reset();
+  // As Reset but also returns all chunks to the allocator
+  void ReleaseMemory();
+  size_t GetNumChunks() const { return chunks_.size(); }
+
+private:
+  struct FreeEntry {
+    FreeEntry *next;
+  };
+  void NextChunk();
+
+  PictureAllocator allocator_;
+  const size_t first_chunk_size_;
+  const size_t chunk_size_;
+  std::vector<AlignedBuffer<CodingUnit>> chunks_;
+  size_t chunk_idx_ = 0;
+  CodingUnit *bump_ptr_ = nullptr;
+  CodingUnit *bump_end_ = nullptr;
+  FreeEntry *free_list_ = nullptr;
+};
+
 class PictureData {
 public:
-  PictureData(ChromaFormat chroma_format, int width, int height, int bitdepth);
+  PictureData(ChromaFormat chroma_format, int width, int height, int bitdepth,
+              const PictureAllocator &allocator = PictureAllocator());
   ~PictureData();
 
   void Init(const SegmentHeader &segment, const Qp &pic_qp,
@@ -86,7 +129,7 @@ public:
        constants::kMaxBinarySplitSizeIntra2);
   }
 
-  // CU data
+  // CU data, not available after ReleaseCuTree
   CodingUnit *GetCtu(CuTree cu_tree, int rsaddr) {
     return static_cast<CodingUnit*>(
       ctu_rs_list_[static_cast<int>(cu_tree)][rsaddr]);
@@ -97,15 +140,18 @@ public:
   }
   CodingUnit* SetCtu(CuTree cu_tree, int rsaddr, CodingUnit *cu);
   int GetNumberOfCtu() const {
+    assert(!cu_pic_table_[0].empty());
     return static_cast<int>(ctu_rs_list_[0].size());
   }
   const CodingUnit* GetCuAt(CuTree cu_tree, int posx, int posy) const {
+    assert(!cu_pic_table_[static_cast<int>(cu_tree)].empty());
     ptrdiff_t cu_idx = (posy / constants::kMinBlockSize) * cu_pic_stride_ +
       (posx / constants::kMinBlockSize);
     return static_cast<CodingUnit*>(
       cu_pic_table_[static_cast<int>(cu_tree)][cu_idx]);
   }
   CodingUnit* GetCuAtForModification(CuTree cu_tree, int posx, int posy) {
+    assert(!cu_pic_table_[static_cast<int>(cu_tree)].empty());
     ptrdiff_t cu_idx = (posy / constants::kMinBlockSize) * cu_pic_stride_ +
       (posx / constants::kMinBlockSize);
     return static_cast<CodingUnit*>(
@@ -117,6 +163,10 @@ public:
   void ReleaseCu(CodingUnit *cu);
   void MarkUsedInPic(CodingUnit *cu);
   void ClearMarkCuInPic(CodingUnit *cu);
+  // Keeps only the motion field of a fully coded picture and returns the
+  // memory of its cu trees, all cu pointers into the picture become invalid
+  void ReleaseCuTree();
+  const MotionField& GetMotionField() const { return motion_field_; }
 
   // High level syntax
   void SetNalType(NalUnitType type) { nal_type_ = type; }
@@ -162,6 +212,7 @@ private:
   bool DetermineForceBipredL1MvdZero();
   RefPicList DetermineTmvpRefList(int *tmvp_ref_idx);
   void AllocateAllCtu(CuTree cu_tree);
+  void AllocateCuStorage();
 
   std::array<std::vector<CodingUnit*>,
     constants::kMaxNumCuTrees> ctu_rs_list_;
@@ -169,10 +220,9 @@ private:
     constants::kMaxNumCuTrees> cu_pic_table_;
   std::array<std::vector<YuvComponent>,
     constants::kMaxNumCuTrees> cu_tree_components_;
-  // Non owning pointers to CU objects that were preivously used in rdo
-  std::vector<CodingUnit*> cu_alloc_free_list_;
-  // Chunks of allocated memory, the inner arrays are static and never resized
-  std::vector<std::vector<CodingUnit>> cu_alloc_buffers_;
+  // CU objects are constructed in place when handed out by CreateCu
+  CuArena cu_arena_;
+  MotionField motion_field_;
   // Holds coefficients for a single ctu, then reused for next one
   std::unique_ptr<CoeffCtuBuffer> ctu_coeff_;
   ptrdiff_t cu_pic_stride_;
@@ -186,9 +236,7 @@ private:
   int num_cu_trees_;
   int ctu_num_x_;
   int ctu_num_y_;
-  int cu_alloc_batch_size_;
-  size_t cu_alloc_list_index_ = 0;
-  size_t cu_alloc_item_index_ = 0;
+  PictureAllocator allocator_;
   PicNum poc_ = static_cast<PicNum>(-1);
   PicNum doc_ = static_cast<PicNum>(-1);
   SegmentNum soc_ = static_cast<SegmentNum>(-1);
@@ -74,14 +74,11 @@ ReferencePictureLists::GetRefPicTid(RefPicList ref_list, int ref_idx) const {
   return entry_list[ref_idx].data->GetTid();
 }
 
-const CodingUnit*
-ReferencePictureLists::GetCodingUnitAt(RefPicList ref_list, int index,
-                                       CuTree cu_tree, int posx,
-                                       int posy) const {
+const MotionField*
+ReferencePictureLists::GetMotionField(RefPicList ref_list, int index) const {
   const std::vector<RefEntry> &entry_list =
     ref_list == RefPicList::kL0 ? l0_ : l1_;
-  std::shared_ptr<const PictureData> pic_data = entry_list[index].data;
-  return pic_data->GetCuAt(cu_tree, posx, posy);
+  return &entry_list[index].data->GetMotionField();
 }
 
 void ReferencePictureLists::SetRefPic(
@@ -38,6 +38,7 @@ enum class RefPicList {
 };
 
 class CodingUnit;
+class MotionField;
 class PictureData;
 
 class ReferencePictureLists {
@@ -66,8 +67,7 @@ public:
   bool HasOnlyBackReferences() const { return only_back_references_; }
   PicturePredictionType GetRefPicType(RefPicList ref_list, int ref_idx) const;
   int GetRefPicTid(RefPicList ref_list, int ref_idx) const;
-  const CodingUnit* GetCodingUnitAt(RefPicList ref_list, int ref_idx,
-                                    CuTree cu_tree, int posx, int posy) const;
+  const MotionField* GetMotionField(RefPicList ref_list, int ref_idx) const;
   void SetRefPic(RefPicList ref_list, int index, PicNum ref_poc,
                  const std::shared_ptr<const PictureData> &pic_data,
                  const std::shared_ptr<const YuvPicture> &ref_pic,
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <vector>
 #include <limits>
 
@@ -87,7 +88,27 @@ void Resampler::ConvertFrom(const PictureFormat &src_format,
                                input_planes[c].second, src_format, out_pic);
     }
   } else {
-    assert(0);  // not implemented
+    // Pack the planes to resample them the same way as contiguous bytes
+    const int sample_size = src_format.bitdepth == 8 ? 1 : 2;
+    tmp_bytes_.resize(sample_size *
+                      util::GetTotalNumSamples(src_format.width,
+                                               src_format.height,
+                                               src_format.chroma_format));
+    uint8_t *dst = &tmp_bytes_[0];
+    for (int c = 0; c < num_components; c++) {
+      const YuvComponent comp = YuvComponent(c);
+      const int width = sample_size *
+        util::ScaleSizeX(src_format.width, src_format.chroma_format, comp);
+      const int height =
+        util::ScaleSizeY(src_format.height, src_format.chroma_format, comp);
+      const uint8_t *src = input_planes[c].first;
+      for (int y = 0; y < height; y++) {
+        std::memcpy(dst, src, width);
+        src += input_planes[c].second;
+        dst += width;
+      }
+    }
+    CopyFromBytesWithResampling(&tmp_bytes_[0], src_format, out_pic);
   }
 }
 
@@ -186,7 +207,8 @@ Resampler::CopyFromBytesFast(YuvComponent comp, const uint8_t *input_bytes,
   if (input_bitdepth > out_pic->GetBitdepth()) {
     assert(0);  // not supported
   } else if (input_bitdepth > 8 &&
-             input_stride == output_stride &&
+             input_stride ==
+             output_stride * static_cast<ptrdiff_t>(sizeof(Sample)) &&
              input_bitdepth == out_pic->GetBitdepth()) {
     assert(width * sizeof(Sample) <= static_cast<size_t>(input_stride));
     const size_t samples = static_cast<size_t>(input_stride * height);
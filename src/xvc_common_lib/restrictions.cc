@@ -26,6 +26,7 @@
 namespace xvc {
 
 thread_local Restrictions Restrictions::instance;
+const NoRestrictions NoRestrictions::instance = NoRestrictions();
 
 Restrictions::Restrictions() {
 #if RESTRICTION_DISABLE_INTRA_REF_PADDING
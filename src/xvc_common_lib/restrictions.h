@@ -48,6 +48,17 @@ public:
 
   bool CheckBaselineCompatibility() const;
 
+  bool IsUnrestricted() const {
+    return !GetIntraRestrictions() &&
+      !GetInterRestrictions() &&
+      !GetTransformRestrictions() &&
+      !GetCabacRestrictions() &&
+      !GetDeblockRestrictions() &&
+      !GetHighLevelRestrictions() &&
+      !GetExtRestrictions() &&
+      !GetExt2Restrictions();
+  }
+
   bool GetIntraRestrictions() const {
     return disable_intra_ref_padding ||
       disable_intra_ref_sample_filter ||
@@ -246,6 +257,98 @@ private:
   void EnableRestrictedMode(RestrictedMode mode);
 } Restrictions;
 
+// Compile-time counterpart of the Restrictions struct where no features are
+// disabled. Performance critical code (evaluated per bin or per coefficient)
+// is templated on the restriction set so that, when a segment does not use
+// any restricted mode, this struct can be used instead and all restriction
+// checks are resolved by the compiler. Selection between the two is done once
+// per picture based on Restrictions::IsUnrestricted().
+struct NoRestrictions {
+  static const NoRestrictions& Get() {
+    return instance;
+  }
+  static constexpr bool disable_intra_ref_padding = false;
+  static constexpr bool disable_intra_ref_sample_filter = false;
+  static constexpr bool disable_intra_dc_post_filter = false;
+  static constexpr bool disable_intra_ver_hor_post_filter = false;
+  static constexpr bool disable_intra_planar = false;
+  static constexpr bool disable_intra_mpm_prediction = false;
+  static constexpr bool disable_intra_chroma_predictor = false;
+  static constexpr bool disable_inter_mvp = false;
+  static constexpr bool disable_inter_scaling_mvp = false;
+  static constexpr bool disable_inter_tmvp_mvp = false;
+  static constexpr bool disable_inter_tmvp_merge = false;
+  static constexpr bool disable_inter_tmvp_ref_list_derivation = false;
+  static constexpr bool disable_inter_merge_candidates = false;
+  static constexpr bool disable_inter_merge_mode = false;
+  static constexpr bool disable_inter_merge_bipred = false;
+  static constexpr bool disable_inter_skip_mode = false;
+  static constexpr bool disable_inter_chroma_subpel = false;
+  static constexpr bool disable_inter_mvd_greater_than_flags = false;
+  static constexpr bool disable_inter_bipred = false;
+  static constexpr bool disable_transform_adaptive_scan_order = false;
+  static constexpr bool disable_transform_residual_greater_than_flags = false;
+  static constexpr bool disable_transform_residual_greater2 = false;
+  static constexpr bool disable_transform_last_position = false;
+  static constexpr bool disable_transform_root_cbf = false;
+  static constexpr bool disable_transform_cbf = false;
+  static constexpr bool disable_transform_subblock_csbf = false;
+  static constexpr bool disable_transform_sign_hiding = false;
+  static constexpr bool disable_transform_adaptive_exp_golomb = false;
+  static constexpr bool disable_cabac_ctx_update = false;
+  static constexpr bool disable_cabac_split_flag_ctx = false;
+  static constexpr bool disable_cabac_skip_flag_ctx = false;
+  static constexpr bool disable_cabac_inter_dir_ctx = false;
+  static constexpr bool disable_cabac_subblock_csbf_ctx = false;
+  static constexpr bool disable_cabac_coeff_sig_ctx = false;
+  static constexpr bool disable_cabac_coeff_greater1_ctx = false;
+  static constexpr bool disable_cabac_coeff_greater2_ctx = false;
+  static constexpr bool disable_cabac_coeff_last_pos_ctx = false;
+  static constexpr bool disable_cabac_init_per_pic_type = false;
+  static constexpr bool disable_cabac_init_per_qp = false;
+  static constexpr bool disable_deblock_strong_filter = false;
+  static constexpr bool disable_deblock_weak_filter = false;
+  static constexpr bool disable_deblock_chroma_filter = false;
+  static constexpr bool disable_deblock_boundary_strength_zero = false;
+  static constexpr bool disable_deblock_boundary_strength_one = false;
+  static constexpr bool disable_deblock_initial_sample_decision = false;
+  static constexpr bool disable_deblock_weak_sample_decision = false;
+  static constexpr bool disable_deblock_two_samples_weak_filter = false;
+  static constexpr bool disable_deblock_depending_on_qp = false;
+  static constexpr bool disable_high_level_default_checksum_method = false;
+  static constexpr bool disable_ext_sink = false;
+  static constexpr bool disable_ext_implicit_last_ctu = false;
+  static constexpr bool disable_ext_tmvp_full_resolution = false;
+  static constexpr bool disable_ext_tmvp_exclude_intra_from_ref_list = false;
+  static constexpr bool disable_ext_ref_list_l0_trim = false;
+  static constexpr bool disable_ext_implicit_partition_type = false;
+  static constexpr bool disable_ext_cabac_alt_split_flag_ctx = false;
+  static constexpr bool disable_ext_cabac_alt_inter_dir_ctx = false;
+  static constexpr bool disable_ext_cabac_alt_last_pos_ctx = false;
+  static constexpr bool disable_ext_two_cu_trees = false;
+  static constexpr bool disable_ext_transform_size_64 = false;
+  static constexpr bool disable_ext_intra_unrestricted_predictor = false;
+  static constexpr bool disable_ext_deblock_subblock_size_4 = false;
+  static constexpr bool disable_ext2_intra_67_modes = false;
+  static constexpr bool disable_ext2_intra_6_predictors = false;
+  static constexpr bool disable_ext2_intra_chroma_from_luma = false;
+  static constexpr bool disable_ext2_inter_adaptive_fullpel_mv = false;
+  static constexpr bool disable_ext2_inter_affine = false;
+  static constexpr bool disable_ext2_inter_affine_merge = false;
+  static constexpr bool disable_ext2_inter_affine_mvp = false;
+  static constexpr bool disable_ext2_inter_bipred_l1_mvd_zero = false;
+  static constexpr bool disable_ext2_inter_high_precision_mv = false;
+  static constexpr bool disable_ext2_inter_local_illumination_comp = false;
+  static constexpr bool disable_ext2_transform_skip = false;
+  static constexpr bool disable_ext2_transform_high_precision = false;
+  static constexpr bool disable_ext2_transform_select = false;
+  static constexpr bool disable_ext2_transform_dst = false;
+  static constexpr bool disable_ext2_cabac_alt_residual_ctx = false;
+
+private:
+  static const NoRestrictions instance;
+};
+
 }   // namespace xvc
 
 #endif  // XVC_COMMON_LIB_RESTRICTIONS_H_
@@ -27,6 +27,7 @@
 #include <memory>
 
 #include "xvc_common_lib/common.h"
+#include "xvc_common_lib/picture_allocator.h"
 #include "xvc_common_lib/utils.h"
 
 namespace xvc {
@@ -204,14 +205,16 @@ public:
 
 class CoeffCtuBuffer {
 public:
-  CoeffCtuBuffer(int chroma_shift_x, int chroma_shift_y) :
+  CoeffCtuBuffer(int chroma_shift_x, int chroma_shift_y,
+                 const PictureAllocator &allocator = PictureAllocator()) :
     // For getting relative position within CTU
     pos_mask_x_({ { constants::kMaxBlockSize - 1,
                 (constants::kMaxBlockSize >> chroma_shift_x) - 1,
                 (constants::kMaxBlockSize >> chroma_shift_x) - 1 } }),
     pos_mask_y_({ { constants::kMaxBlockSize - 1,
                 (constants::kMaxBlockSize >> chroma_shift_y) - 1,
-                (constants::kMaxBlockSize >> chroma_shift_y) - 1 } }) {
+                (constants::kMaxBlockSize >> chroma_shift_y) - 1 } }),
+    storage_(allocator, kCompSize * constants::kMaxYuvComponents) {
   }
   CoeffCtuBuffer(const CoeffCtuBuffer&) = delete;
   CoeffCtuBuffer(const CoeffCtuBuffer&&) = delete;
@@ -220,23 +223,25 @@ public:
   CoeffBuffer GetBuffer(YuvComponent comp, int posx, int posy) {
     posx = posx & pos_mask_x_[static_cast<int>(comp)];
     posy = posy & pos_mask_y_[static_cast<int>(comp)];
-    Coeff *data = &comp_storage_[static_cast<int>(comp)][0];
+    Coeff *data = storage_.data() + static_cast<int>(comp) * kCompSize;
     return CoeffBuffer(data + posy * kStride + posx, kStride);
   }
   DataBuffer<const Coeff> GetBuffer(YuvComponent comp,
                                     int posx, int posy) const {
     posx = posx & pos_mask_x_[static_cast<int>(comp)];
     posy = posy & pos_mask_y_[static_cast<int>(comp)];
-    const Coeff *data = &comp_storage_[static_cast<int>(comp)][0];
+    const Coeff *data =
+      storage_.data() + static_cast<int>(comp) * kCompSize;
     return DataBuffer<const Coeff>(data + posy * kStride + posx, kStride);
   }
 
 private:
   static const int kStride = constants::kMaxBlockSize;
+  static const int kCompSize = constants::kMaxBlockSamples * kStride;
   std::array<int, constants::kMaxYuvComponents> pos_mask_x_;
   std::array<int, constants::kMaxYuvComponents> pos_mask_y_;
-  std::array<std::array<Coeff, constants::kMaxBlockSamples * kStride>,
-    constants::kMaxYuvComponents> comp_storage_;
+  // Aligned storage for all components, kCompSize coefficients each
+  AlignedBuffer<Coeff> storage_;
 };
 
 }   // namespace xvc
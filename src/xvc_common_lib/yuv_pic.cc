@@ -31,11 +31,16 @@ namespace xvc {
 
 YuvPicture::YuvPicture(ChromaFormat chroma_fmt, int width, int height,
                        int bitdepth, bool padding, int crop_width,
-                       int crop_height)
+                       int crop_height, const PictureAllocator &allocator)
   : chroma_format_(chroma_fmt),
   bitdepth_(bitdepth),
   crop_width_(crop_width),
   crop_height_(crop_height) {
+  const int kAlignSamples =
+    static_cast<int>(PictureAllocator::kAlignment / sizeof(Sample));
+  auto align = [kAlignSamples](int size) {
+    return (size + kAlignSamples - 1) & ~(kAlignSamples - 1);
+  };
   int offset_x = padding ? (constants::kMaxBlockSize + 16) : 0;
   int offset_y = padding ? (constants::kMaxBlockSize + 16) : 0;
   width_[0] = width;
@@ -50,23 +55,51 @@ YuvPicture::YuvPicture(ChromaFormat chroma_fmt, int width, int height,
   }
   size_t total_size_w_padding = 0;
   for (int c = 0; c < constants::kMaxYuvComponents; c++) {
-    stride_[c] = width_[c] +
-      (util::ScaleSizeX(offset_x, chroma_fmt, YuvComponent(c)) << 1);
+    // Left padding is extended so that the first sample of each row is
+    // aligned, any extra width is given to the right padding
+    offset_x_[c] =
+      align(util::ScaleSizeX(offset_x, chroma_fmt, YuvComponent(c)));
+    stride_[c] = align(width_[c] + (offset_x_[c] << 1));
     total_height_[c] = height_[c] +
       (util::ScaleSizeY(offset_x, chroma_fmt, YuvComponent(c)) << 1);
     total_size_w_padding += stride_[c] * total_height_[c];
   }
-  sample_buffer_.resize(total_size_w_padding);
+  sample_buffer_ = AlignedBuffer<Sample>(allocator, total_size_w_padding);
+  if (total_size_w_padding > 0) {
+    std::memset(sample_buffer_.data(), 0,
+                total_size_w_padding * sizeof(Sample));
+  }
   bool not_empty = width != 0 && height != 0;
-  Sample *start_ptr = not_empty ? &sample_buffer_[0] : nullptr;
+  Sample *start_ptr = not_empty ? sample_buffer_.data() : nullptr;
   for (int c = 0; c < constants::kMaxYuvComponents; c++) {
-    int comp_offset_x = util::ScaleSizeX(offset_x, chroma_fmt, YuvComponent(c));
     int comp_offset_y = util::ScaleSizeY(offset_y, chroma_fmt, YuvComponent(c));
-    comp_pel_[c] = start_ptr + stride_[c] * comp_offset_y + comp_offset_x;
+    comp_pel_[c] = start_ptr + stride_[c] * comp_offset_y + offset_x_[c];
     start_ptr += total_height_[c] * stride_[c];
   }
 }
 
+YuvPicture::YuvPicture(ChromaFormat chroma_fmt, int width, int height,
+                       int bitdepth,
+                       Sample *const planes[constants::kMaxYuvComponents],
+                       const ptrdiff_t strides[constants::kMaxYuvComponents])
+  : chroma_format_(chroma_fmt),
+  bitdepth_(bitdepth),
+  crop_width_(0),
+  crop_height_(0) {
+  const int num_components = util::GetNumComponents(chroma_fmt);
+  for (int c = 0; c < constants::kMaxYuvComponents; c++) {
+    const YuvComponent comp = YuvComponent(c);
+    width_[c] = util::ScaleSizeX(width, chroma_fmt, comp);
+    height_[c] = util::ScaleSizeY(height, chroma_fmt, comp);
+    shiftx_[c] = c == 0 ? 0 : util::GetChromaShiftX(chroma_fmt);
+    shifty_[c] = c == 0 ? 0 : util::GetChromaShiftY(chroma_fmt);
+    offset_x_[c] = 0;
+    total_height_[c] = height_[c];
+    stride_[c] = c < num_components ? strides[c] : 0;
+    comp_pel_[c] = c < num_components ? planes[c] : nullptr;
+  }
+}
+
 int YuvPicture::GetDisplayWidth(YuvComponent comp) const {
   return util::ScaleSizeX(width_[0] - crop_width_, chroma_format_, comp);
 }
@@ -120,7 +153,8 @@ void YuvPicture::PadBorder() {
     return;
   }
   for (int c = 0; c < constants::kMaxYuvComponents; c++) {
-    int offset_x = static_cast<int>((stride_[c] - width_[c]) >> 1);
+    int offset_x = offset_x_[c];
+    int offset_right = static_cast<int>(stride_[c]) - width_[c] - offset_x;
     int offset_y = static_cast<int>((total_height_[c] - height_[c]) >> 1);
     // Top
     Sample *row = comp_pel_[c];
@@ -141,7 +175,7 @@ void YuvPicture::PadBorder() {
         row[x] = left;
       }
       Sample right = row[width_[c] - 1];
-      for (int x = 0; x < offset_x; x++) {
+      for (int x = 0; x < offset_right; x++) {
         row[width_[c] + x] = right;
       }
       row += stride_[c];
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "xvc_common_lib/common.h"
+#include "xvc_common_lib/picture_allocator.h"
 #include "xvc_common_lib/sample_buffer.h"
 
 namespace xvc {
@@ -52,12 +53,21 @@ struct PictureFormat {
 class YuvPicture {
 public:
   YuvPicture(const PictureFormat &pic_fmt, bool padding,
-             int crop_width, int crop_height)
+             int crop_width, int crop_height,
+             const PictureAllocator &allocator = PictureAllocator())
     : YuvPicture(pic_fmt.chroma_format, pic_fmt.width, pic_fmt.height,
-                 pic_fmt.bitdepth, padding, crop_width, crop_height) {
+                 pic_fmt.bitdepth, padding, crop_width, crop_height,
+                 allocator) {
   }
+  // Plane origins and strides are aligned to PictureAllocator::kAlignment
   YuvPicture(ChromaFormat chroma_format, int width, int height, int bitdepth,
-             bool padding, int crop_width, int crop_height);
+             bool padding, int crop_width, int crop_height,
+             const PictureAllocator &allocator = PictureAllocator());
+  // Wraps externally owned planes without copy, samples are not padded and
+  // must outlive the picture. Strides are given in samples.
+  YuvPicture(ChromaFormat chroma_format, int width, int height, int bitdepth,
+             Sample *const planes[constants::kMaxYuvComponents],
+             const ptrdiff_t strides[constants::kMaxYuvComponents]);
 
   int GetWidth(YuvComponent comp) const { return width_[comp]; }
   int GetHeight(YuvComponent comp) const { return height_[comp]; }
@@ -96,10 +106,11 @@ private:
   int total_height_[constants::kMaxYuvComponents];
   int shiftx_[constants::kMaxYuvComponents];
   int shifty_[constants::kMaxYuvComponents];
+  int offset_x_[constants::kMaxYuvComponents];
   int bitdepth_;
   int crop_width_;
   int crop_height_;
-  std::vector<Sample> sample_buffer_;
+  AlignedBuffer<Sample> sample_buffer_;
   Sample *comp_pel_[constants::kMaxYuvComponents];
 };
 
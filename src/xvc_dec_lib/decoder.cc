@@ -21,6 +21,7 @@
 
 #include "xvc_dec_lib/decoder.h"
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 
@@ -45,16 +46,31 @@ Decoder::Decoder(int num_threads)
   }
 }
 
+void Decoder::SetMaxMemory(size_t max_bytes) {
+  max_memory_bytes_ = max_bytes;
+  if (max_sliding_window_length_ > 0) {
+    ApplyMemoryBudget(*curr_segment_header_);
+    ReleaseUnusedPictureDecoders(0);
+  }
+}
+
 Decoder::~Decoder() {
   if (thread_decoder_) {
     thread_decoder_->StopAll();
   }
+  // Pictures output without copy refer to buffers owned by this decoder
+  assert(pinned_output_pics_.empty());
 }
 
 size_t Decoder::DecodeNal(const uint8_t *nal_unit, size_t nal_unit_size,
                           int64_t user_data) {
+  NalBuffer nal_buffer(nal_unit, nal_unit_size);
+  return DecodeNal(&nal_buffer, user_data);
+}
+
+size_t Decoder::DecodeNal(NalBuffer *nal_buffer, int64_t user_data) {
   // Nal header parsing
-  BitReader bit_reader(nal_unit, nal_unit_size);
+  BitReader bit_reader(nal_buffer->data(), nal_buffer->size());
   NalUnitType nal_unit_type;
   if (!ParseNalUnitHeader(&bit_reader, &nal_unit_type, accept_xvc_bit_zero_)) {
     return kInvalidNal;
@@ -76,7 +92,7 @@ size_t Decoder::DecodeNal(const uint8_t *nal_unit, size_t nal_unit_size,
   }
   if (nal_unit_type >= NalUnitType::kIntraPicture &&
       nal_unit_type <= NalUnitType::kReservedPictureType10) {
-    return DecodePictureNal(nal_unit, nal_unit_size, user_data, &bit_reader);
+    return DecodePictureNal(nal_buffer, user_data, &bit_reader);
   }
   return kInvalidNal;   // unknown nal type
 }
@@ -152,12 +168,11 @@ size_t Decoder::DecodeSegmentHeaderNal(BitReader *bit_reader) {
     return kInvalidNal;
   }
   sub_gop_length_ = curr_segment_header_->max_sub_gop_length;
-  if (sub_gop_length_ + 1 > sliding_window_length_) {
-    sliding_window_length_ = additional_decoder_buffers_ +
+  if (sub_gop_length_ + 1 > max_sliding_window_length_) {
+    max_sliding_window_length_ = additional_decoder_buffers_ +
       sub_gop_length_ + 1 + (thread_decoder_ ? 1 : 0);
   }
-  pic_buffering_num_ =
-    sliding_window_length_ + curr_segment_header_->num_ref_pics;
+  ApplyMemoryBudget(*curr_segment_header_);
 
   if (output_pic_format_.width == 0) {
     output_pic_format_.width = curr_segment_header_->GetOutputWidth();
@@ -179,8 +194,9 @@ size_t Decoder::DecodeSegmentHeaderNal(BitReader *bit_reader) {
   return bit_reader->GetPosition();
 }
 
-size_t Decoder::DecodePictureNal(const uint8_t * nal_unit, size_t nal_unit_size,
-                                 int64_t user_data, BitReader *bit_reader) {
+size_t Decoder::DecodePictureNal(NalBuffer *nal_buffer, int64_t user_data,
+                                 BitReader *bit_reader) {
+  const size_t nal_unit_size = nal_buffer->size();
   // All picture types are decoded using the same process.
   // First, the buffer flag is checked to see if the picture
   // should be decoded or buffered.
@@ -203,8 +219,7 @@ size_t Decoder::DecodePictureNal(const uint8_t * nal_unit, size_t nal_unit_size,
   enforce_sliding_window_ = true;
   num_pics_in_buffer_++;
 
-  NalUnitPtr nal_element(new std::vector<uint8_t>(&nal_unit[0], &nal_unit[0]
-                                                  + nal_unit_size));
+  NalBuffer nal_element = nal_buffer->Retain();
   if (buffer_flag == 0 && num_tail_pics_ > 0) {
     nal_buffer_.push_front({ std::move(nal_element), user_data });
   } else {
@@ -227,8 +242,8 @@ size_t Decoder::DecodePictureNal(const uint8_t * nal_unit, size_t nal_unit_size,
 }
 
 void
-Decoder::DecodeOneBufferedNal(NalUnitPtr &&nal, int64_t user_data) {
-  BitReader pic_bit_reader(&(*nal)[0], nal->size());
+Decoder::DecodeOneBufferedNal(NalBuffer &&nal, int64_t user_data) {
+  BitReader pic_bit_reader(nal.data(), nal.size());
   std::shared_ptr<SegmentHeader> segment_header = curr_segment_header_;
   std::shared_ptr<SegmentHeader> prev_segment_header = prev_segment_header_;
 
@@ -294,8 +309,9 @@ Decoder::DecodeOneBufferedNal(NalUnitPtr &&nal, int64_t user_data) {
   }
 
   // Setup poc and output status on main thread
+  pic_dec->SetDeferredOutput(deferred_output_);
   pic_dec->Init(*segment_header, pic_header, std::move(ref_pic_list),
-                output_pic_format_, user_data);
+                output_pic_format_, zero_copy_output_, user_data);
 
   // Special handling of inter dependency ref counting for lowest layer
   if (pic_header.tid == 0) {
@@ -406,15 +422,39 @@ bool Decoder::GetDecodedPicture(xvc_decoded_picture *output_pic) {
 
   pic_dec->SetOutputStatus(OutputStatus::kHasBeenOutput);
   SetOutputStats(pic_dec, output_pic);
+  if (pic_dec->HasDirectOutput()) {
+    // Reference the reconstructed picture until released by application
+    std::shared_ptr<const YuvPicture> rec_pic = pic_dec->GetRecPic();
+    pinned_output_pics_.push_back(rec_pic);
+    const int num_components =
+      util::GetNumComponents(rec_pic->GetChromaFormat());
+    output_pic->size = 0;
+    output_pic->bytes = nullptr;
+    for (int c = 0; c < constants::kMaxYuvComponents; c++) {
+      const YuvComponent comp = YuvComponent(c);
+      output_pic->planes[c] = c >= num_components ? nullptr :
+        reinterpret_cast<const char *>(rec_pic->GetSamplePtr(comp, 0, 0));
+      output_pic->stride[c] = c >= num_components ? 0 :
+        static_cast<int>(rec_pic->GetStride(comp) * sizeof(Sample));
+    }
+    num_pics_in_buffer_--;
+    return true;
+  }
   const int sample_size = output_pic_format_.bitdepth == 8 ? 1 : 2;
   // TODO(PH) Potential dangerous race-condition, the output_pic->bytes will
   // be modified concurrently when pic_dec is assigned a new nal to decode,
   // so we don't do that until next call to 'decoder_decode_nal'
-  const std::vector<uint8_t> &output_pic_bytes =
-    pic_dec->GetOutputPictureBytes();
-  output_pic->size = output_pic_bytes.size();
-  output_pic->bytes = output_pic_bytes.empty() ? nullptr :
-    reinterpret_cast<const char *>(&output_pic_bytes[0]);
+  const std::vector<uint8_t> *output_pic_bytes =
+    &pic_dec->GetOutputPictureBytes();
+  if (pic_dec->HasDeferredOutput()) {
+    memory_counters_.output_pics -= output_pic_bytes_.capacity();
+    pic_dec->ConvertOutput(&output_pic_bytes_);
+    memory_counters_.output_pics += output_pic_bytes_.capacity();
+    output_pic_bytes = &output_pic_bytes_;
+  }
+  output_pic->size = output_pic_bytes->size();
+  output_pic->bytes = output_pic_bytes->empty() ? nullptr :
+    reinterpret_cast<const char *>(output_pic_bytes->data());
   output_pic->planes[0] = output_pic->bytes;
   output_pic->stride[0] = output_pic_format_.width * sample_size;
   output_pic->planes[1] =
@@ -432,13 +472,24 @@ bool Decoder::GetDecodedPicture(xvc_decoded_picture *output_pic) {
   return true;
 }
 
+bool Decoder::ReleaseDecodedPicture(const xvc_decoded_picture *dec_pic) {
+  for (auto it = pinned_output_pics_.begin();
+       it != pinned_output_pics_.end(); ++it) {
+    if (reinterpret_cast<const char *>((*it)->GetSamplePtr(kY, 0, 0)) ==
+        dec_pic->planes[0]) {
+      pinned_output_pics_.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
 std::shared_ptr<PictureDecoder>
 Decoder::GetFreePictureDecoder(const SegmentHeader &segment) {
+  // Keep one unused picture for decoding into
+  ReleaseUnusedPictureDecoders(1);
   if (pic_decoders_.size() < pic_buffering_num_) {
-    auto pic =
-      std::make_shared<PictureDecoder>(simd_, segment.GetInternalPicFormat(),
-                                       segment.GetCropWidth(),
-                                       segment.GetCropHeight());
+    auto pic = CreatePictureDecoder(segment);
     pic_decoders_.push_back(pic);
     return pic;
   }
@@ -449,8 +500,7 @@ Decoder::GetFreePictureDecoder(const SegmentHeader &segment) {
     // A picture decoder has two independent variables that indicates usage
     // 1. output status - if decoded samples has been sent to application
     // 2. ref count - if picture is no longer referenced by any other pictures
-    if ((*it)->IsReferenced() ||
-      (*it)->GetOutputStatus() != OutputStatus::kHasBeenOutput) {
+    if (!IsUnused(**it)) {
       continue;
     }
     if ((*it)->GetPicData()->GetPoc() < best_poc) {
@@ -470,13 +520,104 @@ Decoder::GetFreePictureDecoder(const SegmentHeader &segment) {
       pic_data->GetPictureHeight(YuvComponent::kY) ||
       segment.chroma_format != pic_data->GetChromaFormat() ||
       segment.internal_bitdepth != pic_data->GetBitdepth()) {
-    pic_dec_it->reset(new PictureDecoder(simd_, segment.GetInternalPicFormat(),
-                                         segment.GetCropWidth(),
-                                         segment.GetCropHeight()));
+    // Release the old picture first so that its buffers can be recycled
+    pic_dec_it->reset();
+    *pic_dec_it = CreatePictureDecoder(segment);
+  } else if (!pinned_output_pics_.empty()) {
+    // Decode into a new buffer if the application still holds the picture
+    std::shared_ptr<const YuvPicture> rec_pic = (*pic_dec_it)->GetRecPic();
+    if (std::find(pinned_output_pics_.begin(), pinned_output_pics_.end(),
+                  rec_pic) != pinned_output_pics_.end()) {
+      (*pic_dec_it)->ReallocateRecPic();
+    }
   }
   return *pic_dec_it;
 }
 
+bool Decoder::IsUnused(const PictureDecoder &pic_dec) {
+  return !pic_dec.IsReferenced() &&
+    pic_dec.GetOutputStatus() == OutputStatus::kHasBeenOutput;
+}
+
+void Decoder::ReleaseUnusedPictureDecoders(int num_kept) {
+  // Only needed after the buffering has been reduced by a memory limit
+  auto it = pic_decoders_.begin();
+  while (it != pic_decoders_.end() &&
+         pic_decoders_.size() > pic_buffering_num_) {
+    if (!IsUnused(**it) || num_kept > 0) {
+      num_kept -= IsUnused(**it) ? 1 : 0;
+      ++it;
+    } else {
+      it = pic_decoders_.erase(it);
+    }
+  }
+}
+
+std::shared_ptr<PictureDecoder>
+Decoder::CreatePictureDecoder(const SegmentHeader &segment) {
+  auto pic =
+    std::make_shared<PictureDecoder>(simd_, segment.GetInternalPicFormat(),
+                                     segment.GetCropWidth(),
+                                     segment.GetCropHeight(),
+                                     picture_allocator_, &memory_counters_);
+  pic->SetRetainAlternativeRecPic(max_memory_bytes_ == 0);
+  // Coding data is only held while a picture is being decoded and is left
+  // out of the estimate of a buffered picture
+  const size_t rec_pic_bytes =
+    pic->GetRecPic()->GetTotalSamples() * sizeof(Sample);
+  const size_t output_bytes = zero_copy_output_ ? 0 :
+    util::GetTotalNumSamples(output_pic_format_.width,
+                             output_pic_format_.height,
+                             output_pic_format_.chroma_format) *
+    (output_pic_format_.bitdepth == 8 ? 1 : 2);
+  if (rec_pic_bytes != rec_pic_bytes_ || output_bytes != output_bytes_) {
+    rec_pic_bytes_ = rec_pic_bytes;
+    output_bytes_ = output_bytes;
+    ApplyMemoryBudget(segment);
+  }
+  return pic;
+}
+
+void Decoder::ApplyMemoryBudget(const SegmentHeader &segment) {
+  // Start over from the unlimited buffering since the budget may have grown
+  const PicNum num_ref_pics = segment.num_ref_pics;
+  const PicNum max_num_pics = max_sliding_window_length_ + num_ref_pics;
+  sliding_window_length_ = max_sliding_window_length_;
+  pic_buffering_num_ = max_num_pics;
+  deferred_output_ = false;
+  if (max_memory_bytes_ == 0 || rec_pic_bytes_ == 0 ||
+      max_num_pics * (rec_pic_bytes_ + output_bytes_) <= max_memory_bytes_) {
+    return;
+  }
+  // Convert to output format on demand into a single buffer instead
+  deferred_output_ = output_bytes_ > 0;
+  const size_t available_bytes = max_memory_bytes_ > output_bytes_ ?
+    max_memory_bytes_ - output_bytes_ : 0;
+  // The pictures of one sub gop and their references must always fit,
+  // only the additional output buffering can be given up
+  const PicNum min_num_pics = segment.max_sub_gop_length + 1 +
+    (thread_decoder_ ? 1 : 0) + num_ref_pics;
+  const PicNum num_pics =
+    util::Clip3<PicNum>(available_bytes / rec_pic_bytes_, min_num_pics,
+                        std::max(min_num_pics, max_num_pics));
+  sliding_window_length_ = num_pics - num_ref_pics;
+  pic_buffering_num_ = num_pics;
+}
+
+void Decoder::GetMemoryUsage(xvc_dec_memory_usage *usage) const {
+  usage->reconstructed_pictures = memory_counters_.rec_pics;
+  usage->alternative_pictures = memory_counters_.alt_rec_pics;
+  usage->picture_data = memory_counters_.pic_data;
+  usage->output_pictures = memory_counters_.output_pics;
+  usage->nal_units = 0;
+  for (auto &nal : nal_buffer_) {
+    usage->nal_units += nal.first.GetAllocatedBytes();
+  }
+  usage->total = usage->reconstructed_pictures + usage->alternative_pictures +
+    usage->picture_data + usage->output_pictures + usage->nal_units;
+  usage->pooled = PictureAllocator::GetPooledBytes();
+}
+
 void Decoder::OnPictureDecoded(std::shared_ptr<PictureDecoder> pic_dec,
                                bool success, const PicDecList &inter_deps) {
   pic_dec->SetOutputStatus(OutputStatus::kHasNotBeenOutput);
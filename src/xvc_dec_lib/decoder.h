@@ -34,10 +34,26 @@
 #include "xvc_common_lib/segment_header.h"
 #include "xvc_common_lib/simd_functions.h"
 #include "xvc_dec_lib/bit_reader.h"
+#include "xvc_dec_lib/nal_buffer.h"
 #include "xvc_dec_lib/picture_decoder.h"
 #include "xvc_dec_lib/xvcdec.h"
 
-struct xvc_decoder {};
+// Api handle. When the 8bit sample pipeline is compiled in, the handle only
+// routes the calls, either to the 8bit pipeline decoder if the first decoded
+// segment header is 8bit or else to the 16bit decoder. The 16bit decoder is
+// created on demand and takes over if a later segment is of higher bitdepth.
+// Open gop tail pictures buffered by the 8bit decoder at such a switch can
+// not be decoded and are reported as lost.
+// Without the 8bit pipeline the handle is the decoder itself.
+struct xvc_decoder {
+  xvc_decoder *lowbd_delegate = nullptr;
+  xvc_decoder *lib_decoder = nullptr;
+  xvc_decoder_parameters params;
+  bool pipeline_selected = false;
+  bool lowbd_draining = false;
+  bool lowbd_open_gop = false;
+  int lowbd_num_tail_pics = 0;
+};
 
 namespace xvc {
 
@@ -61,7 +77,12 @@ public:
   ~Decoder();
   size_t DecodeNal(const uint8_t *nal_unit, size_t nal_unit_size,
                    int64_t user_data = 0);
+  // Decode nal unit, picture data is moved from nal_buffer without copy
+  // unless the buffer is borrowed
+  size_t DecodeNal(NalBuffer *nal_buffer, int64_t user_data = 0);
   bool GetDecodedPicture(xvc_decoded_picture *dec_pic);
+  // Release a picture that was output without copy
+  bool ReleaseDecodedPicture(const xvc_decoded_picture *dec_pic);
   void FlushBufferedNalUnits();
   PicNum GetNumDecodedPics() { return num_pics_in_buffer_; }
   PicNum HasPictureReadyForOutput() {
@@ -92,19 +113,35 @@ public:
     return xvc_dec_chroma_format(curr_segment_header_->chroma_format);
   }
   void SetDithering(bool dither) { output_pic_format_.dither = dither; }
+  void SetPictureAllocator(const PictureAllocator &allocator) {
+    picture_allocator_ = allocator;
+  }
+  // Output reconstructed pictures without copy when the output format
+  // matches the internal format, pictures must then be released explicitly
+  // before the decoder is destroyed
+  void SetZeroCopyOutput(bool zero_copy) { zero_copy_output_ = zero_copy; }
+  // Limit memory usage by reducing optional picture buffering, 0 for none.
+  // A new limit also applies to the current segment
+  void SetMaxMemory(size_t max_bytes);
+  void GetMemoryUsage(xvc_dec_memory_usage *usage) const;
   static bool ParseNalUnitHeader(BitReader *reader, NalUnitType *nal_unit_type,
                                  bool accept_xvc_bit_zero);
 
 private:
-  using NalUnitPtr = std::unique_ptr<std::vector<uint8_t>>;
   using PicDecList = std::vector<std::shared_ptr<const PictureDecoder>>;
   void DecodeAllBufferedNals();
   size_t DecodeSegmentHeaderNal(BitReader *bit_reader);
-  size_t DecodePictureNal(const uint8_t *nal_unit, size_t nal_unit_size,
-                          int64_t user_data, BitReader *bit_reader);
-  void DecodeOneBufferedNal(NalUnitPtr &&nal, int64_t user_data);
+  size_t DecodePictureNal(NalBuffer *nal_buffer, int64_t user_data,
+                          BitReader *bit_reader);
+  void DecodeOneBufferedNal(NalBuffer &&nal, int64_t user_data);
   std::shared_ptr<PictureDecoder>
     GetFreePictureDecoder(const SegmentHeader &segment_header);
+  std::shared_ptr<PictureDecoder>
+    CreatePictureDecoder(const SegmentHeader &segment_header);
+  void ApplyMemoryBudget(const SegmentHeader &segment_header);
+  static bool IsUnused(const PictureDecoder &pic_dec);
+  // Releases unused pictures beyond the current buffering, except num_kept
+  void ReleaseUnusedPictureDecoders(int num_kept);
   void OnPictureDecoded(std::shared_ptr<PictureDecoder> pic_dec, bool success,
                         const PicDecList &inter_deps);
   void SetOutputStats(std::shared_ptr<PictureDecoder> pic_dec,
@@ -118,6 +155,8 @@ private:
   std::shared_ptr<SegmentHeader> prev_segment_header_;
   PicNum num_pics_in_buffer_ = 0;
   PicNum num_corrupted_pics_ = 0;
+  // Sliding window without memory limit and as reduced by the limit
+  PicNum max_sliding_window_length_ = 0;
   PicNum sliding_window_length_ = 0;
   PicNum pic_buffering_num_ = 0;
   PicNum additional_decoder_buffers_ = 0;
@@ -128,13 +167,28 @@ private:
   bool enforce_sliding_window_ = true;
   State state_ = State::kNoSegmentHeader;
   SimdFunctions simd_;
+  // Declared before any picture so that buffers freed on destruction are
+  // still pooled for other instances
+  BufferPoolReference buffer_pool_reference_;
+  PictureAllocator picture_allocator_;
   PictureFormat output_pic_format_;
+  // Must outlive all picture decoders and pictures
+  PictureDecoder::MemoryCounters memory_counters_;
+  size_t max_memory_bytes_ = 0;
+  // Estimated size of one buffered picture and of its output conversion
+  size_t rec_pic_bytes_ = 0;
+  size_t output_bytes_ = 0;
+  // Output conversion shared by all pictures when memory is limited
+  bool deferred_output_ = false;
   std::vector<uint8_t> output_pic_bytes_;
   std::vector<std::shared_ptr<PictureDecoder>> pic_decoders_;
+  // Pictures output without copy that are still held by the application
+  std::vector<std::shared_ptr<const YuvPicture>> pinned_output_pics_;
   std::list<std::shared_ptr<PictureDecoder>> zero_tid_pic_dec_;
-  std::deque<std::pair<NalUnitPtr, int64_t>> nal_buffer_;
+  std::deque<std::pair<NalBuffer, int64_t>> nal_buffer_;
   std::unique_ptr<ThreadDecoder> thread_decoder_;
   bool accept_xvc_bit_zero_ = true;
+  bool zero_copy_output_ = false;
 };
 
 }   // namespace xvc
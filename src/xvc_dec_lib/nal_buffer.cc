@@ -0,0 +1,76 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include "xvc_dec_lib/nal_buffer.h"
+
+#include <cassert>
+#include <utility>
+
+namespace xvc {
+
+NalBuffer& NalBuffer::operator=(NalBuffer &&other) noexcept {
+  if (this != &other) {
+    Release();
+    // Moving the vector keeps its heap storage so data_ remains valid
+    storage_ = std::move(other.storage_);
+    data_ = other.data_;
+    size_ = other.size_;
+    base_ = other.base_;
+    release_ = other.release_;
+    opaque_ = other.opaque_;
+    borrowed_ = other.borrowed_;
+    other.storage_.clear();
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.base_ = nullptr;
+    other.release_ = nullptr;
+    other.opaque_ = nullptr;
+    other.borrowed_ = false;
+  }
+  return *this;
+}
+
+void NalBuffer::Skip(size_t bytes) {
+  assert(bytes <= size_);
+  data_ += bytes;
+  size_ -= bytes;
+}
+
+NalBuffer NalBuffer::Retain() {
+  if (!borrowed_) {
+    return std::move(*this);
+  }
+  NalBuffer copy;
+  copy.storage_.assign(data_, data_ + size_);
+  copy.data_ = copy.storage_.empty() ? nullptr : &copy.storage_[0];
+  copy.size_ = size_;
+  return copy;
+}
+
+void NalBuffer::Release() {
+  if (release_) {
+    release_(opaque_, base_);
+    release_ = nullptr;
+  }
+}
+
+}   // namespace xvc
@@ -0,0 +1,86 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#ifndef XVC_DEC_LIB_NAL_BUFFER_H_
+#define XVC_DEC_LIB_NAL_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xvc {
+
+// Nal unit data that is either borrowed for the duration of a decoder call,
+// owned by the decoder as a private copy or held by reference to
+// application memory that is returned through a release function once the
+// decoder no longer needs it.
+class NalBuffer {
+public:
+  using ReleaseFunc = void(*)(void *opaque, const uint8_t *nal_unit);
+
+  NalBuffer() = default;
+  // Borrowed data, only valid until the current decoder call returns
+  NalBuffer(const uint8_t *nal_unit, size_t nal_unit_size)
+    : data_(nal_unit),
+    size_(nal_unit_size),
+    borrowed_(true) {
+  }
+  // Application data, release is invoked exactly once when no longer used
+  NalBuffer(const uint8_t *nal_unit, size_t nal_unit_size,
+            ReleaseFunc release, void *opaque)
+    : data_(nal_unit),
+    size_(nal_unit_size),
+    base_(nal_unit),
+    release_(release),
+    opaque_(opaque) {
+  }
+  NalBuffer(NalBuffer &&other) noexcept { *this = std::move(other); }
+  NalBuffer(const NalBuffer&) = delete;
+  ~NalBuffer() { Release(); }
+  NalBuffer& operator=(NalBuffer &&other) noexcept;
+  NalBuffer& operator=(const NalBuffer&) = delete;
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  // Bytes of the private copy, zero for borrowed or application data
+  size_t GetAllocatedBytes() const { return storage_.capacity(); }
+  // Skips the first bytes, e.g. after a segment header has been parsed
+  void Skip(size_t bytes);
+  // Returns a buffer that stays valid after the current decoder call,
+  // borrowed data is copied while referenced data is moved without copy
+  NalBuffer Retain();
+
+private:
+  void Release();
+
+  std::vector<uint8_t> storage_;
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  const uint8_t *base_ = nullptr;
+  ReleaseFunc release_ = nullptr;
+  void *opaque_ = nullptr;
+  bool borrowed_ = false;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_DEC_LIB_NAL_BUFFER_H_
@@ -36,17 +36,40 @@
 
 namespace xvc {
 
+// Same allocator, accounting allocations to the given counter
+static PictureAllocator
+CountedAllocator(const PictureAllocator &allocator,
+                 std::atomic<size_t> *counter) {
+  PictureAllocator counted = allocator;
+  counted.allocated_bytes = counter;
+  return counted;
+}
+
 PictureDecoder::PictureDecoder(const SimdFunctions &simd,
                                const PictureFormat &pic_fmt,
-                               int crop_width, int crop_height)
+                               int crop_width, int crop_height,
+                               const PictureAllocator &allocator,
+                               MemoryCounters *counters)
   : simd_(simd),
+  allocator_(CountedAllocator(
+    allocator, counters ? &counters->rec_pics : nullptr)),
+  alt_allocator_(CountedAllocator(
+    allocator, counters ? &counters->alt_rec_pics : nullptr)),
+  counters_(counters),
   output_resampler_(simd.resampler),
   output_format_(),
-  pic_data_(std::make_shared<PictureData>(pic_fmt.chroma_format, pic_fmt.width,
-                                          pic_fmt.height, pic_fmt.bitdepth)),
+  pic_data_(std::make_shared<PictureData>(
+    pic_fmt.chroma_format, pic_fmt.width, pic_fmt.height, pic_fmt.bitdepth,
+    CountedAllocator(allocator, counters ? &counters->pic_data : nullptr))),
   rec_pic_(std::make_shared<YuvPicture>(pic_fmt.chroma_format, pic_fmt.width,
                                         pic_fmt.height, pic_fmt.bitdepth, true,
-                                        crop_width, crop_height)) {
+                                        crop_width, crop_height, allocator_)) {
+}
+
+PictureDecoder::~PictureDecoder() {
+  if (counters_) {
+    counters_->output_pics -= output_pic_bytes_.capacity();
+  }
 }
 
 PictureDecoder::PicNalHeader
@@ -144,11 +167,22 @@ void PictureDecoder::Init(const SegmentHeader &segment,
                           const PicNalHeader &header,
                           ReferencePictureLists &&ref_pic_list,
                           const PictureFormat &output_pic_format,
-                          int64_t user_data) {
+                          bool allow_direct_output, int64_t user_data) {
   assert(output_status_ == OutputStatus::kHasBeenOutput);
   pic_qp_ = header.pic_qp;
   output_format_ = output_pic_format;
+  // Direct output requires that the internal sample layout is identical
+  const bool sample_size_match = (output_format_.bitdepth > 8) ==
+    (sizeof(Sample) > 1);
+  direct_output_ = allow_direct_output && sample_size_match &&
+    output_format_.width == rec_pic_->GetDisplayWidth(YuvComponent::kY) &&
+    output_format_.height == rec_pic_->GetDisplayHeight(YuvComponent::kY) &&
+    output_format_.chroma_format == rec_pic_->GetChromaFormat() &&
+    output_format_.bitdepth == rec_pic_->GetBitdepth();
   user_data_ = user_data;
+  if (!retain_alt_rec_pic_) {
+    alt_rec_pic_.reset();
+  }
   output_status_ = OutputStatus::kProcessing;
   ref_count = 0;
   pic_data_->SetNalType(header.nal_unit_type);
@@ -195,6 +229,8 @@ bool PictureDecoder::Decode(const SegmentHeader &segment,
     assert(0);
     success = false;
   }
+  cu_decoder.reset();
+  pic_data_->ReleaseCuTree();
   if (pic_data_->GetTid() == 0 || !pic_data_->IsHighestLayer()) {
     rec_pic_->PadBorder();
   }
@@ -218,10 +254,35 @@ bool PictureDecoder::Postprocess(const SegmentHeader &segment,
   } else {
     pic_hash_.clear();
   }
-  output_resampler_.ConvertTo(*rec_pic_, output_format_, &output_pic_bytes_);
+  const size_t output_capacity = output_pic_bytes_.capacity();
+  if (direct_output_) {
+    output_pic_bytes_.clear();
+  } else if (deferred_output_) {
+    std::vector<uint8_t>().swap(output_pic_bytes_);
+  } else {
+    output_resampler_.ConvertTo(*rec_pic_, output_format_, &output_pic_bytes_);
+  }
+  if (counters_) {
+    counters_->output_pics += output_pic_bytes_.capacity();
+    counters_->output_pics -= output_capacity;
+  }
   return success;
 }
 
+void PictureDecoder::ConvertOutput(std::vector<uint8_t> *out_bytes) {
+  output_resampler_.ConvertTo(*rec_pic_, output_format_, out_bytes);
+}
+
+void PictureDecoder::ReallocateRecPic() {
+  rec_pic_ =
+    std::make_shared<YuvPicture>(rec_pic_->GetChromaFormat(),
+                                 rec_pic_->GetWidth(YuvComponent::kY),
+                                 rec_pic_->GetHeight(YuvComponent::kY),
+                                 rec_pic_->GetBitdepth(), true,
+                                 rec_pic_->GetCropWidth(),
+                                 rec_pic_->GetCropHeight(), allocator_);
+}
+
 std::shared_ptr<YuvPicture>
 PictureDecoder::GetAlternativeRecPic(const PictureFormat &pic_fmt,
                                      int crop_width, int crop_height) const {
@@ -231,7 +292,7 @@ PictureDecoder::GetAlternativeRecPic(const PictureFormat &pic_fmt,
   auto alt_rec_pic =
     std::make_shared<YuvPicture>(pic_fmt.chroma_format, pic_fmt.width,
                                  pic_fmt.height, pic_fmt.bitdepth, true,
-                                 crop_width, crop_height);
+                                 crop_width, crop_height, alt_allocator_);
   // TODO(PH) Revise const_cast by making this function a pure getter?
   // In the future alternate pictures should probably be created
   // beforehand in a separate thread as this can be quite time consuming
@@ -267,7 +328,7 @@ PictureDecoder::GenerateAlternativeRecPic(
     alt_rec_pic =
       std::make_shared<YuvPicture>(pic_fmt.chroma_format, pic_fmt.width,
                                    pic_fmt.height, pic_fmt.bitdepth, true,
-                                   crop_width, crop_height);
+                                   crop_width, crop_height, alt_allocator_);
     const_cast<PictureDecoder*>(this)->alt_rec_pic_ = alt_rec_pic;
   }
   for (int c = 0; c < util::GetNumComponents(pic_fmt.chroma_format); c++) {
@@ -53,12 +53,23 @@ public:
     bool deblock;
     bool allow_lic;
   };
+  // Bytes currently allocated by the picture decoders of one decoder
+  struct MemoryCounters {
+    std::atomic<size_t> rec_pics{ 0 };
+    std::atomic<size_t> alt_rec_pics{ 0 };
+    std::atomic<size_t> pic_data{ 0 };
+    std::atomic<size_t> output_pics{ 0 };
+  };
 
   PictureDecoder(const SimdFunctions &simd, const PictureFormat &pic_format,
-                 int crop_width, int crop_height);
+                 int crop_width, int crop_height,
+                 const PictureAllocator &allocator = PictureAllocator(),
+                 MemoryCounters *counters = nullptr);
+  ~PictureDecoder();
   void Init(const SegmentHeader &segment, const PicNalHeader &header,
             ReferencePictureLists &&ref_pic_list,
-            const PictureFormat &output_pic_format, int64_t user_data);
+            const PictureFormat &output_pic_format, bool allow_direct_output,
+            int64_t user_data);
   bool Decode(const SegmentHeader &segment,
               const SegmentHeader &prev_segment_header, BitReader *bit_reader,
               bool post_process);
@@ -78,6 +89,18 @@ public:
   const std::vector<uint8_t>& GetOutputPictureBytes() const {
     return output_pic_bytes_;
   }
+  // Leave conversion to output format to the caller of ConvertOutput instead
+  // of keeping converted samples for every buffered picture
+  void SetDeferredOutput(bool deferred) { deferred_output_ = deferred; }
+  bool HasDeferredOutput() const { return deferred_output_ && !direct_output_; }
+  void ConvertOutput(std::vector<uint8_t> *out_bytes);
+  // Keep the alternative picture buffer when the decoder is reused
+  void SetRetainAlternativeRecPic(bool retain) { retain_alt_rec_pic_ = retain; }
+  // True if the reconstructed picture is output as is without conversion
+  bool HasDirectOutput() const { return direct_output_; }
+  // Replaces the reconstructed picture buffer, used when a previously output
+  // picture is still held by the application
+  void ReallocateRecPic();
   void SetIsConforming(bool conforming) { conforming_ = conforming; }
   bool GetIsConforming() const { return conforming_; }
   bool IsReferenced() const { return ref_count > 0; }
@@ -99,6 +122,9 @@ private:
                         BitReader *bit_reader, Checksum::Mode checksum_mode);
 
   const SimdFunctions &simd_;
+  PictureAllocator allocator_;
+  PictureAllocator alt_allocator_;
+  MemoryCounters *counters_;
   Resampler output_resampler_;
   PictureFormat output_format_;
   std::shared_ptr<PictureData> pic_data_;
@@ -107,6 +133,9 @@ private:
   std::vector<uint8_t> pic_hash_;
   std::vector<uint8_t> output_pic_bytes_;
   bool conforming_ = false;
+  bool direct_output_ = false;
+  bool deferred_output_ = false;
+  bool retain_alt_rec_pic_ = true;
   int pic_qp_ = -1;
   int64_t user_data_ = 0;
   std::atomic<OutputStatus> output_status_ = { OutputStatus::kHasBeenOutput };
@@ -32,18 +32,18 @@
 
 namespace xvc {
 
-template<typename Ctx>
-SyntaxReaderCabac<Ctx>::SyntaxReaderCabac(const Qp &qp,
-                                          PicturePredictionType pic_type,
-                                          BitReader *bit_reader)
+template<typename Ctx, typename R>
+SyntaxReaderCabac<Ctx, R>::SyntaxReaderCabac(const Qp &qp,
+                                             PicturePredictionType pic_type,
+                                             BitReader *bit_reader)
   : decoder_(bit_reader),
-  restrictions_(Restrictions::Get()) {
+  restrictions_(R::Get()) {
   ctx_.ResetStates(qp, pic_type);
   decoder_.Start();
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::Finish() {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::Finish() {
   if (!decoder_.DecodeBinTrm()) {
     return false;
   }
@@ -51,9 +51,9 @@ bool SyntaxReaderCabac<Ctx>::Finish() {
   return true;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadAffineFlag(const CodingUnit &cu,
-                                            bool is_merge) {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadAffineFlag(const CodingUnit &cu,
+                                               bool is_merge) {
   if (restrictions_.disable_ext2_inter_affine ||
     (is_merge && restrictions_.disable_ext2_inter_affine_merge)) {
     return false;
@@ -62,8 +62,9 @@ bool SyntaxReaderCabac<Ctx>::ReadAffineFlag(const CodingUnit &cu,
   return decoder_.DecodeBin(&ctx) != 0;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadCbf(const CodingUnit &cu, YuvComponent comp) {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadCbf(const CodingUnit &cu,
+                                        YuvComponent comp) {
   if (restrictions_.disable_transform_cbf) {
     return true;
   }
@@ -74,11 +75,12 @@ bool SyntaxReaderCabac<Ctx>::ReadCbf(const CodingUnit &cu, YuvComponent comp) {
   }
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
 int
-SyntaxReaderCabac<Ctx>::ReadCoefficients(const CodingUnit &cu,
-                                         YuvComponent comp, Coeff *dst_coeff,
-                                         ptrdiff_t dst_stride) {
+SyntaxReaderCabac<Ctx, R>::ReadCoefficients(const CodingUnit &cu,
+                                            YuvComponent comp,
+                                            Coeff *dst_coeff,
+                                            ptrdiff_t dst_stride) {
   if (cu.GetWidth(comp) == 2 || cu.GetHeight(comp) == 2) {
     return ReadCoeffSubblock<1>(cu, comp, dst_coeff, dst_stride);
   } else {
@@ -87,12 +89,13 @@ SyntaxReaderCabac<Ctx>::ReadCoefficients(const CodingUnit &cu,
   }
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
 template<int SubBlockShift>
 int
-SyntaxReaderCabac<Ctx>::ReadCoeffSubblock(const CodingUnit &cu,
-                                          YuvComponent comp, Coeff *dst_coeff,
-                                          ptrdiff_t dst_stride) {
+SyntaxReaderCabac<Ctx, R>::ReadCoeffSubblock(const CodingUnit &cu,
+                                             YuvComponent comp,
+                                             Coeff *dst_coeff,
+                                             ptrdiff_t dst_stride) {
   const int width = cu.GetWidth(comp);
   const int height = cu.GetHeight(comp);
   const int width_log2 = util::SizeToLog2(width);
@@ -360,14 +363,14 @@ SyntaxReaderCabac<Ctx>::ReadCoeffSubblock(const CodingUnit &cu,
   return total_num_sig_coeff;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadEndOfSlice() {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadEndOfSlice() {
   uint32_t bin = decoder_.DecodeBinTrm();
   return bin != 0;
 }
 
-template<typename Ctx>
-InterDir SyntaxReaderCabac<Ctx>::ReadInterDir(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+InterDir SyntaxReaderCabac<Ctx, R>::ReadInterDir(const CodingUnit &cu) {
   assert(cu.GetPartitionType() == PartitionType::kSize2Nx2N);
   Ctx &ctx = ctx_.GetInterDirBiCtx(cu);
   if (decoder_.DecodeBin(&ctx) != 0) {
@@ -377,8 +380,8 @@ InterDir SyntaxReaderCabac<Ctx>::ReadInterDir(const CodingUnit &cu) {
   return bin == 0 ? InterDir::kL0 : InterDir::kL1;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadInterFullpelMvFlag(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadInterFullpelMvFlag(const CodingUnit &cu) {
   if (restrictions_.disable_ext2_inter_adaptive_fullpel_mv) {
     return false;
   }
@@ -386,8 +389,8 @@ bool SyntaxReaderCabac<Ctx>::ReadInterFullpelMvFlag(const CodingUnit &cu) {
   return decoder_.DecodeBin(&ctx) != 0;
 }
 
-template<typename Ctx>
-MvDelta SyntaxReaderCabac<Ctx>::ReadInterMvd() {
+template<typename Ctx, typename R>
+MvDelta SyntaxReaderCabac<Ctx, R>::ReadInterMvd() {
   if (restrictions_.disable_inter_mvd_greater_than_flags) {
     MvDelta mvd;
     mvd.x += ReadExpGolomb(1);
@@ -428,8 +431,8 @@ MvDelta SyntaxReaderCabac<Ctx>::ReadInterMvd() {
   return mvd;
 }
 
-template<typename Ctx>
-int SyntaxReaderCabac<Ctx>::ReadInterMvpIdx(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+int SyntaxReaderCabac<Ctx, R>::ReadInterMvpIdx(const CodingUnit &cu) {
   if ((!cu.GetUseAffine() && restrictions_.disable_inter_mvp) ||
     (cu.GetUseAffine() && restrictions_.disable_ext2_inter_affine_mvp)) {
     return 0;
@@ -438,8 +441,8 @@ int SyntaxReaderCabac<Ctx>::ReadInterMvpIdx(const CodingUnit &cu) {
                             &ctx_.inter_mvp_idx[0], &ctx_.inter_mvp_idx[0]);
 }
 
-template<typename Ctx>
-int SyntaxReaderCabac<Ctx>::ReadInterRefIdx(int num_refs_available) {
+template<typename Ctx, typename R>
+int SyntaxReaderCabac<Ctx, R>::ReadInterRefIdx(int num_refs_available) {
   if (num_refs_available == 1) {
     return 0;
   }
@@ -460,8 +463,9 @@ int SyntaxReaderCabac<Ctx>::ReadInterRefIdx(int num_refs_available) {
   return ref_idx + 1;
 }
 
-template<typename Ctx>
-IntraMode SyntaxReaderCabac<Ctx>::ReadIntraMode(const IntraPredictorLuma &mpm) {
+template<typename Ctx, typename R>
+IntraMode
+SyntaxReaderCabac<Ctx, R>::ReadIntraMode(const IntraPredictorLuma &mpm) {
   Ctx &ctx = ctx_.intra_pred_luma[0];
   uint32_t is_mpm_coded = decoder_.DecodeBin(&ctx);
   if (is_mpm_coded) {
@@ -534,9 +538,10 @@ IntraMode SyntaxReaderCabac<Ctx>::ReadIntraMode(const IntraPredictorLuma &mpm) {
   }
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
 IntraChromaMode
-SyntaxReaderCabac<Ctx>::ReadIntraChromaMode(IntraPredictorChroma chroma_preds) {
+SyntaxReaderCabac<Ctx, R>::ReadIntraChromaMode(
+  IntraPredictorChroma chroma_preds) {
   uint32_t not_dm_chroma = decoder_.DecodeBin(&ctx_.intra_pred_chroma[0]);
   if (!not_dm_chroma) {
     return IntraChromaMode::kDmChroma;
@@ -551,16 +556,16 @@ SyntaxReaderCabac<Ctx>::ReadIntraChromaMode(IntraPredictorChroma chroma_preds) {
   return chroma_preds[chroma_index];
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadLicFlag() {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadLicFlag() {
   if (restrictions_.disable_ext2_inter_local_illumination_comp) {
     return false;
   }
   return decoder_.DecodeBin(&ctx_.lic_flag[0]) != 0;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadMergeFlag() {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadMergeFlag() {
   if (restrictions_.disable_inter_merge_mode) {
     return false;
   }
@@ -568,8 +573,8 @@ bool SyntaxReaderCabac<Ctx>::ReadMergeFlag() {
   return bin != 0;
 }
 
-template<typename Ctx>
-int SyntaxReaderCabac<Ctx>::ReadMergeIdx() {
+template<typename Ctx, typename R>
+int SyntaxReaderCabac<Ctx, R>::ReadMergeIdx() {
   if (restrictions_.disable_inter_merge_candidates) {
     return 0;
   }
@@ -583,8 +588,9 @@ int SyntaxReaderCabac<Ctx>::ReadMergeIdx() {
   return merge_idx;
 }
 
-template<typename Ctx>
-PartitionType SyntaxReaderCabac<Ctx>::ReadPartitionType(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+PartitionType
+SyntaxReaderCabac<Ctx, R>::ReadPartitionType(const CodingUnit &cu) {
   if (cu.GetPredMode() == PredictionMode::kIntra) {
     PartitionType part_type = PartitionType::kSize2Nx2N;
     // Signaling partition type for lowest level assumes single CU tree
@@ -605,15 +611,15 @@ PartitionType SyntaxReaderCabac<Ctx>::ReadPartitionType(const CodingUnit &cu) {
   return PartitionType::kSizeNxN;
 }
 
-template<typename Ctx>
-PredictionMode SyntaxReaderCabac<Ctx>::ReadPredMode() {
+template<typename Ctx, typename R>
+PredictionMode SyntaxReaderCabac<Ctx, R>::ReadPredMode() {
   uint32_t is_intra = decoder_.DecodeBin(&ctx_.cu_pred_mode[0]);
   return is_intra != 0 ? PredictionMode::kIntra : PredictionMode::kInter;
 }
 
-template<typename Ctx>
-int SyntaxReaderCabac<Ctx>::ReadQp(int predicted_qp, int base_qp,
-                                   int aqp_mode) {
+template<typename Ctx, typename R>
+int SyntaxReaderCabac<Ctx, R>::ReadQp(int predicted_qp, int base_qp,
+                                      int aqp_mode) {
   if (aqp_mode == 1) {
     return decoder_.DecodeBypassBins(7);
   }
@@ -642,16 +648,16 @@ int SyntaxReaderCabac<Ctx>::ReadQp(int predicted_qp, int base_qp,
   return tmp_qp;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadRootCbf() {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadRootCbf() {
   if (restrictions_.disable_transform_root_cbf) {
     return true;
   }
   return decoder_.DecodeBin(&ctx_.cu_root_cbf[0]) != 0;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadSkipFlag(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadSkipFlag(const CodingUnit &cu) {
   if (restrictions_.disable_inter_skip_mode ||
       restrictions_.disable_inter_merge_mode) {
     return false;
@@ -660,10 +666,10 @@ bool SyntaxReaderCabac<Ctx>::ReadSkipFlag(const CodingUnit &cu) {
   return decoder_.DecodeBin(&ctx) != 0;
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
 SplitType
-SyntaxReaderCabac<Ctx>::ReadSplitBinary(const CodingUnit &cu,
-                                        SplitRestriction split_restriction) {
+SyntaxReaderCabac<Ctx, R>::ReadSplitBinary(const CodingUnit &cu,
+                                           SplitRestriction split_restriction) {
   Ctx &ctx = ctx_.GetSplitBinaryCtx(cu);
   uint32_t bin = decoder_.DecodeBin(&ctx);
   if (!bin) {
@@ -685,17 +691,17 @@ SyntaxReaderCabac<Ctx>::ReadSplitBinary(const CodingUnit &cu,
   return bin2 != 0 ? SplitType::kVertical : SplitType::kHorizontal;
 }
 
-template<typename Ctx>
-SplitType SyntaxReaderCabac<Ctx>::ReadSplitQuad(const CodingUnit &cu,
-                                                int max_depth) {
+template<typename Ctx, typename R>
+SplitType SyntaxReaderCabac<Ctx, R>::ReadSplitQuad(const CodingUnit &cu,
+                                                   int max_depth) {
   Ctx &ctx = ctx_.GetSplitFlagCtx(cu, max_depth);
   uint32_t bin = decoder_.DecodeBin(&ctx);
   return bin != 0 ? SplitType::kQuad : SplitType::kNone;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadTransformSkip(const CodingUnit &cu,
-                                               YuvComponent comp) {
+template<typename Ctx, typename R>
+bool SyntaxReaderCabac<Ctx, R>::ReadTransformSkip(const CodingUnit &cu,
+                                                  YuvComponent comp) {
   if (restrictions_.disable_ext2_transform_skip ||
       !cu.CanTransformSkip(comp)) {
     return false;
@@ -704,8 +710,9 @@ bool SyntaxReaderCabac<Ctx>::ReadTransformSkip(const CodingUnit &cu,
   return decoder_.DecodeBin(&ctx) != 0;
 }
 
-template<typename Ctx>
-bool SyntaxReaderCabac<Ctx>::ReadTransformSelectEnable(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+bool
+SyntaxReaderCabac<Ctx, R>::ReadTransformSelectEnable(const CodingUnit &cu) {
   if (restrictions_.disable_ext2_transform_select) {
     return false;
   }
@@ -713,8 +720,8 @@ bool SyntaxReaderCabac<Ctx>::ReadTransformSelectEnable(const CodingUnit &cu) {
   return decoder_.DecodeBin(&ctx) != 0;
 }
 
-template<typename Ctx>
-int SyntaxReaderCabac<Ctx>::ReadTransformSelectIdx(const CodingUnit &cu) {
+template<typename Ctx, typename R>
+int SyntaxReaderCabac<Ctx, R>::ReadTransformSelectIdx(const CodingUnit &cu) {
   if (restrictions_.disable_ext2_transform_select) {
     return 0;
   }
@@ -729,12 +736,12 @@ int SyntaxReaderCabac<Ctx>::ReadTransformSelectIdx(const CodingUnit &cu) {
   return type_idx;
 }
 
-template<typename Ctx>
-void SyntaxReaderCabac<Ctx>::ReadCoeffLastPos(int width, int height,
-                                              YuvComponent comp,
-                                              ScanOrder scan_order,
-                                              uint32_t *out_pos_last_x,
-                                              uint32_t *out_pos_last_y) {
+template<typename Ctx, typename R>
+void SyntaxReaderCabac<Ctx, R>::ReadCoeffLastPos(int width, int height,
+                                                 YuvComponent comp,
+                                                 ScanOrder scan_order,
+                                                 uint32_t *out_pos_last_x,
+                                                 uint32_t *out_pos_last_y) {
   if (scan_order == ScanOrder::kVertical) {
     std::swap(width, height);
   }
@@ -783,14 +790,12 @@ void SyntaxReaderCabac<Ctx>::ReadCoeffLastPos(int width, int height,
   *out_pos_last_y = pos_last_y;
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
 template<int SubBlockShift>
 int
-SyntaxReaderCabac<Ctx>::DetermineLastIndex(int subblock_width,
-                                           int subblock_height,
-                                           int pos_last_x, int pos_last_y,
-                                           const uint16_t *subblock_scan_table,
-                                           const uint8_t *coeff_scan_table) {
+SyntaxReaderCabac<Ctx, R>::DetermineLastIndex(
+  int subblock_width, int subblock_height, int pos_last_x, int pos_last_y,
+  const uint16_t *subblock_scan_table, const uint8_t *coeff_scan_table) {
   constexpr int subblock_shift = SubBlockShift;
   constexpr int subblock_mask = (1 << subblock_shift) - 1;
   constexpr int subblock_size = 1 << (subblock_shift * 2);
@@ -814,9 +819,9 @@ SyntaxReaderCabac<Ctx>::DetermineLastIndex(int subblock_width,
   return 0;
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
 uint32_t
-SyntaxReaderCabac<Ctx>::ReadCoeffRemainExpGolomb(uint32_t golomb_rice_k) {
+SyntaxReaderCabac<Ctx, R>::ReadCoeffRemainExpGolomb(uint32_t golomb_rice_k) {
   const uint32_t threshold =
     !restrictions_.disable_ext2_cabac_alt_residual_ctx ?
     TransformHelper::kGolombRiceRangeExt[golomb_rice_k] :
@@ -837,8 +842,8 @@ SyntaxReaderCabac<Ctx>::ReadCoeffRemainExpGolomb(uint32_t golomb_rice_k) {
   }
 }
 
-template<typename Ctx>
-uint32_t SyntaxReaderCabac<Ctx>::ReadExpGolomb(uint32_t golomb_rice_k) {
+template<typename Ctx, typename R>
+uint32_t SyntaxReaderCabac<Ctx, R>::ReadExpGolomb(uint32_t golomb_rice_k) {
   uint32_t abs_level = 0;
   uint32_t bin = 1;
   while (bin) {
@@ -852,11 +857,11 @@ uint32_t SyntaxReaderCabac<Ctx>::ReadExpGolomb(uint32_t golomb_rice_k) {
   return abs_level;
 }
 
-template<typename Ctx>
+template<typename Ctx, typename R>
 uint32_t
-SyntaxReaderCabac<Ctx>::ReadUnaryMaxSymbol(uint32_t max_val,
-                                           Ctx *ctx_start,
-                                           Ctx *ctx_rest) {
+SyntaxReaderCabac<Ctx, R>::ReadUnaryMaxSymbol(uint32_t max_val,
+                                              Ctx *ctx_start,
+                                              Ctx *ctx_rest) {
   assert(max_val > 0);
   uint32_t symbol = decoder_.DecodeBin(ctx_start);
   if (!symbol || max_val == 1) {
@@ -877,6 +882,12 @@ SyntaxReaderCabac<Ctx>::ReadUnaryMaxSymbol(uint32_t max_val,
 std::unique_ptr<SyntaxReader>
 SyntaxReader::Create(const Qp &qp, PicturePredictionType pic_type,
                      BitReader *bit_reader) {
+  if (Restrictions::Get().IsUnrestricted()) {
+    // Common case, all restriction checks can be resolved at compile time
+    return std::unique_ptr<SyntaxReader>(
+      new SyntaxReaderCabac<ContextModelDynamic, NoRestrictions>(qp, pic_type,
+                                                                 bit_reader));
+  }
   if (Restrictions::Get().disable_cabac_ctx_update) {
     return std::unique_ptr<SyntaxReader>(
       new SyntaxReaderCabac<ContextModelStatic>(qp, pic_type, bit_reader));
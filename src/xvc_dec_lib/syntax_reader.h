@@ -29,6 +29,7 @@
 #include "xvc_common_lib/intra_prediction.h"
 #include "xvc_common_lib/picture_types.h"
 #include "xvc_common_lib/quantize.h"
+#include "xvc_common_lib/restrictions.h"
 #include "xvc_common_lib/transform.h"
 #include "xvc_dec_lib/entropy_decoder.h"
 
@@ -72,7 +73,7 @@ public:
   virtual int ReadTransformSelectIdx(const CodingUnit &cu) = 0;
 };
 
-template<typename ContextModel>
+template<typename ContextModel, typename RestrictionSet = Restrictions>
 class SyntaxReaderCabac final : public SyntaxReader {
 public:
   SyntaxReaderCabac(const Qp &qp, PicturePredictionType pic_type,
@@ -123,9 +124,9 @@ private:
   uint32_t ReadUnaryMaxSymbol(uint32_t max_val, ContextModel *ctx_start,
                               ContextModel *ctx_rest);
 
-  CabacContexts<ContextModel> ctx_;
+  CabacContexts<ContextModel, RestrictionSet> ctx_;
   EntropyDecoder<ContextModel> decoder_;
-  const Restrictions &restrictions_;
+  const RestrictionSet &restrictions_;
 };
 
 }   // namespace xvc
@@ -59,7 +59,7 @@ void ThreadDecoder::DecodeAsync(
   std::shared_ptr<SegmentHeader> &&prev_segment_header,
   std::shared_ptr<PictureDecoder> &&pic_dec,
   std::vector<std::shared_ptr<const PictureDecoder>> &&deps,
-  std::unique_ptr<std::vector<uint8_t>> &&nal, size_t nal_offset) {
+  NalBuffer &&nal, size_t nal_offset) {
   // Prepare work for thread
   WorkItem work;
   work.pic_dec = std::move(pic_dec);
@@ -85,22 +85,29 @@ void ThreadDecoder::WaitForPicture(const std::shared_ptr<PictureDecoder> &pic,
 }
 
 void ThreadDecoder::WaitOne(PictureDecodedCallback callback) {
+  // Destroyed after the lock so that the application release function of
+  // the nal unit is never invoked while the lock is held
+  NalBuffer finished_nal;
   std::unique_lock<std::mutex> lock(global_mutex_);
   work_done_cond_.wait(lock, [this] { return !finished_work_.empty(); });
   WorkItem work = std::move(finished_work_.front());
   finished_work_.pop_front();
   jobs_in_flight_--;
+  finished_nal = std::move(work.nal);
   // Note! Callback invoked while lock is being held
   callback(work.pic_dec, work.success, work.inter_dependencies);
 }
 
 void ThreadDecoder::WaitAll(PictureDecodedCallback callback) {
+  // Destroyed after the lock, see WaitOne
+  std::vector<NalBuffer> finished_nals;
   std::unique_lock<std::mutex> lock(global_mutex_);
   while (jobs_in_flight_ > 0) {
     work_done_cond_.wait(lock, [this] { return !finished_work_.empty(); });
     WorkItem work = std::move(finished_work_.front());
     finished_work_.pop_front();
     jobs_in_flight_--;
+    finished_nals.push_back(std::move(work.nal));
     // Note! Callback invoked while lock is held
     callback(work.pic_dec, work.success, work.inter_dependencies);
   }
@@ -150,8 +157,8 @@ void ThreadDecoder::WorkerMain() {
     }
 
     // Decode picture
-    BitReader bit_reader(&(*work.nal)[0] + work.nal_offset,
-                         work.nal->size() - work.nal_offset);
+    BitReader bit_reader(work.nal.data() + work.nal_offset,
+                         work.nal.size() - work.nal_offset);
     work.success = work.pic_dec->Decode(*work.segment_header,
                                         *work.prev_segment_header, &bit_reader,
                                         false);
@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "xvc_common_lib/segment_header.h"
+#include "xvc_dec_lib/nal_buffer.h"
 #include "xvc_dec_lib/picture_decoder.h"
 
 namespace xvc {
@@ -51,7 +52,7 @@ public:
                    std::shared_ptr<SegmentHeader> &&prev_segment_header,
                    std::shared_ptr<PictureDecoder> &&pic_dec,
                    std::vector<std::shared_ptr<const PictureDecoder>> &&deps,
-                   std::unique_ptr<std::vector<uint8_t>> &&nal,
+                   NalBuffer &&nal,
                    size_t nal_offset);
   void WaitForPicture(const std::shared_ptr<PictureDecoder> &pic,
                       PictureDecodedCallback callback);
@@ -64,7 +65,7 @@ private:
     std::vector<std::shared_ptr<const PictureDecoder>> inter_dependencies;
     std::shared_ptr<SegmentHeader> segment_header;
     std::shared_ptr<SegmentHeader> prev_segment_header;
-    std::unique_ptr<std::vector<uint8_t>> nal;
+    NalBuffer nal;
     std::size_t nal_offset;
     bool success;
   };
@@ -24,11 +24,23 @@
 #include <cstring>
 
 #include "xvc_dec_lib/decoder.h"
+#include "xvc_dec_lib/segment_header_reader.h"
+
+#if XVC_HIGH_BITDEPTH && XVC_LOW_BITDEPTH_PIPELINE
+#define XVC_DEC_LOWBD_DELEGATE 1
+#else
+#define XVC_DEC_LOWBD_DELEGATE 0
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if XVC_DEC_LOWBD_DELEGATE
+  // Same api compiled with 8bit samples
+  const xvc_decoder_api* xvc_lowbd_decoder_api_get(void);
+#endif
+
   static xvc_decoder_parameters* xvc_dec_parameters_create() {
     xvc_decoder_parameters *parameters = new xvc_decoder_parameters;
     std::memset(parameters, 0, sizeof(xvc_decoder_parameters));
@@ -58,6 +70,12 @@ extern "C" {
     param->simd_mask = static_cast<uint32_t>(-1);
     param->dither = 1;
     param->additional_decoder_buffers = 0;
+    param->picture_alloc = nullptr;
+    param->picture_free = nullptr;
+    param->picture_alloc_opaque = nullptr;
+    param->huge_pages = 0;
+    param->zero_copy_output = 0;
+    param->max_memory_bytes = 0;
     return XVC_DEC_OK;
   }
 
@@ -95,6 +113,9 @@ extern "C" {
         param->max_framerate > xvc::constants::kTimeScale) {
       return XVC_DEC_FRAMERATE_OUT_OF_RANGE;
     }
+    if (!param->picture_alloc != !param->picture_free) {
+      return XVC_DEC_INVALID_PARAMETER;
+    }
     return XVC_DEC_OK;
   }
 
@@ -108,10 +129,8 @@ extern "C" {
     return XVC_DEC_OK;
   }
 
-  static xvc_decoder* xvc_dec_decoder_create(xvc_decoder_parameters *param) {
-    if (xvc_dec_parameters_check(param) != XVC_DEC_OK) {
-      return nullptr;
-    }
+  static xvc::Decoder*
+    xvc_dec_create_lib_decoder(const xvc_decoder_parameters *param) {
     xvc::Decoder *decoder = new xvc::Decoder(param->threads);
     decoder->SetCpuCapabilities(xvc::SimdCpu::GetMaskedCaps(param->simd_mask));
     decoder->SetOutputWidth(param->output_width);
@@ -122,13 +141,61 @@ extern "C" {
     decoder->SetDecoderTicks(static_cast<int>(xvc::constants::kTimeScale
                                               / param->max_framerate + 0.5));
     decoder->SetDithering(param->dither != 0);
+    xvc::PictureAllocator allocator;
+    allocator.alloc_func = param->picture_alloc;
+    allocator.free_func = param->picture_free;
+    allocator.opaque = param->picture_alloc_opaque;
+    allocator.huge_pages = param->huge_pages != 0;
+    decoder->SetPictureAllocator(allocator);
+    decoder->SetZeroCopyOutput(param->zero_copy_output != 0);
+    decoder->SetMaxMemory(param->max_memory_bytes);
+    return decoder;
+  }
+
+  static xvc::Decoder* xvc_dec_get_lib_decoder(xvc_decoder *decoder) {
+#if XVC_DEC_LOWBD_DELEGATE
+    if (!decoder->lib_decoder) {
+      decoder->lib_decoder = xvc_dec_create_lib_decoder(&decoder->params);
+    }
+    return static_cast<xvc::Decoder*>(decoder->lib_decoder);
+#else
+    return static_cast<xvc::Decoder*>(decoder);
+#endif
+  }
+
+  static xvc_decoder* xvc_dec_decoder_create(xvc_decoder_parameters *param) {
+    if (xvc_dec_parameters_check(param) != XVC_DEC_OK) {
+      return nullptr;
+    }
+#if XVC_DEC_LOWBD_DELEGATE
+    // The decoder is created once the pipeline is known
+    xvc_decoder *decoder = new xvc_decoder();
+    decoder->params = *param;
     return decoder;
+#else
+    return xvc_dec_create_lib_decoder(param);
+#endif
   }
 
+#if XVC_DEC_LOWBD_DELEGATE
+  static void xvc_dec_destroy_delegate(xvc_decoder *decoder) {
+    xvc_lowbd_decoder_api_get()->decoder_destroy(decoder->lowbd_delegate);
+    decoder->lowbd_delegate = nullptr;
+    decoder->lowbd_draining = false;
+  }
+#endif
+
   static xvc_dec_return_code xvc_dec_decoder_destroy(xvc_decoder *decoder) {
     if (decoder) {
-      xvc::Decoder *lib_decoder = reinterpret_cast<xvc::Decoder*>(decoder);
-      delete lib_decoder;
+#if XVC_DEC_LOWBD_DELEGATE
+      if (decoder->lowbd_delegate) {
+        xvc_dec_destroy_delegate(decoder);
+      }
+      delete static_cast<xvc::Decoder*>(decoder->lib_decoder);
+      delete decoder;
+#else
+      delete static_cast<xvc::Decoder*>(decoder);
+#endif
     }
     return XVC_DEC_OK;
   }
@@ -139,7 +206,17 @@ extern "C" {
     if (xvc_dec_parameters_check(param) != XVC_DEC_OK) {
       return XVC_DEC_INVALID_ARGUMENT;
     }
-    xvc::Decoder *lib_decoder = reinterpret_cast<xvc::Decoder*>(decoder);
+#if XVC_DEC_LOWBD_DELEGATE
+    decoder->params.max_framerate = param->max_framerate;
+    if (decoder->lowbd_delegate) {
+      xvc_lowbd_decoder_api_get()->
+        decoder_update_parameters(decoder->lowbd_delegate, param);
+    }
+    if (!decoder->lib_decoder) {
+      return XVC_DEC_OK;
+    }
+#endif
+    xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
 
     // Framerate is the only parameter that is updated.
     // Changes in other parameters will be ignored.
@@ -148,19 +225,83 @@ extern "C" {
     return XVC_DEC_OK;
   }
 
-  static xvc_dec_return_code
-    xvc_dec_decoder_decode_nal(xvc_decoder *decoder, const uint8_t *nal_unit,
-                               size_t nal_unit_size, int64_t user_data) {
-    if (!decoder || !nal_unit || nal_unit_size < 1) {
-      return XVC_DEC_INVALID_ARGUMENT;
+#if XVC_DEC_LOWBD_DELEGATE
+  // Peek at segment headers to select the pipeline. 8bit bitstreams are
+  // handed over to the 8bit pipeline. If a later segment is of higher
+  // bitdepth the 8bit decoder is flushed and decoding continues in the 16bit
+  // decoder, while the remaining pictures of the 8bit decoder are output
+  // first. Returns true if the nal unit should be decoded by the delegate.
+  // Open gop tail pictures buffered by the 8bit decoder at the switch
+  // reference the higher bitdepth key picture and can not be decoded by
+  // either decoder, which is signaled through |tail_pics_lost|.
+  static bool xvc_dec_route_to_delegate(xvc_decoder *decoder,
+                                        const uint8_t *nal_unit,
+                                        size_t nal_unit_size,
+                                        bool *tail_pics_lost) {
+    *tail_pics_lost = false;
+    if (decoder->pipeline_selected &&
+        (!decoder->lowbd_delegate || decoder->lowbd_draining)) {
+      return false;
+    }
+    xvc::BitReader bit_reader(nal_unit, nal_unit_size);
+    xvc::NalUnitType nal_unit_type;
+    if (!xvc::Decoder::ParseNalUnitHeader(&bit_reader, &nal_unit_type, true)) {
+      return decoder->lowbd_delegate != nullptr;
+    }
+    if (nal_unit_type != xvc::NalUnitType::kSegmentHeader) {
+      if (nal_unit_type >= xvc::NalUnitType::kIntraPicture &&
+          nal_unit_type <= xvc::NalUnitType::kReservedPictureType10) {
+        // Tail pictures are buffered until the next key picture
+        const int buffer_flag = bit_reader.ReadBit();
+        decoder->lowbd_num_tail_pics =
+          buffer_flag ? decoder->lowbd_num_tail_pics + 1 : 0;
+      }
+      return decoder->lowbd_delegate != nullptr;
     }
-    xvc::Decoder *lib_decoder = reinterpret_cast<xvc::Decoder*>(decoder);
-    size_t decoded_bytes =
-      lib_decoder->DecodeNal(nal_unit, nal_unit_size, user_data);
+    xvc::SegmentHeader segment_header;
+    bool accept_xvc_bit_zero = false;
+    xvc::Decoder::State state =
+      xvc::SegmentHeaderReader::Read(&segment_header, &bit_reader, 0,
+                                     &accept_xvc_bit_zero);
+    const bool lowbd = state == xvc::Decoder::State::kSegmentHeaderDecoded &&
+      segment_header.internal_bitdepth == 8;
+    if (!decoder->pipeline_selected) {
+      decoder->pipeline_selected = true;
+      if (lowbd) {
+        // Nothing has been decoded before the first segment header
+        delete static_cast<xvc::Decoder*>(decoder->lib_decoder);
+        decoder->lib_decoder = nullptr;
+        decoder->lowbd_delegate =
+          xvc_lowbd_decoder_api_get()->decoder_create(&decoder->params);
+        decoder->lowbd_open_gop = segment_header.open_gop;
+      }
+      return decoder->lowbd_delegate != nullptr;
+    }
+    if (lowbd) {
+      decoder->lowbd_open_gop = segment_header.open_gop;
+    }
+    if (lowbd || state != xvc::Decoder::State::kSegmentHeaderDecoded) {
+      return true;
+    }
+    // Without open gop the buffered tail pictures are decoded by the flush
+    *tail_pics_lost =
+      decoder->lowbd_open_gop && decoder->lowbd_num_tail_pics > 0;
+    xvc_lowbd_decoder_api_get()->decoder_flush(decoder->lowbd_delegate);
+    decoder->lowbd_draining = true;
+    decoder->lowbd_num_tail_pics = 0;
+    return false;
+  }
+#endif
+
+  static xvc_dec_return_code
+    xvc_dec_decode_nal_buffer(xvc::Decoder *lib_decoder,
+                              xvc::NalBuffer *nal_buffer, int64_t user_data) {
+    const size_t nal_unit_size = nal_buffer->size();
+    size_t decoded_bytes = lib_decoder->DecodeNal(nal_buffer, user_data);
     if (decoded_bytes != xvc::Decoder::kInvalidNal &&
         decoded_bytes < nal_unit_size) {
-      lib_decoder->DecodeNal(nal_unit + decoded_bytes,
-                             nal_unit_size - decoded_bytes, user_data);
+      nal_buffer->Skip(decoded_bytes);
+      lib_decoder->DecodeNal(nal_buffer, user_data);
     }
 
     xvc::Decoder::State dec_state = lib_decoder->GetState();
@@ -178,13 +319,89 @@ extern "C" {
     return XVC_DEC_OK;
   }
 
+  static xvc_dec_return_code
+    xvc_dec_decoder_decode_nal(xvc_decoder *decoder, const uint8_t *nal_unit,
+                               size_t nal_unit_size, int64_t user_data) {
+    if (!decoder || !nal_unit || nal_unit_size < 1) {
+      return XVC_DEC_INVALID_ARGUMENT;
+    }
+#if XVC_DEC_LOWBD_DELEGATE
+    bool tail_pics_lost = false;
+    if (xvc_dec_route_to_delegate(decoder, nal_unit, nal_unit_size,
+                                  &tail_pics_lost)) {
+      return xvc_lowbd_decoder_api_get()->
+        decoder_decode_nal(decoder->lowbd_delegate, nal_unit, nal_unit_size,
+                           user_data);
+    }
+#endif
+    xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
+    xvc::NalBuffer nal_buffer(nal_unit, nal_unit_size);
+    xvc_dec_return_code ret =
+      xvc_dec_decode_nal_buffer(lib_decoder, &nal_buffer, user_data);
+#if XVC_DEC_LOWBD_DELEGATE
+    if (ret == XVC_DEC_OK && tail_pics_lost) {
+      return XVC_DEC_TAIL_PICTURES_LOST_AT_BITDEPTH_SWITCH;
+    }
+#endif
+    return ret;
+  }
+
+  static xvc_dec_return_code
+    xvc_dec_decoder_decode_nal_ref(xvc_decoder *decoder,
+                                   const uint8_t *nal_unit,
+                                   size_t nal_unit_size, int64_t user_data,
+                                   xvc::NalBuffer::ReleaseFunc release,
+                                   void *release_opaque) {
+    if (!decoder || !nal_unit || nal_unit_size < 1 || !release) {
+      if (release) {
+        release(release_opaque, nal_unit);
+      }
+      return XVC_DEC_INVALID_ARGUMENT;
+    }
+#if XVC_DEC_LOWBD_DELEGATE
+    bool tail_pics_lost = false;
+    if (xvc_dec_route_to_delegate(decoder, nal_unit, nal_unit_size,
+                                  &tail_pics_lost)) {
+      return xvc_lowbd_decoder_api_get()->
+        decoder_decode_nal_ref(decoder->lowbd_delegate, nal_unit,
+                               nal_unit_size, user_data, release,
+                               release_opaque);
+    }
+#endif
+    xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
+    xvc::NalBuffer nal_buffer(nal_unit, nal_unit_size, release,
+                              release_opaque);
+    xvc_dec_return_code ret =
+      xvc_dec_decode_nal_buffer(lib_decoder, &nal_buffer, user_data);
+#if XVC_DEC_LOWBD_DELEGATE
+    if (ret == XVC_DEC_OK && tail_pics_lost) {
+      return XVC_DEC_TAIL_PICTURES_LOST_AT_BITDEPTH_SWITCH;
+    }
+#endif
+    return ret;
+  }
+
   static xvc_dec_return_code
     xvc_dec_decoder_get_picture(xvc_decoder *decoder,
                                 xvc_decoded_picture *pic_bytes) {
     if (!decoder || !pic_bytes) {
       return XVC_DEC_INVALID_ARGUMENT;
     }
-    xvc::Decoder *lib_decoder = reinterpret_cast<xvc::Decoder*>(decoder);
+#if XVC_DEC_LOWBD_DELEGATE
+    if (decoder->lowbd_delegate) {
+      xvc_dec_return_code ret = xvc_lowbd_decoder_api_get()->
+        decoder_get_picture(decoder->lowbd_delegate, pic_bytes);
+      if (ret != XVC_DEC_NO_DECODED_PIC || !decoder->lowbd_draining) {
+        return ret;
+      }
+      // Zero-copy output pictures are owned by the 8bit decoder until
+      // released, so it is then kept until the handle is destroyed
+      if (!decoder->params.zero_copy_output) {
+        xvc_dec_destroy_delegate(decoder);
+      }
+    }
+#endif
+    xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
     if (!lib_decoder->GetDecodedPicture(pic_bytes)) {
       return XVC_DEC_NO_DECODED_PIC;
     }
@@ -196,7 +413,13 @@ extern "C" {
     if (!decoder) {
       return XVC_DEC_INVALID_ARGUMENT;
     }
-    xvc::Decoder *lib_decoder = reinterpret_cast<xvc::Decoder*>(decoder);
+#if XVC_DEC_LOWBD_DELEGATE
+    if (decoder->lowbd_delegate && !decoder->lowbd_draining) {
+      return xvc_lowbd_decoder_api_get()->
+        decoder_flush(decoder->lowbd_delegate);
+    }
+#endif
+    xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
     lib_decoder->FlushBufferedNalUnits();
     return XVC_DEC_OK;
   }
@@ -207,9 +430,18 @@ extern "C" {
     if (!decoder) {
       return XVC_DEC_INVALID_ARGUMENT;
     }
-    xvc::Decoder *lib_decoder = reinterpret_cast<xvc::Decoder*>(decoder);
-    int num_corrupted =
-      static_cast<uint32_t>(lib_decoder->GetNumCorruptedPics());
+    int num_corrupted = 0;
+#if XVC_DEC_LOWBD_DELEGATE
+    if (decoder->lowbd_delegate) {
+      xvc_lowbd_decoder_api_get()->
+        decoder_check_conformance(decoder->lowbd_delegate, &num_corrupted);
+    }
+    if (decoder->lib_decoder || !decoder->lowbd_delegate)
+#endif
+    {
+      xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
+      num_corrupted += static_cast<int>(lib_decoder->GetNumCorruptedPics());
+    }
     if (out_num) {
       *out_num = num_corrupted;
     }
@@ -219,6 +451,66 @@ extern "C" {
     return XVC_DEC_OK;
   }
 
+  static xvc_dec_return_code
+    xvc_dec_picture_release(xvc_decoder *decoder, xvc_decoded_picture *pic) {
+    if (!decoder || !pic) {
+      return XVC_DEC_INVALID_ARGUMENT;
+    }
+#if XVC_DEC_LOWBD_DELEGATE
+    if (decoder->lowbd_delegate) {
+      xvc_dec_return_code ret = xvc_lowbd_decoder_api_get()->
+        picture_release(decoder->lowbd_delegate, pic);
+      if (ret == XVC_DEC_OK || !decoder->lib_decoder) {
+        return ret;
+      }
+    }
+#endif
+    xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
+    if (!lib_decoder->ReleaseDecodedPicture(pic)) {
+      return XVC_DEC_INVALID_ARGUMENT;
+    }
+    return XVC_DEC_OK;
+  }
+
+  static xvc_dec_return_code
+    xvc_dec_decoder_get_memory_usage(xvc_decoder *decoder,
+                                     xvc_dec_memory_usage *usage) {
+    if (!decoder || !usage) {
+      return XVC_DEC_INVALID_ARGUMENT;
+    }
+#if XVC_DEC_LOWBD_DELEGATE
+    if (decoder->lowbd_delegate) {
+      xvc_lowbd_decoder_api_get()->
+        decoder_get_memory_usage(decoder->lowbd_delegate, usage);
+      if (!decoder->lib_decoder) {
+        return XVC_DEC_OK;
+      }
+      // Both pipelines are alive while the 8bit pictures are drained
+      xvc_dec_memory_usage lowbd_usage = *usage;
+      xvc_dec_get_lib_decoder(decoder)->GetMemoryUsage(usage);
+      usage->reconstructed_pictures += lowbd_usage.reconstructed_pictures;
+      usage->alternative_pictures += lowbd_usage.alternative_pictures;
+      usage->picture_data += lowbd_usage.picture_data;
+      usage->output_pictures += lowbd_usage.output_pictures;
+      usage->nal_units += lowbd_usage.nal_units;
+      usage->total += lowbd_usage.total;
+      usage->pooled += lowbd_usage.pooled;
+      return XVC_DEC_OK;
+    }
+#endif
+    xvc::Decoder *lib_decoder = xvc_dec_get_lib_decoder(decoder);
+    lib_decoder->GetMemoryUsage(usage);
+    return XVC_DEC_OK;
+  }
+
+  static xvc_dec_return_code xvc_dec_buffer_pool_set_limit(size_t max_bytes) {
+#if XVC_DEC_LOWBD_DELEGATE
+    xvc_lowbd_decoder_api_get()->buffer_pool_set_limit(max_bytes);
+#endif
+    xvc::PictureAllocator::SetPoolLimit(max_bytes);
+    return XVC_DEC_OK;
+  }
+
   static const char* xvc_dec_get_error_text(xvc_dec_return_code error_code) {
     switch (error_code) {
       case  XVC_DEC_OK:
@@ -244,6 +536,9 @@ extern "C" {
           "decoder has been compiled for. "
           "Please recompile the decoder to support higher bitdepth "
           "(by setting XVC_HIGH_BITDEPTH equal to 1).";
+      case XVC_DEC_TAIL_PICTURES_LOST_AT_BITDEPTH_SWITCH:
+        return "Open gop pictures at the end of an 8bit segment can not be "
+          "decoded when the next segment is of higher bitdepth";
       case XVC_DEC_INVALID_PARAMETER:
         return "Invalid parameter";
       case XVC_DEC_BITSTREAM_VERSION_LOWER_THAN_SUPPORTED_BY_DECODER:
@@ -271,6 +566,10 @@ extern "C" {
     &xvc_dec_decoder_flush,
     &xvc_dec_decoder_check_conformance,
     &xvc_dec_get_error_text,
+    &xvc_dec_picture_release,
+    &xvc_dec_decoder_decode_nal_ref,
+    &xvc_dec_decoder_get_memory_usage,
+    &xvc_dec_buffer_pool_set_limit,
   };
 
   const xvc_decoder_api* xvc_decoder_api_get() {
@@ -40,7 +40,7 @@ extern "C" {
 #define XVC_DEC_API
 #endif
 
-#define XVC_DEC_API_VERSION   1
+#define XVC_DEC_API_VERSION   2
 
   typedef enum {
     XVC_DEC_OK = 0,
@@ -54,6 +54,7 @@ extern "C" {
     XVC_DEC_NO_SEGMENT_HEADER_DECODED,
     XVC_DEC_BITSTREAM_BITDEPTH_TOO_HIGH,
     XVC_DEC_BITSTREAM_VERSION_LOWER_THAN_SUPPORTED_BY_DECODER,
+    XVC_DEC_TAIL_PICTURES_LOST_AT_BITDEPTH_SWITCH,
   } xvc_dec_return_code;
 
   typedef enum {
@@ -107,6 +108,20 @@ extern "C" {
     int64_t user_data;
   } xvc_decoded_picture;
 
+  // Memory currently allocated by a decoder instance in bytes
+  // Populated using api->decoder_get_memory_usage
+  typedef struct xvc_dec_memory_usage {
+    size_t reconstructed_pictures;  // Reference and output picture buffers
+    size_t alternative_pictures;    // Resampled pictures for open gop
+    size_t picture_data;            // Coding data of pictures being decoded
+    size_t output_pictures;         // Pictures converted to output format
+    size_t nal_units;               // Nal units buffered before decoding
+    size_t total;                   // Sum of all above
+    // Freed buffers kept for reuse by the built-in allocator, shared by all
+    // decoder and encoder instances of the process
+    size_t pooled;
+  } xvc_dec_memory_usage;
+
   // xvc decoder instance
   // Lifecycle managed by api->decoder_create & api->decoder_destroy
   typedef struct xvc_decoder xvc_decoder;
@@ -124,6 +139,26 @@ extern "C" {
     uint32_t simd_mask;
     int dither;
     int additional_decoder_buffers;
+    // Optional application allocator for picture buffers, either both or
+    // none of picture_alloc and picture_free must be set. Returned memory
+    // must be aligned to at least the requested alignment (in bytes).
+    void* (*picture_alloc)(void *opaque, size_t size, size_t alignment);
+    void (*picture_free)(void *opaque, void *ptr);
+    void *picture_alloc_opaque;
+    // Request transparent huge pages for large picture buffers when using
+    // the built-in allocator
+    int huge_pages;
+    // Output pictures by reference to the decoded picture buffer when the
+    // output format matches the bitstream. Such pictures are signaled with
+    // size equal to 0 and must be returned using api->picture_release
+    // before the decoder is destroyed.
+    int zero_copy_output;
+    // Upper limit of memory allocated by the decoder in bytes, 0 for none.
+    // When needed to stay within the limit, output pictures are converted
+    // one at a time, additional output buffering is reduced and alternative
+    // pictures are not retained. Buffering required by the bitstream is
+    // always kept, even if that exceeds the limit.
+    size_t max_memory_bytes;
   } xvc_decoder_parameters;
 
   // xvc decoder api
@@ -161,6 +196,31 @@ extern "C" {
                                                     int *num);
     // Misc
     const char*(*xvc_dec_get_error_text)(xvc_dec_return_code error_code);
+    // Release a picture that was output without copy, see zero_copy_output.
+    // Such picture remains valid until released. All such pictures must be
+    // released before decoder_destroy is called on the decoder.
+    xvc_dec_return_code(*picture_release)(xvc_decoder *decoder,
+                                          xvc_decoded_picture *pic);
+    // Decode the specified nal unit without copying it. The decoder holds on
+    // to the nal unit data until it has been decoded and then invokes
+    // release exactly once, also on error. Note that release may be invoked
+    // before this function returns or from any later api call on decoder,
+    // including decoder_destroy. Release is always invoked on the thread
+    // making that api call and never while the decoder holds an internal
+    // lock, but it must not call back into the api for the same decoder.
+    xvc_dec_return_code(*decoder_decode_nal_ref)(
+      xvc_decoder *decoder, const uint8_t *nal_unit, size_t nal_unit_size,
+      int64_t user_data,
+      void (*release)(void *release_opaque, const uint8_t *nal_unit),
+      void *release_opaque);
+    // Report the memory currently allocated by the decoder
+    xvc_dec_return_code(*decoder_get_memory_usage)(
+      xvc_decoder *decoder, xvc_dec_memory_usage *usage);
+    // Limit the memory in bytes of freed picture buffers that the built-in
+    // allocator keeps for reuse. The pool is shared by all decoder and
+    // encoder instances of the process and is emptied when the last
+    // instance is destroyed.
+    xvc_dec_return_code(*buffer_pool_set_limit)(size_t max_bytes);
   } xvc_decoder_api;
 
   // Starting point for using the xvc decoder api
@@ -34,6 +34,10 @@
 
 namespace xvc {
 
+// Range of ctu qp relative to picture qp supported by delta qp signaling
+static const int kMinCtuDeltaQp = -3;
+static const int kMaxCtuDeltaQp = 7;
+
 struct CuEncoder::RdoCost {
   RdoCost() = default;
   explicit RdoCost(Cost c) : cost(c), dist(0) {}
@@ -59,7 +63,8 @@ CuEncoder::CuEncoder(const EncoderSimdFunctions &simd,
   intra_search_(simd, rec_pic->GetBitdepth(), *pic_data, orig_pic,
                 encoder_settings),
   cu_writer_(pic_data_, &intra_search_),
-  cu_cache_(pic_data) {
+  cu_cache_(pic_data),
+  split_predictor_(*pic_data, orig_pic) {
   for (int tree_idx = 0; tree_idx < constants::kMaxNumCuTrees; tree_idx++) {
     const CuTree cu_tree = static_cast<CuTree>(tree_idx);
     const int max_depth = static_cast<int>(rdo_temp_cu_[tree_idx].size());
@@ -86,12 +91,22 @@ void CuEncoder::EncodeCtu(int rsaddr, SyntaxWriter *bitstream_writer) {
   if (!EncoderSettings::kEncoderCountActualWrittenBits) {
     frac_bits = rsaddr == 0 ? 0 : last_ctu_frac_bits_;
   }
-  RdoSyntaxWriter rdo_writer(*bitstream_writer, 0, frac_bits);
+  // With fast rate estimation all rdo writers of this ctu share the contexts
+  // of the bitstream writer without updating them, avoiding context copies
+  const bool frozen_contexts = encoder_settings_.fast_rate_estimation != 0;
+  RdoSyntaxWriter rdo_writer(*bitstream_writer, 0, frac_bits, frozen_contexts);
+  ctx_journal_.clear();
+  rdo_writer.SetContextJournal(&ctx_journal_);
 
   CodingUnit *ctu = pic_data_.GetCtu(CuTree::Primary, rsaddr);
   int ctu_qp = pic_data_.GetPicQp()->GetQpRaw(YuvComponent::kY);
   if (encoder_settings_.adaptive_qp) {
-    ctu_qp += CalcDeltaQpFromVariance(ctu);
+    int delta_qp = CalcDeltaQpFromVariance(ctu);
+    if (ctu_qp_offsets_) {
+      delta_qp = util::Clip3(delta_qp + (*ctu_qp_offsets_)[rsaddr],
+                             kMinCtuDeltaQp, kMaxCtuDeltaQp);
+    }
+    ctu_qp += delta_qp;
   }
   ctu->SetQp(ctu_qp);
   CompressCu(&ctu, 0, SplitRestriction::kNone, &rdo_writer, ctu->GetQp());
@@ -102,7 +117,12 @@ void CuEncoder::EncodeCtu(int rsaddr, SyntaxWriter *bitstream_writer) {
     if (EncoderSettings::kEncoderStrictRdoBitCounting) {
       CompressCu(&ctu2, 0, SplitRestriction::kNone, &rdo_writer, ctu2->GetQp());
     } else {
-      RdoSyntaxWriter rdo_writer2(*bitstream_writer);
+      RdoSyntaxWriter rdo_writer2(*bitstream_writer,
+                                  bitstream_writer->GetNumWrittenBits(),
+                                  bitstream_writer->GetFractionalBits(),
+                                  frozen_contexts);
+      ctx_journal_.clear();
+      rdo_writer2.SetContextJournal(&ctx_journal_);
       CompressCu(&ctu2, 0, SplitRestriction::kNone, &rdo_writer2,
                  ctu2->GetQp());
     }
@@ -112,7 +132,7 @@ void CuEncoder::EncodeCtu(int rsaddr, SyntaxWriter *bitstream_writer) {
 
   WriteCtu(rsaddr, bitstream_writer);
   if (EncoderSettings::kEncoderStrictRdoBitCounting &&
-      EncoderSettings::kEncoderCountActualWrittenBits) {
+      EncoderSettings::kEncoderCountActualWrittenBits && !frozen_contexts) {
     assert(rdo_writer.GetNumWrittenBits() ==
            bitstream_writer->GetNumWrittenBits());
     assert(rdo_writer.GetFractionalBits() ==
@@ -152,7 +172,12 @@ Distortion CuEncoder::CompressCu(CodingUnit **best_cu, int rdo_depth,
   }
   RdoCost best_cost(std::numeric_limits<Cost>::max());
   CodingUnit::ReconstructionState *best_state = &temp_cu_state_[rdo_depth];
-  RdoSyntaxWriter best_writer(*writer);
+  // Writer state is restored through the context journal, only contexts
+  // touched by the evaluated candidates are copied
+  RdoSyntaxWriter::ContextDelta *best_writer_state =
+    &temp_writer_state_[rdo_depth];
+  const RdoSyntaxWriter::Checkpoint start_checkpoint = writer->GetCheckpoint();
+  bool writer_has_best_state = false;
   CodingUnit **temp_cu = &rdo_temp_cu_[cu_tree][rdo_depth];
   (*temp_cu)->CopyPositionAndSizeFrom(*cu);
 
@@ -165,29 +190,56 @@ Distortion CuEncoder::CompressCu(CodingUnit **best_cu, int rdo_depth,
   if (do_full) {
     Bits start_bits = writer->GetNumWrittenBits();
     best_cost.dist =
-      CompressNoSplit(best_cu, rdo_depth, split_restiction, &best_writer);
+      CompressNoSplit(best_cu, rdo_depth, split_restiction, writer);
     cu = *best_cu;
-    Bits full_bits = best_writer.GetNumWrittenBits() - start_bits;
+    Bits full_bits = writer->GetNumWrittenBits() - start_bits;
     best_cost.cost =
       best_cost.dist + static_cast<Cost>(full_bits * qp.GetLambda() + 0.5);
     cu->SaveStateTo(best_state, rec_pic_);
+    writer->SaveDeltaTo(start_checkpoint, best_writer_state);
+    writer_has_best_state = true;
   }
 
+  // When collecting split statistics all splits are evaluated to get the
+  // actual outcome, the termination heuristics below are only recorded
+  const bool split_stats = do_full && encoder_settings_.cu_split_stats;
+
   // Skip split eval speed-up
-  if (encoder_settings_.fast_cu_split_based_on_full_cu &&
-      do_full && CanSkipAnySplitForCu(*cu)) {
-    *writer = best_writer;
+  const bool full_cu_termination =
+    encoder_settings_.fast_cu_split_based_on_full_cu &&
+    do_full && CanSkipAnySplitForCu(*cu);
+  const bool early_skip_termination =
+    do_full && IsEarlySkip(*cu, qp, best_cost.dist);
+  if ((full_cu_termination || early_skip_termination) && !split_stats) {
     return best_cost.dist;
   }
 
+  // Content adaptive split termination
+  const Cost no_split_cost = best_cost.cost;
+  SplitPredictor::Features split_features = SplitPredictor::Features();
+  if (do_full &&
+      (encoder_settings_.fast_cu_split_prediction || split_stats)) {
+    split_features = split_predictor_.GetFeatures(*cu, qp, no_split_cost);
+    if (!split_stats && split_predictor_.CanSkipSplit(split_features)) {
+      return best_cost.dist;
+    }
+  }
+  auto write_split_stats = [&](Cost final_cost) {
+    if (split_stats) {
+      split_predictor_.RecordStats(*cu, split_features, no_split_cost,
+                                   final_cost, full_cu_termination,
+                                   early_skip_termination);
+    }
+  };
+
   bool best_binary_depth_greater_than_one = false;
   Cost hor_cost = 0;
   // Horizontal split
   if (do_hor_split) {
-    RdoSyntaxWriter splitcu_writer(*writer);
+    writer->Rollback(start_checkpoint);
     RdoCost split_cost =
       CompressSplitCu(*temp_cu, rdo_depth, qp, SplitType::kHorizontal,
-                      split_restiction, &splitcu_writer);
+                      split_restiction, writer);
     hor_cost = split_cost.cost;
     for (auto &sub_cu : (*temp_cu)->GetSubCu()) {
       best_binary_depth_greater_than_one |=
@@ -198,25 +250,27 @@ Distortion CuEncoder::CompressCu(CodingUnit **best_cu, int rdo_depth,
       cu = *best_cu;
       if (!do_quad_split && !do_ver_split) {
         // No more split evaluations
-        *writer = splitcu_writer;
+        write_split_stats(split_cost.cost);
         return split_cost.dist;
       }
       best_cost = split_cost;
-      best_writer = splitcu_writer;
       cu->SaveStateTo(best_state, rec_pic_);
+      writer->SaveDeltaTo(start_checkpoint, best_writer_state);
+      writer_has_best_state = true;
     } else {
       // Restore (previous) best state
       cu->LoadStateFrom(*best_state, &rec_pic_);
       pic_data_.MarkUsedInPic(cu);
+      writer_has_best_state = false;
     }
   }
 
   // Vertical split
   if (do_ver_split) {
-    RdoSyntaxWriter splitcu_writer(*writer);
+    writer->Rollback(start_checkpoint);
     RdoCost split_cost =
       CompressSplitCu(*temp_cu, rdo_depth, qp, SplitType::kVertical,
-                      split_restiction, &splitcu_writer);
+                      split_restiction, writer);
     if (split_cost.cost < hor_cost) {
       best_binary_depth_greater_than_one = false;
       for (auto &sub_cu : (*temp_cu)->GetSubCu()) {
@@ -229,16 +283,18 @@ Distortion CuEncoder::CompressCu(CodingUnit **best_cu, int rdo_depth,
       cu = *best_cu;
       if (!do_quad_split) {
         // No more split evaluations
-        *writer = splitcu_writer;
+        write_split_stats(split_cost.cost);
         return split_cost.dist;
       }
       best_cost = split_cost;
-      best_writer = splitcu_writer;
       cu->SaveStateTo(best_state, rec_pic_);
+      writer->SaveDeltaTo(start_checkpoint, best_writer_state);
+      writer_has_best_state = true;
     } else {
       // Restore (previous) best state
       cu->LoadStateFrom(*best_state, &rec_pic_);
       pic_data_.MarkUsedInPic(cu);
+      writer_has_best_state = false;
     }
   }
 
@@ -246,29 +302,38 @@ Distortion CuEncoder::CompressCu(CodingUnit **best_cu, int rdo_depth,
   if (encoder_settings_.fast_quad_split_based_on_binary_split &&
       do_quad_split && do_hor_split && do_ver_split &&
       CanSkipQuadSplitForCu(*cu, best_binary_depth_greater_than_one)) {
-    *writer = best_writer;
+    if (!writer_has_best_state) {
+      writer->Rollback(start_checkpoint);
+      writer->LoadDeltaFrom(*best_writer_state);
+    }
+    write_split_stats(best_cost.cost);
     return best_cost.dist;
   }
 
   // Quad split
   if (do_quad_split) {
-    RdoSyntaxWriter splitcu_writer(*writer);
+    writer->Rollback(start_checkpoint);
     RdoCost split_cost =
       CompressSplitCu(*temp_cu, rdo_depth, qp, SplitType::kQuad,
-                      split_restiction, &splitcu_writer);
+                      split_restiction, writer);
     if (split_cost.cost < best_cost.cost) {
       std::swap(*best_cu, *temp_cu);
       // No more split evaluations
-      *writer = splitcu_writer;
+      write_split_stats(split_cost.cost);
       return split_cost.dist;
     } else {
       // Restore (previous) best state
       cu->LoadStateFrom(*best_state, &rec_pic_);
       pic_data_.MarkUsedInPic(cu);
+      writer_has_best_state = false;
     }
   }
 
-  *writer = best_writer;
+  if (!writer_has_best_state) {
+    writer->Rollback(start_checkpoint);
+    writer->LoadDeltaFrom(*best_writer_state);
+  }
+  write_split_stats(best_cost.cost);
   return best_cost.dist;
 }
 
@@ -310,8 +375,6 @@ int CuEncoder::CalcDeltaQpFromVariance(const CodingUnit *cu) {
   const double kOffset = 15;
   const int kVarBlocksize = 16;
   const int kMeanDiv = 2;
-  const int kMinQpOffset = -3;
-  const int kMaxQpOffset = 7;
   const YuvComponent luma = YuvComponent::kY;
   const int x = cu->GetPosX(luma);
   const int y = cu->GetPosY(luma);
@@ -359,7 +422,7 @@ int CuEncoder::CalcDeltaQpFromVariance(const CodingUnit *cu) {
   int bd = orig_pic_.GetBitdepth();
   double dqp = kStrength * (1.5 * std::log(variance) - kOffset - 2 * (bd - 8));
 
-  return util::Clip3(static_cast<int>(dqp), kMinQpOffset, kMaxQpOffset);
+  return util::Clip3(static_cast<int>(dqp), kMinCtuDeltaQp, kMaxCtuDeltaQp);
 }
 
 
@@ -441,6 +504,7 @@ CuEncoder::CompressInterPic(CodingUnit **best_cu_ref, CodingUnit **temp_cu_ref,
   if (cu->GetSplit() != SplitType::kNone) {
     cu->UnSplit();
   }
+  inter_search_.ResetPredictionCache();
 
   const bool fast_skip_inter =
     encoder_settings_.fast_mode_selection_for_cached_cu &&
@@ -474,6 +538,16 @@ CuEncoder::CompressInterPic(CodingUnit **best_cu_ref, CodingUnit **temp_cu_ref,
     save_if_best_cost(cost);
   }
 
+  if (best_cost.cost < std::numeric_limits<Cost>::max() &&
+      ((encoder_settings_.fast_merge_first && best_cu->GetSkipFlag()) ||
+       IsEarlySkip(*best_cu, qp, best_cost.dist))) {
+    // Assume skip is best without evaluating any other prediction mode
+    best_cu->LoadStateFrom(*best_state, &rec_pic_);
+    *best_cu_ref = best_cu;
+    *temp_cu_ref = cu;
+    return best_cost;
+  }
+
   if (!fast_skip_inter) {
     RdoCost cost = CompressInter(cu, qp, writer, RdMode::kInterMe,
                                  best_cost.cost);
@@ -592,7 +666,6 @@ CuEncoder::CompressMerge(CodingUnit *cu, const Qp &qp,
   std::array<int, constants::kNumInterMergeCandidates> cand_lookup;
   if (encoder_settings_.fast_merge_eval &&
       !fast_merge_skip && num_merge_cand > 1) {
-    // TODO(PH) Prediction samples for each candidate can be used in loop below
     num_merge_cand =
       inter_search_.SearchMergeCandidates(cu, qp, bitstream_writer, merge_list,
                                           this, &cand_lookup);
@@ -736,10 +809,32 @@ void CuEncoder::SetQpForAllCusInCtu(CodingUnit *ctu, int qp) {
 
 
 bool CuEncoder::CanSkipAnySplitForCu(const CodingUnit &cu) const {
+  if (encoder_settings_.fast_merge_first) {
+    return cu.GetSkipFlag();
+  }
   const int binary_depth_threshold = pic_data_.IsHighestLayer() ? 2 : 3;
   return cu.GetSkipFlag() && cu.GetBinaryDepth() >= binary_depth_threshold;
 }
 
+bool CuEncoder::IsEarlySkip(const CodingUnit &cu, const Qp &qp,
+                            Distortion dist) const {
+  // Skip with low distortion relative to lambda, and thus qp, is not likely
+  // to be improved by motion search, coding a residual or splitting. The
+  // distortion covers all components of the cu, so the threshold is given
+  // in 1/256 of lambda per sample with chroma samples weighted the same way
+  // as their distortion.
+  if (!encoder_settings_.fast_skip_detection || !cu.GetSkipFlag()) {
+    return false;
+  }
+  double num_samples = 0;
+  for (YuvComponent comp : pic_data_.GetComponents(cu.GetCuTree())) {
+    num_samples += qp.GetDistortionWeight(comp) *
+      cu.GetWidth(comp) * cu.GetHeight(comp);
+  }
+  return 256.0 * dist <=
+    encoder_settings_.fast_skip_detection * qp.GetLambda() * num_samples;
+}
+
 bool
 CuEncoder::CanSkipQuadSplitForCu(const CodingUnit &cu,
                                  bool binary_depth_greater_than_one) const {
@@ -34,6 +34,7 @@
 #include "xvc_enc_lib/intra_search.h"
 #include "xvc_enc_lib/encoder_settings.h"
 #include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/split_predictor.h"
 #include "xvc_enc_lib/syntax_writer.h"
 #include "xvc_enc_lib/transform_encoder.h"
 
@@ -46,6 +47,34 @@ public:
             const EncoderSettings &encoder_settings);
   ~CuEncoder();
   void EncodeCtu(int rsaddr, SyntaxWriter *writer);
+  // Additional per ctu qp offsets, only used with adaptive qp
+  void SetCtuQpOffsets(const std::vector<int> *ctu_qp_offsets) {
+    ctu_qp_offsets_ = ctu_qp_offsets;
+  }
+  // Picture level motion used as start point for motion estimation
+  void SetCoarseMotion(const MotionPyramid::RefMotionFields *coarse_motion) {
+    inter_search_.SetCoarseMotion(coarse_motion);
+  }
+  // Interpolated reference pictures, null entries are filtered on demand
+  void SetSubpelPlanes(const SubpelPlaneCache::RefPlanes *subpel_planes) {
+    inter_search_.SetSubpelPlanes(subpel_planes);
+  }
+  // Storage for reusing motion compensated predictions within a cu
+  void SetInterPredCache(std::vector<Sample> *pred_cache_samples) {
+    inter_search_.SetPredictionCache(pred_cache_samples);
+  }
+  // Edge directions of the original picture for intra mode pruning
+  void SetEdgeDirections(const EdgeDirectionMap *edge_map) {
+    intra_search_.SetEdgeDirections(edge_map);
+  }
+  // Cu sizes of the closest reference picture for split prediction
+  void SetColocatedCuSizes(const CuSizeMap *colocated) {
+    split_predictor_.SetColocatedCuSizes(colocated);
+  }
+  // Destination of the split statistics when enabled by the settings
+  void SetCuSplitStats(std::vector<xvc_enc_cu_split_stats> *stats) {
+    split_predictor_.SetStatsOutput(stats);
+  }
 
 private:
   enum class RdMode {
@@ -90,6 +119,7 @@ private:
   void WriteCtu(int rsaddr, SyntaxWriter *writer);
   void SetQpForAllCusInCtu(CodingUnit *ctu, int qp);
   bool CanSkipAnySplitForCu(const CodingUnit &cu) const;
+  bool IsEarlySkip(const CodingUnit &cu, const Qp &qp, Distortion dist) const;
   bool CanSkipQuadSplitForCu(const CodingUnit &cu,
                              bool binary_depth_greater_than_one) const;
 
@@ -101,10 +131,15 @@ private:
   IntraSearch intra_search_;
   CuWriter cu_writer_;
   CuCache cu_cache_;
+  SplitPredictor split_predictor_;
+  const std::vector<int> *ctu_qp_offsets_ = nullptr;
   uint32_t last_ctu_frac_bits_ = 0;
   // +2 for allow access to one depth lower than smallest CU in RDO
   std::array<CodingUnit::ReconstructionState,
     constants::kMaxBlockDepth + 2> temp_cu_state_;
+  std::array<RdoSyntaxWriter::ContextDelta,
+    constants::kMaxBlockDepth + 2> temp_writer_state_;
+  EntropyEncoder::ContextJournal ctx_journal_;
   CodingUnit::ResidualState rd_transform_state_;
   std::array<std::array<CodingUnit*, constants::kMaxBlockDepth + 2>,
     constants::kMaxNumCuTrees> rdo_temp_cu_;
@@ -0,0 +1,119 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include "xvc_enc_lib/edge_direction_map.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace xvc {
+
+// Same angles as used by angular intra prediction with 67 modes
+static const std::array<int8_t, 33> kAngleTableExt = {
+  -32, -29, -26, -23, -21, -19, -17, -15, -13, -11, -9, -7, -5, -3, -2, -1,
+  0, 1, 2, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 26, 29, 32
+};
+static const int kModeHorizontal = 18;
+static const int kModeVertical = 50;
+
+EdgeDirectionMap::EdgeDirectionMap(int width, int height, int bitdepth)
+  : width_(width),
+  height_(height),
+  bitdepth_(bitdepth),
+  mode_(width * height),
+  magnitude_(width * height) {
+  for (int ratio = -kAngleScale; ratio <= kAngleScale; ratio++) {
+    int best_offset = 0;
+    for (int offset = -16; offset <= 16; offset++) {
+      const int diff = std::abs(kAngleTableExt[16 + offset] - ratio);
+      const int best_diff = std::abs(kAngleTableExt[16 + best_offset] - ratio);
+      if (diff < best_diff ||
+          (diff == best_diff && std::abs(offset) < std::abs(best_offset))) {
+        best_offset = offset;
+      }
+    }
+    ratio_to_offset_[kAngleScale + ratio] = static_cast<int8_t>(best_offset);
+  }
+}
+
+void EdgeDirectionMap::Build(const YuvPicture &pic) {
+  const YuvComponent comp = YuvComponent::kY;
+  const Sample *src = pic.GetSamplePtr(comp, 0, 0);
+  const ptrdiff_t stride = pic.GetStride(comp);
+  const int shift = bitdepth_ - 8;
+  std::fill(mode_.begin(), mode_.end(), static_cast<uint8_t>(0));
+  std::fill(magnitude_.begin(), magnitude_.end(), static_cast<uint16_t>(0));
+  // Samples on the picture border have no gradient
+  for (int y = 1; y < height_ - 1; y++) {
+    const Sample *above = src + (y - 1) * stride;
+    const Sample *cur = src + y * stride;
+    const Sample *below = src + (y + 1) * stride;
+    for (int x = 1; x < width_ - 1; x++) {
+      const int grad_x =
+        (above[x + 1] + 2 * cur[x + 1] + below[x + 1]) -
+        (above[x - 1] + 2 * cur[x - 1] + below[x - 1]);
+      const int grad_y =
+        (below[x - 1] + 2 * below[x] + below[x + 1]) -
+        (above[x - 1] + 2 * above[x] + above[x + 1]);
+      const int magnitude = (std::abs(grad_x) + std::abs(grad_y)) >> shift;
+      if (magnitude == 0) {
+        continue;
+      }
+      mode_[y * width_ + x] =
+        static_cast<uint8_t>(GetAngularMode(grad_x, grad_y));
+      magnitude_[y * width_ + x] =
+        static_cast<uint16_t>(std::min(magnitude, 0xffff));
+    }
+  }
+}
+
+void EdgeDirectionMap::GetHistogram(int posx, int posy, int width, int height,
+                                    Histogram *hist) const {
+  hist->fill(0);
+  const int x_end = std::min(posx + width, width_);
+  const int y_end = std::min(posy + height, height_);
+  for (int y = posy; y < y_end; y++) {
+    const uint8_t *mode = &mode_[y * width_];
+    const uint16_t *magnitude = &magnitude_[y * width_];
+    for (int x = posx; x < x_end; x++) {
+      (*hist)[mode[x]] += magnitude[x];
+    }
+  }
+}
+
+int EdgeDirectionMap::GetAngularMode(int grad_x, int grad_y) const {
+  // The edge is perpendicular to the gradient, a vertical mode with angle a
+  // (in 1/32 samples per row) has gradient direction (32, a) and a
+  // horizontal mode has gradient direction (a, 32)
+  const int abs_x = std::abs(grad_x);
+  const int abs_y = std::abs(grad_y);
+  const bool same_sign = (grad_x < 0) == (grad_y < 0);
+  if (abs_x >= abs_y) {
+    int ratio = (kAngleScale * abs_y + abs_x / 2) / abs_x;
+    ratio = same_sign ? ratio : -ratio;
+    return kModeVertical + ratio_to_offset_[kAngleScale + ratio];
+  }
+  int ratio = (kAngleScale * abs_x + abs_y / 2) / abs_y;
+  ratio = same_sign ? ratio : -ratio;
+  return kModeHorizontal - ratio_to_offset_[kAngleScale + ratio];
+}
+
+}   // namespace xvc
@@ -0,0 +1,66 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#ifndef XVC_ENC_LIB_EDGE_DIRECTION_MAP_H_
+#define XVC_ENC_LIB_EDGE_DIRECTION_MAP_H_
+
+#include <array>
+#include <vector>
+
+#include "xvc_common_lib/common.h"
+#include "xvc_common_lib/cu_types.h"
+#include "xvc_common_lib/yuv_pic.h"
+
+namespace xvc {
+
+// Direction and strength of the luma gradient at each sample of a picture.
+// The direction is stored as the angular intra mode (67 mode numbering) that
+// predicts along the edge, so the histogram of a block tells which angular
+// modes are likely to predict it well.
+class EdgeDirectionMap {
+public:
+  using Histogram = std::array<uint32_t, kNbrIntraModesExt>;
+
+  EdgeDirectionMap(int width, int height, int bitdepth);
+  int GetWidth() const { return width_; }
+  int GetHeight() const { return height_; }
+  // Computes the sobel gradient of every luma sample
+  void Build(const YuvPicture &pic);
+  // Sum of gradient magnitudes for each angular mode inside the given area
+  void GetHistogram(int posx, int posy, int width, int height,
+                    Histogram *hist) const;
+
+private:
+  static const int kAngleScale = 32;
+  int GetAngularMode(int grad_x, int grad_y) const;
+
+  const int width_;
+  const int height_;
+  const int bitdepth_;
+  // Closest angle offset for each tan(angle) * kAngleScale
+  std::array<int8_t, 2 * kAngleScale + 1> ratio_to_offset_;
+  std::vector<uint8_t> mode_;
+  std::vector<uint16_t> magnitude_;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_ENC_LIB_EDGE_DIRECTION_MAP_H_
@@ -57,25 +57,79 @@ Encoder::Encoder(int internal_bitdepth, int num_threads)
 }
 
 Encoder::~Encoder() {
+  // Drop all references to input pictures before invoking their release
+  lookahead_.reset();
+  delayed_inputs_.clear();
+  thread_encoder_.reset();
+  pic_encoders_.clear();
+  InvokePendingInputReleases();
 }
 
 bool Encoder::Encode(const uint8_t *pic_bytes,
                      xvc_enc_pic_buffer *out_rec_pic, int64_t user_data) {
-  return Encode(pic_bytes, nullptr, out_rec_pic, user_data);
+  return Encode(pic_bytes, nullptr, nullptr, nullptr, out_rec_pic, user_data);
 }
 
 bool Encoder::Encode(const PicPlanes &planes, xvc_enc_pic_buffer *out_rec_pic,
                      int64_t user_data) {
-  return Encode(nullptr, &planes, out_rec_pic, user_data);
+  return Encode(nullptr, &planes, nullptr, nullptr, out_rec_pic, user_data);
+}
+
+bool Encoder::Encode(const PicPlanes &planes, ReleaseFunc release,
+                     void *opaque, xvc_enc_pic_buffer *out_rec_pic,
+                     int64_t user_data) {
+  return Encode(nullptr, &planes, release, opaque, out_rec_pic, user_data);
 }
 
 bool Encoder::Encode(const uint8_t *pic_bytes, const PicPlanes *pic_planes,
+                     ReleaseFunc release, void *opaque,
                      xvc_enc_pic_buffer *out_rec_pic, int64_t user_data) {
+  api_output_nals_.clear();
+  if (!encoder_settings_.lookahead) {
+    EncodeNextPicture(pic_bytes, pic_planes, release, opaque, nullptr,
+                      out_rec_pic, user_data);
+    return true;
+  }
+  if (!lookahead_) {
+    lookahead_.reset(new Lookahead(simd_.sample_metric,
+                                   segment_header_->GetInternalWidth(),
+                                   segment_header_->GetInternalHeight(),
+                                   segment_header_->internal_bitdepth));
+  }
+  // Input pictures are analyzed when received while encoding is delayed by
+  // the lookahead depth, so that decisions can be based on later pictures
+  std::shared_ptr<const YuvPicture> orig_pic =
+    PrepareDelayedOrigPic(pic_bytes, pic_planes, release, opaque);
+  lookahead_->Push(num_input_pics_++, orig_pic);
+  delayed_inputs_.push_back({ std::move(orig_pic), user_data });
+  if (delayed_inputs_.size() >
+      static_cast<size_t>(std::max(0, encoder_settings_.lookahead_depth))) {
+    EncodeDelayedInput(out_rec_pic);
+  } else if (out_rec_pic) {
+    out_rec_pic->pic = nullptr;
+    out_rec_pic->size = 0;
+  }
+  return true;
+}
+
+void Encoder::EncodeDelayedInput(xvc_enc_pic_buffer *out_rec_pic) {
+  DelayedInput input = std::move(delayed_inputs_.front());
+  delayed_inputs_.pop_front();
+  EncodeNextPicture(nullptr, nullptr, nullptr, nullptr,
+                    std::move(input.orig_pic), out_rec_pic, input.user_data);
+}
+
+void Encoder::EncodeNextPicture(const uint8_t *pic_bytes,
+                                const PicPlanes *pic_planes,
+                                ReleaseFunc release, void *opaque,
+                                std::shared_ptr<const YuvPicture>
+                                delayed_orig_pic,
+                                xvc_enc_pic_buffer *out_rec_pic,
+                                int64_t user_data) {
   if (!initialized_) {
     initialized_ = true;
     Initialize();
   }
-  api_output_nals_.clear();
 
   PicNum doc =
     SegmentHeader::CalcDocFromPoc(poc_, segment_header_->max_sub_gop_length,
@@ -88,7 +142,8 @@ bool Encoder::Encode(const uint8_t *pic_bytes, const PicPlanes *pic_planes,
   }
 
   // Check if it is time to encode a new segment header.
-  bool encode_segment_header = ((poc_ % segment_length_) == 0);
+  bool encode_segment_header =
+    (((poc_ - segment_start_poc_) % segment_length_) == 0);
   if (segment_header_->leading_pictures > 0) {
     encode_segment_header = (poc_ >= segment_header_->max_sub_gop_length &&
       ((poc_ - segment_header_->max_sub_gop_length) % segment_length_) == 0);
@@ -105,8 +160,21 @@ bool Encoder::Encode(const uint8_t *pic_bytes, const PicPlanes *pic_planes,
   std::shared_ptr<PictureEncoder> pic_enc =
     PrepareNewInputPicture(*segment_header_, doc, poc_, tid,
                            encode_segment_header, pic_bytes, pic_planes,
+                           release, opaque, std::move(delayed_orig_pic),
                            user_data);
 
+  if (lookahead_) {
+    if (tid == 0 && !encode_segment_header && CanStartSegmentAtSceneCut() &&
+        lookahead_->HasSceneCut(
+          poc_ + 1 - segment_header_->max_sub_gop_length, poc_)) {
+      // Turn the last picture of the sub-gop into an intra access picture,
+      // the rest of the sub-gop is then coded as tail pictures
+      encode_segment_header = true;
+      StartNewSegment();
+      pic_enc->Init(*segment_header_, doc, poc_, tid, true);
+    }
+  }
+
   if (encode_segment_header) {
     DetermineBufferFlags(*pic_enc);
   }
@@ -119,6 +187,12 @@ bool Encoder::Encode(const uint8_t *pic_bytes, const PicPlanes *pic_planes,
     EncodeOnePicture(pic_enc);
     doc_ = 0;
   } else if (tid == 0) {
+    if (lookahead_) {
+      // Qp offsets of the sub-gop also account for the pictures received
+      // after it, the remaining pictures are updated again with later input
+      lookahead_->Propagate(lookahead_propagate_poc_, num_input_pics_ - 1);
+      lookahead_propagate_poc_ = GetLookaheadPoc(poc_) + 1;
+    }
     for (PicNum i = 0; i < segment_header_->max_sub_gop_length; i++) {
       for (auto &pic : pic_encoders_) {
         if (pic->GetPicData()->GetDoc() == doc_ + 1) {
@@ -143,11 +217,17 @@ bool Encoder::Encode(const uint8_t *pic_bytes, const PicPlanes *pic_planes,
     out_rec_pic->size = 0;
   }
   PrepareOutputNals();
-  return true;
+  ReleaseUnusedInputPictures(false);
+  InvokePendingInputReleases();
 }
 
 bool Encoder::Flush(xvc_enc_pic_buffer *rec_pic) {
   api_output_nals_.clear();
+  if (!delayed_inputs_.empty()) {
+    // Pictures held back by the lookahead are encoded one per call
+    EncodeDelayedInput(rec_pic);
+    return true;
+  }
   // Since poc is increased at the end of each call to Encode
   // it is reduced by one here to get the poc of the last picture.
   if (poc_ > 0) {
@@ -156,6 +236,10 @@ bool Encoder::Flush(xvc_enc_pic_buffer *rec_pic) {
 
   // Check if there are pictures left to encode.
   if (doc_ < poc_) {
+    if (lookahead_ && !(doc_ == 0 && segment_header_->leading_pictures)) {
+      lookahead_->Propagate(lookahead_propagate_poc_, num_input_pics_ - 1);
+      lookahead_propagate_poc_ = num_input_pics_;
+    }
     // If flush is performed before a full SubGop has been input,
     // then leading_pictures is disabled and picture numbers are
     // recalculated.
@@ -195,8 +279,11 @@ bool Encoder::Flush(xvc_enc_pic_buffer *rec_pic) {
   // Check if reconstruction should be performed.
   ReconstructNextPicture(rec_pic);
   PrepareOutputNals();
-  return doc_ + 1 < poc_ || last_rec_poc_ + 1 < poc_ ||
+  const bool more_output = doc_ + 1 < poc_ || last_rec_poc_ + 1 < poc_ ||
     !doc_bitstream_order_.empty();
+  ReleaseUnusedInputPictures(!more_output);
+  InvokePendingInputReleases();
+  return more_output;
 }
 
 void Encoder::SetEncoderSettings(const EncoderSettings &settings) {
@@ -226,10 +313,17 @@ void Encoder::SetEncoderSettings(const EncoderSettings &settings) {
   if (settings.fast_inter_adaptive_fullpel_mv) {
     restrictions.disable_ext2_inter_adaptive_fullpel_mv = 1;
   }
+  if (settings.fast_inter_affine) {
+    restrictions.disable_ext2_inter_affine = 1;
+  }
   Restrictions::GetRW() = restrictions;
 }
 
 void Encoder::Initialize() {
+  if (encoder_settings_.leading_pictures < 0) {
+    encoder_settings_.leading_pictures = DetermineLeadingPictures() ? 1 : 0;
+    segment_header_->leading_pictures = encoder_settings_.leading_pictures;
+  }
   if (encoder_settings_.leading_pictures > 0 &&
     (segment_header_->max_sub_gop_length == 1 ||
      segment_header_->low_delay)) {
@@ -248,6 +342,13 @@ void Encoder::Initialize() {
     extra_num_buffered_subgops_ =
       static_cast<int>(thread_encoder_->GetNumThreads() - 1);
   }
+  if (target_bitrate_ > 0 || max_bitrate_ > 0) {
+    const double intra_period = static_cast<double>(
+      std::min(segment_length_, closed_gop_interval_));
+    rate_control_.reset(new RateControl(target_bitrate_, max_bitrate_,
+                                        vbv_buffer_size_, framerate_,
+                                        intra_period, segment_qp_));
+  }
   pic_buffering_num_ = segment_header_->num_ref_pics +
     static_cast<size_t>(segment_header_->max_sub_gop_length);
   if (!extra_num_buffered_subgops_) {
@@ -260,7 +361,23 @@ void Encoder::Initialize() {
   }
 }
 
+bool Encoder::DetermineLeadingPictures() {
+  // Start with an intra picture either at the first picture, or at the last
+  // picture of the first sub-gop with the preceding pictures coded as
+  // leading pictures, depending on which is expected to predict a picture
+  // in between at lowest cost
+  const PicNum sub_gop_length = segment_header_->max_sub_gop_length;
+  if (!lookahead_ || segment_header_->low_delay || sub_gop_length < 4 ||
+      num_input_pics_ < sub_gop_length) {
+    return false;
+  }
+  const PicNum middle_poc = (11 * sub_gop_length + 8) / 16;
+  return lookahead_->GetInterCost(middle_poc, sub_gop_length - 1) <=
+    lookahead_->GetInterCost(0, middle_poc);
+}
+
 void Encoder::StartNewSegment() {
+  segment_start_poc_ = poc_;
   prev_segment_header_ = std::move(segment_header_);
   segment_header_.reset(new SegmentHeader(*prev_segment_header_));
   if (((poc_ + segment_length_) % closed_gop_interval_) == 0) {
@@ -273,6 +390,12 @@ void Encoder::StartNewSegment() {
      poc_ != segment_header_->max_sub_gop_length)) {
     segment_header_->soc++;
   }
+  pending_segment_headers_.push_back(segment_header_);
+}
+
+bool Encoder::CanStartSegmentAtSceneCut() const {
+  return poc_ > 0 && !encoder_settings_.leading_pictures &&
+    !segment_header_->low_delay;
 }
 
 void Encoder::EncodeOnePicture(std::shared_ptr<PictureEncoder> pic_enc) {
@@ -286,6 +409,15 @@ void Encoder::EncodeOnePicture(std::shared_ptr<PictureEncoder> pic_enc) {
   assert(pic_enc->GetOutputStatus() == OutputStatus::kReady);
   pic_enc->SetOutputStatus(OutputStatus::kProcessing);
 
+  if (lookahead_) {
+    Lookahead::QpOffsets qp_offsets =
+      lookahead_->GetQpOffsets(GetLookaheadPoc(pic_enc->GetPoc()));
+    // Only pictures used for reference pass information on to others
+    if (!pic_enc->GetPicData()->IsHighestLayer()) {
+      pic_enc->SetQpOffsets(std::move(qp_offsets));
+    }
+  }
+
   NalBuffer pic_nal_buffer;
   if (!avail_nal_buffers_.empty()) {
     pic_nal_buffer = std::move(avail_nal_buffers_.back());
@@ -294,6 +426,23 @@ void Encoder::EncodeOnePicture(std::shared_ptr<PictureEncoder> pic_enc) {
     pic_nal_buffer.reset(new std::vector<uint8_t>());
   }
 
+  int segment_qp = segment_qp_;
+  if (rate_control_) {
+    // The qp is updated once per sub-gop to keep the qp between temporal
+    // layers consistent, starting with the lowest layer picture
+    if (pic_enc->GetPicData()->GetTid() == 0) {
+      const PicNum sub_gop_length = segment_header->max_sub_gop_length;
+      const PicNum poc = pic_enc->GetPoc();
+      const PicNum feedback_end_poc =
+        poc + 1 > 2 * sub_gop_length ? poc + 1 - 2 * sub_gop_length : 0;
+      WaitForRateControlFeedback(feedback_end_poc);
+      const bool is_intra = pic_enc->GetPicData()->IsIntraPic();
+      const int num_pics = poc == 0 ? 1 : static_cast<int>(sub_gop_length);
+      rate_control_->StartSubGop(num_pics, is_intra, feedback_end_poc);
+    }
+    segment_qp = rate_control_->GetQp();
+  }
+
   // Determine reference pictures
   ReferenceListSorter<PictureEncoder>
     ref_list_sorter(*segment_header, prev_segment_header_->open_gop);
@@ -305,13 +454,13 @@ void Encoder::EncodeOnePicture(std::shared_ptr<PictureEncoder> pic_enc) {
 
   if (thread_encoder_) {
     thread_encoder_->EncodeAsync(segment_header, pic_enc, dependent_pic_enc,
-                                 std::move(pic_nal_buffer), segment_qp_,
+                                 std::move(pic_nal_buffer), segment_qp,
                                  pic_enc->GetBufferFlag());
   } else {
     // Bitstream reference valid until next picture is coded
     const std::vector<uint8_t> *pic_bytes =
-      pic_enc->Encode(*segment_header, segment_qp_, pic_enc->GetBufferFlag(),
-                      encoder_settings_);
+      pic_enc->Encode(*segment_header, segment_qp, pic_enc->GetBufferFlag(),
+                      dependent_pic_enc, encoder_settings_);
     *pic_nal_buffer = *pic_bytes;
     pic_enc->SetOutputStatus(OutputStatus::kFinishedProcessing);
     OnPictureEncoded(pic_enc, dependent_pic_enc, std::move(pic_nal_buffer));
@@ -325,6 +474,26 @@ void Encoder::EncodeOnePicture(std::shared_ptr<PictureEncoder> pic_enc) {
   doc_++;
 }
 
+void Encoder::WaitForRateControlFeedback(PicNum end_poc) {
+  // The qp of a sub-gop is only based on pictures from before the previous
+  // sub-gop, which gives the same result regardless of number of threads
+  if (!thread_encoder_) {
+    return;
+  }
+  for (auto &pic_enc : pic_encoders_) {
+    const OutputStatus status = pic_enc->GetOutputStatus();
+    if (pic_enc->GetPoc() < end_poc &&
+        (status == OutputStatus::kProcessing ||
+         status == OutputStatus::kFinishedProcessing)) {
+      thread_encoder_->WaitForPicture(
+        pic_enc, [this](std::shared_ptr<PictureEncoder> pic,
+                        const PicEncList &deps, NalBuffer &&nal_buffer) {
+        OnPictureEncoded(pic, deps, std::move(nal_buffer));
+      });
+    }
+  }
+}
+
 void Encoder::OnPictureEncoded(std::shared_ptr<PictureEncoder> pic_enc,
                                const PicEncList &inter_deps,
                                NalBuffer &&pic_nal_buffer) {
@@ -339,6 +508,17 @@ void Encoder::OnPictureEncoded(std::shared_ptr<PictureEncoder> pic_enc,
   nal.buffer_flag = pic_enc->GetBufferFlag();
   nal.user_data = pic_enc ? pic_enc->GetUserData() : 0;
   SetNalStats(*pic_enc->GetPicData(), *pic_enc, &nal.stats);
+  if (cu_split_stats_func_) {
+    for (const xvc_enc_cu_split_stats &stats : pic_enc->GetCuSplitStats()) {
+      cu_split_stats_func_(cu_split_stats_opaque_, &stats);
+    }
+  }
+  if (rate_control_) {
+    rate_control_->OnPictureEncoded(
+      pic_enc->GetPoc(), pic_enc->GetDoc(), 8 * nal.size,
+      pic_enc->GetPicData()->IsIntraPic(), pic_enc->GetSegmentQp(),
+      pic_enc->GetPicData()->GetPicQp()->GetQpRaw(YuvComponent::kY));
+  }
   auto &nal_stats_pair =
     pending_out_nal_buffers_[pic_enc->GetPicData()->GetDoc()];
   nal_stats_pair.first = std::move(pic_nal_buffer);
@@ -389,8 +569,14 @@ void Encoder::PrepareOutputNals() {
   xvc_enc_nal_unit &nal = next_output_nal_it->second.second;
   if (nal.stats.nal_unit_type ==
       static_cast<uint32_t>(NalUnitType::kIntraAccessPicture)) {
+    // Output may lag behind by more than one segment when using threads
+    std::shared_ptr<const SegmentHeader> segment_header = segment_header_;
+    if (!pending_segment_headers_.empty()) {
+      segment_header = pending_segment_headers_.front();
+      pending_segment_headers_.pop_front();
+    }
     xvc_enc_nal_unit segment_nal =
-      WriteSegmentHeaderNal(*segment_header_, &segment_header_bit_writer_);
+      WriteSegmentHeaderNal(*segment_header, &segment_header_bit_writer_);
     api_output_nals_.emplace_back(std::move(segment_nal));
   }
   assert(nal.bytes == &(*pic_nal_buffer)[0]);
@@ -447,6 +633,9 @@ Encoder::PrepareNewInputPicture(const SegmentHeader &segment, PicNum doc,
                                 PicNum poc, int tid, bool is_access_picture,
                                 const uint8_t *pic_bytes,
                                 const PicPlanes *pic_planes,
+                                ReleaseFunc release, void *opaque,
+                                std::shared_ptr<const YuvPicture>
+                                delayed_orig_pic,
                                 int64_t user_data) {
   // Start with assuming all picture in sub-gop reference each other
   // clean-up later in UpdateReferenceCounts, also special case for first intra
@@ -465,18 +654,131 @@ Encoder::PrepareNewInputPicture(const SegmentHeader &segment, PicNum doc,
   pic_enc->Init(segment, doc, poc, tid, is_access_picture);
   pic_enc->SetReferenceCount(ref_cnt);
   pic_enc->SetUserData(user_data);
-  PictureFormat input_format(segment.GetOutputWidth(),
-                             segment.GetOutputHeight(),
-                             input_bitdepth_, segment.chroma_format,
-                             segment.color_matrix, false);
+  if (delayed_orig_pic) {
+    pic_enc->SetExternalOrigPic(std::move(delayed_orig_pic));
+  } else if (pic_planes && release && CanReferenceInput(*pic_planes)) {
+    pic_enc->SetExternalOrigPic(
+      ReferenceInputPlanes(*pic_planes, release, opaque));
+  } else {
+    ConvertInputPicture(pic_bytes, pic_planes, release, opaque,
+                        pic_enc->PrepareOrigPic());
+  }
+  return pic_enc;
+}
+
+std::shared_ptr<const YuvPicture>
+Encoder::PrepareDelayedOrigPic(const uint8_t *pic_bytes,
+                               const PicPlanes *pic_planes,
+                               ReleaseFunc release, void *opaque) {
+  if (pic_planes && release && CanReferenceInput(*pic_planes)) {
+    return ReferenceInputPlanes(*pic_planes, release, opaque);
+  }
+  // Not owned by any picture encoder since these are yet to be assigned
+  const PictureFormat pic_fmt = segment_header_->GetInternalPicFormat();
+  std::shared_ptr<YuvPicture> orig_pic =
+    std::make_shared<YuvPicture>(pic_fmt.chroma_format, pic_fmt.width,
+                                 pic_fmt.height, pic_fmt.bitdepth, false,
+                                 segment_header_->GetCropWidth(),
+                                 segment_header_->GetCropHeight(),
+                                 picture_allocator_);
+  ConvertInputPicture(pic_bytes, pic_planes, release, opaque, orig_pic.get());
+  return orig_pic;
+}
+
+std::shared_ptr<const YuvPicture>
+Encoder::ReferenceInputPlanes(const PicPlanes &pic_planes, ReleaseFunc release,
+                              void *opaque) {
+  // Reference the input samples directly, the planes are released after
+  // the last reference to the original picture has been dropped
+  Sample *planes[constants::kMaxYuvComponents];
+  ptrdiff_t strides[constants::kMaxYuvComponents];
+  for (int c = 0; c < constants::kMaxYuvComponents; c++) {
+    planes[c] = reinterpret_cast<Sample*>(
+      const_cast<uint8_t*>(pic_planes[c].first));
+    strides[c] = pic_planes[c].second / sizeof(Sample);
+  }
+  const uint8_t *release_plane = pic_planes[0].first;
+  return std::shared_ptr<const YuvPicture>(
+    new YuvPicture(segment_header_->chroma_format,
+                   segment_header_->GetInternalWidth(),
+                   segment_header_->GetInternalHeight(),
+                   segment_header_->internal_bitdepth, planes, strides),
+    [this, release, opaque, release_plane](const YuvPicture *pic) {
+    delete pic;
+    std::lock_guard<std::mutex> lock(pending_input_release_mutex_);
+    pending_input_releases_.push_back({ release, opaque, release_plane });
+  });
+}
+
+void Encoder::ConvertInputPicture(const uint8_t *pic_bytes,
+                                  const PicPlanes *pic_planes,
+                                  ReleaseFunc release, void *opaque,
+                                  YuvPicture *orig_pic) {
+  PictureFormat input_format(segment_header_->GetOutputWidth(),
+                             segment_header_->GetOutputHeight(),
+                             input_bitdepth_, segment_header_->chroma_format,
+                             segment_header_->color_matrix, false);
   if (pic_bytes) {
-    input_resampler_.ConvertFrom(input_format, pic_bytes,
-                                 pic_enc->GetOrigPic().get());
+    input_resampler_.ConvertFrom(input_format, pic_bytes, orig_pic);
   } else if (pic_planes) {
-    input_resampler_.ConvertFrom(input_format, *pic_planes,
-                                 pic_enc->GetOrigPic().get());
+    input_resampler_.ConvertFrom(input_format, *pic_planes, orig_pic);
+    if (release) {
+      release(opaque, (*pic_planes)[0].first);
+    }
+  }
+}
+
+bool Encoder::CanReferenceInput(const PicPlanes &pic_planes) const {
+  // Input samples must have the exact memory layout of internal samples
+  const int sample_size = input_bitdepth_ > 8 ? 2 : 1;
+  if (sample_size != static_cast<int>(sizeof(Sample)) ||
+      input_bitdepth_ != segment_header_->internal_bitdepth ||
+      segment_header_->GetInternalWidth() !=
+      segment_header_->GetOutputWidth() ||
+      segment_header_->GetInternalHeight() !=
+      segment_header_->GetOutputHeight() ||
+      segment_header_->GetInternalWidth() == 0 ||
+      segment_header_->GetInternalHeight() == 0) {
+    return false;
+  }
+  const int num_components =
+    util::GetNumComponents(segment_header_->chroma_format);
+  for (int c = 0; c < num_components; c++) {
+    if (!pic_planes[c].first ||
+        reinterpret_cast<uintptr_t>(pic_planes[c].first) % sizeof(Sample) ||
+        pic_planes[c].second % sizeof(Sample)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+PicNum Encoder::GetLookaheadPoc(PicNum poc) const {
+  // Input order is one behind poc when starting with leading pictures
+  return segment_header_->leading_pictures ? poc - 1 : poc;
+}
+
+void Encoder::ReleaseUnusedInputPictures(bool all_encoded) {
+  // Original picture is no longer needed once encoded and not referenced
+  for (auto &pic_enc : pic_encoders_) {
+    OutputStatus status = pic_enc->GetOutputStatus();
+    if ((status == OutputStatus::kHasNotBeenOutput ||
+         status == OutputStatus::kHasBeenOutput) &&
+        (all_encoded || !pic_enc->IsReferenced())) {
+      pic_enc->ReleaseExternalOrigPic();
+    }
+  }
+}
+
+void Encoder::InvokePendingInputReleases() {
+  std::vector<PendingInputRelease> releases;
+  {
+    std::lock_guard<std::mutex> lock(pending_input_release_mutex_);
+    releases.swap(pending_input_releases_);
+  }
+  for (const PendingInputRelease &pending : releases) {
+    pending.release(pending.opaque, pending.plane);
   }
-  return pic_enc;
 }
 
 void Encoder::DetermineBufferFlags(const PictureEncoder &intra_pic) {
@@ -569,7 +871,8 @@ std::shared_ptr<PictureEncoder> Encoder::GetNewPictureEncoder() {
       std::make_shared<PictureEncoder>(simd_,
                                        segment_header_->GetInternalPicFormat(),
                                        segment_header_->GetCropWidth(),
-                                       segment_header_->GetCropHeight());
+                                       segment_header_->GetCropHeight(),
+                                       picture_allocator_);
     pic_encoders_.push_back(pic);
     return pic;
   }
@@ -25,6 +25,7 @@
 #include <deque>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -40,8 +41,14 @@
 #include "xvc_enc_lib/picture_encoder.h"
 #include "xvc_enc_lib/encoder_settings.h"
 #include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/lookahead.h"
+#include "xvc_enc_lib/rate_control.h"
 
-struct xvc_encoder {};
+// Api handle. When the 8bit sample pipeline is compiled in, calls on a handle
+// with a delegate are forwarded to the 8bit pipeline encoder.
+struct xvc_encoder {
+  xvc_encoder *lowbd_delegate = nullptr;
+};
 
 namespace xvc {
 
@@ -51,12 +58,21 @@ class Encoder : public xvc_encoder {
 public:
   using PicPlane = std::pair<const uint8_t *, ptrdiff_t>;
   using PicPlanes = std::array<PicPlane, constants::kMaxYuvComponents>;
+  using ReleaseFunc = void(*)(void *opaque, const uint8_t *plane);
+  using CuSplitStatsFunc = void(*)(void *opaque,
+                                   const xvc_enc_cu_split_stats *stats);
   explicit Encoder(int internal_bitdepth, int num_threads = 0);
   ~Encoder();
   bool Encode(const uint8_t *pic_bytes, xvc_enc_pic_buffer *rec_pic,
               int64_t user_data = 0);
   bool Encode(const PicPlanes &planes,
               xvc_enc_pic_buffer *rec_pic, int64_t user_data = 0);
+  // Encode input planes by reference when the input format matches the
+  // internal format, otherwise the planes are copied. release is invoked
+  // exactly once when the planes are no longer used by the encoder, always
+  // from within Encode, Flush or the destructor on the calling thread.
+  bool Encode(const PicPlanes &planes, ReleaseFunc release, void *opaque,
+              xvc_enc_pic_buffer *rec_pic, int64_t user_data = 0);
   bool Flush(xvc_enc_pic_buffer *rec_pic);
   std::vector<xvc_enc_nal_unit>& GetOutputNals() {
     return api_output_nals_;
@@ -69,6 +85,13 @@ public:
     simd_ = EncoderSimdFunctions(capabilities,
                                  segment_header_->internal_bitdepth);
   }
+  void SetPictureAllocator(const PictureAllocator &allocator) {
+    picture_allocator_ = allocator;
+  }
+  void SetCuSplitStatsCallback(CuSplitStatsFunc func, void *opaque) {
+    cu_split_stats_func_ = func;
+    cu_split_stats_opaque_ = opaque;
+  }
   void SetResolution(int width, int height) {
     segment_header_->SetWidth(width);
     segment_header_->SetHeight(height);
@@ -113,6 +136,13 @@ public:
     segment_qp_ =
       util::Clip3(qp, constants::kMinAllowedQp, constants::kMaxAllowedQp);
   }
+  // Bitrates in bits per second and buffer size in bits, zero disables
+  void SetRateControl(double target_bitrate, double max_bitrate,
+                      double buffer_size) {
+    target_bitrate_ = target_bitrate;
+    max_bitrate_ = max_bitrate;
+    vbv_buffer_size_ = buffer_size;
+  }
   void SetChecksumMode(Checksum::Mode mode) {
     segment_header_->checksum_mode = mode;
   }
@@ -124,10 +154,19 @@ private:
   using NalBuffer = std::unique_ptr<std::vector<uint8_t>>;
   using PicEncList = std::vector<std::shared_ptr<const PictureEncoder>>;
   bool Encode(const uint8_t *pic_bytes, const PicPlanes *planes,
+              ReleaseFunc release, void *opaque,
               xvc_enc_pic_buffer *rec_pic, int64_t user_data);
+  void EncodeNextPicture(const uint8_t *pic_bytes, const PicPlanes *planes,
+                         ReleaseFunc release, void *opaque,
+                         std::shared_ptr<const YuvPicture> delayed_orig_pic,
+                         xvc_enc_pic_buffer *rec_pic, int64_t user_data);
+  void EncodeDelayedInput(xvc_enc_pic_buffer *rec_pic);
   void Initialize();
+  bool DetermineLeadingPictures();
   void StartNewSegment();
+  bool CanStartSegmentAtSceneCut() const;
   void EncodeOnePicture(std::shared_ptr<PictureEncoder> pic);
+  void WaitForRateControlFeedback(PicNum end_poc);
   void OnPictureEncoded(std::shared_ptr<PictureEncoder> pic_enc,
                         const PicEncList &inter_deps,
                         NalBuffer &&pic_nal_buffer);
@@ -137,7 +176,24 @@ private:
     PrepareNewInputPicture(const SegmentHeader &segment, PicNum doc, PicNum poc,
                            int tid, bool is_access_picture,
                            const uint8_t *pic_bytes,
-                           const PicPlanes *pic_planes, int64_t user_data);
+                           const PicPlanes *pic_planes, ReleaseFunc release,
+                           void *opaque,
+                           std::shared_ptr<const YuvPicture> delayed_orig_pic,
+                           int64_t user_data);
+  std::shared_ptr<const YuvPicture>
+    PrepareDelayedOrigPic(const uint8_t *pic_bytes,
+                          const PicPlanes *pic_planes, ReleaseFunc release,
+                          void *opaque);
+  std::shared_ptr<const YuvPicture>
+    ReferenceInputPlanes(const PicPlanes &pic_planes, ReleaseFunc release,
+                         void *opaque);
+  void ConvertInputPicture(const uint8_t *pic_bytes,
+                           const PicPlanes *pic_planes, ReleaseFunc release,
+                           void *opaque, YuvPicture *orig_pic);
+  bool CanReferenceInput(const PicPlanes &pic_planes) const;
+  PicNum GetLookaheadPoc(PicNum poc) const;
+  void ReleaseUnusedInputPictures(bool all_encoded);
+  void InvokePendingInputReleases();
   void DetermineBufferFlags(const PictureEncoder &pic_enc);
   void UpdateReferenceCounts(PicNum last_subgop_end_poc);
   std::shared_ptr<PictureEncoder> GetNewPictureEncoder();
@@ -156,11 +212,31 @@ private:
   PicNum poc_ = 0;
   PicNum doc_ = 0;
   PicNum segment_length_ = 1;
+  // Segments may also start early at a scene cut
+  PicNum segment_start_poc_ = 0;
   PicNum closed_gop_interval_ = std::numeric_limits<PicNum>::max();
   size_t pic_buffering_num_ = 1;
   int extra_num_buffered_subgops_ = 0;
   int segment_qp_ = std::numeric_limits<int>::max();
+  double target_bitrate_ = 0;
+  double max_bitrate_ = 0;
+  double vbv_buffer_size_ = 0;
   EncoderSimdFunctions simd_;
+  // Declared before any picture so that buffers freed on destruction are
+  // still pooled for other instances
+  BufferPoolReference buffer_pool_reference_;
+  PictureAllocator picture_allocator_;
+  CuSplitStatsFunc cu_split_stats_func_ = nullptr;
+  void *cu_split_stats_opaque_ = nullptr;
+  // Referenced input planes that are no longer used, the last reference may
+  // be dropped on any encoder thread while release is invoked on the caller
+  struct PendingInputRelease {
+    ReleaseFunc release;
+    void *opaque;
+    const uint8_t *plane;
+  };
+  std::mutex pending_input_release_mutex_;
+  std::vector<PendingInputRelease> pending_input_releases_;
   EncoderSettings encoder_settings_;
   Resampler input_resampler_;
   std::vector<std::shared_ptr<PictureEncoder>> pic_encoders_;
@@ -169,10 +245,23 @@ private:
   std::vector<xvc_enc_nal_unit> api_output_nals_;
   std::vector<NalBuffer> avail_nal_buffers_;
   std::deque<PicNum> doc_bitstream_order_;
+  // Segments waiting for their intra access picture to be output
+  std::deque<std::shared_ptr<const SegmentHeader>> pending_segment_headers_;
   std::unordered_map<PicNum,
     std::pair<NalBuffer, xvc_enc_nal_unit>> pending_out_nal_buffers_;
   PicNum last_rec_poc_ = static_cast<PicNum>(-1);
   std::unique_ptr<ThreadEncoder> thread_encoder_;
+  std::unique_ptr<Lookahead> lookahead_;
+  std::unique_ptr<RateControl> rate_control_;
+  // Lookahead analyses are indexed by input order
+  PicNum lookahead_propagate_poc_ = 0;
+  PicNum num_input_pics_ = 0;
+  // Input pictures analyzed by the lookahead but not yet encoded
+  struct DelayedInput {
+    std::shared_ptr<const YuvPicture> orig_pic;
+    int64_t user_data;
+  };
+  std::deque<DelayedInput> delayed_inputs_;
 };
 
 }   // namespace xvc
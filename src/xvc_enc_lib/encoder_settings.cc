@@ -41,6 +41,17 @@ void EncoderSettings::Initialize(SpeedMode speed_mode) {
       fast_transform_select = 0;
       fast_inter_local_illumination_comp = 0;
       fast_inter_adaptive_fullpel_mv = 0;
+      fast_rate_estimation = 0;
+      fast_inter_affine = 0;
+      fast_merge_first = 0;
+      pyramid_motion_search = 0;
+      subpel_plane_cache = 0;
+      intra_edge_mode_pruning = 0;
+      fast_cu_split_prediction = 0;
+      fast_skip_detection = 0;
+      fast_bipred_uni_cost_ratio = 0;
+      fast_bipred_refinement_ratio = 120;
+      rdo_quant = 1;
       break;
     case SpeedMode::kSlow:
       bipred_refinement_iterations = 1;
@@ -53,6 +64,17 @@ void EncoderSettings::Initialize(SpeedMode speed_mode) {
       fast_transform_select = 0;
       fast_inter_local_illumination_comp = 0;
       fast_inter_adaptive_fullpel_mv = 0;
+      fast_rate_estimation = 0;
+      fast_inter_affine = 0;
+      fast_merge_first = 0;
+      pyramid_motion_search = 0;
+      subpel_plane_cache = 0;
+      intra_edge_mode_pruning = 0;
+      fast_cu_split_prediction = 0;
+      fast_skip_detection = 0;
+      fast_bipred_uni_cost_ratio = 0;
+      fast_bipred_refinement_ratio = 0;
+      rdo_quant = 1;
       break;
     case SpeedMode::kFast:
       bipred_refinement_iterations = 1;
@@ -65,6 +87,44 @@ void EncoderSettings::Initialize(SpeedMode speed_mode) {
       fast_transform_select = 1;
       fast_inter_local_illumination_comp = 1;
       fast_inter_adaptive_fullpel_mv = 1;
+      fast_rate_estimation = 0;
+      fast_inter_affine = 0;
+      fast_merge_first = 0;
+      pyramid_motion_search = 0;
+      subpel_plane_cache = 0;
+      intra_edge_mode_pruning = 4;
+      fast_cu_split_prediction = 1;
+      fast_skip_detection = 0;
+      fast_bipred_uni_cost_ratio = 0;
+      fast_bipred_refinement_ratio = 0;
+      rdo_quant = 1;
+      break;
+    case SpeedMode::kUltraFast:
+      inter_search_range_uni_max = 64;
+      inter_search_range_uni_min = 32;
+      bipred_refinement_iterations = 1;
+      always_evaluate_intra_in_inter = 0;
+      default_num_ref_pics = 1;
+      max_binary_split_depth = 1;
+      fast_transform_select_eval = 1;
+      fast_intra_mode_eval_level = 3;
+      fast_transform_size_64 = 1;
+      fast_transform_select = 1;
+      fast_inter_local_illumination_comp = 1;
+      fast_inter_adaptive_fullpel_mv = 1;
+      fast_rate_estimation = 1;
+      fast_inter_affine = 1;
+      fast_merge_first = 1;
+      pyramid_motion_search = 1;
+      subpel_plane_cache = 0;
+      intra_edge_mode_pruning = 4;
+      fast_cu_split_prediction = 1;
+      fast_skip_detection = 0;
+      fast_bipred_uni_cost_ratio = 0;
+      fast_bipred_refinement_ratio = 0;
+      rdo_quant = 0;
+      fast_merge_eval = 2;
+      fast_quad_split_based_on_binary_split = 2;
       break;
     default:
       assert(0);
@@ -88,6 +148,17 @@ void EncoderSettings::Initialize(RestrictedMode mode) {
   fast_transform_select = 0;
   fast_inter_local_illumination_comp = 0;
   fast_inter_adaptive_fullpel_mv = 0;
+  fast_rate_estimation = 0;
+  fast_inter_affine = 0;
+  fast_merge_first = 0;
+  pyramid_motion_search = 0;
+  subpel_plane_cache = 0;
+  intra_edge_mode_pruning = 0;
+  fast_cu_split_prediction = 0;
+  fast_skip_detection = 0;
+  fast_bipred_uni_cost_ratio = 0;
+  fast_bipred_refinement_ratio = 0;
+  rdo_quant = 1;
   fast_merge_eval = 1;
   fast_quad_split_based_on_binary_split = 2;
   eval_prev_mv_search_result = 0;
@@ -145,6 +216,8 @@ void EncoderSettings::ParseExplicitSettings(std::string explicit_settings) {
       stream >> inter_search_range_uni_max;
     } else if (setting == "inter_search_range_uni_min") {
       stream >> inter_search_range_uni_min;
+    } else if (setting == "inter_search_range_bi") {
+      stream >> inter_search_range_bi;
     } else if (setting == "bipred_refinement_iterations") {
       stream >> bipred_refinement_iterations;
     } else if (setting == "always_evaluate_intra_in_inter") {
@@ -165,6 +238,28 @@ void EncoderSettings::ParseExplicitSettings(std::string explicit_settings) {
       stream >> fast_inter_local_illumination_comp;
     } else if (setting == "fast_inter_adaptive_fullpel_mv") {
       stream >> fast_inter_adaptive_fullpel_mv;
+    } else if (setting == "fast_rate_estimation") {
+      stream >> fast_rate_estimation;
+    } else if (setting == "fast_inter_affine") {
+      stream >> fast_inter_affine;
+    } else if (setting == "fast_merge_first") {
+      stream >> fast_merge_first;
+    } else if (setting == "pyramid_motion_search") {
+      stream >> pyramid_motion_search;
+    } else if (setting == "subpel_plane_cache") {
+      stream >> subpel_plane_cache;
+    } else if (setting == "intra_edge_mode_pruning") {
+      stream >> intra_edge_mode_pruning;
+    } else if (setting == "fast_cu_split_prediction") {
+      stream >> fast_cu_split_prediction;
+    } else if (setting == "fast_skip_detection") {
+      stream >> fast_skip_detection;
+    } else if (setting == "fast_bipred_uni_cost_ratio") {
+      stream >> fast_bipred_uni_cost_ratio;
+    } else if (setting == "fast_bipred_refinement_ratio") {
+      stream >> fast_bipred_refinement_ratio;
+    } else if (setting == "rdo_quant") {
+      stream >> rdo_quant;
     } else if (setting == "fast_merge_eval") {
       stream >> fast_merge_eval;
     } else if (setting == "fast_quad_split_based_on_binary_split") {
@@ -173,6 +268,8 @@ void EncoderSettings::ParseExplicitSettings(std::string explicit_settings) {
       stream >> eval_prev_mv_search_result;
     } else if (setting == "fast_inter_pred_bits") {
       stream >> fast_inter_pred_bits;
+    } else if (setting == "inter_pred_cache") {
+      stream >> inter_pred_cache;
     } else if (setting == "rdo_quant_2x2") {
       stream >> rdo_quant_2x2;
     } else if (setting == "intra_qp_offset") {
@@ -193,6 +290,10 @@ void EncoderSettings::ParseExplicitSettings(std::string explicit_settings) {
       stream >> leading_pictures;
     } else if (setting == "source_padding") {
       stream >> source_padding;
+    } else if (setting == "lookahead") {
+      stream >> lookahead;
+    } else if (setting == "lookahead_depth") {
+      stream >> lookahead_depth;
     } else if (setting == "lambda_scale_a") {
       stream >> lambda_scale_a;
     } else if (setting == "lambda_scale_b") {
@@ -33,7 +33,8 @@ enum struct SpeedMode {
   kPlacebo = 0,
   kSlow = 1,
   kFast = 2,
-  kTotalNumber = 3,
+  kUltraFast = 3,
+  kTotalNumber = 4,
 };
 
 enum struct TuneMode {
@@ -56,13 +57,11 @@ struct EncoderSettings {
                 "Fast bit counting should use strict rdo bit signaling");
 
   // Fast encoder decisions (always used)
-  static const bool rdo_quant = true;
   static const bool fast_cu_split_based_on_full_cu = true;
   static const bool fast_mode_selection_for_cached_cu = true;
   static const bool skip_mode_decision_for_identical_cu = false;
   static const bool fast_inter_transform_dist = true;  // not really any impact
   static const bool fast_inter_root_cbf_zero_bits = false;  // very small loss
-  static const int inter_search_range_bi = 4;
 
   // Speed mode dependent settings
   int inter_search_range_uni_max = 256;
@@ -77,12 +76,25 @@ struct EncoderSettings {
   int fast_transform_select = -1;
   int fast_inter_local_illumination_comp = -1;
   int fast_inter_adaptive_fullpel_mv = -1;
+  int fast_rate_estimation = -1;
+  int fast_inter_affine = -1;
+  int fast_merge_first = -1;
+  int pyramid_motion_search = -1;
+  int subpel_plane_cache = -1;
+  int intra_edge_mode_pruning = -1;
+  int fast_cu_split_prediction = -1;
+  int fast_skip_detection = -1;
+  int fast_bipred_uni_cost_ratio = -1;
+  int fast_bipred_refinement_ratio = -1;
+  int rdo_quant = -1;
 
   // Settings with default values used in all speed modes
+  int inter_search_range_bi = 4;
   int fast_merge_eval = 1;
   int fast_quad_split_based_on_binary_split = 1;
   int eval_prev_mv_search_result = 1;
   int fast_inter_pred_bits = 0;
+  int inter_pred_cache = 1;
   int rdo_quant_2x2 = 1;
   int intra_qp_offset = 0;
   int smooth_lambda_scaling = 1;
@@ -93,10 +105,13 @@ struct EncoderSettings {
   int encapsulation_mode = 0;
   int leading_pictures = 0;
   int source_padding = 1;
+  int lookahead = 0;
+  int lookahead_depth = 0;
   int chroma_qp_offset_table = 1;
   int chroma_qp_offset_u = 0;
   int chroma_qp_offset_v = 0;
   int flat_lambda = 0;
+  int cu_split_stats = 0;
   float lambda_scale_a = 1.0f;
   float lambda_scale_b = 0.0f;
   RestrictedMode restricted_mode = RestrictedMode::kUnrestricted;
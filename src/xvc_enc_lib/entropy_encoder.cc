@@ -21,6 +21,8 @@
 
 #include "xvc_enc_lib/entropy_encoder.h"
 
+#include <cassert>
+
 #include "xvc_common_lib/cabac.h"
 #include "xvc_enc_lib/encoder_settings.h"
 
@@ -32,7 +34,14 @@ EntropyEncoder::EntropyEncoder(BitWriter *bit_writer)
 
 EntropyEncoder::EntropyEncoder(BitWriter *bit_writer, uint32_t written_bits,
                                uint32_t fractional_bits)
-  : bit_writer_(bit_writer) {
+  : EntropyEncoder(bit_writer, written_bits, fractional_bits, true) {
+}
+
+EntropyEncoder::EntropyEncoder(BitWriter *bit_writer, uint32_t written_bits,
+                               uint32_t fractional_bits, bool update_contexts)
+  : bit_writer_(bit_writer),
+  update_contexts_(update_contexts) {
+  assert(!bit_writer || update_contexts);
   Start();
   frac_bits_ = (written_bits << 15) | (fractional_bits & 32767);
 }
@@ -43,6 +52,12 @@ void EntropyEncoder::EncodeBin(uint32_t binval, ContextModel *ctx) {
 
   if (!bit_writer_) {
     frac_bits_ += ctx->GetEntropyBits(binval);
+    if (!update_contexts_) {
+      return;
+    }
+    if (ctx_journal_) {
+      ctx_journal_->push_back({ ctx, *ctx });
+    }
     if (binval != ctxmps) {
       ctx->UpdateLPS();
     } else {
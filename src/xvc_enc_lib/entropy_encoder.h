@@ -22,6 +22,8 @@
 #ifndef XVC_ENC_LIB_ENTROPY_ENCODER_H_
 #define XVC_ENC_LIB_ENTROPY_ENCODER_H_
 
+#include <vector>
+
 #include "xvc_common_lib/context_model.h"
 #include "xvc_enc_lib/bit_writer.h"
 
@@ -29,9 +31,18 @@ namespace xvc {
 
 class EntropyEncoder {
 public:
+  // Context state prior to an update, used for rolling back rdo decisions
+  struct ContextJournalEntry {
+    ContextModel *ctx;
+    ContextModel state;
+  };
+  using ContextJournal = std::vector<ContextJournalEntry>;
+
   explicit EntropyEncoder(BitWriter *bit_writer);
   EntropyEncoder(BitWriter *bit_writer, uint32_t written_bits,
                  uint32_t fractional_bits);
+  EntropyEncoder(BitWriter *bit_writer, uint32_t written_bits,
+                 uint32_t fractional_bits, bool update_contexts);
 
   void EncodeBin(uint32_t binval, ContextModel *ctx);
   void EncodeBypass(uint32_t binval);
@@ -39,6 +50,12 @@ public:
   void EncodeBinTrm(uint32_t binval);
 
   void ResetBitCounting() { frac_bits_ &= 32767; }
+  void SetBitCounting(Bits written_bits, Bits fractional_bits) {
+    frac_bits_ = (static_cast<uint64_t>(written_bits) << 15) |
+      (fractional_bits & 32767);
+  }
+  ContextJournal* GetContextJournal() const { return ctx_journal_; }
+  void SetContextJournal(ContextJournal *journal) { ctx_journal_ = journal; }
   void Start();
   void Finish();
   Bits GetNumWrittenBits() const {
@@ -59,6 +76,8 @@ private:
   int bits_left_;
   uint64_t frac_bits_ = 0;
   BitWriter *bit_writer_;
+  bool update_contexts_ = true;
+  ContextJournal *ctx_journal_ = nullptr;
 };
 
 }   // namespace xvc
@@ -0,0 +1,177 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include "xvc_enc_lib/inter_full_search.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "xvc_enc_lib/inter_search.h"
+
+namespace xvc {
+
+MvFullpel FullSearch::Search(const CodingUnit &cu, const Qp &qp,
+                             const SampleMetric &metric,
+                             const ResidualBufferConst &orig_buffer,
+                             const MotionVector &mvp,
+                             const YuvPicture &ref_pic,
+                             const MvFullpel &mv_min,
+                             const MvFullpel &mv_max) {
+  const YuvComponent comp = YuvComponent::kY;
+  const int width = cu.GetWidth(comp);
+  const int height = cu.GetHeight(comp);
+  const int mvd_precision =
+    cu.GetFullpelMv() ? MvDelta::kPrecisionShift : 0;
+  const uint32_t lambda =
+    static_cast<uint32_t>(std::floor(65536.0 * qp.GetLambdaSqrt()));
+  const Residual *orig = orig_buffer.GetDataPtr();
+  const ptrdiff_t orig_stride = orig_buffer.GetStride();
+  const Sample *ref_cu = ref_pic.GetSamplePtr(comp, cu.GetPosX(comp),
+                                              cu.GetPosY(comp));
+  const ptrdiff_t ref_stride = ref_pic.GetStride(comp);
+  const int num_x = mv_max.x - mv_min.x + 1;
+  const int num_y = mv_max.y - mv_min.y + 1;
+  auto get_dist = [&](int mv_x, int mv_y) {
+    const Sample *ref_mv = ref_cu + mv_y * ref_stride + mv_x;
+    return metric.CompareSample(qp, comp, width, height, orig, orig_stride,
+                                ref_mv, ref_stride);
+  };
+
+  // Successive elimination, the difference between the sums of the original
+  // and reference blocks is a lower bound of the sad at each position
+  const MetricType metric_type = metric.GetType();
+  const bool is_sad =
+    metric_type == MetricType::kSad || metric_type == MetricType::kSadFast;
+  const bool use_sum_bound = is_sad && num_x * num_y > 1;
+  const int row_step = metric_type == MetricType::kSadFast ? 2 : 1;
+  const int dist_shift = bitdepth_ - 8;
+  int orig_sum = 0;
+  if (use_sum_bound) {
+    for (int y = 0; y < height; y += row_step) {
+      for (int x = 0; x < width; x++) {
+        orig_sum += orig[y * orig_stride + x];
+      }
+    }
+    ComputeBlockSums(ref_cu + mv_min.y * ref_stride + mv_min.x, ref_stride,
+                     width, height, row_step, num_x, num_y);
+  }
+
+  // Starting from the center of the window gives a tight bound early, the
+  // raster order below still selects the first position with lowest cost
+  const int center_x = (mv_min.x + mv_max.x) / 2;
+  const int center_y = (mv_min.y + mv_max.y) / 2;
+  Distortion cost_best = std::numeric_limits<Distortion>::max();
+  MvFullpel mv_best(center_x, center_y);
+  if (use_sum_bound) {
+    Bits bits =
+      InterSearch::GetMvdBitsFullpel(mvp, center_x, center_y, mvd_precision);
+    cost_best = get_dist(center_x, center_y) + ((lambda * bits) >> 16) + 1;
+  }
+  std::array<Distortion, kNumOffsets> bound;
+  std::array<Distortion, kNumOffsets> mv_cost;
+  std::array<Distortion, kNumOffsets> dist_x4;
+  for (int mv_y = mv_min.y; mv_y <= mv_max.y; mv_y++) {
+    for (int mv_x0 = mv_min.x; mv_x0 <= mv_max.x; mv_x0 += kNumOffsets) {
+      const int num_offsets = std::min(kNumOffsets, mv_max.x - mv_x0 + 1);
+      int num_candidates = 0;
+      for (int i = 0; i < num_offsets; i++) {
+        bound[i] = 0;
+        if (use_sum_bound) {
+          const int ref_sum =
+            block_sums_[(mv_y - mv_min.y) * num_x + mv_x0 + i - mv_min.x];
+          bound[i] = (std::abs(orig_sum - ref_sum) * row_step) >> dist_shift;
+        }
+        Bits bits =
+          InterSearch::GetMvdBitsFullpel(mvp, mv_x0 + i, mv_y, mvd_precision);
+        mv_cost[i] = (lambda * bits) >> 16;
+        num_candidates += bound[i] + mv_cost[i] < cost_best;
+      }
+      // Evaluating several offsets at once reuses the loads of the original,
+      // positions that are skipped below only cost extra arithmetic
+      const bool use_x4 =
+        is_sad && num_offsets == kNumOffsets && num_candidates > 1;
+      if (use_x4) {
+        metric.CompareSampleX4(qp, comp, width, height, orig, orig_stride,
+                               ref_cu + mv_y * ref_stride + mv_x0, ref_stride,
+                               &dist_x4[0]);
+      }
+      for (int i = 0; i < num_offsets; i++) {
+        if (bound[i] + mv_cost[i] >= cost_best) {
+          continue;
+        }
+        Distortion dist = use_x4 ? dist_x4[i] : get_dist(mv_x0 + i, mv_y);
+        if (dist >= cost_best) {
+          continue;
+        }
+        Distortion cost = dist + mv_cost[i];
+        if (cost < cost_best) {
+          cost_best = cost;
+          mv_best.x = mv_x0 + i;
+          mv_best.y = mv_y;
+        }
+      }
+    }
+  }
+  return mv_best;
+}
+
+void FullSearch::ComputeBlockSums(const Sample *ref, ptrdiff_t ref_stride,
+                                  int width, int height, int row_step,
+                                  int num_x, int num_y) {
+  // Column sums are kept separately for each row phase and updated
+  // incrementally when moving down one position
+  const int window_width = num_x + width - 1;
+  block_col_sums_.assign(row_step * window_width, 0);
+  block_sums_.resize(num_x * num_y);
+  for (int y = 0; y < num_y; y++) {
+    int *col_sum = &block_col_sums_[(y % row_step) * window_width];
+    if (y < row_step) {
+      for (int row = 0; row < height; row += row_step) {
+        const Sample *src = ref + (y + row) * ref_stride;
+        for (int x = 0; x < window_width; x++) {
+          col_sum[x] += src[x];
+        }
+      }
+    } else {
+      const Sample *src_out = ref + (y - row_step) * ref_stride;
+      const Sample *src_in = ref + (y - row_step + height) * ref_stride;
+      for (int x = 0; x < window_width; x++) {
+        col_sum[x] += src_in[x] - src_out[x];
+      }
+    }
+    int sum = 0;
+    for (int x = 0; x < width; x++) {
+      sum += col_sum[x];
+    }
+    int *out = &block_sums_[y * num_x];
+    out[0] = sum;
+    for (int x = 1; x < num_x; x++) {
+      sum += col_sum[x + width - 1] - col_sum[x - 1];
+      out[x] = sum;
+    }
+  }
+}
+
+}   // namespace xvc
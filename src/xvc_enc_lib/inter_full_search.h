@@ -0,0 +1,60 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#ifndef XVC_ENC_LIB_INTER_FULL_SEARCH_H_
+#define XVC_ENC_LIB_INTER_FULL_SEARCH_H_
+
+#include <vector>
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/sample_buffer.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_common_lib/quantize.h"
+#include "xvc_enc_lib/sample_metric.h"
+
+namespace xvc {
+
+class FullSearch {
+public:
+  explicit FullSearch(int bitdepth) : bitdepth_(bitdepth) {}
+  // Exhaustive search over all fullpel positions within [mv_min, mv_max],
+  // returns the first position in raster order with lowest cost
+  MvFullpel Search(const CodingUnit &cu, const Qp &qp,
+                   const SampleMetric &metric,
+                   const ResidualBufferConst &orig_buffer,
+                   const MotionVector &mvp, const YuvPicture &ref_pic,
+                   const MvFullpel &mv_min, const MvFullpel &mv_max);
+
+private:
+  static const int kNumOffsets = 4;
+  void ComputeBlockSums(const Sample *ref, ptrdiff_t ref_stride, int width,
+                        int height, int row_step, int num_x, int num_y);
+
+  const int bitdepth_;
+  // Reference block sums for each position of the search window
+  std::vector<int> block_sums_;
+  std::vector<int> block_col_sums_;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_ENC_LIB_INTER_FULL_SEARCH_H_
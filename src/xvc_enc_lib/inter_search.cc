@@ -62,7 +62,8 @@ InterSearch::InterSearch(const EncoderSimdFunctions &simd,
   satd_metric_(simd.sample_metric, bitdepth_, MetricType::kSatd),
   cu_writer_(pic_data, nullptr),
   bipred_orig_buffer_(constants::kMaxBlockSize, constants::kMaxBlockSize),
-  bipred_pred_buffer_(constants::kMaxBlockSize, constants::kMaxBlockSize) {
+  bipred_pred_buffer_(constants::kMaxBlockSize, constants::kMaxBlockSize),
+  full_search_(bitdepth_) {
   std::vector<int> l1_mapping =
     ref_pic_list.GetSamePocMappingFor(RefPicList::kL1);
   assert(l1_mapping.size() <= same_poc_in_l0_mapping_.size());
@@ -174,7 +175,7 @@ InterSearch::SearchMergeCandidates(CodingUnit *cu, const Qp &qp,
   std::array<std::pair<int, double>, max_merge_cand> cand_cost;
   for (int merge_idx = 0; merge_idx < max_merge_cand; merge_idx++) {
     ApplyMergeCand(cu, merge_list[merge_idx]);
-    MotionCompensation(*cu, YuvComponent::kY, &pred_buffer);
+    MotionCompensationCached(*cu, YuvComponent::kY, &pred_buffer);
     Distortion dist =
       metric.CompareSample(*cu, YuvComponent::kY, orig_pic_, pred_buffer);
     Bits bits = merge_idx + 1 - (merge_idx < max_merge_cand - 1 ? 0 : 1);
@@ -193,6 +194,10 @@ InterSearch::SearchMergeCandidates(CodingUnit *cu, const Qp &qp,
       num_merge_cand = merge_idx;
     }
   }
+  if (encoder_settings_.fast_merge_eval >= 2) {
+    // Only the candidate with best prediction is fully evaluated
+    return 1;
+  }
   return num_merge_cand;
 }
 
@@ -240,9 +245,12 @@ Distortion InterSearch::SearchMotion(CodingUnit *cu, const Qp &qp,
   assert(cu->GetInterDir() == InterDir::kL1);
   cu->LoadStateFrom(state_l0, RefPicList::kL0);
   InterDir best_uni_dir = cost_l0 <= cost_l1 ? InterDir::kL0 : InterDir::kL1;
-  Distortion cost_best_bi =
-    SearchBiIterative(cu, qp, bitstream_writer, best_uni_dir, pred_buffer,
-                      &state_bi);
+  Distortion cost_best_bi = std::numeric_limits<Distortion>::max();
+  if (EvalBiPred(cost_l0, cost_l1)) {
+    cost_best_bi = SearchBiIterative(cu, qp, bitstream_writer, best_uni_dir,
+                                     std::min(cost_l0, cost_l1_unique_poc),
+                                     pred_buffer, &state_bi);
+  }
 
   Distortion best_cost;
   if (cost_best_bi <= cost_l0 && cost_best_bi <= cost_l1_unique_poc) {
@@ -290,7 +298,7 @@ InterSearch::CompressAndEvalCbf(CodingUnit *cu, const Qp &qp,
       const YuvComponent comp = YuvComponent(c);
       SampleBuffer &pred_buffer = encoder->GetPredBuffer(comp);
       if (tx_pass == 0) {
-        MotionCompensation(*cu, comp, &pred_buffer);
+        MotionCompensationCached(*cu, comp, &pred_buffer);
       }
       Cost *best_cost_comp = tx_pass == 0 ? nullptr : &best_cost[c].cost;
       // TODO(PH) Should update contexts after each component for rdo quant
@@ -382,17 +390,103 @@ InterSearch::CompressSkipOnly(CodingUnit *cu, const Qp &qp,
     int posx = cu->GetPosX(comp);
     int posy = cu->GetPosY(comp);
     SampleBuffer reco_buffer = rec_pic->GetSampleBuffer(comp, posx, posy);
-    MotionCompensation(*cu, comp, &reco_buffer);
+    MotionCompensationCached(*cu, comp, &reco_buffer);
     cu->ClearCbf(comp);
     sum_dist += cu_metric_.CompareSample(*cu, comp, orig_pic_, reco_buffer);
   }
   return sum_dist;
 }
 
+bool InterSearch::EvalBiPred(Distortion cost_l0, Distortion cost_l1) const {
+  // Bi-prediction rarely improves on a uni-prediction that is much better
+  // than the best prediction from the other list
+  const int max_ratio = encoder_settings_.fast_bipred_uni_cost_ratio;
+  if (!max_ratio) {
+    return true;
+  }
+  const Distortion cost_min = std::min(cost_l0, cost_l1);
+  const Distortion cost_max = std::max(cost_l0, cost_l1);
+  return 100 * cost_max <= max_ratio * cost_min;
+}
+
+void InterSearch::MotionCompensationCached(const CodingUnit &cu,
+                                           YuvComponent comp,
+                                           SampleBuffer *pred_buffer) {
+  if (!pred_cache_samples_ || cu.GetUseAffine()) {
+    MotionCompensation(cu, comp, pred_buffer);
+    return;
+  }
+  const size_t cache_size = kPredCacheSize * constants::kMaxYuvComponents *
+    constants::kMaxBlockSize * constants::kMaxBlockSize;
+  if (pred_cache_samples_->size() < cache_size) {
+    pred_cache_samples_->resize(cache_size);
+  }
+  CachedPrediction *entry = FindCachedPrediction(cu);
+  if (!entry) {
+    const int idx = pred_cache_next_;
+    pred_cache_next_ = (pred_cache_next_ + 1) % kPredCacheSize;
+    pred_cache_num_entries_ =
+      std::min(pred_cache_num_entries_ + 1, kPredCacheSize);
+    entry = &pred_cache_[idx];
+    SetPredictionKey(cu, entry);
+    entry->valid.fill(false);
+  }
+  const int entry_idx = static_cast<int>(entry - &pred_cache_[0]);
+  const ptrdiff_t offset = constants::kMaxBlockSize * constants::kMaxBlockSize *
+    (entry_idx * constants::kMaxYuvComponents + static_cast<int>(comp));
+  SampleBuffer cached(&(*pred_cache_samples_)[offset], constants::kMaxBlockSize);
+  if (!entry->valid[static_cast<int>(comp)]) {
+    MotionCompensation(cu, comp, &cached);
+    entry->valid[static_cast<int>(comp)] = true;
+  }
+  pred_buffer->CopyFrom(cu.GetWidth(comp), cu.GetHeight(comp), cached);
+}
+
+InterSearch::CachedPrediction*
+InterSearch::FindCachedPrediction(const CodingUnit &cu) {
+  for (int idx = 0; idx < pred_cache_num_entries_; idx++) {
+    if (HasSameMotion(cu, pred_cache_[idx])) {
+      return &pred_cache_[idx];
+    }
+  }
+  return nullptr;
+}
+
+void InterSearch::SetPredictionKey(const CodingUnit &cu,
+                                   CachedPrediction *entry) {
+  entry->inter_dir = cu.GetInterDir();
+  entry->use_lic = cu.GetUseLic();
+  for (int i = 0; i < 2; i++) {
+    const RefPicList ref_list = RefPicList(i);
+    entry->ref_idx[i] = cu.HasMv(ref_list) ?
+      static_cast<int8_t>(cu.GetRefIdx(ref_list)) : -1;
+    entry->mv[i] = cu.HasMv(ref_list) ?
+      cu.GetMv(ref_list, MvCorner::kDefault) : MotionVector();
+  }
+}
+
+bool InterSearch::HasSameMotion(const CodingUnit &cu,
+                                const CachedPrediction &entry) {
+  if (entry.inter_dir != cu.GetInterDir() ||
+      entry.use_lic != cu.GetUseLic()) {
+    return false;
+  }
+  for (int i = 0; i < 2; i++) {
+    const RefPicList ref_list = RefPicList(i);
+    if (cu.HasMv(ref_list) &&
+        (entry.ref_idx[i] != cu.GetRefIdx(ref_list) ||
+         entry.mv[i] != cu.GetMv(ref_list, MvCorner::kDefault))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Distortion
 InterSearch::SearchBiIterative(CodingUnit *cu, const Qp &qp,
                                const SyntaxWriter &bitstream_writer,
-                               InterDir best_uni_dir, SampleBuffer *pred_buffer,
+                               InterDir best_uni_dir, Distortion best_uni_cost,
+                               SampleBuffer *pred_buffer,
                                CodingUnit::InterState *best_state) {
   const YuvComponent comp = YuvComponent::kY;
   SampleBufferConst orig_luma =
@@ -407,6 +501,7 @@ InterSearch::SearchBiIterative(CodingUnit *cu, const Qp &qp,
 
   Distortion cost_best = std::numeric_limits<Distortion>::max();
   int num_iterations = encoder_settings_.bipred_refinement_iterations;
+  const int max_ratio = encoder_settings_.fast_bipred_refinement_ratio;
   if (cu->GetPicData()->GetForceBipredL1MvdZero()) {
     num_iterations = 1;
     search_list = RefPicList::kL0;
@@ -415,9 +510,16 @@ InterSearch::SearchBiIterative(CodingUnit *cu, const Qp &qp,
     // If searching in L1 use original without L0 prediction
     cu->SetInterDir(search_list == RefPicList::kL0 ?
                     InterDir::kL1 : InterDir::kL0);
-    MotionCompensation(*cu, comp, &bipred_pred_buffer_);
-    bipred_orig_buffer_.SubtractWeighted(width, height, orig_luma,
-                                         bipred_pred_buffer_);
+    // The target only depends on the fixed list motion, which often repeats
+    // between the motion searches of the same cu
+    if (cu->GetUseAffine() || !bipred_target_valid_ ||
+        !HasSameMotion(*cu, bipred_target_)) {
+      MotionCompensationCached(*cu, comp, &bipred_pred_buffer_);
+      bipred_orig_buffer_.SubtractWeighted(width, height, orig_luma,
+                                           bipred_pred_buffer_);
+      SetPredictionKey(*cu, &bipred_target_);
+      bipred_target_valid_ = !cu->GetUseAffine();
+    }
     cu->SetInterDir(InterDir::kBi);
 
     Distortion prev_best = cost_best;
@@ -427,6 +529,12 @@ InterSearch::SearchBiIterative(CodingUnit *cu, const Qp &qp,
     if (cost_best == prev_best) {
       break;
     }
+    // Refinement rarely turns a bi-prediction that is clearly worse than
+    // uni-prediction into the best choice
+    if (max_ratio &&
+        100 * cost_best > max_ratio * static_cast<double>(best_uni_cost)) {
+      break;
+    }
     search_list = ReferencePictureLists::Inverse(search_list);
   }
   return cost_best;
@@ -630,14 +738,26 @@ InterSearch::MotionEstNormal(const CodingUnit &cu, const Qp &qp,
   SampleMetric fullpel_metric(simd_.sample_metric, bitdepth_,
                               GetFullpelMetric(cu));
   if (search_method == SearchMethod::kFullSearch) {
-    mv_fullpel =
-      FullSearch(cu, qp, fullpel_metric, mvp, *ref_pic, clip_min, clip_max);
+    mv_fullpel = full_search_.Search(cu, qp, fullpel_metric,
+                                     bipred_orig_buffer_, mvp, *ref_pic,
+                                     clip_min, clip_max);
   } else if (search_method == SearchMethod::kTzSearch) {
+    const MvFullpel *coarse_mv = nullptr;
+    MvFullpel coarse_fullpel;
+    if (coarse_motion_ &&
+        !(*coarse_motion_)[static_cast<int>(ref_list)][ref_idx].IsEmpty()) {
+      const YuvComponent comp = YuvComponent::kY;
+      coarse_fullpel = (*coarse_motion_)[static_cast<int>(ref_list)][ref_idx]
+        .GetMv(cu.GetPosX(comp), cu.GetPosY(comp), cu.GetWidth(comp),
+               cu.GetHeight(comp));
+      coarse_mv = &coarse_fullpel;
+    }
     TzSearch tz_search(orig_pic_, *this, encoder_settings_, search_range);
     mv_fullpel =
       tz_search.Search(cu, qp, fullpel_metric, mvp, *ref_pic,
                        clip_min, clip_max,
-                       previous_fullpel_[static_cast<int>(ref_list)][ref_idx]);
+                       previous_fullpel_[static_cast<int>(ref_list)][ref_idx],
+                       coarse_mv);
     previous_fullpel_[static_cast<int>(ref_list)][ref_idx] = mv_fullpel;
   } else {
     assert(0);
@@ -647,15 +767,17 @@ InterSearch::MotionEstNormal(const CodingUnit &cu, const Qp &qp,
 
   SampleMetric subpel_metric(simd_.sample_metric, bitdepth_,
                              GetSubpelMetric(cu));
+  const SubpelPlaneCache *subpel_cache = !subpel_planes_ ? nullptr :
+    (*subpel_planes_)[static_cast<int>(ref_list)][ref_idx];
   Distortion dist = std::numeric_limits<Distortion>::max();
   if (cu.GetFullpelMv()) {
     mv_subpel = MotionVector(mv_fullpel);
     dist = GetSubpelDist(cu, qp, *ref_pic, subpel_metric, mv_subpel,
-                         orig_buffer, pred_buffer);
+                         orig_buffer, subpel_cache, pred_buffer);
   } else {
     mv_subpel =
       SubpelSearch(cu, qp, subpel_metric, *ref_pic, mvp, mv_fullpel,
-                   orig_buffer, pred_buffer, &dist);
+                   orig_buffer, subpel_cache, pred_buffer, &dist);
   }
   *out_dist = bipred ? (dist >> 1) : dist;
   return mv_subpel;
@@ -850,46 +972,6 @@ InterSearch::AffineGradientSearch(int width, int height,
   return mvd;
 }
 
-MvFullpel InterSearch::FullSearch(const CodingUnit &cu, const Qp &qp,
-                                  const SampleMetric &metric,
-                                  const MotionVector &mvp,
-                                  const YuvPicture &ref_pic,
-                                  const MvFullpel &mv_min,
-                                  const MvFullpel &mv_max) {
-  const YuvComponent comp = YuvComponent::kY;
-  const int width = cu.GetWidth(comp);
-  const int height = cu.GetHeight(comp);
-  const int mvd_precision =
-    cu.GetFullpelMv() ? MvDelta::kPrecisionShift : 0;
-  const uint32_t lambda =
-    static_cast<uint32_t>(std::floor(65536.0 * qp.GetLambdaSqrt()));
-  const Sample *ref_cu = ref_pic.GetSamplePtr(comp, cu.GetPosX(comp),
-                                              cu.GetPosY(comp));
-  intptr_t ref_stride = ref_pic.GetStride(comp);
-  Distortion cost_best = std::numeric_limits<Distortion>::max();
-  MvFullpel mv_best;
-  for (int mv_y = mv_min.y; mv_y <= mv_max.y; mv_y++) {
-    for (int mv_x = mv_min.x; mv_x <= mv_max.x; mv_x++) {
-      const Sample *ref_mv = ref_cu + mv_y * ref_stride + mv_x;
-      Distortion dist = metric.CompareSample(qp, comp, width, height,
-                                             bipred_orig_buffer_.GetDataPtr(),
-                                             bipred_orig_buffer_.GetStride(),
-                                             ref_mv, ref_stride);
-      if (dist >= cost_best) {
-        continue;
-      }
-      Bits bits = GetMvdBitsFullpel(mvp, mv_x, mv_y, mvd_precision);
-      Distortion cost = dist + ((lambda * bits) >> 16);
-      if (cost < cost_best) {
-        cost_best = cost;
-        mv_best.x = mv_x;
-        mv_best.y = mv_y;
-      }
-    }
-  }
-  return mv_best;
-}
-
 template<typename TOrig>
 MotionVector
 InterSearch::SubpelSearch(const CodingUnit &cu, const Qp &qp,
@@ -897,6 +979,7 @@ InterSearch::SubpelSearch(const CodingUnit &cu, const Qp &qp,
                           const YuvPicture &ref_pic, const MotionVector &mvp,
                           const MvFullpel &mv_fullpel,
                           const DataBuffer<TOrig> &orig_buffer,
+                          const SubpelPlaneCache *subpel_cache,
                           SampleBuffer *pred_buffer, Distortion *out_dist) {
   uint32_t lambda =
     static_cast<uint32_t>(std::floor(65536.0 * qp.GetLambdaSqrt()));
@@ -911,7 +994,7 @@ InterSearch::SubpelSearch(const CodingUnit &cu, const Qp &qp,
     const MvDelta mvd(kSquareXYHalf[i][0], kSquareXYHalf[i][1], 1);
     const MotionVector mv = mv_base + mvd;
     Distortion dist = GetSubpelDist(cu, qp, ref_pic, metric, mv,
-                                    orig_buffer, pred_buffer);
+                                    orig_buffer, subpel_cache, pred_buffer);
     if (dist >= best_cost) {
       continue;
     }
@@ -930,7 +1013,7 @@ InterSearch::SubpelSearch(const CodingUnit &cu, const Qp &qp,
     const MvDelta mvd(kSquareXYQpel[i][0], kSquareXYQpel[i][1], 2);
     const MotionVector mv = mv_base + mvd;
     Distortion dist = GetSubpelDist(cu, qp, ref_pic, metric, mv,
-                                    orig_buffer, pred_buffer);
+                                    orig_buffer, subpel_cache, pred_buffer);
     if (dist >= best_cost) {
       continue;
     }
@@ -954,10 +1037,22 @@ InterSearch::GetSubpelDist(const CodingUnit &cu, const Qp &qp,
                            const YuvPicture &ref_pic,
                            const SampleMetric &metric, const MotionVector &mv,
                            const DataBuffer<TOrig> &orig_buffer,
+                           const SubpelPlaneCache *subpel_cache,
                            SampleBuffer *pred_buffer) {
   const YuvComponent comp = YuvComponent::kY;
   const int width = cu.GetWidth(comp);
   const int height = cu.GetHeight(comp);
+  if (subpel_cache) {
+    MotionVector mv_clip = mv;
+    ClipMv(cu, ref_pic, &mv_clip);
+    SampleBufferConst cached_pred =
+      subpel_cache->GetPrediction(cu.GetPosX(comp), cu.GetPosY(comp),
+                                  mv_clip);
+    if (cached_pred.GetDataPtr()) {
+      return metric.CompareSample(qp, comp, width, height, orig_buffer,
+                                  cached_pred);
+    }
+  }
   MotionCompensationMv(cu, comp, ref_pic, mv, false, pred_buffer);
   return
     metric.CompareSample(qp, comp, width, height, orig_buffer, *pred_buffer);
@@ -23,6 +23,7 @@
 #define XVC_ENC_LIB_INTER_SEARCH_H_
 
 #include <array>
+#include <vector>
 
 #include "xvc_common_lib/coding_unit.h"
 #include "xvc_common_lib/inter_prediction.h"
@@ -32,7 +33,10 @@
 #include "xvc_common_lib/quantize.h"
 #include "xvc_enc_lib/encoder_settings.h"
 #include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/inter_full_search.h"
+#include "xvc_enc_lib/motion_pyramid.h"
 #include "xvc_enc_lib/sample_metric.h"
+#include "xvc_enc_lib/subpel_plane_cache.h"
 #include "xvc_enc_lib/syntax_writer.h"
 #include "xvc_enc_lib/transform_encoder.h"
 
@@ -79,6 +83,29 @@ public:
                             const InterMergeCandidateList &merge_list,
                             TransformEncoder *encoder,
                             MergeCandLookup *out_cand_list);
+  // Motion estimated on downsampled pictures, used as search start point
+  void SetCoarseMotion(const MotionPyramid::RefMotionFields *coarse_motion) {
+    coarse_motion_ = coarse_motion;
+  }
+  // Pre-interpolated reference pictures used by subpel search
+  void SetSubpelPlanes(const SubpelPlaneCache::RefPlanes *subpel_planes) {
+    subpel_planes_ = subpel_planes;
+  }
+  // Storage for caching motion compensated predictions within a cu, sized
+  // on first use and kept by the owner across pictures. Without storage
+  // all predictions are computed on demand.
+  void SetPredictionCache(std::vector<Sample> *pred_cache_samples) {
+    pred_cache_samples_ = pred_cache_samples;
+  }
+  // Must be called before evaluating prediction modes of a new cu
+  void ResetPredictionCache() {
+    pred_cache_num_entries_ = 0;
+    pred_cache_next_ = 0;
+    bipred_target_valid_ = false;
+  }
+  // Estimated bits for signaling a fullpel mv relative to mvp
+  static Bits GetMvdBitsFullpel(const MotionVector &mvp, int mv_x, int mv_y,
+                                int mvd_down_shift);
 
 private:
   enum class SearchMethod { kTzSearch, kFullSearch };
@@ -87,7 +114,23 @@ private:
   static constexpr double kFastMergeCostFactor = 1.25;
   static constexpr double kFastTransformSelectCostFactor = 1.1;
   static constexpr int kNumMvp = constants::kNumInterMvPredictors;
+  static const int kPredCacheSize = 8;
+
+  struct CachedPrediction {
+    InterDir inter_dir;
+    bool use_lic;
+    std::array<int8_t, 2> ref_idx;
+    std::array<MotionVector, 2> mv;
+    std::array<bool, constants::kMaxYuvComponents> valid;
+  };
 
+  bool EvalBiPred(Distortion cost_l0, Distortion cost_l1) const;
+  void MotionCompensationCached(const CodingUnit &cu, YuvComponent comp,
+                                SampleBuffer *pred_buffer);
+  CachedPrediction* FindCachedPrediction(const CodingUnit &cu);
+  static void SetPredictionKey(const CodingUnit &cu, CachedPrediction *entry);
+  static bool HasSameMotion(const CodingUnit &cu,
+                            const CachedPrediction &entry);
   Distortion SearchMotion(CodingUnit *cu, const Qp &qp,
                           const SyntaxWriter &bitstream_writer,
                           InterSearchFlags search_flags,
@@ -101,7 +144,8 @@ private:
                               TransformEncoder *encoder, YuvPicture *rec_pic);
   Distortion SearchBiIterative(CodingUnit *cu, const Qp &qp,
                                const SyntaxWriter &bitstream_writer,
-                               InterDir best_uni_dir, SampleBuffer *pred_buffer,
+                               InterDir best_uni_dir, Distortion best_uni_cost,
+                               SampleBuffer *pred_buffer,
                                CodingUnit::InterState *best_state);
   template<typename TOrig>
   Distortion SearchRefIdx(CodingUnit *cu, const Qp &qp, RefPicList ref_list,
@@ -161,22 +205,20 @@ private:
   MvDelta2 AffineGradientSearch(int width, int height,
                                 const SampleBuffer &pred_buffer,
                                 const ResidualBuffer &err_buffer);
-  MvFullpel FullSearch(const CodingUnit &cu, const Qp &qp,
-                       const SampleMetric &metric, const MotionVector &mvp,
-                       const YuvPicture &ref_pic, const MvFullpel &mv_min,
-                       const MvFullpel &mv_max);
   template<typename TOrig>
   MotionVector SubpelSearch(const CodingUnit &cu, const Qp &qp,
                             const SampleMetric &metric,
                             const YuvPicture &ref_pic, const MotionVector &mvp,
                             const MvFullpel &mv_fullpel,
                             const DataBuffer<TOrig> &orig_buffer,
+                            const SubpelPlaneCache *subpel_cache,
                             SampleBuffer *pred_buffer, Distortion *out_dist);
   template<typename TOrig>
   Distortion GetSubpelDist(const CodingUnit &cu, const Qp &qp,
                            const YuvPicture &ref_pic,
                            const SampleMetric &metric, const MotionVector &mv,
                            const DataBuffer<TOrig> &orig_buffer,
+                           const SubpelPlaneCache *subpel_cache,
                            SampleBuffer *pred_buffer);
   template<bool IsAffine, typename MotionVec>
   int EvalStartMvp(const CodingUnit &cu, const Qp &qp,
@@ -201,8 +243,6 @@ private:
                          int mvd_down_shift);
   static Bits GetMvdBits(const MotionVector3 &mvp, const MotionVector3 &mv,
                          int mvd_down_shift);
-  static Bits GetMvdBitsFullpel(const MotionVector &mvp, int mv_x, int mv_y,
-                                int mvd_down_shift);
   static Bits GetNumExpGolombBits(int mvd);
   // Affine template helper functions
   template<bool IsAffine, typename MotionVec>
@@ -226,6 +266,16 @@ private:
   CuWriter cu_writer_;
   ResidualBufferStorage bipred_orig_buffer_;
   SampleBufferStorage bipred_pred_buffer_;
+  // Motion of the fixed list prediction in bipred_orig_buffer_
+  CachedPrediction bipred_target_;
+  bool bipred_target_valid_ = false;
+  // Motion compensated predictions of the current cu, reused when merge,
+  // skip and motion search evaluate identical motion
+  std::array<CachedPrediction, kPredCacheSize> pred_cache_;
+  std::vector<Sample> *pred_cache_samples_ = nullptr;
+  int pred_cache_num_entries_ = 0;
+  int pred_cache_next_ = 0;
+  FullSearch full_search_;
   // Mapping of ref_idx from L1 to L0 when POC is same
   std::array<int, constants::kMaxNumRefPics> same_poc_in_l0_mapping_;
   // Best uni-prediction motion estimation result for a single CU
@@ -240,6 +290,8 @@ private:
   // Best fullpel search mv per ref list, ref idx and picture
   std::array<std::array<MvFullpel, constants::kMaxNumRefPics>,
     static_cast<int>(RefPicList::kTotalNumber)> previous_fullpel_;
+  const MotionPyramid::RefMotionFields *coarse_motion_ = nullptr;
+  const SubpelPlaneCache::RefPlanes *subpel_planes_ = nullptr;
   // Affine search buffers
   std::array<std::array<float, constants::kMaxBlockSize>,
     constants::kMaxBlockSize> affine_delta_hor_;
@@ -85,9 +85,10 @@ MvFullpel
 TzSearch::Search(const CodingUnit &cu, const Qp &qp, const SampleMetric &metric,
                  const MotionVector &mvp, const YuvPicture &ref_pic,
                  const MvFullpel &mv_min, const MvFullpel &mv_max,
-                 const MvFullpel &prev_search) {
+                 const MvFullpel &prev_search, const MvFullpel *coarse_mv) {
   static const int kDiamondSearchThreshold = 3;
   static const int kFullSearchGranularity = 5;
+  static const int kCoarseRasterRangeDiv = 4;
   const YuvComponent comp = YuvComponent::kY;
   auto orig_buffer =
     orig_pic_.GetSampleBuffer(comp, cu.GetPosX(comp), cu.GetPosY(comp));
@@ -127,6 +128,19 @@ TzSearch::Search(const CodingUnit &cu, const Qp &qp, const SampleMetric &metric,
     }
   }
 
+  // Check MV from coarse motion estimation of the whole picture, the raster
+  // search is then limited to the remaining uncertainty of the estimate
+  if (coarse_mv) {
+    MotionVector coarse_clip = MotionVector(*coarse_mv);
+    inter_pred_.ClipMv(cu, ref_pic, &coarse_clip);
+    MvFullpel coarse_fullpel = coarse_clip;
+    CheckCostBest(&state, coarse_fullpel.x, coarse_fullpel.y);
+    MotionVector best_subpel = MotionVector(state.mv_best);
+    inter_pred_.DetermineMinMaxMv(cu, ref_pic, best_subpel,
+                                  search_range_ / kCoarseRasterRangeDiv,
+                                  &fullsearch_min, &fullsearch_max);
+  }
+
   // Initial search around mvp
   MvFullpel mv_base = state.mv_best;
   int rounds_with_no_match = 0;
@@ -21,6 +21,7 @@
 
 #include "xvc_enc_lib/intra_search.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "xvc_common_lib/restrictions.h"
@@ -110,6 +111,17 @@ IntraSearch::CompressIntraChroma(CodingUnit *cu, const Qp &qp,
                                      ref_state_v, enc, rec_pic);
     return best_dist;
   }
+  if (encoder_settings_.fast_intra_mode_eval_level >= 3) {
+    // Only fully code the chroma mode with best prediction
+    cu->SetIntraModeChroma(
+      DetermineFastChromaMode(cu, qp, bitstream_writer, chroma_modes,
+                              ref_state_u, ref_state_v, enc, *rec_pic));
+    best_dist += PredictAndTransform(cu, YuvComponent::kU, qp, bitstream_writer,
+                                     ref_state_u, enc, rec_pic);
+    best_dist += PredictAndTransform(cu, YuvComponent::kV, qp, bitstream_writer,
+                                     ref_state_v, enc, rec_pic);
+    return best_dist;
+  }
 
   Cost best_cost = std::numeric_limits<Cost>::max();
   IntraChromaMode best_mode = IntraChromaMode::kInvalid;
@@ -215,11 +227,17 @@ IntraSearch::DetermineSlowIntraModes(CodingUnit *cu, const Qp &qp,
     !Restrictions::Get().disable_ext2_intra_67_modes;
   SampleBuffer &pred_buf = encoder->GetPredBuffer(comp);
   std::array<bool, kNbrIntraModesExt> evaluated_modes = { false };
+  std::array<bool, kNbrIntraModesExt> pruned_modes = { false };
 
   IntraPredictorLuma mpm = GetPredictorLuma(*cu);
+  if (edge_map_ && encoder_settings_.intra_edge_mode_pruning > 0) {
+    DetermineEdgePrunedModes(*cu, mpm, num_intra_modes, &pruned_modes);
+  }
+  int num_evaluated_modes = 0;
   for (int i = 0; i < num_intra_modes; i++) {
     IntraMode intra_mode = static_cast<IntraMode>(i);
-    if (two_fast_search_passes && intra_mode > IntraMode::kDc && (i % 2) != 0) {
+    if ((two_fast_search_passes && intra_mode > IntraMode::kDc &&
+        (i % 2) != 0) || pruned_modes[i]) {
       (*modes_cost)[i] = std::make_pair(intra_mode,
                                         std::numeric_limits<double>::max());
       continue;
@@ -237,6 +255,7 @@ IntraSearch::DetermineSlowIntraModes(CodingUnit *cu, const Qp &qp,
     double cost = dist + bits * qp.GetLambdaSqrt();
     (*modes_cost)[i] = std::make_pair(intra_mode, cost);
     evaluated_modes[intra_mode] = true;
+    num_evaluated_modes++;
   }
   std::stable_sort(modes_cost->begin(), modes_cost->begin() + num_intra_modes,
                    [](std::pair<IntraMode, double> p1,
@@ -248,11 +267,15 @@ IntraSearch::DetermineSlowIntraModes(CodingUnit *cu, const Qp &qp,
   int width_log2 = util::SizeToLog2(cu->GetWidth(comp));
   int height_log2 = util::SizeToLog2(cu->GetHeight(comp));
   int num_modes_for_slow_rdo = kNumIntraFastModesNoExt[width_log2];
-  if (encoder_settings_.fast_intra_mode_eval_level == 2) {
+  if (encoder_settings_.fast_intra_mode_eval_level >= 3) {
+    num_modes_for_slow_rdo = 1;
+  } else if (encoder_settings_.fast_intra_mode_eval_level == 2) {
     num_modes_for_slow_rdo = kNumIntraFastModesExt[width_log2][height_log2];
   } else if (encoder_settings_.fast_intra_mode_eval_level == 0) {
     num_modes_for_slow_rdo = 33;
   }
+  num_modes_for_slow_rdo =
+    std::min(num_modes_for_slow_rdo, num_evaluated_modes);
 
   if (two_fast_search_passes) {
     int modes_added = num_modes_for_slow_rdo;
@@ -286,6 +309,11 @@ IntraSearch::DetermineSlowIntraModes(CodingUnit *cu, const Qp &qp,
     });
   }
 
+  if (encoder_settings_.fast_intra_mode_eval_level >= 3) {
+    // Trust the sorted estimate without evaluating predictor modes
+    return num_modes_for_slow_rdo;
+  }
+
   // Extend shortlist with predictor modes
   for (int i = 0; i < mpm.num_neighbor_modes; i++) {
     bool found = false;
@@ -302,4 +330,91 @@ IntraSearch::DetermineSlowIntraModes(CodingUnit *cu, const Qp &qp,
   return num_modes_for_slow_rdo;
 }
 
+void
+IntraSearch::DetermineEdgePrunedModes(const CodingUnit &cu,
+                                      const IntraPredictorLuma &mpm,
+                                      int num_intra_modes,
+                                      std::array<bool, kNbrIntraModesExt>
+                                      *pruned) {
+  const YuvComponent comp = YuvComponent::kY;
+  const bool ext_modes = num_intra_modes == kNbrIntraModesExt;
+  const int mode_step = ext_modes ? 2 : 1;
+  EdgeDirectionMap::Histogram hist;
+  edge_map_->GetHistogram(cu.GetPosX(comp), cu.GetPosY(comp),
+                          cu.GetWidth(comp), cu.GetHeight(comp), &hist);
+
+  // Each mode of the first search pass also collects the edges of the modes
+  // half way to its neighbors in the histogram (67 mode numbering)
+  std::array<std::pair<uint32_t, int>, kNbrIntraModes> scores;
+  int num_angular = 0;
+  for (int mode = IntraMode::kDc + 1; mode < num_intra_modes;
+       mode += mode_step) {
+    const int hist_mode = ext_modes ? mode : 2 * mode - 2;
+    uint32_t score = 2 * hist[hist_mode];
+    if (hist_mode > IntraMode::kDc + 1) {
+      score += hist[hist_mode - 1];
+    }
+    if (hist_mode < kNbrIntraModesExt - 1) {
+      score += hist[hist_mode + 1];
+    }
+    scores[num_angular++] = std::make_pair(score, mode);
+    (*pruned)[mode] = true;
+  }
+  const int num_kept =
+    std::min(encoder_settings_.intra_edge_mode_pruning, num_angular);
+  std::partial_sort(scores.begin(), scores.begin() + num_kept,
+                    scores.begin() + num_angular,
+                    [](std::pair<uint32_t, int> p1,
+                       std::pair<uint32_t, int> p2) {
+    return p1.first > p2.first ||
+      (p1.first == p2.first && p1.second < p2.second);
+  });
+  // Blocks without edges are left to planar, dc and the predictor modes
+  for (int i = 0; i < num_kept && scores[i].first > 0; i++) {
+    (*pruned)[scores[i].second] = false;
+  }
+  for (int i = 0; i < mpm.num_neighbor_modes; i++) {
+    (*pruned)[mpm[i]] = false;
+  }
+}
+
+IntraChromaMode
+IntraSearch::DetermineFastChromaMode(CodingUnit *cu, const Qp &qp,
+                                     const SyntaxWriter &bitstream_writer,
+                                     const IntraPredictorChroma &chroma_modes,
+                                     const IntraPrediction::RefState &ref_u,
+                                     const IntraPrediction::RefState &ref_v,
+                                     TransformEncoder *encoder,
+                                     const YuvPicture &rec_pic) {
+  SampleBuffer &pred_buf_u = encoder->GetPredBuffer(YuvComponent::kU);
+  SampleBuffer &pred_buf_v = encoder->GetPredBuffer(YuvComponent::kV);
+  IntraChromaMode best_mode = IntraChromaMode::kInvalid;
+  double best_cost = std::numeric_limits<double>::max();
+  for (int i = 0; i < static_cast<int>(chroma_modes.size()); i++) {
+    IntraChromaMode chroma_mode = chroma_modes[i];
+    if (chroma_mode == IntraChromaMode::kInvalid) {
+      continue;
+    }
+    cu->SetIntraModeChroma(chroma_mode);
+    IntraMode intra_mode = cu->GetIntraMode(YuvComponent::kU);
+    Predict(intra_mode, *cu, YuvComponent::kU, ref_u, rec_pic, &pred_buf_u);
+    Predict(intra_mode, *cu, YuvComponent::kV, ref_v, rec_pic, &pred_buf_v);
+    uint64_t dist =
+      satd_metric_.CompareSample(*cu, YuvComponent::kU, orig_pic_, pred_buf_u) +
+      satd_metric_.CompareSample(*cu, YuvComponent::kV, orig_pic_, pred_buf_v);
+
+    // Bits
+    RdoSyntaxWriter rdo_writer(bitstream_writer, 0);
+    cu_writer_.WriteIntraPrediction(*cu, YuvComponent::kU, &rdo_writer);
+    Bits bits = rdo_writer.GetNumWrittenBits();
+    double cost = dist + bits * qp.GetLambdaSqrt();
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_mode = chroma_mode;
+    }
+  }
+  assert(best_mode != IntraChromaMode::kInvalid);
+  return best_mode;
+}
+
 }   // namespace xvc
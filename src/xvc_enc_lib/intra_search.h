@@ -28,6 +28,7 @@
 #include "xvc_common_lib/picture_data.h"
 #include "xvc_enc_lib/syntax_writer.h"
 #include "xvc_enc_lib/cu_writer.h"
+#include "xvc_enc_lib/edge_direction_map.h"
 #include "xvc_enc_lib/encoder_settings.h"
 #include "xvc_enc_lib/encoder_simd_functions.h"
 #include "xvc_enc_lib/transform_encoder.h"
@@ -50,6 +51,10 @@ public:
   Distortion CompressIntraFast(CodingUnit *cu, YuvComponent comp, const Qp &qp,
                                const SyntaxWriter &writer,
                                TransformEncoder *encoder, YuvPicture *rec_pic);
+  // Edge directions of the original picture, used for pruning angular modes
+  void SetEdgeDirections(const EdgeDirectionMap *edge_map) {
+    edge_map_ = edge_map;
+  }
 
 private:
   using IntraModeSet =
@@ -64,6 +69,16 @@ private:
                               const IntraPrediction::RefState &ref_state,
                               TransformEncoder *encoder, YuvPicture *rec_pic,
                               IntraModeSet *modes_cost);
+  void DetermineEdgePrunedModes(const CodingUnit &cu,
+                                const IntraPredictorLuma &mpm,
+                                int num_intra_modes,
+                                std::array<bool, kNbrIntraModesExt> *pruned);
+  IntraChromaMode DetermineFastChromaMode(
+    CodingUnit *cu, const Qp &qp, const SyntaxWriter &bitstream_writer,
+    const IntraPredictorChroma &chroma_modes,
+    const IntraPrediction::RefState &ref_u,
+    const IntraPrediction::RefState &ref_v, TransformEncoder *encoder,
+    const YuvPicture &rec_pic);
 
   const PictureData &pic_data_;
   const YuvPicture &orig_pic_;
@@ -71,6 +86,7 @@ private:
   const SampleMetric satd_metric_;
   CodingUnit::ResidualState best_cu_state_;
   CuWriter cu_writer_;
+  const EdgeDirectionMap *edge_map_ = nullptr;
 };
 
 }   // namespace xvc
@@ -0,0 +1,396 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include "xvc_enc_lib/lookahead.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace xvc {
+
+// Inter cost must save at least this fraction of the intra cost
+static const double kSceneCutRatio = 0.9;
+// Qp reduction per doubling of the information passed on to later pictures
+static const double kPropagateStrength = 1.0;
+static const int kMaxPicQpOffset = 3;
+
+Lookahead::Lookahead(const SampleMetric::SimdFunc &simd, int width,
+                     int height, int bitdepth)
+  : width_((width + 1) >> 1),
+  height_((height + 1) >> 1),
+  width_in_blocks_((width_ + kBlockSize - 1) / kBlockSize),
+  height_in_blocks_((height_ + kBlockSize - 1) / kBlockSize),
+  stride_(width_in_blocks_ * kBlockSize + 2 * kPadding),
+  qp_(constants::kMaxAllowedQp, ChromaFormat::kMonochrome, bitdepth, 1.0),
+  sad_metric_(simd, bitdepth, MetricType::kSad),
+  satd_metric_(simd, bitdepth, MetricType::kSatd),
+  intra_metric_(simd, bitdepth, MetricType::kSatdAcOnly),
+  flat_block_(kBlockSize * kBlockSize, 0) {
+  const size_t plane_size = static_cast<size_t>(stride_) *
+    (height_in_blocks_ * kBlockSize + 2 * kPadding);
+  planes_[0].resize(plane_size);
+  planes_[1].resize(plane_size);
+  worker_ = std::thread([this] { WorkerMain(); });
+}
+
+Lookahead::~Lookahead() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  running_ = false;
+  work_cond_.notify_all();
+  lock.unlock();
+  worker_.join();
+}
+
+void Lookahead::Push(PicNum poc, std::shared_ptr<const YuvPicture> orig_pic) {
+  Input input;
+  input.poc = poc;
+  input.orig_pic = std::move(orig_pic);
+  std::unique_lock<std::mutex> lock(mutex_);
+  pending_.push_back(std::move(input));
+  work_cond_.notify_one();
+}
+
+bool Lookahead::HasSceneCut(PicNum first_poc, PicNum last_poc) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  WaitForAnalysis(last_poc, &lock);
+  for (auto it = analyses_.lower_bound(first_poc);
+       it != analyses_.end() && it->first <= last_poc; ++it) {
+    if (it->second.scene_cut) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Lookahead::Propagate(PicNum first_poc, PicNum last_poc) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  WaitForAnalysis(last_poc, &lock);
+  analyses_.erase(analyses_.begin(), analyses_.lower_bound(first_poc));
+
+  const int ctu_blocks = (constants::kCtuSize >> 1) / kBlockSize;
+  const int width_in_ctus = (width_in_blocks_ + ctu_blocks - 1) / ctu_blocks;
+  const int height_in_ctus = (height_in_blocks_ + ctu_blocks - 1) / ctu_blocks;
+  const int num_blocks = width_in_blocks_ * height_in_blocks_;
+  // Amount of information passed on to the later pictures in the range,
+  // accumulated per block while walking backwards through the range
+  std::vector<double> propagate_in(num_blocks, 0.0);
+  std::vector<double> ref_propagate_in(num_blocks);
+  std::vector<double> ctu_dqp(width_in_ctus * height_in_ctus);
+  std::vector<int> ctu_num_blocks(width_in_ctus * height_in_ctus);
+  for (PicNum i = 0; i <= last_poc - first_poc; i++) {
+    const PicNum poc = last_poc - i;
+    auto it = analyses_.find(poc);
+    if (it == analyses_.end()) {
+      std::fill(propagate_in.begin(), propagate_in.end(), 0.0);
+      continue;
+    }
+    Analysis &analysis = it->second;
+    // Nothing is passed on across a scene cut or to pictures before the range
+    const bool propagate = poc > first_poc && analysis.has_inter &&
+      !analysis.scene_cut;
+    std::fill(ref_propagate_in.begin(), ref_propagate_in.end(), 0.0);
+    std::fill(ctu_dqp.begin(), ctu_dqp.end(), 0.0);
+    std::fill(ctu_num_blocks.begin(), ctu_num_blocks.end(), 0);
+    for (int by = 0; by < height_in_blocks_; by++) {
+      for (int bx = 0; bx < width_in_blocks_; bx++) {
+        const int idx = by * width_in_blocks_ + bx;
+        const double intra = analysis.intra_cost[idx];
+        const double amount = intra + propagate_in[idx];
+        const int ctu_idx =
+          (by / ctu_blocks) * width_in_ctus + bx / ctu_blocks;
+        ctu_dqp[ctu_idx] -= kPropagateStrength * std::log2(amount / intra);
+        ctu_num_blocks[ctu_idx]++;
+        if (!propagate) {
+          continue;
+        }
+        // The matched area of the previous picture passes on the part of
+        // the information that this block does not need to code again
+        const MvFullpel &mv = analysis.mv[idx];
+        const int ref_x = util::Clip3(bx * kBlockSize + mv.x, 0,
+                                      (width_in_blocks_ - 1) * kBlockSize);
+        const int ref_y = util::Clip3(by * kBlockSize + mv.y, 0,
+                                      (height_in_blocks_ - 1) * kBlockSize);
+        const int ref_idx =
+          ((ref_y + kBlockSize / 2) / kBlockSize) * width_in_blocks_ +
+          (ref_x + kBlockSize / 2) / kBlockSize;
+        const double inter =
+          std::min(intra, static_cast<double>(analysis.inter_cost[idx]));
+        ref_propagate_in[std::min(ref_idx, num_blocks - 1)] +=
+          amount * (1 - inter / intra);
+      }
+    }
+    double pic_dqp = 0;
+    for (size_t j = 0; j < ctu_dqp.size(); j++) {
+      ctu_dqp[j] /= ctu_num_blocks[j];
+      pic_dqp += ctu_dqp[j];
+    }
+    pic_dqp /= ctu_dqp.size();
+    QpOffsets &qp_offsets = analysis.qp_offsets;
+    qp_offsets.pic_offset =
+      util::Clip3(static_cast<int>(std::lround(pic_dqp)), -kMaxPicQpOffset, 0);
+    qp_offsets.ctu_offsets.resize(ctu_dqp.size());
+    for (size_t j = 0; j < ctu_dqp.size(); j++) {
+      qp_offsets.ctu_offsets[j] = static_cast<int>(
+        std::lround(ctu_dqp[j] - qp_offsets.pic_offset));
+    }
+    propagate_in.swap(ref_propagate_in);
+  }
+}
+
+int64_t Lookahead::GetInterCost(PicNum first_poc, PicNum last_poc) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  WaitForAnalysis(last_poc, &lock);
+  int64_t cost = 0;
+  for (auto it = analyses_.upper_bound(first_poc);
+       it != analyses_.end() && it->first <= last_poc; ++it) {
+    const Analysis &analysis = it->second;
+    for (size_t i = 0; i < analysis.intra_cost.size(); i++) {
+      cost += analysis.has_inter ?
+        std::min(analysis.intra_cost[i], analysis.inter_cost[i]) :
+        analysis.intra_cost[i];
+    }
+  }
+  return cost;
+}
+
+Lookahead::QpOffsets Lookahead::GetQpOffsets(PicNum poc) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = analyses_.find(poc);
+  if (it == analyses_.end()) {
+    return QpOffsets();
+  }
+  QpOffsets qp_offsets = std::move(it->second.qp_offsets);
+  analyses_.erase(it);
+  return qp_offsets;
+}
+
+void Lookahead::WorkerMain() {
+  int plane_idx = 0;
+  while (true) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_ && pending_.empty()) {
+      work_cond_.wait(lock);
+    }
+    if (!running_) {
+      break;
+    }
+    Input input = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+
+    std::vector<Sample> &plane = planes_[plane_idx];
+    Downsample(*input.orig_pic, &plane);
+    // The original picture is not needed anymore
+    input.orig_pic.reset();
+    Analysis analysis;
+    const bool has_prev = input.poc > 0 && prev_poc_ + 1 == input.poc;
+    Analyze(plane, has_prev ? &planes_[plane_idx ^ 1] : nullptr, &analysis);
+    prev_poc_ = input.poc;
+    plane_idx ^= 1;
+
+    lock.lock();
+    analyses_[input.poc] = std::move(analysis);
+    last_analyzed_poc_ = input.poc;
+    has_analyzed_ = true;
+    done_cond_.notify_all();
+  }
+}
+
+void Lookahead::Downsample(const YuvPicture &orig_pic,
+                           std::vector<Sample> *plane) {
+  const YuvComponent luma = YuvComponent::kY;
+  const int orig_width = orig_pic.GetWidth(luma);
+  const int orig_height = orig_pic.GetHeight(luma);
+  const ptrdiff_t orig_stride = orig_pic.GetStride(luma);
+  const int pad_width = width_in_blocks_ * kBlockSize + kPadding;
+  const int pad_height = height_in_blocks_ * kBlockSize + kPadding;
+  Sample *dst = &(*plane)[kPadding * stride_ + kPadding];
+  for (int y = 0; y < height_; y++) {
+    const Sample *src0 = orig_pic.GetSamplePtr(luma, 0, 2 * y);
+    const Sample *src1 = 2 * y + 1 < orig_height ? src0 + orig_stride : src0;
+    for (int x = 0; x < width_; x++) {
+      const int x1 = std::min(2 * x + 1, orig_width - 1);
+      dst[x] = static_cast<Sample>(
+        (src0[2 * x] + src0[x1] + src1[2 * x] + src1[x1] + 2) >> 2);
+    }
+    for (int x = width_; x < pad_width; x++) {
+      dst[x] = dst[width_ - 1];
+    }
+    for (int x = -kPadding; x < 0; x++) {
+      dst[x] = dst[0];
+    }
+    dst += stride_;
+  }
+  const Sample *first_line = &(*plane)[kPadding * stride_];
+  const Sample *last_line = first_line + (height_ - 1) * stride_;
+  for (int y = height_; y < pad_height; y++) {
+    std::copy(last_line, last_line + stride_, &(*plane)[(kPadding + y) *
+                                                       stride_]);
+  }
+  for (int y = 0; y < kPadding; y++) {
+    std::copy(first_line, first_line + stride_, &(*plane)[y * stride_]);
+  }
+}
+
+void Lookahead::Analyze(const std::vector<Sample> &plane,
+                        const std::vector<Sample> *prev_plane,
+                        Analysis *analysis) {
+  const YuvComponent luma = YuvComponent::kY;
+  const int num_blocks = width_in_blocks_ * height_in_blocks_;
+  const ptrdiff_t origin = kPadding * stride_ + kPadding;
+  analysis->has_inter = prev_plane != nullptr;
+  analysis->intra_cost.resize(num_blocks);
+  analysis->inter_cost.resize(prev_plane ? num_blocks : 0);
+  analysis->mv.resize(prev_plane ? num_blocks : 0);
+  int64_t sum_intra = 0;
+  int64_t sum_best = 0;
+  for (int by = 0; by < height_in_blocks_; by++) {
+    for (int bx = 0; bx < width_in_blocks_; bx++) {
+      const int idx = by * width_in_blocks_ + bx;
+      const ptrdiff_t offset =
+        origin + by * kBlockSize * stride_ + bx * kBlockSize;
+      const Sample *cur = &plane[offset];
+      const int intra_cost = 1 + static_cast<int>(
+        intra_metric_.CompareSample(qp_, luma, kBlockSize, kBlockSize,
+                                    cur, stride_, &flat_block_[0],
+                                    kBlockSize));
+      analysis->intra_cost[idx] = intra_cost;
+      sum_intra += intra_cost;
+      if (!prev_plane) {
+        continue;
+      }
+      // Predict from the left and above motion as seeds for the search
+      MvFullpel mvp;
+      if (bx > 0) {
+        mvp = analysis->mv[idx - 1];
+      } else if (by > 0) {
+        mvp = analysis->mv[idx - width_in_blocks_];
+      }
+      MvFullpel mv;
+      const int inter_cost =
+        SearchBlock(cur, &(*prev_plane)[offset], bx, by, mvp, &mv);
+      analysis->inter_cost[idx] = inter_cost;
+      analysis->mv[idx] = mv;
+      sum_best += std::min(intra_cost, inter_cost);
+    }
+  }
+  // Flat pictures (e.g. fades) are not considered as scene cuts
+  analysis->scene_cut = prev_plane &&
+    sum_intra > num_blocks * kBlockSize * kBlockSize &&
+    sum_best > kSceneCutRatio * sum_intra;
+}
+
+int Lookahead::SearchBlock(const Sample *cur, const Sample *ref, int bx,
+                           int by, MvFullpel mvp, MvFullpel *best_mv) const {
+  const YuvComponent luma = YuvComponent::kY;
+  // Keep the block within the padded area of the reference plane
+  const int min_x = std::max(-kSearchRange, -bx * kBlockSize - kBlockSize);
+  const int max_x = kSearchRange;
+  const int min_y = std::max(-kSearchRange, -by * kBlockSize - kBlockSize);
+  const int max_y = kSearchRange;
+  auto sad_at = [&](const MvFullpel &mv) {
+    return static_cast<int>(
+      sad_metric_.CompareSample(qp_, luma, kBlockSize, kBlockSize, cur,
+                                stride_, ref + mv.y * stride_ + mv.x,
+                                stride_));
+  };
+  mvp.x = util::Clip3(mvp.x, min_x, max_x);
+  mvp.y = util::Clip3(mvp.y, min_y, max_y);
+  MvFullpel best(0, 0);
+  int best_sad = sad_at(best);
+  if (mvp != best) {
+    const int sad = sad_at(mvp);
+    if (sad < best_sad) {
+      best_sad = sad;
+      best = mvp;
+    }
+  }
+  // Diamond refinement with decreasing step size
+  static const std::array<std::array<int, 2>, 4> kDiamond = { {
+    { 0, -1 }, { -1, 0 }, { 1, 0 }, { 0, 1 }
+  } };
+  for (int step = kSearchRange / 4; step > 0; step >>= 1) {
+    bool improved = true;
+    while (improved) {
+      improved = false;
+      const MvFullpel center = best;
+      for (const auto &offset : kDiamond) {
+        const MvFullpel mv(center.x + offset[0] * step,
+                           center.y + offset[1] * step);
+        if (mv.x < min_x || mv.x > max_x || mv.y < min_y || mv.y > max_y) {
+          continue;
+        }
+        const int sad = sad_at(mv);
+        if (sad < best_sad) {
+          best_sad = sad;
+          best = mv;
+          improved = true;
+        }
+      }
+    }
+  }
+  *best_mv = best;
+
+  // Half sample refinement of the cost, a motion of one sample in full
+  // resolution is a half sample motion here
+  const Sample *ref_best = ref + best.y * stride_ + best.x;
+  int best_cost = static_cast<int>(
+    satd_metric_.CompareSample(qp_, luma, kBlockSize, kBlockSize, cur,
+                               stride_, ref_best, stride_));
+  std::array<Sample, kBlockSize * kBlockSize> pred;
+  for (int dy = -1; dy <= 1; dy++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      if (dx == 0 && dy == 0) {
+        continue;
+      }
+      const Sample *src0 = ref_best + std::min(dy, 0) * stride_ +
+        std::min(dx, 0);
+      const ptrdiff_t offset_x = dx != 0 ? 1 : 0;
+      const ptrdiff_t offset_y = dy != 0 ? stride_ : 0;
+      for (int y = 0; y < kBlockSize; y++) {
+        const Sample *src = src0 + y * stride_;
+        for (int x = 0; x < kBlockSize; x++) {
+          pred[y * kBlockSize + x] = static_cast<Sample>(
+            (src[x] + src[x + offset_x] + src[x + offset_y] +
+             src[x + offset_x + offset_y] + 2) >> 2);
+        }
+      }
+      const int cost = static_cast<int>(
+        satd_metric_.CompareSample(qp_, luma, kBlockSize, kBlockSize, cur,
+                                   stride_, &pred[0], kBlockSize));
+      best_cost = std::min(best_cost, cost);
+    }
+  }
+  return 1 + best_cost;
+}
+
+void Lookahead::WaitForAnalysis(PicNum poc,
+                                std::unique_lock<std::mutex> *lock) {
+  // Pictures are analyzed in the same order as they are pushed
+  while (!has_analyzed_ || last_analyzed_poc_ < poc) {
+    done_cond_.wait(*lock);
+  }
+}
+
+}   // namespace xvc
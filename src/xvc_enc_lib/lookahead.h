@@ -0,0 +1,122 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#ifndef XVC_ENC_LIB_LOOKAHEAD_H_
+#define XVC_ENC_LIB_LOOKAHEAD_H_
+
+// Some C++11 headers are not allowed by cpplint
+#include <condition_variable>   // NOLINT
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>                // NOLINT
+#include <thread>               // NOLINT
+#include <vector>
+
+#include "xvc_common_lib/common.h"
+#include "xvc_common_lib/cu_types.h"
+#include "xvc_common_lib/quantize.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/sample_metric.h"
+
+namespace xvc {
+
+// Analyses input pictures at half resolution on a separate thread. The
+// estimated intra and inter costs are used for scene cut detection and for
+// deriving picture and ctu qp offsets from how much each area is expected
+// to be referenced by the following pictures.
+class Lookahead {
+public:
+  struct QpOffsets {
+    int pic_offset = 0;
+    // Relative to the picture qp, indexed by ctu raster scan address
+    std::vector<int> ctu_offsets;
+  };
+
+  Lookahead(const SampleMetric::SimdFunc &simd, int width, int height,
+            int bitdepth);
+  ~Lookahead();
+  // Queues an input picture for analysis, pictures must be pushed in
+  // display order and the original picture must stay unmodified until the
+  // picture has been analyzed
+  void Push(PicNum poc, std::shared_ptr<const YuvPicture> orig_pic);
+  // Returns true if any picture in the range starts a new scene
+  bool HasSceneCut(PicNum first_poc, PicNum last_poc);
+  // Derives qp offsets for all pictures in the range from the accumulated
+  // amount of information each block passes on to the later pictures in
+  // the range. Analysis of pictures before the range is discarded.
+  void Propagate(PicNum first_poc, PicNum last_poc);
+  // Returns the estimated cost of predicting each picture after the first
+  // picture in the range from its preceding picture, summed over the range
+  int64_t GetInterCost(PicNum first_poc, PicNum last_poc);
+  QpOffsets GetQpOffsets(PicNum poc);
+
+private:
+  static const int kBlockSize = 8;
+  static const int kSearchRange = 16;
+  static const int kPadding = kSearchRange + kBlockSize;
+
+  struct Input {
+    PicNum poc;
+    std::shared_ptr<const YuvPicture> orig_pic;
+  };
+  struct Analysis {
+    bool has_inter = false;
+    bool scene_cut = false;
+    std::vector<int> intra_cost;
+    std::vector<int> inter_cost;
+    std::vector<MvFullpel> mv;
+    QpOffsets qp_offsets;
+  };
+  void WorkerMain();
+  void Downsample(const YuvPicture &orig_pic, std::vector<Sample> *plane);
+  void Analyze(const std::vector<Sample> &plane,
+               const std::vector<Sample> *prev_plane, Analysis *analysis);
+  int SearchBlock(const Sample *cur, const Sample *ref, int bx, int by,
+                  MvFullpel mvp, MvFullpel *best_mv) const;
+  void WaitForAnalysis(PicNum poc, std::unique_lock<std::mutex> *lock);
+
+  const int width_;
+  const int height_;
+  const int width_in_blocks_;
+  const int height_in_blocks_;
+  const int stride_;
+  const Qp qp_;
+  const SampleMetric sad_metric_;
+  const SampleMetric satd_metric_;
+  const SampleMetric intra_metric_;
+  std::vector<Sample> flat_block_;
+  std::vector<Sample> planes_[2];
+  PicNum prev_poc_ = static_cast<PicNum>(-1);
+  std::map<PicNum, Analysis> analyses_;
+  PicNum last_analyzed_poc_ = 0;
+  bool has_analyzed_ = false;
+  std::deque<Input> pending_;
+  std::mutex mutex_;
+  std::condition_variable work_cond_;
+  std::condition_variable done_cond_;
+  bool running_ = true;
+  std::thread worker_;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_ENC_LIB_LOOKAHEAD_H_
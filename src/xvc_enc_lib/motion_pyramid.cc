@@ -0,0 +1,215 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include "xvc_enc_lib/motion_pyramid.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace xvc {
+
+MvFullpel MotionPyramid::MotionField::GetMv(int posx, int posy, int width,
+                                            int height) const {
+  const int bx = util::Clip3((posx + width / 2) / kFieldBlockSize, 0,
+                             width_in_blocks_ - 1);
+  const int by = util::Clip3((posy + height / 2) / kFieldBlockSize, 0,
+                             height_in_blocks_ - 1);
+  return mv_[by * width_in_blocks_ + bx];
+}
+
+MotionPyramid::MotionPyramid(const SampleMetric::SimdFunc &simd, int width,
+                             int height, int bitdepth)
+  : width_(width),
+  height_(height),
+  qp_(constants::kMaxAllowedQp, ChromaFormat::kMonochrome, bitdepth, 1.0),
+  sad_metric_(simd, bitdepth, MetricType::kSad),
+  mv_cost_factor_(4 << (bitdepth - 8)) {
+  int level_width = width;
+  int level_height = height;
+  for (Level &level : levels_) {
+    level_width = (level_width + 1) >> 1;
+    level_height = (level_height + 1) >> 1;
+    level.width = level_width;
+    level.height = level_height;
+    level.width_in_blocks = (level_width + kBlockSize - 1) / kBlockSize;
+    level.height_in_blocks = (level_height + kBlockSize - 1) / kBlockSize;
+    level.stride = level.width_in_blocks * kBlockSize + 2 * kPadding;
+    level.plane.resize(level.stride *
+                       (level.height_in_blocks * kBlockSize + 2 * kPadding));
+  }
+}
+
+void MotionPyramid::Build(const YuvPicture &pic) {
+  const YuvComponent luma = YuvComponent::kY;
+  assert(pic.GetWidth(luma) == width_ && pic.GetHeight(luma) == height_);
+  Downsample(pic.GetSamplePtr(luma, 0, 0), pic.GetStride(luma), width_,
+             height_, &levels_[0]);
+  for (int i = 1; i < kNumLevels; i++) {
+    const Level &src = levels_[i - 1];
+    Downsample(src.GetBlock(0, 0), src.stride, src.width, src.height,
+               &levels_[i]);
+  }
+}
+
+void MotionPyramid::EstimateMotion(const MotionPyramid &ref, int search_range,
+                                   MotionField *field) const {
+  assert(ref.width_ == width_ && ref.height_ == height_);
+  std::vector<MvFullpel> coarse;
+  std::vector<MvFullpel> fine;
+  SearchLevel(kNumLevels - 1, ref.levels_[kNumLevels - 1], nullptr,
+              search_range >> kNumLevels, &coarse);
+  for (int i = kNumLevels - 2; i >= 0; i--) {
+    SearchLevel(i, ref.levels_[i], &coarse, 0, &fine);
+    std::swap(coarse, fine);
+  }
+  field->width_in_blocks_ = levels_[0].width_in_blocks;
+  field->height_in_blocks_ = levels_[0].height_in_blocks;
+  field->mv_.resize(coarse.size());
+  for (size_t i = 0; i < coarse.size(); i++) {
+    field->mv_[i] = MvFullpel(coarse[i].x * 2, coarse[i].y * 2);
+  }
+}
+
+void MotionPyramid::Downsample(const Sample *src, ptrdiff_t src_stride,
+                               int src_width, int src_height, Level *level) {
+  const int pad_width = level->width_in_blocks * kBlockSize + kPadding;
+  const int pad_height = level->height_in_blocks * kBlockSize + kPadding;
+  const ptrdiff_t stride = level->stride;
+  Sample *dst = &level->plane[kPadding * stride + kPadding];
+  for (int y = 0; y < level->height; y++) {
+    const Sample *src0 = src + 2 * y * src_stride;
+    const Sample *src1 = 2 * y + 1 < src_height ? src0 + src_stride : src0;
+    for (int x = 0; x < level->width; x++) {
+      const int x1 = std::min(2 * x + 1, src_width - 1);
+      dst[x] = static_cast<Sample>(
+        (src0[2 * x] + src0[x1] + src1[2 * x] + src1[x1] + 2) >> 2);
+    }
+    for (int x = level->width; x < pad_width; x++) {
+      dst[x] = dst[level->width - 1];
+    }
+    for (int x = -kPadding; x < 0; x++) {
+      dst[x] = dst[0];
+    }
+    dst += stride;
+  }
+  const Sample *first_line = &level->plane[kPadding * stride];
+  const Sample *last_line = first_line + (level->height - 1) * stride;
+  for (int y = level->height; y < pad_height; y++) {
+    std::copy(last_line, last_line + stride,
+              &level->plane[(kPadding + y) * stride]);
+  }
+  for (int y = 0; y < kPadding; y++) {
+    std::copy(first_line, first_line + stride, &level->plane[y * stride]);
+  }
+}
+
+void MotionPyramid::SearchLevel(int level_idx, const Level &ref,
+                                const std::vector<MvFullpel> *parent,
+                                int search_range,
+                                std::vector<MvFullpel> *field) const {
+  const YuvComponent luma = YuvComponent::kY;
+  const Level &cur = levels_[level_idx];
+  const int width_in_blocks = cur.width_in_blocks;
+  const int height_in_blocks = cur.height_in_blocks;
+  field->assign(width_in_blocks * height_in_blocks, MvFullpel(0, 0));
+  for (int by = 0; by < height_in_blocks; by++) {
+    for (int bx = 0; bx < width_in_blocks; bx++) {
+      const int idx = by * width_in_blocks + bx;
+      const Sample *cur_block = cur.GetBlock(bx, by);
+      const Sample *ref_block = ref.GetBlock(bx, by);
+      // Keep the block within the padded area of the reference plane
+      const int min_x = -kPadding - bx * kBlockSize;
+      const int max_x = (width_in_blocks - bx - 1) * kBlockSize + kPadding;
+      const int min_y = -kPadding - by * kBlockSize;
+      const int max_y = (height_in_blocks - by - 1) * kBlockSize + kPadding;
+      // Motion of the left or above block is used as predictor, this keeps
+      // the field smooth in areas without texture
+      MvFullpel mvp;
+      if (bx > 0) {
+        mvp = (*field)[idx - 1];
+      } else if (by > 0) {
+        mvp = (*field)[idx - width_in_blocks];
+      }
+      auto cost_at = [&](const MvFullpel &mv) {
+        const Distortion sad =
+          sad_metric_.CompareSample(qp_, luma, kBlockSize, kBlockSize,
+                                    cur_block, cur.stride,
+                                    ref_block + mv.y * ref.stride + mv.x,
+                                    ref.stride);
+        return sad + mv_cost_factor_ *
+          (std::abs(mv.x - mvp.x) + std::abs(mv.y - mvp.y));
+      };
+      MvFullpel best(0, 0);
+      Distortion best_cost = cost_at(best);
+      auto check = [&](int mv_x, int mv_y) {
+        const MvFullpel mv(util::Clip3(mv_x, min_x, max_x),
+                           util::Clip3(mv_y, min_y, max_y));
+        if (mv == best) {
+          return;
+        }
+        const Distortion cost = cost_at(mv);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best = mv;
+        }
+      };
+      check(mvp.x, mvp.y);
+      if (by > 0) {
+        const MvFullpel &above = (*field)[idx - width_in_blocks];
+        check(above.x, above.y);
+        if (bx + 1 < width_in_blocks) {
+          const MvFullpel &above_right = (*field)[idx - width_in_blocks + 1];
+          check(above_right.x, above_right.y);
+        }
+      }
+      if (parent) {
+        const int parent_width = levels_[level_idx + 1].width_in_blocks;
+        const int parent_height = levels_[level_idx + 1].height_in_blocks;
+        const int px = std::min(bx >> 1, parent_width - 1);
+        const int py = std::min(by >> 1, parent_height - 1);
+        const MvFullpel &parent_mv = (*parent)[py * parent_width + px];
+        check(parent_mv.x * 2, parent_mv.y * 2);
+      } else {
+        // Sparse search over the full range, only done at lowest resolution
+        const int grid_min_x = std::max(-search_range, min_x);
+        const int grid_max_x = std::min(search_range, max_x);
+        const int grid_min_y = std::max(-search_range, min_y);
+        const int grid_max_y = std::min(search_range, max_y);
+        for (int y = grid_min_y; y <= grid_max_y; y += kGridStep) {
+          for (int x = grid_min_x; x <= grid_max_x; x += kGridStep) {
+            check(x, y);
+          }
+        }
+      }
+      const MvFullpel center = best;
+      for (int dy = -kRefineRange; dy <= kRefineRange; dy++) {
+        for (int dx = -kRefineRange; dx <= kRefineRange; dx++) {
+          check(center.x + dx, center.y + dy);
+        }
+      }
+      (*field)[idx] = best;
+    }
+  }
+}
+
+}   // namespace xvc
@@ -0,0 +1,111 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#ifndef XVC_ENC_LIB_MOTION_PYRAMID_H_
+#define XVC_ENC_LIB_MOTION_PYRAMID_H_
+
+#include <array>
+#include <vector>
+
+#include "xvc_common_lib/common.h"
+#include "xvc_common_lib/cu_types.h"
+#include "xvc_common_lib/quantize.h"
+#include "xvc_common_lib/reference_picture_lists.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/sample_metric.h"
+
+namespace xvc {
+
+// Luma of a picture downsampled by two and four in each direction. Motion is
+// searched over a wide range at the lowest resolution and refined at each
+// finer level, the resulting field is used as starting point for the full
+// resolution motion estimation of each CU.
+class MotionPyramid {
+public:
+  // Size in full resolution samples of each block of the motion field
+  static const int kFieldBlockSize = 16;
+
+  class MotionField {
+  public:
+    bool IsEmpty() const { return mv_.empty(); }
+    // Motion of the block covering the center of the given area
+    MvFullpel GetMv(int posx, int posy, int width, int height) const;
+
+  private:
+    int width_in_blocks_ = 0;
+    int height_in_blocks_ = 0;
+    std::vector<MvFullpel> mv_;
+    friend class MotionPyramid;
+  };
+  using RefMotionFields =
+    std::array<std::array<MotionField, constants::kMaxNumRefPics>,
+    static_cast<int>(RefPicList::kTotalNumber)>;
+
+  MotionPyramid(const SampleMetric::SimdFunc &simd, int width, int height,
+                int bitdepth);
+  int GetWidth() const { return width_; }
+  int GetHeight() const { return height_; }
+  // Downsamples the luma of the picture into all levels
+  void Build(const YuvPicture &pic);
+  // Estimates the motion of this picture relative to the reference picture
+  // within +-search_range full resolution samples
+  void EstimateMotion(const MotionPyramid &ref, int search_range,
+                      MotionField *field) const;
+
+private:
+  static const int kNumLevels = 2;
+  static const int kBlockSize = 8;
+  static const int kPadding = 2 * kBlockSize;
+  static const int kGridStep = 4;
+  static const int kRefineRange = 2;
+  static_assert(kFieldBlockSize == 2 * kBlockSize,
+                "Motion field is stored at half resolution");
+
+  struct Level {
+    int width;
+    int height;
+    int width_in_blocks;
+    int height_in_blocks;
+    ptrdiff_t stride;
+    std::vector<Sample> plane;
+    const Sample* GetBlock(int bx, int by) const {
+      return &plane[(kPadding + by * kBlockSize) * stride + kPadding +
+        bx * kBlockSize];
+    }
+  };
+  void Downsample(const Sample *src, ptrdiff_t src_stride, int src_width,
+                  int src_height, Level *level);
+  void SearchLevel(int level_idx, const Level &ref,
+                   const std::vector<MvFullpel> *parent, int search_range,
+                   std::vector<MvFullpel> *field) const;
+
+  const int width_;
+  const int height_;
+  const Qp qp_;
+  const SampleMetric sad_metric_;
+  const int mv_cost_factor_;
+  std::array<Level, kNumLevels> levels_;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_ENC_LIB_MOTION_PYRAMID_H_
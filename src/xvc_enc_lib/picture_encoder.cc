@@ -41,16 +41,30 @@ namespace xvc {
 
 PictureEncoder::PictureEncoder(const EncoderSimdFunctions &simd,
                                const PictureFormat &pic_fmt,
-                               int crop_width, int crop_height)
+                               int crop_width, int crop_height,
+                               const PictureAllocator &allocator)
   : simd_(simd),
-  orig_pic_(std::make_shared<YuvPicture>(pic_fmt.chroma_format, pic_fmt.width,
-                                         pic_fmt.height, pic_fmt.bitdepth,
-                                         false, crop_width, crop_height)),
+  pic_fmt_(pic_fmt),
+  crop_width_(crop_width),
+  crop_height_(crop_height),
+  allocator_(allocator),
   pic_data_(std::make_shared<PictureData>(pic_fmt.chroma_format, pic_fmt.width,
-                                          pic_fmt.height, pic_fmt.bitdepth)),
+                                          pic_fmt.height, pic_fmt.bitdepth,
+                                          allocator)),
   rec_pic_(std::make_shared<YuvPicture>(pic_fmt.chroma_format, pic_fmt.width,
                                         pic_fmt.height, pic_fmt.bitdepth,
-                                        true, 0, 0)) {
+                                        true, 0, 0, allocator)) {
+}
+
+YuvPicture* PictureEncoder::PrepareOrigPic() {
+  if (!own_orig_pic_) {
+    own_orig_pic_ =
+      std::make_shared<YuvPicture>(pic_fmt_.chroma_format, pic_fmt_.width,
+                                   pic_fmt_.height, pic_fmt_.bitdepth, false,
+                                   crop_width_, crop_height_, allocator_);
+  }
+  orig_pic_ = own_orig_pic_;
+  return own_orig_pic_.get();
 }
 
 void PictureEncoder::Init(const SegmentHeader &segment, PicNum doc, PicNum poc,
@@ -58,6 +72,7 @@ void PictureEncoder::Init(const SegmentHeader &segment, PicNum doc, PicNum poc,
   const int max_tid = SegmentHeader::GetMaxTid(segment.max_sub_gop_length);
   output_status_ = OutputStatus::kReady;
   buffer_flag_ = false;
+  qp_offsets_ = Lookahead::QpOffsets();
   pic_data_->SetDoc(doc);
   pic_data_->SetPoc(poc);
   pic_data_->SetTid(tid);
@@ -95,6 +110,8 @@ void PictureEncoder::Init(const SegmentHeader &segment, PicNum doc, PicNum poc,
 const std::vector<uint8_t>*
 PictureEncoder::Encode(const SegmentHeader &segment, int segment_qp,
                        int buffer_flag,
+                       const std::vector<std::shared_ptr<const PictureEncoder>>
+                       &ref_pics,
                        const EncoderSettings &encoder_settings) {
   const PicturePredictionType picture_type = pic_data_->GetPredictionType();
   int sub_gop_length = static_cast<int>(segment.max_sub_gop_length);
@@ -105,6 +122,7 @@ PictureEncoder::Encode(const SegmentHeader &segment, int segment_qp,
     max_tid = SegmentHeader::GetMaxTid(sub_gop_length);
     pic_tid = max_tid;
   }
+  segment_qp_ = segment_qp;
   const int pic_qp =
     DerivePictureQp(encoder_settings, segment_qp, picture_type, pic_tid);
   const double pic_lambda =
@@ -121,6 +139,18 @@ PictureEncoder::Encode(const SegmentHeader &segment, int segment_qp,
   const bool allow_lic = DetermineAllowLic(pic_data_->GetPredictionType(),
                                            *pic_data_->GetRefPicLists());
   pic_data_->SetUseLocalIlluminationCompensation(allow_lic);
+  if (encoder_settings.pyramid_motion_search) {
+    EstimateCoarseMotion(ref_pics,
+                         std::max(encoder_settings.inter_search_range_uni_max,
+                                  kMinCoarseSearchRange));
+  }
+  has_subpel_planes_ = false;
+  if (encoder_settings.subpel_plane_cache > 0) {
+    CollectRefSubpelPlanes(ref_pics);
+  }
+  if (encoder_settings.intra_edge_mode_pruning > 0) {
+    BuildEdgeDirections();
+  }
 
   bit_writer_.Clear();
   if (encoder_settings.encapsulation_mode != 0) {
@@ -135,6 +165,30 @@ PictureEncoder::Encode(const SegmentHeader &segment, int segment_qp,
     cu_encoder(new CuEncoder(simd_, *orig_pic_, rec_pic_.get(), pic_data_.get(),
                              encoder_settings));
   int num_ctus = pic_data_->GetNumberOfCtu();
+  if (static_cast<int>(qp_offsets_.ctu_offsets.size()) == num_ctus) {
+    cu_encoder->SetCtuQpOffsets(&qp_offsets_.ctu_offsets);
+  }
+  if (encoder_settings.pyramid_motion_search) {
+    cu_encoder->SetCoarseMotion(&coarse_motion_);
+  }
+  if (encoder_settings.subpel_plane_cache > 0) {
+    cu_encoder->SetSubpelPlanes(&ref_subpel_planes_);
+  }
+  if (encoder_settings.inter_pred_cache > 0) {
+    cu_encoder->SetInterPredCache(&inter_pred_cache_);
+  }
+  if (encoder_settings.intra_edge_mode_pruning > 0) {
+    cu_encoder->SetEdgeDirections(edge_map_.get());
+  }
+  const bool use_cu_size_map = encoder_settings.fast_cu_split_prediction > 0 ||
+    encoder_settings.cu_split_stats > 0;
+  if (use_cu_size_map) {
+    cu_encoder->SetColocatedCuSizes(FindColocatedCuSizes(ref_pics));
+  }
+  cu_split_stats_.clear();
+  if (encoder_settings.cu_split_stats > 0) {
+    cu_encoder->SetCuSplitStats(&cu_split_stats_);
+  }
   for (int rsaddr = 0; rsaddr < num_ctus; rsaddr++) {
     cu_encoder->EncodeCtu(rsaddr, &writer);
   }
@@ -145,9 +199,18 @@ PictureEncoder::Encode(const SegmentHeader &segment, int segment_qp,
     deblocker.DeblockPicture();
   }
   writer.Finish();
+  if (use_cu_size_map) {
+    cu_size_map_.Build(*pic_data_);
+  }
+  // Rdo buffers are handed back to picture before the cu trees are released
+  cu_encoder.reset();
+  pic_data_->ReleaseCuTree();
 
   if (pic_data_->GetTid() == 0 || !pic_data_->IsHighestLayer()) {
     rec_pic_->PadBorder();
+    if (encoder_settings.subpel_plane_cache > 0) {
+      BuildSubpelPlanes(encoder_settings.subpel_plane_cache);
+    }
   }
   pic_data_->GetRefPicLists()->ZeroOutReferences();
   if (pic_data_->GetTid() == 0 ||
@@ -163,6 +226,133 @@ PictureEncoder::Encode(const SegmentHeader &segment, int segment_qp,
   return bit_writer_.GetBytes();
 }
 
+void PictureEncoder::EstimateCoarseMotion(
+  const std::vector<std::shared_ptr<const PictureEncoder>> &ref_pics,
+  int search_range) {
+  const YuvComponent luma = YuvComponent::kY;
+  const int width = orig_pic_->GetWidth(luma);
+  const int height = orig_pic_->GetHeight(luma);
+  if (!motion_pyramid_ || motion_pyramid_->GetWidth() != width ||
+      motion_pyramid_->GetHeight() != height) {
+    motion_pyramid_.reset(new MotionPyramid(simd_.sample_metric, width,
+                                            height, pic_data_->GetBitdepth()));
+  }
+  // Also built for intra pictures since they are used as reference later
+  motion_pyramid_->Build(*orig_pic_);
+
+  const ReferencePictureLists &ref_lists = *pic_data_->GetRefPicLists();
+  for (int list_idx = 0; list_idx < static_cast<int>(coarse_motion_.size());
+       list_idx++) {
+    const RefPicList ref_list = static_cast<RefPicList>(list_idx);
+    const int num_ref_pics =
+      pic_data_->IsIntraPic() ? 0 : ref_lists.GetNumRefPics(ref_list);
+    for (int ref_idx = 0; ref_idx < constants::kMaxNumRefPics; ref_idx++) {
+      MotionPyramid::MotionField &field = coarse_motion_[list_idx][ref_idx];
+      field = MotionPyramid::MotionField();
+      if (ref_idx >= num_ref_pics) {
+        continue;
+      }
+      const PicNum ref_poc = ref_lists.GetRefPoc(ref_list, ref_idx);
+      if (list_idx > 0 && ref_lists.HasRefPoc(RefPicList::kL0, ref_poc)) {
+        // Same picture is already estimated for the first list
+        for (int i = 0; i < ref_lists.GetNumRefPics(RefPicList::kL0); i++) {
+          if (ref_lists.GetRefPoc(RefPicList::kL0, i) == ref_poc) {
+            field = coarse_motion_[0][i];
+            break;
+          }
+        }
+        continue;
+      }
+      for (const std::shared_ptr<const PictureEncoder> &ref_pic : ref_pics) {
+        if (ref_pic->GetPoc() != ref_poc) {
+          continue;
+        }
+        if (ref_pic->motion_pyramid_ &&
+            ref_pic->motion_pyramid_->GetWidth() == width &&
+            ref_pic->motion_pyramid_->GetHeight() == height) {
+          motion_pyramid_->EstimateMotion(*ref_pic->motion_pyramid_,
+                                          search_range, &field);
+        }
+        break;
+      }
+    }
+  }
+}
+
+void PictureEncoder::BuildSubpelPlanes(int level) {
+  const YuvComponent luma = YuvComponent::kY;
+  const int width = rec_pic_->GetWidth(luma);
+  const int height = rec_pic_->GetHeight(luma);
+  if (width == 0 || height == 0) {
+    return;
+  }
+  if (!subpel_planes_ || subpel_planes_->GetWidth() != width ||
+      subpel_planes_->GetHeight() != height ||
+      subpel_planes_->GetLevel() != level) {
+    subpel_planes_.reset(new SubpelPlaneCache(width, height, level,
+                                              allocator_));
+  }
+  // Set before any picture referencing it is started, the planes are then
+  // interpolated by the threads encoding the referencing pictures
+  subpel_planes_->Build(simd_.inter_prediction, *rec_pic_);
+  has_subpel_planes_ = true;
+}
+
+void PictureEncoder::BuildEdgeDirections() {
+  const YuvComponent luma = YuvComponent::kY;
+  const int width = orig_pic_->GetWidth(luma);
+  const int height = orig_pic_->GetHeight(luma);
+  if (!edge_map_ || edge_map_->GetWidth() != width ||
+      edge_map_->GetHeight() != height) {
+    edge_map_.reset(new EdgeDirectionMap(width, height,
+                                         pic_data_->GetBitdepth()));
+  }
+  edge_map_->Build(*orig_pic_);
+}
+
+const CuSizeMap* PictureEncoder::FindColocatedCuSizes(
+  const std::vector<std::shared_ptr<const PictureEncoder>> &ref_pics) const {
+  const ReferencePictureLists &ref_lists = *pic_data_->GetRefPicLists();
+  if (pic_data_->IsIntraPic() ||
+      ref_lists.GetNumRefPics(RefPicList::kL0) == 0) {
+    return nullptr;
+  }
+  const PicNum ref_poc = ref_lists.GetRefPoc(RefPicList::kL0, 0);
+  for (const std::shared_ptr<const PictureEncoder> &ref_pic : ref_pics) {
+    if (ref_pic->GetPoc() == ref_poc && !ref_pic->cu_size_map_.IsEmpty()) {
+      return &ref_pic->cu_size_map_;
+    }
+  }
+  return nullptr;
+}
+
+void PictureEncoder::CollectRefSubpelPlanes(
+  const std::vector<std::shared_ptr<const PictureEncoder>> &ref_pics) {
+  const ReferencePictureLists &ref_lists = *pic_data_->GetRefPicLists();
+  for (int list_idx = 0; list_idx < static_cast<int>(ref_subpel_planes_.size());
+       list_idx++) {
+    const RefPicList ref_list = static_cast<RefPicList>(list_idx);
+    const int num_ref_pics =
+      pic_data_->IsIntraPic() ? 0 : ref_lists.GetNumRefPics(ref_list);
+    for (int ref_idx = 0; ref_idx < constants::kMaxNumRefPics; ref_idx++) {
+      ref_subpel_planes_[list_idx][ref_idx] = nullptr;
+      if (ref_idx >= num_ref_pics) {
+        continue;
+      }
+      const YuvPicture *ref_pic = ref_lists.GetRefPic(ref_list, ref_idx);
+      for (const std::shared_ptr<const PictureEncoder> &ref_pic_enc :
+           ref_pics) {
+        if (ref_pic_enc->rec_pic_.get() == ref_pic &&
+            ref_pic_enc->has_subpel_planes_) {
+          ref_subpel_planes_[list_idx][ref_idx] =
+            ref_pic_enc->subpel_planes_.get();
+          break;
+        }
+      }
+    }
+  }
+}
+
 std::shared_ptr<YuvPicture>
 PictureEncoder::GetAlternativeRecPic(const PictureFormat &pic_fmt,
                                      int crop_width, int crop_height) const {
@@ -223,6 +413,7 @@ PictureEncoder::DerivePictureQp(const EncoderSettings &encoder_settings,
   } else {
     pic_qp = segment_qp + tid + 1;
   }
+  pic_qp += qp_offsets_.pic_offset;
   return util::Clip3(pic_qp, constants::kMinAllowedQp,
                      constants::kMaxAllowedQp);
 }
@@ -255,7 +446,7 @@ PictureEncoder::DetermineAllowLic(PicturePredictionType pic_type,
 
   std::vector<int32_t> histogram_orig(num_buckets, 0);
   std::vector<int32_t> histogram_ref(num_buckets, 0);
-  SampleBuffer orig_buffer = orig_pic_->GetSampleBuffer(comp, 0, 0);
+  SampleBufferConst orig_buffer = orig_pic_->GetSampleBuffer(comp, 0, 0);
   build_histogram(orig_buffer, true, &histogram_orig);
 
   int num_ref_lists = pic_type == PicturePredictionType::kBi ? 2 : 1;
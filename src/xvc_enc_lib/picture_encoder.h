@@ -32,8 +32,13 @@
 #include "xvc_common_lib/segment_header.h"
 #include "xvc_common_lib/yuv_pic.h"
 #include "xvc_enc_lib/bit_writer.h"
+#include "xvc_enc_lib/edge_direction_map.h"
 #include "xvc_enc_lib/encoder_settings.h"
 #include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/lookahead.h"
+#include "xvc_enc_lib/motion_pyramid.h"
+#include "xvc_enc_lib/split_predictor.h"
+#include "xvc_enc_lib/subpel_plane_cache.h"
 #include "xvc_enc_lib/syntax_writer.h"
 #include "xvc_enc_lib/xvcenc.h"
 
@@ -43,9 +48,26 @@ class PictureEncoder {
 public:
   PictureEncoder(const EncoderSimdFunctions &simd,
                  const PictureFormat &pic_fmt,
-                 int crop_width, int crop_height);
+                 int crop_width, int crop_height,
+                 const PictureAllocator &allocator = PictureAllocator());
   std::shared_ptr<const YuvPicture> GetOrigPic() const { return orig_pic_; }
-  std::shared_ptr<YuvPicture> GetOrigPic() { return orig_pic_; }
+  // Returns the internal original picture buffer for writing input samples,
+  // the buffer is allocated on first use
+  YuvPicture* PrepareOrigPic();
+  // Use externally owned samples as original picture without copy
+  void SetExternalOrigPic(std::shared_ptr<const YuvPicture> &&orig_pic) {
+    orig_pic_ = std::move(orig_pic);
+  }
+  bool HasExternalOrigPic() const {
+    return orig_pic_ && orig_pic_ != own_orig_pic_;
+  }
+  // Drops the reference to an external original picture once it is no
+  // longer needed for encoding or as reference
+  void ReleaseExternalOrigPic() {
+    if (HasExternalOrigPic()) {
+      orig_pic_.reset();
+    }
+  }
   std::shared_ptr<const PictureData> GetPicData() const { return pic_data_; }
   std::shared_ptr<PictureData> GetPicData() { return pic_data_; }
   std::shared_ptr<const YuvPicture> GetRecPic() const { return rec_pic_; }
@@ -79,13 +101,26 @@ public:
         break;
     }
   }
+  // Segment qp the picture was last encoded with
+  int GetSegmentQp() const { return segment_qp_; }
   void SetUserData(int64_t user_data) { user_data_ = user_data; }
   int64_t GetUserData() const { return user_data_; }
+  // Qp adjustments from lookahead analysis, reset by Init
+  void SetQpOffsets(Lookahead::QpOffsets &&qp_offsets) {
+    qp_offsets_ = std::move(qp_offsets);
+  }
+  // Split statistics of the last encode when enabled by the settings
+  const std::vector<xvc_enc_cu_split_stats>& GetCuSplitStats() const {
+    return cu_split_stats_;
+  }
 
   void Init(const SegmentHeader &segment, PicNum doc, PicNum poc, int tid,
             bool is_access_picture);
+  // The reference pictures must have been encoded before, they are only
+  // accessed during the call
   const std::vector<uint8_t>*
     Encode(const SegmentHeader &segment, int segment_qp, int buffer_flag,
+           const std::vector<std::shared_ptr<const PictureEncoder>> &ref_pics,
            const EncoderSettings &encoder_settings);
   const std::vector<uint8_t>& GetLastChecksum() const { return pic_hash_; }
   std::shared_ptr<YuvPicture> GetAlternativeRecPic(
@@ -99,6 +134,15 @@ private:
                      Checksum::Mode checksum_mode);
   int DerivePictureQp(const EncoderSettings &encoder_settings, int segment_qp,
                       PicturePredictionType pic_type, int tid) const;
+  void EstimateCoarseMotion(
+    const std::vector<std::shared_ptr<const PictureEncoder>> &ref_pics,
+    int search_range);
+  void BuildSubpelPlanes(int level);
+  void BuildEdgeDirections();
+  const CuSizeMap* FindColocatedCuSizes(
+    const std::vector<std::shared_ptr<const PictureEncoder>> &ref_pics) const;
+  void CollectRefSubpelPlanes(
+    const std::vector<std::shared_ptr<const PictureEncoder>> &ref_pics);
   bool DetermineAllowLic(PicturePredictionType pic_type,
                          const ReferencePictureLists &ref_list) const;
   uint64_t CalculatePicMetric(const Qp &qp) const;
@@ -110,9 +154,18 @@ private:
                                 int max_temporal_id);
   static int GetQpFromLambda(int bitdepth, double lambda);
 
+  // Motion of this size is found by the coarse search regardless of the
+  // search range used at full resolution
+  static const int kMinCoarseSearchRange = 256;
+
   const EncoderSimdFunctions &simd_;
   BitWriter bit_writer_;
-  std::shared_ptr<YuvPicture> orig_pic_;
+  PictureFormat pic_fmt_;
+  int crop_width_;
+  int crop_height_;
+  PictureAllocator allocator_;
+  std::shared_ptr<const YuvPicture> orig_pic_;
+  std::shared_ptr<YuvPicture> own_orig_pic_;
   std::shared_ptr<PictureData> pic_data_;
   std::shared_ptr<YuvPicture> rec_pic_;
   std::vector<uint8_t> pic_hash_;
@@ -121,6 +174,20 @@ private:
   double rec_psnr_u_ = 0;
   double rec_psnr_v_ = 0;
   int64_t user_data_ = 0;
+  int segment_qp_ = 0;
+  Lookahead::QpOffsets qp_offsets_;
+  std::unique_ptr<MotionPyramid> motion_pyramid_;
+  MotionPyramid::RefMotionFields coarse_motion_;
+  // Interpolation of the reconstruction, valid while used as reference
+  std::unique_ptr<SubpelPlaneCache> subpel_planes_;
+  bool has_subpel_planes_ = false;
+  SubpelPlaneCache::RefPlanes ref_subpel_planes_;
+  // Motion compensated predictions cached per cu, allocated on first use
+  std::vector<Sample> inter_pred_cache_;
+  std::unique_ptr<EdgeDirectionMap> edge_map_;
+  // Coded cu sizes, valid while used as reference
+  CuSizeMap cu_size_map_;
+  std::vector<xvc_enc_cu_split_stats> cu_split_stats_;
   OutputStatus output_status_ = OutputStatus::kHasBeenOutput;
   bool buffer_flag_ = false;
   mutable int ref_count_ = 0;
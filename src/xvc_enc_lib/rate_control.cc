@@ -0,0 +1,172 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include "xvc_enc_lib/rate_control.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "xvc_common_lib/common.h"
+#include "xvc_common_lib/utils.h"
+
+namespace xvc {
+
+// Deviation from the target is paid back over this many seconds
+static const double kAbrWindowSeconds = 2.0;
+// Decay per picture of the complexity estimate, spanning a few sub-gops
+// so that all temporal layers are represented
+static const double kComplexityDecay = 0.97;
+static const int kMaxQpStep = 3;
+static const double kInitialBufferFullness = 0.9;
+static const double kMinBufferFullness = 0.1;
+// Lower qp limit unless a lower initial qp is given, very low qp values
+// are not useful for rate control
+static const int kMinQp = 10;
+
+RateControl::RateControl(double target_bitrate, double max_bitrate,
+                         double buffer_size, double framerate,
+                         double intra_period, int initial_qp)
+  : target_bitrate_(target_bitrate),
+  max_bitrate_(max_bitrate > 0 ? max_bitrate : target_bitrate),
+  buffer_size_(buffer_size > 0 || max_bitrate <= 0 ?
+               buffer_size : max_bitrate),
+  framerate_(framerate),
+  intra_period_(std::max(1.0, intra_period)),
+  initial_qp_(initial_qp),
+  qp_(initial_qp),
+  buffer_fullness_(kInitialBufferFullness * buffer_size_) {
+}
+
+int RateControl::StartSubGop(int num_pics, bool has_intra_pic,
+                             PicNum feedback_end_poc) {
+  // The buffer is drained in coding order
+  std::vector<PictureStats> feedback;
+  while (!pending_stats_.empty() &&
+         pending_stats_.begin()->first < feedback_end_poc) {
+    feedback.push_back(pending_stats_.begin()->second);
+    pending_stats_.erase(pending_stats_.begin());
+  }
+  std::sort(feedback.begin(), feedback.end(),
+            [](const PictureStats &a, const PictureStats &b) {
+    return a.doc < b.doc;
+  });
+  for (const PictureStats &stats : feedback) {
+    UpdateModel(stats);
+  }
+  int qp = qp_;
+  if (target_bitrate_ <= 0) {
+    qp = initial_qp_;
+  } else if (inter_weight_ > 0 || (intra_period_ <= 1 && intra_weight_ > 0)) {
+    const double pic_budget = target_bitrate_ / framerate_;
+    const double window = target_bitrate_ * kAbrWindowSeconds;
+    const double deviation = total_bits_ - num_encoded_ * pic_budget;
+    const double budget =
+      pic_budget * util::Clip3((window - deviation) / window, 0.5, 2.0);
+    // Intra pictures are accounted for over the whole intra period
+    const double complexity = intra_period_ <= 1 ? GetComplexity(true) :
+      GetComplexity(false) + GetComplexity(true) / intra_period_;
+    const int model_qp =
+      static_cast<int>(std::lround(6 * std::log2(complexity / budget)));
+    qp = util::Clip3(model_qp, qp_ - kMaxQpStep, qp_ + kMaxQpStep);
+  }
+  if (buffer_size_ > 0) {
+    // When the pictures already being encoded drain the buffer, the new
+    // pictures should at least not drain it any further
+    const double min_fullness =
+      std::min(kMinBufferFullness * buffer_size_,
+               PredictBufferFullness(0, false, qp_));
+    while (qp < constants::kMaxAllowedQp &&
+           PredictBufferFullness(num_pics, has_intra_pic, qp) < min_fullness) {
+      qp++;
+    }
+  }
+  qp_ = util::Clip3(qp, std::min(kMinQp, initial_qp_),
+                    constants::kMaxAllowedQp);
+  num_pending_ += num_pics;
+  return qp_;
+}
+
+void RateControl::OnPictureEncoded(PicNum poc, PicNum doc, size_t bits,
+                                   bool intra_pic, int segment_qp,
+                                   int pic_qp) {
+  pending_stats_[poc] = { doc, bits, intra_pic, segment_qp, pic_qp };
+}
+
+void RateControl::UpdateModel(const PictureStats &stats) {
+  const double complexity = stats.bits * std::pow(2.0, stats.pic_qp / 6.0);
+  const double qp_offset = stats.pic_qp - stats.segment_qp;
+  if (stats.intra_pic) {
+    intra_complexity_ = intra_complexity_ * kComplexityDecay + complexity;
+    intra_qp_offset_ = intra_qp_offset_ * kComplexityDecay + qp_offset;
+    intra_weight_ = intra_weight_ * kComplexityDecay + 1;
+  } else {
+    inter_complexity_ = inter_complexity_ * kComplexityDecay + complexity;
+    inter_qp_offset_ = inter_qp_offset_ * kComplexityDecay + qp_offset;
+    inter_weight_ = inter_weight_ * kComplexityDecay + 1;
+  }
+  total_bits_ += stats.bits;
+  num_encoded_++;
+  num_pending_ = std::max(0, num_pending_ - 1);
+  if (buffer_size_ > 0) {
+    buffer_fullness_ =
+      std::min(buffer_size_, buffer_fullness_ + max_bitrate_ / framerate_) -
+      stats.bits;
+  }
+}
+
+double RateControl::GetComplexity(bool intra_pic) const {
+  // Nothing is predicted before the first picture of each type is encoded
+  const double weight = intra_pic ? intra_weight_ : inter_weight_;
+  if (weight <= 0) {
+    return 0;
+  }
+  const double complexity =
+    (intra_pic ? intra_complexity_ : inter_complexity_) / weight;
+  const double qp_offset =
+    (intra_pic ? intra_qp_offset_ : inter_qp_offset_) / weight;
+  // Estimated bits at segment qp zero, pictures are coded at the segment
+  // qp plus the typical picture qp offset
+  return complexity * std::pow(2.0, -qp_offset / 6.0);
+}
+
+double RateControl::PredictBits(int qp, bool intra_pic) const {
+  return GetComplexity(intra_pic) * std::pow(2.0, -qp / 6.0);
+}
+
+double RateControl::PredictBufferFullness(int num_pics, bool has_intra_pic,
+                                          int qp) const {
+  const double fill = max_bitrate_ / framerate_;
+  double fullness = buffer_fullness_;
+  // Pictures still being encoded use the previous qp
+  for (int i = 0; i < num_pending_; i++) {
+    fullness = std::min(buffer_size_, fullness + fill) -
+      PredictBits(qp_, false);
+  }
+  for (int i = 0; i < num_pics; i++) {
+    const bool intra_pic = has_intra_pic && i == 0;
+    fullness = std::min(buffer_size_, fullness + fill) -
+      PredictBits(qp, intra_pic);
+  }
+  return fullness;
+}
+
+}   // namespace xvc
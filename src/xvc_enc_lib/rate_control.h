@@ -0,0 +1,94 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#ifndef XVC_ENC_LIB_RATE_CONTROL_H_
+#define XVC_ENC_LIB_RATE_CONTROL_H_
+
+#include <cstddef>
+#include <map>
+
+#include "xvc_common_lib/common.h"
+
+namespace xvc {
+
+// Single pass rate control that derives the base qp of each sub-gop from
+// the bits spent so far. Optionally a decoder buffer of given size that is
+// filled at the maximum bitrate (VBV) is modelled and the qp is raised when
+// the buffer would otherwise underflow. Without a target bitrate the
+// initial qp is used as long as the buffer constraint allows (capped
+// constant quality).
+class RateControl {
+public:
+  // Bitrates in bits per second and buffer size in bits, zero disables
+  RateControl(double target_bitrate, double max_bitrate, double buffer_size,
+              double framerate, double intra_period, int initial_qp);
+  // Derives the segment qp for the next num_pics pictures to encode. Only
+  // feedback of pictures with poc lower than feedback_end_poc is used, so
+  // that the result does not depend on how far ahead pictures are being
+  // encoded. The feedback is applied in coding order.
+  int StartSubGop(int num_pics, bool has_intra_pic, PicNum feedback_end_poc);
+  int GetQp() const { return qp_; }
+  // Feedback of the actual bits spent on a picture, the segment qp given for
+  // it and the picture qp it was encoded with, may be given in any order
+  void OnPictureEncoded(PicNum poc, PicNum doc, size_t bits, bool intra_pic,
+                        int segment_qp, int pic_qp);
+  double GetBufferFullness() const { return buffer_fullness_; }
+
+private:
+  struct PictureStats {
+    PicNum doc;
+    size_t bits;
+    bool intra_pic;
+    int segment_qp;
+    int pic_qp;
+  };
+  void UpdateModel(const PictureStats &stats);
+  double GetComplexity(bool intra_pic) const;
+  double PredictBits(int qp, bool intra_pic) const;
+  double PredictBufferFullness(int num_pics, bool has_intra_pic,
+                               int qp) const;
+
+  const double target_bitrate_;
+  const double max_bitrate_;
+  const double buffer_size_;
+  const double framerate_;
+  const double intra_period_;
+  const int initial_qp_;
+  int qp_;
+  std::map<PicNum, PictureStats> pending_stats_;
+  double total_bits_ = 0;
+  int num_encoded_ = 0;
+  int num_pending_ = 0;
+  // Estimated bits at picture qp zero, bits ~ complexity * 2^(-qp / 6), and
+  // picture qp relative to the segment qp, as decaying sums over the
+  // recently encoded pictures of each type
+  double inter_complexity_ = 0;
+  double inter_qp_offset_ = 0;
+  double inter_weight_ = 0;
+  double intra_complexity_ = 0;
+  double intra_qp_offset_ = 0;
+  double intra_weight_ = 0;
+  double buffer_fullness_ = 0;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_ENC_LIB_RATE_CONTROL_H_
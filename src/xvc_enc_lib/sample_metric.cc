@@ -22,6 +22,7 @@
 #include "xvc_enc_lib/sample_metric.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
@@ -297,6 +298,40 @@ SampleMetric::Compare(const Qp &qp, YuvComponent comp, int width, int height,
   return static_cast<Distortion>(dist * weight);
 }
 
+void
+SampleMetric::CompareSampleX4(const Qp &qp, YuvComponent comp,
+                              int width, int height,
+                              const Residual *src1, ptrdiff_t stride1,
+                              const Sample *src2, ptrdiff_t stride2,
+                              Distortion *out_dist) const {
+  const int widx = util::SizeToLog2(width);
+  std::array<int, 4> sad;
+  int scale;
+  switch (type_) {
+    case MetricType::kSad:
+      simd_func_.sad_short_sample_x4[widx](width, height, src1, stride1,
+                                           src2, stride2, &sad[0]);
+      scale = 1;
+      break;
+    case MetricType::kSadFast:
+      simd_func_.sad_short_sample_x4[widx](width, height / 2, src1,
+                                           stride1 * 2, src2, stride2 * 2,
+                                           &sad[0]);
+      scale = 2;
+      break;
+    default:
+      assert(0);
+      scale = 0;
+      sad.fill(0);
+      break;
+  }
+  const double weight = qp.GetDistortionWeight(comp);
+  for (int i = 0; i < 4; i++) {
+    uint64_t dist = (static_cast<uint64_t>(sad[i]) * scale) >> (bitdepth_ - 8);
+    out_dist[i] = static_cast<Distortion>(dist * weight);
+  }
+}
+
 template<typename SampleT1, typename SampleT2>
 static uint64_t ComputeSsd_c(int width, int height,
                              const SampleT1 *sample1, ptrdiff_t stride1,
@@ -683,6 +718,27 @@ static int ComputeSad_c(int width, int height,
   return sum;
 }
 
+template<typename SampleT1, typename SampleT2>
+static void ComputeSadX4_c(int width, int height,
+                           const SampleT1 *sample1, ptrdiff_t stride1,
+                           const SampleT2 *sample2, ptrdiff_t stride2,
+                           int *out_sad) {
+  int sum[4] = { 0, 0, 0, 0 };
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      for (int i = 0; i < 4; i++) {
+        int diff = sample1[x] - sample2[x + i];
+        sum[i] += std::abs(diff);
+      }
+    }
+    sample1 += stride1;
+    sample2 += stride2;
+  }
+  for (int i = 0; i < 4; i++) {
+    out_sad[i] = sum[i];
+  }
+}
+
 template<int SkipLines, typename SampleT1, typename SampleT2>
 uint64_t
 SampleMetric::ComputeSadAcOnly(int width, int height,
@@ -798,6 +854,13 @@ SampleMetric::SimdFunc::SimdFunc() {
   sad_short_sample[4] = &ComputeSad_c<Residual, Sample>;  // 16
   sad_short_sample[5] = &ComputeSad_c<Residual, Sample>;  // 32
   sad_short_sample[6] = &ComputeSad_c<Residual, Sample>;  // 64
+  sad_short_sample_x4[0] = nullptr;
+  sad_short_sample_x4[1] = &ComputeSadX4_c<Residual, Sample>;  // 2
+  sad_short_sample_x4[2] = &ComputeSadX4_c<Residual, Sample>;  // 4
+  sad_short_sample_x4[3] = &ComputeSadX4_c<Residual, Sample>;  // 8
+  sad_short_sample_x4[4] = &ComputeSadX4_c<Residual, Sample>;  // 16
+  sad_short_sample_x4[5] = &ComputeSadX4_c<Residual, Sample>;  // 32
+  sad_short_sample_x4[6] = &ComputeSadX4_c<Residual, Sample>;  // 64
 
   ssd_sample_sample[0] = nullptr;
   ssd_sample_sample[1] = &ComputeSsd_c<Sample, Sample>;  // 2
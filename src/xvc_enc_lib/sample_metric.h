@@ -52,6 +52,7 @@ public:
     structural_strength_(structural_strength) {
   }
   SampleMetric(const SampleMetric&) = delete;
+  MetricType GetType() const { return type_; }
   // Compare sample blocks of arbitrary size
   Distortion ComparePicture(const Qp &qp, YuvComponent comp,
                             YuvComponent metric_comp, const YuvPicture &pic1,
@@ -97,6 +98,11 @@ public:
                            const Sample *src2, ptrdiff_t stride2) const {
     return Compare(qp, comp, width, height, src1, stride1, src2, stride2);
   }
+  // Residual vs Sample at 4 consecutive horizontal offsets, sad metrics only
+  void CompareSampleX4(const Qp &qp, YuvComponent comp, int width, int height,
+                       const Residual *src1, ptrdiff_t stride1,
+                       const Sample *src2, ptrdiff_t stride2,
+                       Distortion *out_dist) const;
   // Residual vs Residual
   Distortion CompareShort(const Qp &qp, YuvComponent comp,
                           int width, int height,
@@ -173,6 +179,11 @@ struct SampleMetric::SimdFunc {
   int(*sad_short_sample[kMaxSize])(int width, int height,
                                    const int16_t *sample1, ptrdiff_t stride1,
                                    const Sample *sample2, ptrdiff_t stride2);
+  void(*sad_short_sample_x4[kMaxSize])(int width, int height,
+                                       const int16_t *sample1,
+                                       ptrdiff_t stride1,
+                                       const Sample *sample2,
+                                       ptrdiff_t stride2, int *out_sad);
   uint64_t(*ssd_sample_sample[kMaxSize])(int width, int height,
                                          const Sample *sample1,
                                          ptrdiff_t stride1,
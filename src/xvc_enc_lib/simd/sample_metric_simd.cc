@@ -94,6 +94,46 @@ static int ComputeSad_8x2_sse2(int width, int height,
   return _mm_cvtsi128_si32(out);
 }
 
+__attribute__((target("sse2")))
+static void ComputeSadX4_8x1_sse2(int width, int height,
+                                  const int16_t *src1, ptrdiff_t stride1,
+                                  const Sample *src2, ptrdiff_t stride2,
+                                  int *out_sad) {
+  static_assert(std::is_same<Sample, uint16_t>::value, "assume high bitdepth");
+  // Each original row is loaded once and compared to all four offsets
+  auto sad_8x1_epi32 = [](__m128i orig, const Sample *ptr)
+    __attribute__((target("sse2"))) {
+    __m128i ref = _mm_loadu_si128(CAST_M128i_CONST(ptr));
+    __m128i diff = _mm_sub_epi16(orig, ref);
+    __m128i neg = _mm_sub_epi16(_mm_setzero_si128(), diff);
+    __m128i ones_epi16 = _mm_load_si128(CAST_M128i_CONST(&kOnes16bit[0]));
+    return _mm_madd_epi16(_mm_max_epi16(diff, neg), ones_epi16);
+  };  // NOLINT
+  __m128i sum0 = _mm_setzero_si128();
+  __m128i sum1 = _mm_setzero_si128();
+  __m128i sum2 = _mm_setzero_si128();
+  __m128i sum3 = _mm_setzero_si128();
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x += 8) {
+      __m128i orig = _mm_loadu_si128(CAST_M128i_CONST(src1 + x));
+      sum0 = _mm_add_epi32(sum0, sad_8x1_epi32(orig, src2 + x + 0));
+      sum1 = _mm_add_epi32(sum1, sad_8x1_epi32(orig, src2 + x + 1));
+      sum2 = _mm_add_epi32(sum2, sad_8x1_epi32(orig, src2 + x + 2));
+      sum3 = _mm_add_epi32(sum3, sad_8x1_epi32(orig, src2 + x + 3));
+    }
+    src1 += stride1;
+    src2 += stride2;
+  }
+  // Transpose and add so that lane i holds the total of sum i
+  __m128i sum01 = _mm_add_epi32(_mm_unpacklo_epi32(sum0, sum1),
+                                _mm_unpackhi_epi32(sum0, sum1));
+  __m128i sum23 = _mm_add_epi32(_mm_unpacklo_epi32(sum2, sum3),
+                                _mm_unpackhi_epi32(sum2, sum3));
+  __m128i out = _mm_add_epi32(_mm_unpacklo_epi64(sum01, sum23),
+                              _mm_unpackhi_epi64(sum01, sum23));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out_sad), out);
+}
+
 template<typename SampleT1, typename Sample>
 __attribute__((target("sse2")))
 static uint64_t ComputeSsd_8x2_sse2(int width, int height,
@@ -229,6 +269,10 @@ void SampleMetricSimd::Register(const std::set<CpuCapability> &caps,
     sm.sad_short_sample[4] = &ComputeSad_8x2_sse2<int16_t>;   // 16
     sm.sad_short_sample[5] = &ComputeSad_8x2_sse2<int16_t>;   // 32
     sm.sad_short_sample[6] = &ComputeSad_8x2_sse2<int16_t>;   // 64
+    sm.sad_short_sample_x4[3] = &ComputeSadX4_8x1_sse2;   // 8
+    sm.sad_short_sample_x4[4] = &ComputeSadX4_8x1_sse2;   // 16
+    sm.sad_short_sample_x4[5] = &ComputeSadX4_8x1_sse2;   // 32
+    sm.sad_short_sample_x4[6] = &ComputeSadX4_8x1_sse2;   // 64
 
     sm.ssd_sample_sample[3] = &ComputeSsd_8x2_sse2<Sample, Sample>;   // 8
     sm.ssd_sample_sample[4] = &ComputeSsd_8x2_sse2<Sample, Sample>;   // 16
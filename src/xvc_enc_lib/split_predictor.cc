@@ -0,0 +1,210 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include "xvc_enc_lib/split_predictor.h"
+
+#include <algorithm>
+#include <array>
+
+#include "xvc_common_lib/utils.h"
+
+namespace xvc {
+
+// Highest rd cost per sample without split (as in Features) for which no
+// split is evaluated, -1 means always evaluate splits. Indexed by picture
+// and block type, log2 of CU area starting at 32 samples and number of
+// smaller neighbors (2 or more use the last column).
+// Calibrated offline by encoding a set of test sequences at qp 27 and 37 in
+// the slow and fast speed modes with split statistics written by the
+// encoder app (-cu-split-stats-file). CUs where a faster heuristic
+// terminates the split evaluation earlier are excluded since the prediction
+// is never reached for them. For each table entry the highest threshold was
+// selected such that at least 97% of the CUs at or below it were not split
+// in the full evaluation, requiring at least 200 CUs below the threshold.
+static const int kMinLog2Area = 5;
+static const int kNumLog2Areas = 8;
+static const int kNumNeighborContexts = 3;
+static const std::array<std::array<std::array<int8_t, kNumNeighborContexts>,
+  kNumLog2Areas>, 3> kSplitCostThreshold = { {
+    {{   // inter, no skip
+      { 11, -1, -1 },
+      {  5, -1, -1 },
+      {  2, -1, -1 },
+      { -1, -1, -1 },
+      { -1, -1, -1 },
+      { -1, -1, -1 },
+      { -1, -1, -1 },
+      { -1, -1, -1 },
+    }},
+    {{   // inter, skip
+      { 13, -1, -1 },
+      {  7, -1, -1 },
+      { 16,  1, -1 },
+      {  1, -1, -1 },
+      {  9,  0, -1 },
+      {  8, -1, -1 },
+      {  8, -1, -1 },
+      {  8, -1, -1 },
+    }},
+    {{   // intra
+      { 15, -1, -1 },
+      { 10, -1, -1 },
+      {  5,  1, -1 },
+      {  4, -1, -1 },
+      {  4, -1, -1 },
+      {  5, -1, -1 },
+      { -1, -1, -1 },
+      { 28, -1, -1 },
+    }},
+  } };
+
+void CuSizeMap::Build(const PictureData &pic_data) {
+  const YuvComponent luma = YuvComponent::kY;
+  const int block_size = constants::kMinBlockSize;
+  const int width = pic_data.GetPictureWidth(luma);
+  const int height = pic_data.GetPictureHeight(luma);
+  width_in_blocks_ = (width + block_size - 1) / block_size;
+  height_in_blocks_ = (height + block_size - 1) / block_size;
+  log2_area_.resize(width_in_blocks_ * height_in_blocks_);
+  for (int y = 0; y < height_in_blocks_; y++) {
+    for (int x = 0; x < width_in_blocks_; x++) {
+      const CodingUnit *cu =
+        pic_data.GetCuAt(CuTree::Primary, x * block_size, y * block_size);
+      log2_area_[y * width_in_blocks_ + x] = static_cast<int8_t>(!cu ? -1 :
+        util::SizeToLog2(cu->GetWidth(luma)) +
+        util::SizeToLog2(cu->GetHeight(luma)));
+    }
+  }
+}
+
+int CuSizeMap::GetLog2Area(int posx, int posy) const {
+  if (posx < 0 || posy < 0) {
+    return -1;
+  }
+  const int x = posx / constants::kMinBlockSize;
+  const int y = posy / constants::kMinBlockSize;
+  if (x >= width_in_blocks_ || y >= height_in_blocks_) {
+    return -1;
+  }
+  return log2_area_[y * width_in_blocks_ + x];
+}
+
+SplitPredictor::SplitPredictor(const PictureData &pic_data,
+                               const YuvPicture &orig_pic)
+  : pic_data_(pic_data),
+  orig_pic_(orig_pic) {
+}
+
+SplitPredictor::Features
+SplitPredictor::GetFeatures(const CodingUnit &cu, const Qp &qp,
+                            Cost no_split_cost) const {
+  const YuvComponent luma = YuvComponent::kY;
+  const int posx = cu.GetPosX(luma);
+  const int posy = cu.GetPosY(luma);
+  const int width = cu.GetWidth(luma);
+  const int height = cu.GetHeight(luma);
+  Features features;
+  features.intra_pic = pic_data_.IsIntraPic();
+  features.log2_area = util::SizeToLog2(width) + util::SizeToLog2(height);
+  features.num_smaller_neighbors = 0;
+  const CodingUnit *left =
+    posx > 0 ? pic_data_.GetCuAt(cu.GetCuTree(), posx - 1, posy) : nullptr;
+  const CodingUnit *above =
+    posy > 0 ? pic_data_.GetCuAt(cu.GetCuTree(), posx, posy - 1) : nullptr;
+  for (const CodingUnit *neighbor : { left, above }) {
+    if (neighbor && util::SizeToLog2(neighbor->GetWidth(luma)) +
+        util::SizeToLog2(neighbor->GetHeight(luma)) < features.log2_area) {
+      features.num_smaller_neighbors++;
+    }
+  }
+  if (colocated_) {
+    const int colocated_log2_area =
+      colocated_->GetLog2Area(posx + width / 2, posy + height / 2);
+    if (colocated_log2_area >= 0 &&
+        colocated_log2_area < features.log2_area) {
+      features.num_smaller_neighbors++;
+    }
+  }
+  features.skip = !cu.IsIntra() && cu.GetSkipFlag();
+  const double cost_per_sample =
+    16.0 * no_split_cost / (qp.GetLambda() * width * height);
+  features.cost_per_sample =
+    static_cast<int>(std::min(cost_per_sample, 1.0 * (1 << 20)));
+  return features;
+}
+
+bool SplitPredictor::CanSkipSplit(const Features &features) const {
+  const int area_idx = features.log2_area - kMinLog2Area;
+  if (area_idx < 0 || area_idx >= kNumLog2Areas) {
+    return false;
+  }
+  const int type_idx = features.intra_pic ? 2 : (features.skip ? 1 : 0);
+  const int ctx = std::min(features.num_smaller_neighbors,
+                           kNumNeighborContexts - 1);
+  return features.cost_per_sample <=
+    kSplitCostThreshold[type_idx][area_idx][ctx];
+}
+
+void SplitPredictor::RecordStats(const CodingUnit &cu,
+                                 const Features &features,
+                                 Cost no_split_cost, Cost best_cost,
+                                 bool full_cu_termination,
+                                 bool early_skip_termination) {
+  if (!stats_) {
+    return;
+  }
+  xvc_enc_cu_split_stats stats;
+  stats.intra_pic = features.intra_pic ? 1 : 0;
+  stats.log2_area = features.log2_area;
+  stats.num_smaller_neighbors = features.num_smaller_neighbors;
+  stats.skip = features.skip ? 1 : 0;
+  stats.cost_per_sample = features.cost_per_sample;
+  stats.variance = CalcVariance(cu);
+  stats.split_gain = no_split_cost == 0 ? 0 :
+    static_cast<int>((no_split_cost - best_cost) * 1000 / no_split_cost);
+  stats.full_cu_termination = full_cu_termination ? 1 : 0;
+  stats.early_skip_termination = early_skip_termination ? 1 : 0;
+  stats_->push_back(stats);
+}
+
+int SplitPredictor::CalcVariance(const CodingUnit &cu) const {
+  const YuvComponent luma = YuvComponent::kY;
+  const int width = cu.GetWidth(luma);
+  const int height = cu.GetHeight(luma);
+  const Sample *src =
+    orig_pic_.GetSamplePtr(luma, cu.GetPosX(luma), cu.GetPosY(luma));
+  const ptrdiff_t stride = orig_pic_.GetStride(luma);
+  uint64_t sum = 0;
+  uint64_t sum_squares = 0;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      sum += src[x];
+      sum_squares += src[x] * src[x];
+    }
+    src += stride;
+  }
+  const uint64_t num = width * height;
+  const uint64_t variance = (sum_squares - sum * sum / num) / num;
+  const int shift = 2 * (orig_pic_.GetBitdepth() - 8);
+  return static_cast<int>(variance >> shift);
+}
+
+}   // namespace xvc
@@ -0,0 +1,96 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#ifndef XVC_ENC_LIB_SPLIT_PREDICTOR_H_
+#define XVC_ENC_LIB_SPLIT_PREDICTOR_H_
+
+#include <vector>
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/common.h"
+#include "xvc_common_lib/picture_data.h"
+#include "xvc_common_lib/quantize.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/xvcenc.h"
+
+namespace xvc {
+
+// Size of the CU covering each 4x4 luma block of a coded picture, kept
+// while the picture is used as reference
+class CuSizeMap {
+public:
+  bool IsEmpty() const { return log2_area_.empty(); }
+  void Build(const PictureData &pic_data);
+  // Log2 of the luma area of the CU covering the position, or -1 if unknown
+  int GetLog2Area(int posx, int posy) const;
+
+private:
+  int width_in_blocks_ = 0;
+  int height_in_blocks_ = 0;
+  std::vector<int8_t> log2_area_;
+};
+
+// Predicts if the split evaluations of a CU can be skipped, from features
+// that are cheap to derive once the best mode without split is known.
+// The decision thresholds are calibrated offline from the statistics
+// recorded by RecordStats (see split_predictor.cc for the procedure).
+class SplitPredictor {
+public:
+  struct Features {
+    bool intra_pic;
+    int log2_area;
+    // Number of left, above and co-located CUs being smaller than this CU
+    int num_smaller_neighbors;
+    bool skip;
+    // Rd cost without split per sample, relative to lambda and in 1/16
+    int cost_per_sample;
+  };
+
+  SplitPredictor(const PictureData &pic_data, const YuvPicture &orig_pic);
+  // Cu sizes of the closest reference picture, may be null
+  void SetColocatedCuSizes(const CuSizeMap *colocated) {
+    colocated_ = colocated;
+  }
+  Features GetFeatures(const CodingUnit &cu, const Qp &qp,
+                       Cost no_split_cost) const;
+  bool CanSkipSplit(const Features &features) const;
+  // Destination of RecordStats, may be null
+  void SetStatsOutput(std::vector<xvc_enc_cu_split_stats> *stats) {
+    stats_ = stats;
+  }
+  // Appends the features, the variance of the original samples and the
+  // outcome of the full split evaluation of a CU to the stats output
+  void RecordStats(const CodingUnit &cu, const Features &features,
+                   Cost no_split_cost, Cost best_cost,
+                   bool full_cu_termination, bool early_skip_termination);
+
+private:
+  int CalcVariance(const CodingUnit &cu) const;
+
+  const PictureData &pic_data_;
+  const YuvPicture &orig_pic_;
+  const CuSizeMap *colocated_ = nullptr;
+  std::vector<xvc_enc_cu_split_stats> *stats_ = nullptr;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_ENC_LIB_SPLIT_PREDICTOR_H_
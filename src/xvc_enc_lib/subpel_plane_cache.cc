@@ -0,0 +1,103 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include "xvc_enc_lib/subpel_plane_cache.h"
+
+#include <cassert>
+#include <memory>
+
+namespace xvc {
+
+SubpelPlaneCache::SubpelPlaneCache(int width, int height, int level,
+                                   const PictureAllocator &allocator)
+  : width_(width),
+  height_(height),
+  level_(level),
+  phase_shift_(MotionVector::kPrecisionShift - level),
+  stride_(width + 2 * kMargin),
+  allocator_(allocator) {
+  assert(level > 0 && level <= MotionVector::kPrecisionShift);
+  for (std::atomic<bool> &built : plane_built_) {
+    built = false;
+  }
+}
+
+void SubpelPlaneCache::Build(const InterPrediction::SimdFunc &simd,
+                             const YuvPicture &ref_pic) {
+  assert(ref_pic.GetWidth(YuvComponent::kY) == width_ &&
+         ref_pic.GetHeight(YuvComponent::kY) == height_);
+  simd_ = &simd;
+  ref_pic_ = &ref_pic;
+  // Memory of previously used phases is kept for the new reference picture
+  for (std::atomic<bool> &built : plane_built_) {
+    built.store(false, std::memory_order_relaxed);
+  }
+}
+
+SampleBufferConst
+SubpelPlaneCache::GetPrediction(int posx, int posy,
+                                const MotionVector &mv) const {
+  const int shift = MotionVector::kPrecisionShift;
+  const int frac_x = mv.x & ((1 << shift) - 1);
+  const int frac_y = mv.y & ((1 << shift) - 1);
+  const int phase_mask = (1 << phase_shift_) - 1;
+  if ((frac_x & phase_mask) != 0 || (frac_y & phase_mask) != 0) {
+    return SampleBufferConst(nullptr, 0);
+  }
+  const int x = posx + (mv.x >> shift);
+  const int y = posy + (mv.y >> shift);
+  if (frac_x == 0 && frac_y == 0) {
+    return ref_pic_->GetSampleBuffer(YuvComponent::kY, x, y);
+  }
+  const int phase_idx =
+    ((frac_y >> phase_shift_) << level_) + (frac_x >> phase_shift_);
+  if (!plane_built_[phase_idx].load(std::memory_order_acquire)) {
+    BuildPlane(phase_idx);
+  }
+  assert(x >= -kMargin && y >= -kMargin);
+  return SampleBufferConst(
+    planes_[phase_idx].data() + (y + kMargin) * stride_ + x + kMargin,
+    stride_);
+}
+
+void SubpelPlaneCache::BuildPlane(int phase_idx) const {
+  std::lock_guard<std::mutex> lock(plane_mutex_[phase_idx]);
+  if (plane_built_[phase_idx].load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (!planes_[phase_idx].data()) {
+    const size_t plane_size =
+      static_cast<size_t>(stride_) * (height_ + 2 * kMargin);
+    planes_[phase_idx] = AlignedBuffer<Sample>(allocator_, plane_size);
+  }
+  // Allocated on heap due to the size of its internal filter buffers
+  std::unique_ptr<InterPrediction>
+    inter_pred(new InterPrediction(*simd_, *ref_pic_,
+                                   ref_pic_->GetBitdepth()));
+  const int num_phases = 1 << level_;
+  const int frac_x = (phase_idx % num_phases) << phase_shift_;
+  const int frac_y = (phase_idx / num_phases) << phase_shift_;
+  inter_pred->InterpolateLumaPlane(*ref_pic_, frac_x, frac_y, kMargin,
+                                   planes_[phase_idx].data(), stride_);
+  plane_built_[phase_idx].store(true, std::memory_order_release);
+}
+
+}   // namespace xvc
@@ -0,0 +1,89 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#ifndef XVC_ENC_LIB_SUBPEL_PLANE_CACHE_H_
+#define XVC_ENC_LIB_SUBPEL_PLANE_CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <mutex>    // NOLINT
+#include <vector>
+
+#include "xvc_common_lib/common.h"
+#include "xvc_common_lib/cu_types.h"
+#include "xvc_common_lib/inter_prediction.h"
+#include "xvc_common_lib/picture_allocator.h"
+#include "xvc_common_lib/reference_picture_lists.h"
+#include "xvc_common_lib/sample_buffer.h"
+#include "xvc_common_lib/yuv_pic.h"
+
+namespace xvc {
+
+// Luma of a reconstructed reference picture interpolated at each half sample
+// (and optionally quarter sample) phase, replacing the interpolation
+// filtering of each candidate position during subpel motion search. Each
+// phase plane is allocated and interpolated on first use by any of the
+// threads encoding a picture that references it, phases that are never
+// searched take no memory.
+class SubpelPlaneCache {
+public:
+  using RefPlanes =
+    std::array<std::array<const SubpelPlaneCache*, constants::kMaxNumRefPics>,
+    static_cast<int>(RefPicList::kTotalNumber)>;
+
+  // Level 1 caches the half sample phases, level 2 also the quarter samples
+  SubpelPlaneCache(int width, int height, int level,
+                   const PictureAllocator &allocator = PictureAllocator());
+  int GetWidth() const { return width_; }
+  int GetHeight() const { return height_; }
+  int GetLevel() const { return level_; }
+  // Sets the padded reference picture to interpolate from, must not be
+  // called while any thread may be reading from the cache
+  void Build(const InterPrediction::SimdFunc &simd, const YuvPicture &ref_pic);
+  // Returns the prediction of a block at the given luma position using a
+  // clipped motion vector, sample pointer is null if the phase is not cached
+  SampleBufferConst GetPrediction(int posx, int posy,
+                                  const MotionVector &mv) const;
+
+private:
+  // Covers any block position allowed by InterPrediction::ClipMv
+  static const int kMargin = constants::kMaxBlockSize + 8;
+  static const int kMaxNumPhases =
+    1 << (2 * MotionVector::kPrecisionShift);
+
+  void BuildPlane(int phase_idx) const;
+
+  const int width_;
+  const int height_;
+  const int level_;
+  const int phase_shift_;
+  const ptrdiff_t stride_;
+  const PictureAllocator allocator_;
+  const InterPrediction::SimdFunc *simd_ = nullptr;
+  const YuvPicture *ref_pic_ = nullptr;
+  mutable std::array<std::mutex, kMaxNumPhases> plane_mutex_;
+  mutable std::array<std::atomic<bool>, kMaxNumPhases> plane_built_;
+  mutable std::array<AlignedBuffer<Sample>, kMaxNumPhases> planes_;
+};
+
+}   // namespace xvc
+
+#endif  // XVC_ENC_LIB_SUBPEL_PLANE_CACHE_H_
@@ -34,14 +34,21 @@ namespace xvc {
 
 SyntaxWriter::SyntaxWriter(const Qp &qp, PicturePredictionType pic_type,
                            BitWriter *bit_writer)
-  : encoder_(bit_writer) {
-  ctx_.ResetStates(qp, pic_type);
+  : ctx_(&ctx_storage_),
+  encoder_(bit_writer),
+  unrestricted_(Restrictions::Get().IsUnrestricted()) {
+  ctx_->ResetStates(qp, pic_type);
   encoder_.Start();
 }
 
-SyntaxWriter::SyntaxWriter(const Contexts &contexts,
+SyntaxWriter::SyntaxWriter(const Contexts &contexts, bool frozen_contexts,
                            EntropyEncoder &&entropyenc)
-  : ctx_(contexts), encoder_(std::move(entropyenc)) {
+  : ctx_(frozen_contexts ? const_cast<Contexts*>(&contexts) : &ctx_storage_),
+  encoder_(std::move(entropyenc)),
+  unrestricted_(Restrictions::Get().IsUnrestricted()) {
+  if (!frozen_contexts) {
+    ctx_storage_ = contexts;
+  }
 }
 
 void SyntaxWriter::Finish() {
@@ -56,7 +63,7 @@ void SyntaxWriter::WriteAffineFlag(const CodingUnit &cu, bool is_merge,
     assert(!use_affine);
     return;
   }
-  ContextModel &ctx = ctx_.GetAffineCtx(cu);
+  ContextModel &ctx = ctx_->GetAffineCtx(cu);
   encoder_.EncodeBin(use_affine ? 1 : 0, &ctx);
 }
 
@@ -66,27 +73,35 @@ void SyntaxWriter::WriteCbf(const CodingUnit &cu, YuvComponent comp, bool cbf) {
     return;
   }
   if (util::IsLuma(comp)) {
-    encoder_.EncodeBin(cbf ? 1 : 0, &ctx_.cu_cbf_luma[0]);
+    encoder_.EncodeBin(cbf ? 1 : 0, &ctx_->cu_cbf_luma[0]);
   } else {
-    encoder_.EncodeBin(cbf ? 1 : 0, &ctx_.cu_cbf_chroma[0]);
+    encoder_.EncodeBin(cbf ? 1 : 0, &ctx_->cu_cbf_chroma[0]);
   }
 }
 
 int SyntaxWriter::WriteCoefficients(const CodingUnit &cu, YuvComponent comp,
                                     const Coeff *coeff,
                                     ptrdiff_t src_coeff_stride) {
-  if (cu.GetWidth(comp) == 2 || cu.GetHeight(comp) == 2) {
-    return WriteCoeffSubblock<1>(cu, comp, coeff, src_coeff_stride);
-  } else {
-    return WriteCoeffSubblock<constants::kSubblockShift>(cu, comp, coeff,
-                                                         src_coeff_stride);
-  }
-}
-
-template<int SubBlockShift>
+  constexpr int kShift = constants::kSubblockShift;
+  const bool small_block = cu.GetWidth(comp) == 2 || cu.GetHeight(comp) == 2;
+  if (unrestricted_) {
+    return small_block ?
+      WriteCoeffSubblock<1, NoRestrictions>(cu, comp, coeff,
+                                            src_coeff_stride) :
+      WriteCoeffSubblock<kShift, NoRestrictions>(cu, comp, coeff,
+                                                 src_coeff_stride);
+  }
+  return small_block ?
+    WriteCoeffSubblock<1, Restrictions>(cu, comp, coeff, src_coeff_stride) :
+    WriteCoeffSubblock<kShift, Restrictions>(cu, comp, coeff,
+                                             src_coeff_stride);
+}
+
+template<int SubBlockShift, typename RestrictionSet>
 int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
                                      const Coeff *src_coeff,
                                      ptrdiff_t src_coeff_stride) {
+  const RestrictionSet &restrictions = RestrictionSet::Get();
   const int width = cu.GetWidth(comp);
   const int height = cu.GetHeight(comp);
   const int width_log2 = util::SizeToLog2(width);
@@ -101,7 +116,7 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
   int nbr_subblocks = subblock_width * subblock_height;
   std::vector<uint8_t> subblock_csbf(nbr_subblocks);
   std::vector<uint16_t> scan_subblock_table(nbr_subblocks);
-  if (!Restrictions::Get().disable_transform_cbf) {
+  if (!restrictions.disable_transform_cbf) {
     subblock_csbf[0] = 1;
   }
   ScanOrder scan_order = TransformHelper::DetermineScanOrder(cu, comp);
@@ -144,8 +159,9 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
 
   int last_nonzero_pos = -1;
   int first_nonzero_pos = subblock_size;
-  if (!Restrictions::Get().disable_transform_last_position) {
-    WriteCoeffLastPos(width, height, comp, scan_order, pos_last_x, pos_last_y);
+  if (!restrictions.disable_transform_last_position) {
+    WriteCoeffLastPos<RestrictionSet>(width, height, comp, scan_order,
+                                      pos_last_x, pos_last_y);
 
     subblock_last_index = pos_last_index >> (subblock_shift + subblock_shift);
 
@@ -154,8 +170,8 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
     subblock_last_coeff_offset =
       ((subblock_last_index + 1) << (subblock_shift + subblock_shift)) -
       pos_last_index + 1;
-    if (Restrictions::Get().disable_transform_cbf &&
-        Restrictions::Get().disable_transform_subblock_csbf &&
+    if (restrictions.disable_transform_cbf &&
+        restrictions.disable_transform_subblock_csbf &&
         pos_last_x == 0 && pos_last_y == 0) {
       subblock_last_coeff_offset--;
     } else {
@@ -181,31 +197,31 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
     int subblock_pos_y = subblock_scan_y << subblock_shift;
 
     // Code sig sublock flag
-    if (Restrictions::Get().disable_transform_subblock_csbf) {
+    if (restrictions.disable_transform_subblock_csbf) {
       subblock_csbf[subblock_scan] = 1;
     }
     bool sig = subblock_csbf[subblock_scan] != 0;
     int pattern_sig_ctx = 0;
     bool is_last_subblock = subblock_index == subblock_last_index &&
-      !Restrictions::Get().disable_transform_last_position &&
-      !Restrictions::Get().disable_transform_cbf;
+      !restrictions.disable_transform_last_position &&
+      !restrictions.disable_transform_cbf;
     bool is_first_subblock = subblock_index == 0 &&
-      !Restrictions::Get().disable_transform_cbf;
+      !restrictions.disable_transform_cbf;
     if (is_last_subblock || is_first_subblock ||
-        Restrictions::Get().disable_transform_subblock_csbf) {
+        restrictions.disable_transform_subblock_csbf) {
       // implicitly signaled
-      assert(sig || Restrictions::Get().disable_transform_subblock_csbf);
+      assert(sig || restrictions.disable_transform_subblock_csbf);
       // derive pattern_sig_ctx
-      ctx_.GetSubblockCsbfCtx(comp, &subblock_csbf[0], subblock_scan_x,
-                              subblock_scan_y, subblock_width, subblock_height,
-                              &pattern_sig_ctx);
+      ctx_->GetSubblockCsbfCtx(restrictions, comp, &subblock_csbf[0],
+                               subblock_scan_x, subblock_scan_y,
+                               subblock_width, subblock_height,
+                               &pattern_sig_ctx);
     } else {
-      ContextModel &ctx = ctx_.GetSubblockCsbfCtx(comp, &subblock_csbf[0],
-                                                  subblock_scan_x,
-                                                  subblock_scan_y,
-                                                  subblock_width,
-                                                  subblock_height,
-                                                  &pattern_sig_ctx);
+      ContextModel &ctx =
+        ctx_->GetSubblockCsbfCtx(restrictions, comp, &subblock_csbf[0],
+                                 subblock_scan_x, subblock_scan_y,
+                                 subblock_width, subblock_height,
+                                 &pattern_sig_ctx);
       encoder_.EncodeBin(sig ? 1 : 0, &ctx);
     }
     if (!sig) {
@@ -220,16 +236,16 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
       const int coeff_scan_y = subblock_pos_y + (scan_offset >> subblock_shift);
       Coeff coeff = src_coeff[coeff_scan_y * src_coeff_stride + coeff_scan_x];
       bool not_first_subblock = subblock_index > 0 &&
-        !Restrictions::Get().disable_transform_subblock_csbf;
+        !restrictions.disable_transform_subblock_csbf;
       if (coeff_index == 0 && not_first_subblock && coeff_num_non_zero == 0) {
         // implicitly signaled 1
         assert(coeff != 0);
       } else {
         ContextModel &ctx =
-          ctx_.GetCoeffSigCtx(comp, pattern_sig_ctx, scan_order,
-                              coeff_scan_x, coeff_scan_y,
-                              src_coeff, src_coeff_stride,
-                              width_log2, height_log2);
+          ctx_->GetCoeffSigCtx(restrictions, comp, pattern_sig_ctx,
+                               scan_order, coeff_scan_x, coeff_scan_y,
+                               src_coeff, src_coeff_stride,
+                               width_log2, height_log2);
         encoder_.EncodeBin(coeff != 0, &ctx);
       }
       if (coeff != 0) {
@@ -254,7 +270,7 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
 
     // greater than 1 flag
     int max_num_c1_flags = constants::kMaxNumC1Flags;
-    if (Restrictions::Get().disable_transform_residual_greater_than_flags) {
+    if (restrictions.disable_transform_residual_greater_than_flags) {
       max_num_c1_flags = 0;
     }
     int ctx_set = (subblock_index > 0 && util::IsLuma(comp)) ? 2 : 0;
@@ -271,14 +287,15 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
       const int coeff_scan_x = subblock_pos[i] - (coeff_scan_y << log2size);
       uint32_t greater_than_1 = subblock_coeff[i] > 1;
       ContextModel &ctx =
-        ctx_.GetCoeffGreater1Ctx(comp, ctx_set, c1, coeff_scan_x, coeff_scan_y,
-                                 i == 0 && is_last_subblock,
-                                 src_coeff, src_coeff_stride, width, height);
+        ctx_->GetCoeffGreater1Ctx(restrictions, comp, ctx_set, c1,
+                                  coeff_scan_x, coeff_scan_y,
+                                  i == 0 && is_last_subblock,
+                                  src_coeff, src_coeff_stride, width, height);
       encoder_.EncodeBin(greater_than_1, &ctx);
       if (greater_than_1) {
         c1 = 0;
         if (first_c2_idx == -1 &&
-            !Restrictions::Get().disable_transform_residual_greater2) {
+            !restrictions.disable_transform_residual_greater2) {
           first_c2_idx = i;
         }
       } else if (c1 < 3 && c1 > 0) {
@@ -293,15 +310,16 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
         (coeff_scan_y << log2size);
       uint32_t greater_than_2 = subblock_coeff[first_c2_idx] > 2;
       ContextModel &ctx =
-        ctx_.GetCoeffGreater2Ctx(comp, ctx_set, coeff_scan_x, coeff_scan_y,
-                                 first_c2_idx == 0 && is_last_subblock,
-                                 src_coeff, src_coeff_stride, width, height);
+        ctx_->GetCoeffGreater2Ctx(restrictions, comp, ctx_set, coeff_scan_x,
+                                  coeff_scan_y,
+                                  first_c2_idx == 0 && is_last_subblock,
+                                  src_coeff, src_coeff_stride, width, height);
       encoder_.EncodeBin(greater_than_2, &ctx);
     }
 
     // sign hiding
     bool sign_hidden = false;
-    if (!Restrictions::Get().disable_transform_sign_hiding &&
+    if (!restrictions.disable_transform_sign_hiding &&
         last_nonzero_pos - first_nonzero_pos >
         constants::kSignHidingThreshold) {
       sign_hidden = true;
@@ -319,7 +337,7 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
     // abs level remaining
     if (c1 == 0 || coeff_num_non_zero > max_num_c1_flags) {
       int first_coeff_greater2 =
-        Restrictions::Get().disable_transform_residual_greater2 ? 0 : 1;
+        restrictions.disable_transform_residual_greater2 ? 0 : 1;
       uint32_t golomb_rice_k = 0;
       for (int i = 0; i < coeff_num_non_zero; i++) {
         const int coeff_scan_y = subblock_pos[i] >> log2size;
@@ -327,15 +345,16 @@ int SyntaxWriter::WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
         Coeff base_level = static_cast<Coeff>(
           (i < max_num_c1_flags) ? (2 + first_coeff_greater2) : 1);
         if (subblock_coeff[i] >= base_level) {
-          if (!Restrictions::Get().disable_ext2_cabac_alt_residual_ctx) {
+          if (!restrictions.disable_ext2_cabac_alt_residual_ctx) {
             golomb_rice_k =
-              ctx_.GetCoeffGolombRiceK(coeff_scan_x, coeff_scan_y, width,
-                                       height, src_coeff, src_coeff_stride);
+              ctx_->GetCoeffGolombRiceK(restrictions, coeff_scan_x,
+                                        coeff_scan_y, width, height,
+                                        src_coeff, src_coeff_stride);
           }
-          WriteCoeffRemainExpGolomb(subblock_coeff[i] - base_level,
-                                    golomb_rice_k);
+          WriteCoeffRemainExpGolomb<RestrictionSet>(
+            subblock_coeff[i] - base_level, golomb_rice_k);
           if (subblock_coeff[i] > 3 * (1 << golomb_rice_k) &&
-              !Restrictions::Get().disable_transform_adaptive_exp_golomb) {
+              !restrictions.disable_transform_adaptive_exp_golomb) {
             golomb_rice_k = std::min(golomb_rice_k + 1, 4u);
           }
         }
@@ -358,11 +377,11 @@ void SyntaxWriter::WriteEndOfSlice(bool end_of_slice) {
 
 void SyntaxWriter::WriteInterDir(const CodingUnit &cu, InterDir inter_dir) {
   assert(cu.GetPartitionType() == PartitionType::kSize2Nx2N);
-  ContextModel &ctx = ctx_.GetInterDirBiCtx(cu);
+  ContextModel &ctx = ctx_->GetInterDirBiCtx(cu);
   encoder_.EncodeBin(inter_dir == InterDir::kBi ? 1 : 0, &ctx);
   if (inter_dir != InterDir::kBi) {
     uint32_t bin = inter_dir == InterDir::kL0 ? 0 : 1;
-    encoder_.EncodeBin(bin, &ctx_.inter_dir[4]);
+    encoder_.EncodeBin(bin, &ctx_->inter_dir[4]);
   }
 }
 
@@ -372,7 +391,7 @@ void SyntaxWriter::WriteInterFullpelMvFlag(const CodingUnit &cu,
     assert(!fullpel_mv_only);
     return;
   }
-  ContextModel &ctx = ctx_.GetInterFullpelMvCtx(cu);
+  ContextModel &ctx = ctx_->GetInterFullpelMvCtx(cu);
   encoder_.EncodeBin(fullpel_mv_only ? 1 : 0, &ctx);
 }
 
@@ -390,13 +409,13 @@ void SyntaxWriter::WriteInterMvd(const MvDelta &mvd) {
     }
     return;
   }
-  encoder_.EncodeBin(mvd.x != 0, &ctx_.inter_mvd[0]);
-  encoder_.EncodeBin(mvd.y != 0, &ctx_.inter_mvd[0]);
+  encoder_.EncodeBin(mvd.x != 0, &ctx_->inter_mvd[0]);
+  encoder_.EncodeBin(mvd.y != 0, &ctx_->inter_mvd[0]);
   if (abs_mvd_x) {
-    encoder_.EncodeBin(abs_mvd_x > 1, &ctx_.inter_mvd[1]);
+    encoder_.EncodeBin(abs_mvd_x > 1, &ctx_->inter_mvd[1]);
   }
   if (abs_mvd_y) {
-    encoder_.EncodeBin(abs_mvd_y > 1, &ctx_.inter_mvd[1]);
+    encoder_.EncodeBin(abs_mvd_y > 1, &ctx_->inter_mvd[1]);
   }
   if (abs_mvd_x) {
     if (abs_mvd_x > 1) {
@@ -419,7 +438,7 @@ void SyntaxWriter::WriteInterMvpIdx(const CodingUnit &cu, int mvp_idx) {
     return;
   }
   WriteUnaryMaxSymbol(mvp_idx, constants::kNumInterMvPredictors - 1,
-                      &ctx_.inter_mvp_idx[0], &ctx_.inter_mvp_idx[0]);
+                      &ctx_->inter_mvp_idx[0], &ctx_->inter_mvp_idx[0]);
 }
 
 void SyntaxWriter::WriteInterRefIdx(int ref_idx, int num_refs_available) {
@@ -427,12 +446,12 @@ void SyntaxWriter::WriteInterRefIdx(int ref_idx, int num_refs_available) {
   if (num_refs_available == 1) {
     return;
   }
-  encoder_.EncodeBin(ref_idx != 0 ? 1 : 0, &ctx_.inter_ref_idx[0]);
+  encoder_.EncodeBin(ref_idx != 0 ? 1 : 0, &ctx_->inter_ref_idx[0]);
   if (!ref_idx || num_refs_available == 2) {
     return;
   }
   ref_idx--;
-  encoder_.EncodeBin(ref_idx != 0 ? 1 : 0, &ctx_.inter_ref_idx[1]);
+  encoder_.EncodeBin(ref_idx != 0 ? 1 : 0, &ctx_->inter_ref_idx[1]);
   if (!ref_idx) {
     return;
   }
@@ -456,18 +475,18 @@ void SyntaxWriter::WriteIntraMode(IntraMode intra_mode,
       mpm_index = i;
     }
   }
-  ContextModel &ctx = ctx_.intra_pred_luma[0];
+  ContextModel &ctx = ctx_->intra_pred_luma[0];
   encoder_.EncodeBin(mpm_index >= 0, &ctx);
   if (mpm_index >= 0) {
     if (!Restrictions::Get().disable_ext2_intra_6_predictors) {
       encoder_.EncodeBin(mpm_index > 0,
-                         &ctx_.GetIntraPredictorCtx(mpm[0]));
+                         &ctx_->GetIntraPredictorCtx(mpm[0]));
       if (mpm_index > 0) {
         encoder_.EncodeBin(mpm_index > 1,
-                           &ctx_.GetIntraPredictorCtx(mpm[1]));
+                           &ctx_->GetIntraPredictorCtx(mpm[1]));
         if (mpm_index > 1) {
           encoder_.EncodeBin(mpm_index > 2,
-                             &ctx_.GetIntraPredictorCtx(mpm[2]));
+                             &ctx_->GetIntraPredictorCtx(mpm[2]));
           if (mpm_index > 2) {
             encoder_.EncodeBypass(mpm_index > 3);
             if (mpm_index > 3) {
@@ -526,16 +545,16 @@ void SyntaxWriter::WriteIntraMode(IntraMode intra_mode,
 void SyntaxWriter::WriteIntraChromaMode(IntraChromaMode chroma_mode,
                                         IntraPredictorChroma chroma_preds) {
   if (chroma_mode == IntraChromaMode::kDmChroma) {
-    encoder_.EncodeBin(0, &ctx_.intra_pred_chroma[0]);
+    encoder_.EncodeBin(0, &ctx_->intra_pred_chroma[0]);
     return;
   }
-  encoder_.EncodeBin(1, &ctx_.intra_pred_chroma[0]);
+  encoder_.EncodeBin(1, &ctx_->intra_pred_chroma[0]);
   if (!Restrictions::Get().disable_ext2_intra_chroma_from_luma) {
     if (chroma_mode == IntraChromaMode::kLmChroma) {
-      encoder_.EncodeBin(0, &ctx_.intra_pred_chroma[1]);
+      encoder_.EncodeBin(0, &ctx_->intra_pred_chroma[1]);
       return;
     }
-    encoder_.EncodeBin(1, &ctx_.intra_pred_chroma[1]);
+    encoder_.EncodeBin(1, &ctx_->intra_pred_chroma[1]);
   }
   int chroma_index = 0;
   for (int i = 1; i < static_cast<int>(chroma_preds.size()) - 1; i++) {
@@ -551,7 +570,7 @@ void SyntaxWriter::WriteLicFlag(bool use_lic) {
     assert(!use_lic);
     return;
   }
-  encoder_.EncodeBin(use_lic ? 1 : 0, &ctx_.lic_flag[0]);
+  encoder_.EncodeBin(use_lic ? 1 : 0, &ctx_->lic_flag[0]);
 }
 
 void SyntaxWriter::WriteMergeFlag(bool merge) {
@@ -559,7 +578,7 @@ void SyntaxWriter::WriteMergeFlag(bool merge) {
     assert(!merge);
     return;
   }
-  encoder_.EncodeBin(merge ? 1 : 0, &ctx_.inter_merge_flag[0]);
+  encoder_.EncodeBin(merge ? 1 : 0, &ctx_->inter_merge_flag[0]);
 }
 
 void SyntaxWriter::WriteMergeIdx(int merge_idx) {
@@ -570,7 +589,7 @@ void SyntaxWriter::WriteMergeIdx(int merge_idx) {
   assert(merge_idx >= 0);
   const int max_merge_cand = constants::kNumInterMergeCandidates;
   uint32_t bin = merge_idx != 0;
-  encoder_.EncodeBin(bin, &ctx_.inter_merge_idx[0]);
+  encoder_.EncodeBin(bin, &ctx_->inter_merge_idx[0]);
   if (merge_idx != 0) {
     uint32_t bins = (1 << merge_idx) - 2;
     bins >>= (merge_idx == max_merge_cand - 1) ? 1 : 0;
@@ -586,16 +605,16 @@ void SyntaxWriter::WritePartitionType(const CodingUnit &cu,
     assert(cu.GetCuTree() == CuTree::Primary);
     if (cu.GetDepth() == constants::kMaxCuDepth) {
       uint32_t bin = type == PartitionType::kSize2Nx2N ? 1 : 0;
-      encoder_.EncodeBin(bin, &ctx_.cu_part_size[0]);
+      encoder_.EncodeBin(bin, &ctx_->cu_part_size[0]);
     }
     return;
   }
   switch (type) {
     case PartitionType::kSize2Nx2N:
-      encoder_.EncodeBin(1, &ctx_.cu_part_size[0]);
+      encoder_.EncodeBin(1, &ctx_->cu_part_size[0]);
       break;
     default:
-      encoder_.EncodeBin(0, &ctx_.cu_part_size[0]);
+      encoder_.EncodeBin(0, &ctx_->cu_part_size[0]);
       // TODO(Dev) Non 2Nx2N part size not implemented
       assert(0);
       break;
@@ -604,7 +623,7 @@ void SyntaxWriter::WritePartitionType(const CodingUnit &cu,
 
 void SyntaxWriter::WritePredMode(PredictionMode pred_mode) {
   uint32_t is_intra = pred_mode == PredictionMode::kIntra ? 1 : 0;
-  encoder_.EncodeBin(is_intra, &ctx_.cu_pred_mode[0]);
+  encoder_.EncodeBin(is_intra, &ctx_->cu_pred_mode[0]);
 }
 
 void SyntaxWriter::WriteQp(int qp_value, int predicted_qp, int aqp_mode) {
@@ -613,9 +632,9 @@ void SyntaxWriter::WriteQp(int qp_value, int predicted_qp, int aqp_mode) {
     return;
   }
   if (qp_value == predicted_qp) {
-    encoder_.EncodeBin(1, &ctx_.delta_qp[0]);
+    encoder_.EncodeBin(1, &ctx_->delta_qp[0]);
   } else {
-    encoder_.EncodeBin(0, &ctx_.delta_qp[0]);
+    encoder_.EncodeBin(0, &ctx_->delta_qp[0]);
     if (qp_value == predicted_qp - 1 ||
         qp_value == predicted_qp + 10) {
       encoder_.EncodeBypassBins(2, 2);
@@ -658,7 +677,7 @@ void SyntaxWriter::WriteRootCbf(bool root_cbf) {
     assert(root_cbf);
     return;
   }
-  encoder_.EncodeBin(root_cbf != 0, &ctx_.cu_root_cbf[0]);
+  encoder_.EncodeBin(root_cbf != 0, &ctx_->cu_root_cbf[0]);
 }
 
 void SyntaxWriter::WriteSkipFlag(const CodingUnit &cu, bool skip_flag) {
@@ -667,7 +686,7 @@ void SyntaxWriter::WriteSkipFlag(const CodingUnit &cu, bool skip_flag) {
     assert(!skip_flag);
     return;
   }
-  ContextModel &ctx = ctx_.GetSkipFlagCtx(cu);
+  ContextModel &ctx = ctx_->GetSkipFlagCtx(cu);
   encoder_.EncodeBin(skip_flag ? 1 : 0, &ctx);
 }
 
@@ -675,7 +694,7 @@ void SyntaxWriter::WriteSplitBinary(const CodingUnit &cu,
                                     SplitRestriction split_restriction,
                                     SplitType split) {
   assert(split != SplitType::kQuad);
-  ContextModel &ctx = ctx_.GetSplitBinaryCtx(cu);
+  ContextModel &ctx = ctx_->GetSplitBinaryCtx(cu);
   encoder_.EncodeBin(split != SplitType::kNone ? 1 : 0, &ctx);
   if (split == SplitType::kNone) {
     return;
@@ -695,13 +714,13 @@ void SyntaxWriter::WriteSplitBinary(const CodingUnit &cu,
   int offset =
     cu.GetWidth(YuvComponent::kY) == cu.GetHeight(YuvComponent::kY) ? 0 :
     (cu.GetWidth(YuvComponent::kY) > cu.GetHeight(YuvComponent::kY) ? 1 : 2);
-  ContextModel &ctx2 = ctx_.cu_split_binary[3 + offset];
+  ContextModel &ctx2 = ctx_->cu_split_binary[3 + offset];
   encoder_.EncodeBin(split == SplitType::kVertical ? 1 : 0, &ctx2);
 }
 
 void SyntaxWriter::WriteSplitQuad(const CodingUnit &cu, int max_depth,
                                   SplitType split) {
-  ContextModel &ctx = ctx_.GetSplitFlagCtx(cu, max_depth);
+  ContextModel &ctx = ctx_->GetSplitFlagCtx(cu, max_depth);
   encoder_.EncodeBin(split == SplitType::kQuad ? 1 : 0, &ctx);
 }
 
@@ -712,7 +731,7 @@ void SyntaxWriter::WriteTransformSkip(const CodingUnit &cu, YuvComponent comp,
     assert(!transform_skip);
     return;
   }
-  ContextModel &ctx = ctx_.transform_skip_flag[util::IsLuma(comp) ? 0 : 1];
+  ContextModel &ctx = ctx_->transform_skip_flag[util::IsLuma(comp) ? 0 : 1];
   encoder_.EncodeBin(transform_skip ? 1 : 0, &ctx);
 }
 
@@ -722,7 +741,7 @@ void SyntaxWriter::WriteTransformSelectEnable(const CodingUnit &cu,
     assert(!enable);
     return;
   }
-  ContextModel &ctx = ctx_.transform_select_flag[cu.GetDepth()];
+  ContextModel &ctx = ctx_->transform_select_flag[cu.GetDepth()];
   encoder_.EncodeBin(enable ? 1 : 0, &ctx);
 }
 
@@ -733,16 +752,18 @@ void SyntaxWriter::WriteTransformSelectIdx(const CodingUnit &cu, int type_idx) {
   }
   static_assert(constants::kMaxTransformSelectIdx == 4, "2 bits signaling");
   ContextModel &ctx1 = cu.IsIntra() ?
-    ctx_.transform_select_idx[0] : ctx_.transform_select_idx[2];
+    ctx_->transform_select_idx[0] : ctx_->transform_select_idx[2];
   ContextModel &ctx2 = cu.IsIntra() ?
-    ctx_.transform_select_idx[1] : ctx_.transform_select_idx[3];
+    ctx_->transform_select_idx[1] : ctx_->transform_select_idx[3];
   encoder_.EncodeBin((type_idx & 1) ? 1 : 0, &ctx1);
   encoder_.EncodeBin((type_idx >> 1) ? 1 : 0, &ctx2);
 }
 
+template<typename RestrictionSet>
 void SyntaxWriter::WriteCoeffLastPos(int width, int height, YuvComponent comp,
                                      ScanOrder scan_order, int last_pos_x,
                                      int last_pos_y) {
+  const RestrictionSet &restrictions = RestrictionSet::Get();
   if (scan_order == ScanOrder::kVertical) {
     std::swap(last_pos_x, last_pos_y);
     std::swap(width, height);
@@ -753,24 +774,28 @@ void SyntaxWriter::WriteCoeffLastPos(int width, int height, YuvComponent comp,
   int ctx_last_x;
   for (ctx_last_x = 0; ctx_last_x < group_idx_x; ctx_last_x++) {
     ContextModel &ctx =
-      ctx_.GetCoeffLastPosCtx(comp, width, height, ctx_last_x, true);
+      ctx_->GetCoeffLastPosCtx(restrictions, comp, width, height,
+                               ctx_last_x, true);
     encoder_.EncodeBin(1, &ctx);
   }
   if (group_idx_x < TransformHelper::kLastPosGroupIdx[width - 1]) {
     ContextModel &ctx =
-      ctx_.GetCoeffLastPosCtx(comp, width, height, ctx_last_x, true);
+      ctx_->GetCoeffLastPosCtx(restrictions, comp, width, height,
+                               ctx_last_x, true);
     encoder_.EncodeBin(0, &ctx);
   }
   // pos Y
   int ctx_last_y;
   for (ctx_last_y = 0; ctx_last_y < group_idx_y; ctx_last_y++) {
     ContextModel &ctx =
-      ctx_.GetCoeffLastPosCtx(comp, width, height, ctx_last_y, false);
+      ctx_->GetCoeffLastPosCtx(restrictions, comp, width, height,
+                               ctx_last_y, false);
     encoder_.EncodeBin(1, &ctx);
   }
   if (group_idx_y < TransformHelper::kLastPosGroupIdx[height - 1]) {
     ContextModel &ctx =
-      ctx_.GetCoeffLastPosCtx(comp, width, height, ctx_last_y, false);
+      ctx_->GetCoeffLastPosCtx(restrictions, comp, width, height,
+                               ctx_last_y, false);
     encoder_.EncodeBin(0, &ctx);
   }
 
@@ -792,10 +817,11 @@ void SyntaxWriter::WriteCoeffLastPos(int width, int height, YuvComponent comp,
   }
 }
 
+template<typename RestrictionSet>
 void SyntaxWriter::WriteCoeffRemainExpGolomb(uint32_t code_number,
                                              uint32_t golomb_rice_k) {
   const uint32_t threshold =
-    !Restrictions::Get().disable_ext2_cabac_alt_residual_ctx ?
+    !RestrictionSet::Get().disable_ext2_cabac_alt_residual_ctx ?
     TransformHelper::kGolombRiceRangeExt[golomb_rice_k] :
     constants::kCoeffRemainBinReduction;
   if (code_number < (threshold << golomb_rice_k)) {
@@ -866,14 +892,95 @@ RdoSyntaxWriter::RdoSyntaxWriter(const SyntaxWriter &writer,
 
 RdoSyntaxWriter::RdoSyntaxWriter(const SyntaxWriter & writer,
                                  uint32_t bits_written, uint32_t frac_bits)
-  : SyntaxWriter(writer.GetContexts(),
-                 EntropyEncoder(nullptr, bits_written, frac_bits)) {
+  : RdoSyntaxWriter(writer, bits_written, frac_bits,
+                    writer.HasFrozenContexts()) {
+}
+
+RdoSyntaxWriter::RdoSyntaxWriter(const SyntaxWriter & writer,
+                                 uint32_t bits_written, uint32_t frac_bits,
+                                 bool frozen_contexts)
+  : SyntaxWriter(writer.GetContexts(), frozen_contexts,
+                 EntropyEncoder(nullptr, bits_written, frac_bits,
+                                !frozen_contexts)) {
 }
 
 RdoSyntaxWriter& RdoSyntaxWriter::operator=(const RdoSyntaxWriter &writer) {
-  ctx_ = writer.ctx_;
+  if (writer.HasFrozenContexts()) {
+    ctx_ = writer.ctx_;
+  } else {
+    ctx_storage_ = *writer.ctx_;
+    ctx_ = &ctx_storage_;
+  }
+  EntropyEncoder::ContextJournal *journal = encoder_.GetContextJournal();
   encoder_ = writer.encoder_;
+  encoder_.SetContextJournal(journal);
+  unrestricted_ = writer.unrestricted_;
   return *this;
 }
 
+void RdoSyntaxWriter::SetContextJournal(
+  EntropyEncoder::ContextJournal *journal) {
+  assert(journal->empty());
+  encoder_.SetContextJournal(journal);
+}
+
+RdoSyntaxWriter::Checkpoint RdoSyntaxWriter::GetCheckpoint() const {
+  const EntropyEncoder::ContextJournal *journal = encoder_.GetContextJournal();
+  return { journal ? journal->size() : 0, encoder_.GetNumWrittenBits(),
+    encoder_.GetFractionalBits() };
+}
+
+void RdoSyntaxWriter::Rollback(const Checkpoint &checkpoint) {
+  EntropyEncoder::ContextJournal *journal = encoder_.GetContextJournal();
+  if (journal) {
+    assert(journal->size() >= checkpoint.journal_size);
+    while (journal->size() > checkpoint.journal_size) {
+      const EntropyEncoder::ContextJournalEntry &entry = journal->back();
+      *entry.ctx = entry.state;
+      journal->pop_back();
+    }
+  }
+  encoder_.SetBitCounting(checkpoint.written_bits, checkpoint.frac_bits);
+}
+
+void RdoSyntaxWriter::SaveDeltaTo(const Checkpoint &checkpoint,
+                                  ContextDelta *delta) const {
+  const EntropyEncoder::ContextJournal *journal = encoder_.GetContextJournal();
+  delta->contexts.clear();
+  if (journal) {
+    for (size_t i = checkpoint.journal_size; i < journal->size(); i++) {
+      delta->contexts.push_back({ (*journal)[i].ctx, ContextModel() });
+    }
+    // A context may have been updated several times, only its final state
+    // needs to be kept
+    auto by_ctx = [](const EntropyEncoder::ContextJournalEntry &a,
+                     const EntropyEncoder::ContextJournalEntry &b) {
+      return a.ctx < b.ctx;
+    };
+    auto same_ctx = [](const EntropyEncoder::ContextJournalEntry &a,
+                       const EntropyEncoder::ContextJournalEntry &b) {
+      return a.ctx == b.ctx;
+    };
+    std::sort(delta->contexts.begin(), delta->contexts.end(), by_ctx);
+    delta->contexts.erase(std::unique(delta->contexts.begin(),
+                                      delta->contexts.end(), same_ctx),
+                          delta->contexts.end());
+    for (EntropyEncoder::ContextJournalEntry &entry : delta->contexts) {
+      entry.state = *entry.ctx;
+    }
+  }
+  delta->written_bits = encoder_.GetNumWrittenBits();
+  delta->frac_bits = encoder_.GetFractionalBits();
+}
+
+void RdoSyntaxWriter::LoadDeltaFrom(const ContextDelta &delta) {
+  EntropyEncoder::ContextJournal *journal = encoder_.GetContextJournal();
+  assert(journal || delta.contexts.empty());
+  for (const EntropyEncoder::ContextJournalEntry &entry : delta.contexts) {
+    journal->push_back({ entry.ctx, *entry.ctx });
+    *entry.ctx = entry.state;
+  }
+  encoder_.SetBitCounting(delta.written_bits, delta.frac_bits);
+}
+
 }   // namespace xvc
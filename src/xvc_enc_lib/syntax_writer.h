@@ -38,8 +38,14 @@ class SyntaxWriter {
 public:
   SyntaxWriter(const Qp &qp, PicturePredictionType pic_type,
                BitWriter *bit_writer);
-  SyntaxWriter(const Contexts &contexts, EntropyEncoder &&entropyenc);
-  const Contexts& GetContexts() const { return ctx_; }
+  SyntaxWriter(const Contexts &contexts, bool frozen_contexts,
+               EntropyEncoder &&entropyenc);
+  SyntaxWriter(const SyntaxWriter &writer) = delete;
+  SyntaxWriter& operator=(const SyntaxWriter &writer) = delete;
+  const Contexts& GetContexts() const { return *ctx_; }
+  // Frozen contexts are shared with the originating writer and never updated,
+  // bits are then only estimated from the context states at time of creation
+  bool HasFrozenContexts() const { return ctx_ != &ctx_storage_; }
   Bits GetNumWrittenBits() const {
     return encoder_.GetNumWrittenBits();
   }
@@ -79,30 +85,60 @@ public:
   void WriteTransformSelectIdx(const CodingUnit &cu, int type_idx);
 
 private:
-  template<int SubBlockShift>
+  // Residual coding is templated on the restriction set so that all
+  // restriction checks per bin are resolved at compile time for segments
+  // without any restrictions
+  template<int SubBlockShift, typename RestrictionSet>
   int WriteCoeffSubblock(const CodingUnit &cu, YuvComponent comp,
                          const Coeff *coeff, ptrdiff_t coeff_stride);
+  template<typename RestrictionSet>
   void WriteCoeffLastPos(int width, int height, YuvComponent comp,
                          ScanOrder scan_order, int last_pos_x,
                          int last_pos_y);
+  template<typename RestrictionSet>
   void WriteCoeffRemainExpGolomb(uint32_t abs_level, uint32_t golomb_rice_k);
   void WriteExpGolomb(uint32_t abs_level, uint32_t golomb_rice_k);
   void WriteUnaryMaxSymbol(uint32_t symbol, uint32_t max_val,
                            ContextModel *ctx_start, ContextModel *ctx_rest);
 
-  Contexts ctx_;
+  Contexts ctx_storage_;
+  Contexts *ctx_;
   EntropyEncoder encoder_;
+  bool unrestricted_ = false;
   friend class RdoSyntaxWriter;
 };
 
 class RdoSyntaxWriter : public SyntaxWriter {
 public:
+  // Position in the context journal together with the bit counters
+  struct Checkpoint {
+    size_t journal_size;
+    Bits written_bits;
+    Bits frac_bits;
+  };
+  // Final value of all contexts touched since a checkpoint
+  struct ContextDelta {
+    EntropyEncoder::ContextJournal contexts;
+    Bits written_bits = 0;
+    Bits frac_bits = 0;
+  };
+
   explicit RdoSyntaxWriter(const SyntaxWriter &writer);
   explicit RdoSyntaxWriter(const RdoSyntaxWriter &writer);
   RdoSyntaxWriter(const SyntaxWriter &writer, uint32_t bits_written);
   RdoSyntaxWriter(const SyntaxWriter &writer, uint32_t bits_written,
                   uint32_t frac_bits);
+  RdoSyntaxWriter(const SyntaxWriter &writer, uint32_t bits_written,
+                  uint32_t frac_bits, bool frozen_contexts);
   RdoSyntaxWriter& operator=(const RdoSyntaxWriter &writer);
+
+  // Record all context updates so that state can be restored in time
+  // proportional to the number of updates instead of copying all contexts
+  void SetContextJournal(EntropyEncoder::ContextJournal *journal);
+  Checkpoint GetCheckpoint() const;
+  void Rollback(const Checkpoint &checkpoint);
+  void SaveDeltaTo(const Checkpoint &checkpoint, ContextDelta *delta) const;
+  void LoadDeltaFrom(const ContextDelta &delta);
 };
 
 }   // namespace xvc
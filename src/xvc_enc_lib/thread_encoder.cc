@@ -144,7 +144,8 @@ void ThreadEncoder::WorkerMain(int thread_idx) {
     // Encode picture
     const std::vector<uint8_t> *pic_bytes =
       work.pic_enc->Encode(*work.segment_header, work.segment_qp,
-                           work.buffer_flag, encoder_settings_);
+                           work.buffer_flag, work.pic_dependencies,
+                           encoder_settings_);
     *work.nal_buffer = *pic_bytes;
     work.pic_enc->SetOutputStatus(OutputStatus::kFinishedProcessing);
 
@@ -31,10 +31,21 @@
 #include "xvc_enc_lib/encoder.h"
 #include "xvc_enc_lib/encoder_settings.h"
 
+#if XVC_HIGH_BITDEPTH && XVC_LOW_BITDEPTH_PIPELINE
+#define XVC_ENC_LOWBD_DELEGATE 1
+#else
+#define XVC_ENC_LOWBD_DELEGATE 0
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if XVC_ENC_LOWBD_DELEGATE
+  // Same api compiled with 8bit samples
+  const xvc_encoder_api* xvc_lowbd_encoder_api_get(void);
+#endif
+
   static const int kDefaultSubGopLength = 16;
 
   static xvc_encoder_parameters* xvc_enc_parameters_create() {
@@ -85,6 +96,17 @@ extern "C" {
     param->threads = 0;
     param->simd_mask = static_cast<uint32_t>(-1);
     param->explicit_encoder_settings = nullptr;
+    param->picture_alloc = nullptr;
+    param->picture_free = nullptr;
+    param->picture_alloc_opaque = nullptr;
+    param->huge_pages = 0;
+    param->lookahead = 0;
+    param->lookahead_depth = 0;
+    param->target_bitrate = 0;
+    param->max_bitrate = 0;
+    param->vbv_buffer_size = 0;
+    param->cu_split_stats = nullptr;
+    param->cu_split_stats_opaque = nullptr;
     return XVC_ENC_OK;
   }
 
@@ -215,6 +237,31 @@ extern "C" {
         param->tune_mode >= static_cast<int>(xvc::TuneMode::kTotalNumber)) {
       return XVC_ENC_INVALID_PARAMETER;
     }
+    if (!param->picture_alloc != !param->picture_free) {
+      return XVC_ENC_INVALID_PARAMETER;
+    }
+    if (param->leading_pictures < -1 || param->leading_pictures > 1) {
+      return XVC_ENC_INVALID_PARAMETER;
+    }
+    if (param->lookahead < 0 || param->lookahead > 1) {
+      return XVC_ENC_INVALID_PARAMETER;
+    }
+    if (param->lookahead_depth < 0 ||
+        param->lookahead_depth >
+        static_cast<int>(4 * xvc::constants::kMaxSubGopLength)) {
+      return XVC_ENC_INVALID_PARAMETER;
+    }
+    if (param->target_bitrate < 0 || param->max_bitrate < 0 ||
+        param->vbv_buffer_size < 0) {
+      return XVC_ENC_INVALID_PARAMETER;
+    }
+    if (param->max_bitrate > 0 && param->target_bitrate > param->max_bitrate) {
+      return XVC_ENC_INVALID_PARAMETER;
+    }
+    if (param->vbv_buffer_size > 0 &&
+        param->target_bitrate == 0 && param->max_bitrate == 0) {
+      return XVC_ENC_INVALID_PARAMETER;
+    }
     return XVC_ENC_OK;
   }
 
@@ -250,6 +297,9 @@ extern "C" {
 
     encoder_settings.leading_pictures = param->leading_pictures;
     encoder_settings.flat_lambda = param->flat_lambda;
+    encoder_settings.lookahead = param->lookahead;
+    encoder_settings.lookahead_depth = param->lookahead_depth;
+    encoder_settings.cu_split_stats = param->cu_split_stats ? 1 : 0;
     if (param->lambda_a != 0) {
       encoder_settings.lambda_scale_a = param->lambda_a;
     }
@@ -294,11 +344,32 @@ extern "C" {
     if (xvc_enc_parameters_check(param) != XVC_ENC_OK) {
       return nullptr;
     }
+#if XVC_ENC_LOWBD_DELEGATE
+    if (param->internal_bitdepth == 8) {
+      // Half the memory bandwidth with 8bit samples throughout
+      xvc_encoder *delegate =
+        xvc_lowbd_encoder_api_get()->encoder_create(param);
+      if (!delegate) {
+        return nullptr;
+      }
+      xvc_encoder *handle = new xvc_encoder();
+      handle->lowbd_delegate = delegate;
+      return handle;
+    }
+#endif
     xvc::Encoder *encoder = new xvc::Encoder(param->internal_bitdepth,
                                              param->threads);
     xvc_enc_set_encoder_settings(encoder, param);
 
     encoder->SetCpuCapabilities(xvc::SimdCpu::GetMaskedCaps(param->simd_mask));
+    xvc::PictureAllocator allocator;
+    allocator.alloc_func = param->picture_alloc;
+    allocator.free_func = param->picture_free;
+    allocator.opaque = param->picture_alloc_opaque;
+    allocator.huge_pages = param->huge_pages != 0;
+    encoder->SetPictureAllocator(allocator);
+    encoder->SetCuSplitStatsCallback(param->cu_split_stats,
+                                     param->cu_split_stats_opaque);
     encoder->SetResolution(param->width, param->height);
     encoder->SetChromaFormat(xvc::ChromaFormat(param->chroma_format));
     encoder->SetColorMatrix(xvc::ColorMatrix(param->color_matrix));
@@ -334,6 +405,9 @@ extern "C" {
       }
     }
     encoder->SetQp(param->qp);
+    encoder->SetRateControl(1000.0 * param->target_bitrate,
+                            1000.0 * param->max_bitrate,
+                            1000.0 * param->vbv_buffer_size);
     encoder->SetLowDelay(param->low_delay != 0);
     if (param->num_ref_pics >= 0) {
       encoder->SetNumRefPics(param->num_ref_pics);
@@ -354,10 +428,18 @@ extern "C" {
   }
 
   static xvc_enc_return_code xvc_enc_encoder_destroy(xvc_encoder *encoder) {
-    if (encoder) {
-      xvc::Encoder *lib_encoder = reinterpret_cast<xvc::Encoder*>(encoder);
-      delete lib_encoder;
+    if (!encoder) {
+      return XVC_ENC_OK;
     }
+#if XVC_ENC_LOWBD_DELEGATE
+    if (encoder->lowbd_delegate) {
+      xvc_lowbd_encoder_api_get()->encoder_destroy(encoder->lowbd_delegate);
+      delete encoder;
+      return XVC_ENC_OK;
+    }
+#endif
+    xvc::Encoder *lib_encoder = static_cast<xvc::Encoder*>(encoder);
+    delete lib_encoder;
     return XVC_ENC_OK;
   }
 
@@ -368,7 +450,14 @@ extern "C" {
     if (!encoder || !input_picture || !nal_units || !num_nal_units) {
       return XVC_ENC_INVALID_ARGUMENT;
     }
-    xvc::Encoder *lib_encoder = reinterpret_cast<xvc::Encoder*>(encoder);
+#if XVC_ENC_LOWBD_DELEGATE
+    if (encoder->lowbd_delegate) {
+      return xvc_lowbd_encoder_api_get()->
+        encoder_encode(encoder->lowbd_delegate, input_picture, nal_units,
+                       num_nal_units, rec_pic);
+    }
+#endif
+    xvc::Encoder *lib_encoder = static_cast<xvc::Encoder*>(encoder);
     bool success = lib_encoder->Encode(input_picture, rec_pic);
     std::vector<xvc_enc_nal_unit> &output_nals = lib_encoder->GetOutputNals();
     if (output_nals.size() > 0) {
@@ -389,12 +478,19 @@ extern "C" {
     if (!encoder || !plane_bytes || !nal_units || !num_nal_units) {
       return XVC_ENC_INVALID_ARGUMENT;
     }
+#if XVC_ENC_LOWBD_DELEGATE
+    if (encoder->lowbd_delegate) {
+      return xvc_lowbd_encoder_api_get()->
+        encoder_encode2(encoder->lowbd_delegate, plane_bytes, plane_stride,
+                        nal_units, num_nal_units, rec_pic, user_data);
+    }
+#endif
     xvc::Encoder::PicPlanes pic_planes = {
       std::make_pair(plane_bytes[0], plane_stride[0]),
       std::make_pair(plane_bytes[1], plane_stride[1]),
       std::make_pair(plane_bytes[2], plane_stride[2])
     };
-    xvc::Encoder *lib_encoder = reinterpret_cast<xvc::Encoder*>(encoder);
+    xvc::Encoder *lib_encoder = static_cast<xvc::Encoder*>(encoder);
     bool success = lib_encoder->Encode(pic_planes, rec_pic, user_data);
     std::vector<xvc_enc_nal_unit> &output_nals = lib_encoder->GetOutputNals();
     if (output_nals.size() > 0) {
@@ -407,13 +503,63 @@ extern "C" {
     return success ? XVC_ENC_OK : XVC_ENC_INVALID_ARGUMENT;
   }
 
+  static xvc_enc_return_code
+    xvc_enc_encoder_encode_ref(xvc_encoder *encoder,
+                               const uint8_t *plane_bytes[3],
+                               int plane_stride[3],
+                               xvc_enc_nal_unit **nal_units,
+                               int *num_nal_units, xvc_enc_pic_buffer *rec_pic,
+                               int64_t user_data,
+                               xvc::Encoder::ReleaseFunc release,
+                               void *release_opaque) {
+    if (!encoder || !plane_bytes || !nal_units || !num_nal_units ||
+        !release) {
+      if (plane_bytes && release) {
+        release(release_opaque, plane_bytes[0]);
+      }
+      return XVC_ENC_INVALID_ARGUMENT;
+    }
+#if XVC_ENC_LOWBD_DELEGATE
+    if (encoder->lowbd_delegate) {
+      return xvc_lowbd_encoder_api_get()->
+        encoder_encode_ref(encoder->lowbd_delegate, plane_bytes, plane_stride,
+                           nal_units, num_nal_units, rec_pic, user_data,
+                           release, release_opaque);
+    }
+#endif
+    xvc::Encoder::PicPlanes pic_planes = {
+      std::make_pair(plane_bytes[0], plane_stride[0]),
+      std::make_pair(plane_bytes[1], plane_stride[1]),
+      std::make_pair(plane_bytes[2], plane_stride[2])
+    };
+    xvc::Encoder *lib_encoder = static_cast<xvc::Encoder*>(encoder);
+    bool success = lib_encoder->Encode(pic_planes, release, release_opaque,
+                                       rec_pic, user_data);
+    std::vector<xvc_enc_nal_unit> &output_nals = lib_encoder->GetOutputNals();
+    if (output_nals.size() > 0) {
+      *nal_units = &output_nals[0];
+      *num_nal_units = static_cast<int>(output_nals.size());
+    } else {
+      *nal_units = nullptr;
+      *num_nal_units = 0;
+    }
+    return success ? XVC_ENC_OK : XVC_ENC_INVALID_ARGUMENT;
+  }
+
   static xvc_enc_return_code
     xvc_enc_encoder_flush(xvc_encoder *encoder, xvc_enc_nal_unit **nal_units,
                           int *num_nal_units, xvc_enc_pic_buffer *rec_pic) {
     if (!encoder || !nal_units || !num_nal_units) {
       return XVC_ENC_INVALID_ARGUMENT;
     }
-    xvc::Encoder *lib_encoder = reinterpret_cast<xvc::Encoder*>(encoder);
+#if XVC_ENC_LOWBD_DELEGATE
+    if (encoder->lowbd_delegate) {
+      return xvc_lowbd_encoder_api_get()->
+        encoder_flush(encoder->lowbd_delegate, nal_units, num_nal_units,
+                      rec_pic);
+    }
+#endif
+    xvc::Encoder *lib_encoder = static_cast<xvc::Encoder*>(encoder);
     bool success = lib_encoder->Flush(rec_pic);
     std::vector<xvc_enc_nal_unit> &output_nals = lib_encoder->GetOutputNals();
     if (output_nals.size() > 0) {
@@ -426,6 +572,14 @@ extern "C" {
     return success ? XVC_ENC_OK : XVC_ENC_NO_MORE_OUTPUT;
   }
 
+  static xvc_enc_return_code xvc_enc_buffer_pool_set_limit(size_t max_bytes) {
+#if XVC_ENC_LOWBD_DELEGATE
+    xvc_lowbd_encoder_api_get()->buffer_pool_set_limit(max_bytes);
+#endif
+    xvc::PictureAllocator::SetPoolLimit(max_bytes);
+    return XVC_ENC_OK;
+  }
+
   static const char* xvc_enc_get_error_text(xvc_enc_return_code error_code) {
     switch (error_code) {
       case XVC_ENC_OK:
@@ -484,6 +638,8 @@ extern "C" {
     &xvc_enc_encoder_encode2,
     &xvc_enc_encoder_flush,
     &xvc_enc_get_error_text,
+    &xvc_enc_encoder_encode_ref,
+    &xvc_enc_buffer_pool_set_limit,
   };
 
   const xvc_encoder_api* xvc_encoder_api_get() {
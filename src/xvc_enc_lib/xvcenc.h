@@ -40,7 +40,7 @@ extern "C" {
 #define XVC_ENC_API
 #endif
 
-#define XVC_ENC_API_VERSION   1
+#define XVC_ENC_API_VERSION   2
 
   typedef enum {
     XVC_ENC_OK = 0,
@@ -102,6 +102,25 @@ extern "C" {
     int64_t user_data;
   } xvc_enc_nal_unit;
 
+  // Features and outcome of the split evaluation of one CU, used for
+  // calibrating the split prediction of the encoder
+  typedef struct xvc_enc_cu_split_stats {
+    int intra_pic;
+    int log2_area;
+    int num_smaller_neighbors;
+    int skip;
+    // Rd cost without split per sample, relative to lambda and in 1/16
+    int cost_per_sample;
+    int variance;
+    // Rd cost reduction from splitting, in 1/1000 of the cost without split
+    int split_gain;
+    // Set if a faster heuristic would have terminated the split evaluation
+    // before the split prediction: based on the CU without split or based
+    // on an early skip decision
+    int full_cu_termination;
+    int early_skip_termination;
+  } xvc_enc_cu_split_stats;
+
   // Represents one reconstructed picture
   // Lifecycle managed by api->picture_create & api->picture_destroy
   typedef struct xvc_enc_pic_buffer {
@@ -139,6 +158,8 @@ extern "C" {
     int flat_lambda;
     float lambda_a;
     float lambda_b;
+    // Set to -1 to decide from the lookahead analysis of the first sub-gop,
+    // which requires a lookahead depth of at least the sub-gop length - 1
     int leading_pictures;
     int speed_mode;
     int tune_mode;
@@ -146,6 +167,34 @@ extern "C" {
     int threads;
     uint32_t simd_mask;
     char* explicit_encoder_settings;
+    // Optional application allocator for picture buffers, either both or
+    // none of picture_alloc and picture_free must be set. Returned memory
+    // must be aligned to at least the requested alignment (in bytes).
+    void* (*picture_alloc)(void *opaque, size_t size, size_t alignment);
+    void (*picture_free)(void *opaque, void *ptr);
+    void *picture_alloc_opaque;
+    // Request transparent huge pages for large picture buffers when using
+    // the built-in allocator
+    int huge_pages;
+    // Analyse downsampled input pictures on a separate thread to start new
+    // segments at scene cuts and adapt picture and block qp to how much
+    // each area is referenced by following pictures
+    int lookahead;
+    // Number of input pictures encoding is delayed by, so that the
+    // lookahead decisions take the following pictures into account
+    int lookahead_depth;
+    // Single-pass rate control, bitrates in kbit/s and buffer size in kbit.
+    // The qp parameter is used as initial qp, or as constant qp capped by
+    // the buffer model when only max_bitrate is set. Zero disables.
+    int target_bitrate;
+    int max_bitrate;
+    int vbv_buffer_size;
+    // Optional callback receiving the split statistics of each CU where
+    // splits are evaluated. Setting it makes the encoder evaluate all splits
+    // (no split termination heuristics), so it is meant for calibration
+    // only. Invoked in coding order on the thread making the api call.
+    void (*cu_split_stats)(void *opaque, const xvc_enc_cu_split_stats *stats);
+    void *cu_split_stats_opaque;
   } xvc_encoder_parameters;
 
   // xvc encoder api
@@ -184,6 +233,26 @@ extern "C" {
                                         xvc_enc_pic_buffer *rec_pic);
     // Misc
     const char*(*xvc_enc_get_error_text)(xvc_enc_return_code error_code);
+    // Same as encoder_encode2 but the planes are used without copy when the
+    // input bitdepth, chroma format and resolution match the internal format.
+    // The encoder invokes release exactly once with plane_bytes[0] when the
+    // picture is no longer needed, this may happen before this function
+    // returns (e.g. when the input had to be copied) or in any later api
+    // call on the encoder, including encoder_destroy. Release is always
+    // invoked on the thread making that api call, also when the encoder
+    // uses internal threads, and must not call back into the api for the
+    // same encoder.
+    xvc_enc_return_code(*encoder_encode_ref)(
+      xvc_encoder *encoder, const uint8_t *plane_bytes[3],
+      int plane_stride[3], xvc_enc_nal_unit **nal_units, int *num_nal_units,
+      xvc_enc_pic_buffer *rec_pic, int64_t user_data,
+      void (*release)(void *release_opaque, const uint8_t *plane_bytes),
+      void *release_opaque);
+    // Limit the memory in bytes of freed picture buffers that the built-in
+    // allocator keeps for reuse. The pool is shared by all decoder and
+    // encoder instances of the process and is emptied when the last
+    // instance is destroyed.
+    xvc_enc_return_code(*buffer_pool_set_limit)(size_t max_bytes);
   } xvc_encoder_api;
 
   // Starting point for using the xvc encoder api
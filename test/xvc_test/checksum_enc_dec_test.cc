@@ -101,12 +101,12 @@ protected:
                                     segment_.chroma_format,
                                     segment_.color_matrix, false);
     resampler.ConvertFrom(input_format, reinterpret_cast<const uint8_t*>(orig),
-                          pic_encoder_->GetOrigPic().get());
+                          pic_encoder_->PrepareOrigPic());
 
     xvc::EncoderSettings encoder_settings;
     encoder_settings.Initialize(xvc::SpeedMode::kSlow);
     encoder_settings.Tune(xvc::TuneMode::kPsnr);
-    return pic_encoder_->Encode(segment_, segment_qp_, buffer_flag,
+    return pic_encoder_->Encode(segment_, segment_qp_, buffer_flag, {},
                                 encoder_settings);
   }
 
@@ -125,7 +125,7 @@ protected:
     // TODO(PH) Also verify inter pictures?
     xvc::ReferencePictureLists ref_pic_list;
     pic_decoder_->Init(segment_, pic_header, std::move(ref_pic_list),
-                       output_pic_format_, 0);
+                       output_pic_format_, false, 0);
     return pic_decoder_->Decode(segment_, segment_, &bit_reader, true);
   }
 
@@ -0,0 +1,90 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include <vector>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/picture_data.h"
+
+namespace {
+
+static const size_t kFirstChunkSize = 8;
+static const size_t kChunkSize = 4;
+
+class CuArenaTest : public ::testing::Test {
+protected:
+  CuArenaTest()
+    : arena_(xvc::PictureAllocator(), kFirstChunkSize, kChunkSize) {
+  }
+
+  xvc::CodingUnit* Allocate() {
+    return static_cast<xvc::CodingUnit*>(arena_.Allocate());
+  }
+
+  xvc::CuArena arena_;
+};
+
+TEST_F(CuArenaTest, AllocatesInMemoryOrder) {
+  xvc::CodingUnit *first = Allocate();
+  for (size_t i = 1; i < kFirstChunkSize; i++) {
+    EXPECT_EQ(first + i, Allocate());
+  }
+  EXPECT_EQ(1U, arena_.GetNumChunks());
+  xvc::CodingUnit *second = Allocate();
+  EXPECT_EQ(2U, arena_.GetNumChunks());
+  for (size_t i = 1; i < kChunkSize; i++) {
+    EXPECT_EQ(second + i, Allocate());
+  }
+  EXPECT_EQ(2U, arena_.GetNumChunks());
+}
+
+TEST_F(CuArenaTest, ReusesFreedLastFirst) {
+  std::vector<xvc::CodingUnit*> cus;
+  for (int i = 0; i < 4; i++) {
+    cus.push_back(Allocate());
+  }
+  arena_.Free(cus[1]);
+  arena_.Free(cus[3]);
+  EXPECT_EQ(cus[3], Allocate());
+  EXPECT_EQ(cus[1], Allocate());
+  EXPECT_EQ(cus[3] + 1, Allocate());
+}
+
+TEST_F(CuArenaTest, ResetKeepsChunks) {
+  std::vector<xvc::CodingUnit*> cus;
+  for (size_t i = 0; i < kFirstChunkSize + kChunkSize; i++) {
+    cus.push_back(Allocate());
+  }
+  arena_.Free(cus[2]);
+  arena_.Reset();
+  for (size_t i = 0; i < cus.size(); i++) {
+    EXPECT_EQ(cus[i], Allocate());
+  }
+  EXPECT_EQ(2U, arena_.GetNumChunks());
+  arena_.ReleaseMemory();
+  EXPECT_EQ(0U, arena_.GetNumChunks());
+  Allocate();
+  EXPECT_EQ(1U, arena_.GetNumChunks());
+}
+
+}   // namespace
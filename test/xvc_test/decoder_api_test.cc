@@ -54,6 +54,10 @@ TEST(DecoderAPI, ParamCheck) {
   params->max_framerate = 92000;
   EXPECT_EQ(XVC_DEC_FRAMERATE_OUT_OF_RANGE, api->parameters_check(params));
 
+  EXPECT_EQ(XVC_DEC_OK, api->parameters_set_default(params));
+  params->picture_free = [](void *opaque, void *ptr) {};
+  EXPECT_EQ(XVC_DEC_INVALID_PARAMETER, api->parameters_check(params));
+
   EXPECT_EQ(XVC_DEC_OK, api->parameters_set_default(params));
   EXPECT_EQ(XVC_DEC_OK, api->parameters_check(params));
   EXPECT_EQ(XVC_DEC_OK, api->parameters_destroy(params));
@@ -95,6 +99,39 @@ TEST(DecoderAPI, DecoderDecodeNal) {
   EXPECT_EQ(XVC_DEC_OK, api->decoder_destroy(decoder));
 }
 
+static void CountNalRelease(void *opaque, const uint8_t *nal_unit) {
+  (*reinterpret_cast<int*>(opaque))++;
+}
+
+TEST(DecoderAPI, DecoderDecodeNalRef) {
+  const xvc_decoder_api *api = xvc_decoder_api_get();
+  std::vector<uint8_t> nal_bytes_;
+  nal_bytes_.push_back(0);
+  size_t nal_size = 1;
+  int num_released = 0;
+  EXPECT_EQ(XVC_DEC_INVALID_ARGUMENT,
+            api->decoder_decode_nal_ref(nullptr, &nal_bytes_[0], nal_size, 0,
+                                        &CountNalRelease, &num_released));
+  EXPECT_EQ(1, num_released);
+  xvc_decoder_parameters *params = api->parameters_create();
+  EXPECT_EQ(XVC_DEC_OK, api->parameters_set_default(params));
+  xvc_decoder *decoder = api->decoder_create(params);
+  EXPECT_EQ(XVC_DEC_OK, api->parameters_destroy(params));
+  EXPECT_EQ(XVC_DEC_INVALID_ARGUMENT,
+            api->decoder_decode_nal_ref(decoder, &nal_bytes_[0], nal_size, 0,
+                                        nullptr, nullptr));
+  EXPECT_EQ(XVC_DEC_INVALID_ARGUMENT,
+            api->decoder_decode_nal_ref(decoder, &nal_bytes_[0], 0, 0,
+                                        &CountNalRelease, &num_released));
+  EXPECT_EQ(2, num_released);
+  // Invalid nal units are released immediately
+  EXPECT_EQ(XVC_DEC_NO_SEGMENT_HEADER_DECODED,
+            api->decoder_decode_nal_ref(decoder, &nal_bytes_[0], nal_size, 0,
+                                        &CountNalRelease, &num_released));
+  EXPECT_EQ(3, num_released);
+  EXPECT_EQ(XVC_DEC_OK, api->decoder_destroy(decoder));
+}
+
 TEST(DecoderAPI, DecoderGetDecodedPic) {
   const xvc_decoder_api *api = xvc_decoder_api_get();
   xvc_decoded_picture decoded_pic;
@@ -136,4 +173,35 @@ TEST(DecoderAPI, DecoderCheckConformance) {
   EXPECT_EQ(XVC_DEC_OK, api->decoder_destroy(decoder));
 }
 
+TEST(DecoderAPI, DecoderGetMemoryUsage) {
+  const xvc_decoder_api *api = xvc_decoder_api_get();
+  xvc_dec_memory_usage usage;
+  EXPECT_EQ(XVC_DEC_INVALID_ARGUMENT,
+            api->decoder_get_memory_usage(nullptr, &usage));
+  xvc_decoder_parameters *params = api->parameters_create();
+  EXPECT_EQ(XVC_DEC_OK, api->parameters_set_default(params));
+  EXPECT_EQ(0U, params->max_memory_bytes);
+  xvc_decoder *decoder = api->decoder_create(params);
+  EXPECT_EQ(XVC_DEC_OK, api->parameters_destroy(params));
+  EXPECT_EQ(XVC_DEC_INVALID_ARGUMENT,
+            api->decoder_get_memory_usage(decoder, nullptr));
+  EXPECT_EQ(XVC_DEC_OK, api->decoder_get_memory_usage(decoder, &usage));
+  EXPECT_EQ(0U, usage.total);
+  EXPECT_EQ(XVC_DEC_OK, api->decoder_destroy(decoder));
+}
+
+TEST(DecoderAPI, BufferPoolSetLimit) {
+  const xvc_decoder_api *api = xvc_decoder_api_get();
+  xvc_decoder_parameters *params = api->parameters_create();
+  EXPECT_EQ(XVC_DEC_OK, api->parameters_set_default(params));
+  xvc_decoder *decoder = api->decoder_create(params);
+  EXPECT_EQ(XVC_DEC_OK, api->parameters_destroy(params));
+  xvc_dec_memory_usage usage;
+  EXPECT_EQ(XVC_DEC_OK, api->buffer_pool_set_limit(0));
+  EXPECT_EQ(XVC_DEC_OK, api->decoder_get_memory_usage(decoder, &usage));
+  EXPECT_EQ(0U, usage.pooled);
+  EXPECT_EQ(XVC_DEC_OK, api->buffer_pool_set_limit(512 * 1024 * 1024));
+  EXPECT_EQ(XVC_DEC_OK, api->decoder_destroy(decoder));
+}
+
 }   // namespace
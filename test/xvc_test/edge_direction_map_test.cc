@@ -0,0 +1,97 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include <memory>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/edge_direction_map.h"
+
+namespace {
+
+static const int kBitdepth = 8;
+static const int kWidth = 64;
+static const int kHeight = 32;
+
+class EdgeDirectionMapTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    pic_.reset(new xvc::YuvPicture(xvc::ChromaFormat::k420, kWidth, kHeight,
+                                   kBitdepth, false, kWidth, kHeight));
+  }
+
+  // Triangle wave along coord_x * x + coord_y * y
+  void FillStripes(int coord_x, int coord_y) {
+    for (int y = 0; y < kHeight; y++) {
+      xvc::Sample *dst = pic_->GetSamplePtr(xvc::YuvComponent::kY, 0, y);
+      for (int x = 0; x < kWidth; x++) {
+        const int phase = (coord_x * x + coord_y * y + 64) % 32;
+        dst[x] = static_cast<xvc::Sample>(phase < 16 ? phase * 8 :
+                                          (32 - phase) * 8);
+      }
+    }
+  }
+
+  int GetDominantMode(const xvc::EdgeDirectionMap &edge_map) {
+    xvc::EdgeDirectionMap::Histogram hist;
+    edge_map.GetHistogram(8, 8, 16, 16, &hist);
+    int best_mode = 0;
+    for (int mode = 0; mode < static_cast<int>(hist.size()); mode++) {
+      if (hist[mode] > hist[best_mode]) {
+        best_mode = mode;
+      }
+    }
+    return best_mode;
+  }
+
+  std::unique_ptr<xvc::YuvPicture> pic_;
+};
+
+TEST_F(EdgeDirectionMapTest, DominantModeFollowsEdges) {
+  xvc::EdgeDirectionMap edge_map(kWidth, kHeight, kBitdepth);
+  FillStripes(1, 0);
+  edge_map.Build(*pic_);
+  EXPECT_EQ(50, GetDominantMode(edge_map));
+  FillStripes(0, 1);
+  edge_map.Build(*pic_);
+  EXPECT_EQ(18, GetDominantMode(edge_map));
+  FillStripes(1, 1);
+  edge_map.Build(*pic_);
+  EXPECT_EQ(66, GetDominantMode(edge_map));
+  FillStripes(1, -1);
+  edge_map.Build(*pic_);
+  EXPECT_EQ(34, GetDominantMode(edge_map));
+}
+
+TEST_F(EdgeDirectionMapTest, FlatPictureHasEmptyHistogram) {
+  xvc::EdgeDirectionMap edge_map(kWidth, kHeight, kBitdepth);
+  FillStripes(0, 0);
+  edge_map.Build(*pic_);
+  xvc::EdgeDirectionMap::Histogram hist;
+  edge_map.GetHistogram(0, 0, kWidth, kHeight, &hist);
+  for (uint32_t bin : hist) {
+    EXPECT_EQ(0U, bin);
+  }
+}
+
+}   // namespace
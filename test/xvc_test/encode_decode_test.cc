@@ -19,7 +19,12 @@
 * Please visit https://xvc.io/license/ for more information.
 ******************************************************************************/
 
+#include <functional>
 #include <list>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "googletest/include/gtest/gtest.h"
@@ -33,8 +38,17 @@ namespace {
 struct TestParam {
   int internal_bitdepth;
   bool use_leading_pictures;
+  xvc::SpeedMode speed_mode;
+  const char *explicit_settings;
 };
 
+void PrintTo(const TestParam &param, std::ostream *os) {
+  *os << param.internal_bitdepth << "bit" <<
+    (param.use_leading_pictures ? " leading pictures " : " ") <<
+    "speed mode " << static_cast<int>(param.speed_mode) << " \"" <<
+    param.explicit_settings << "\"";
+}
+
 static constexpr int kQp = 27;
 static constexpr double kPsnrThreshold = 28.0;
 static constexpr int kSubGopLength = 8;
@@ -45,12 +59,24 @@ class EncodeDecodeTest : public ::testing::TestWithParam<TestParam>,
   public ::xvc_test::EncoderHelper, public ::xvc_test::DecoderHelper {
 protected:
   void SetUp() override {
-    xvc::EncoderSettings encoder_settings = GetDefaultEncoderSettings();
+    SetupEncoder(GetTestEncoderSettings());
+    DecoderHelper::Init();
+  }
+
+  xvc::EncoderSettings GetTestEncoderSettings() const {
+    xvc::EncoderSettings encoder_settings;
+    encoder_settings.Initialize(GetParam().speed_mode);
+    encoder_settings.Tune(xvc::TuneMode::kPsnr);
+    encoder_settings.ParseExplicitSettings(GetParam().explicit_settings);
     encoder_settings.leading_pictures = GetParam().use_leading_pictures ? 1 : 0;
-    SetupEncoder(encoder_settings, 0, 0, GetParam().internal_bitdepth, kQp);
+    return encoder_settings;
+  }
+
+  void SetupEncoder(const xvc::EncoderSettings &encoder_settings) {
+    EncoderHelper::SetupEncoder(encoder_settings, 0, 0,
+                                GetParam().internal_bitdepth, kQp);
     encoder_->SetSubGopLength(kSubGopLength);
     encoder_->SetSegmentLength(kSegmentLength);
-    DecoderHelper::Init();
   }
 
   void TearDown() override {
@@ -77,6 +103,67 @@ protected:
     }
   }
 
+  // Encodes with input planes passed by reference, each input buffer is
+  // overwritten when released to detect any later use by the encoder
+  void EncodeReferenced(int width, int height, int frames) {
+    // Release must always be invoked on the thread calling the encoder
+    static std::thread::id api_thread_id;
+    api_thread_id = std::this_thread::get_id();
+    const int input_bitdepth = GetParam().internal_bitdepth;
+    const int sample_size = input_bitdepth == 8 ? 1 : 2;
+    const int chroma_width = width / 2;
+    encoder_->SetResolution(width, height);
+    encoder_->SetInputBitdepth(input_bitdepth);
+    std::vector<std::vector<uint8_t>> input_buffers;
+    for (int i = 0; i < frames; i++) {
+      xvc_test::TestYuvPic orig_pic(width, height, input_bitdepth, i, i);
+      input_buffers.push_back(orig_pic.GetBytes());
+      orig_pics_.emplace_back(std::move(orig_pic));
+      verified_.push_back(false);
+    }
+    auto release = [](void *opaque, const uint8_t *plane) {
+      EXPECT_EQ(api_thread_id, std::this_thread::get_id());
+      auto *buffers =
+        reinterpret_cast<std::vector<std::vector<uint8_t>>*>(opaque);
+      for (std::vector<uint8_t> &buffer : *buffers) {
+        if (&buffer[0] == plane) {
+          std::fill(buffer.begin(), buffer.end(), static_cast<uint8_t>(0));
+          buffer[0] = 1;
+          return;
+        }
+      }
+      FAIL() << "Unknown input released";
+    };
+    for (int i = 0; i < frames; i++) {
+      const uint8_t *luma = &input_buffers[i][0];
+      xvc::Encoder::PicPlanes planes = {
+        std::make_pair(luma, width * sample_size),
+        std::make_pair(luma + width * height * sample_size,
+                       chroma_width * sample_size),
+        std::make_pair(luma + width * height * sample_size * 5 / 4,
+                       chroma_width * sample_size)
+      };
+      xvc_enc_pic_buffer rec_pic;
+      EXPECT_TRUE(encoder_->Encode(planes, release, &input_buffers, &rec_pic));
+      for (xvc_enc_nal_unit &nal_unit : encoder_->GetOutputNals()) {
+        encoded_nal_units_.push_back(
+          xvc_test::NalUnit(nal_unit.bytes, nal_unit.bytes + nal_unit.size));
+        encoded_pocs_.push_back(nal_unit.stats.poc);
+      }
+      if (rec_pic.size > 0) {
+        rec_pics_.emplace_back(rec_pic.pic, rec_pic.pic + rec_pic.size);
+      }
+    }
+    for (xvc_enc_nal_stats stats : EncoderFlush()) {
+      encoded_pocs_.push_back(stats.poc);
+    }
+    // All input must have been released after flush
+    for (const std::vector<uint8_t> &buffer : input_buffers) {
+      EXPECT_EQ(1, buffer[0]);
+      EXPECT_EQ(0, buffer[1]);
+    }
+  }
+
   void Decode(int width, int height, int frames, bool do_flush = true) {
     DecodeSegmentHeaderSuccess(GetNextNalToDecode());
     encoded_pocs_.pop_front();
@@ -92,6 +179,43 @@ protected:
     }
   }
 
+  // Decodes as Decode with on_picture invoked before decoding each picture,
+  // returns the memory usage after each decoded picture
+  std::vector<xvc_dec_memory_usage>
+    DecodeWithMemoryUsage(int width, int height, int frames,
+                          const std::function<void(int)> &on_picture) {
+    std::vector<xvc_dec_memory_usage> usage(frames);
+    DecodeSegmentHeaderSuccess(GetNextNalToDecode());
+    encoded_pocs_.pop_front();
+    for (int i = 0; i < frames; i++) {
+      on_picture(i);
+      int64_t user_data = kPocOffset + encoded_pocs_.front();
+      encoded_pocs_.pop_front();
+      if (DecodePictureSuccess(GetNextNalToDecode(), user_data)) {
+        VerifyPicture(width, height, last_decoded_picture_);
+        while (decoder_->GetDecodedPicture(&last_decoded_picture_)) {
+          VerifyPicture(width, height, last_decoded_picture_);
+        }
+      }
+      decoder_->GetMemoryUsage(&usage[i]);
+    }
+    while (DecoderFlushAndGet()) {
+      VerifyPicture(width, height, last_decoded_picture_);
+    }
+    return usage;
+  }
+
+  static std::vector<size_t>
+    GetNumRecPics(const std::vector<xvc_dec_memory_usage> &usage) {
+    // Exactly one picture is buffered after the first picture
+    std::vector<size_t> num_rec_pics;
+    for (const xvc_dec_memory_usage &pic_usage : usage) {
+      num_rec_pics.push_back(pic_usage.reconstructed_pictures /
+                             usage[0].reconstructed_pictures);
+    }
+    return num_rec_pics;
+  }
+
   void VerifyPicture(int width, int height,
                      const xvc_decoded_picture &decoded_picture) {
     int poc = decoded_picture.stats.poc;
@@ -110,6 +234,41 @@ protected:
     }
   }
 
+  // Packs the planes of a picture that was output without copy
+  std::vector<char> PackPicture(int width, int height,
+                                const xvc_decoded_picture &decoded_picture) {
+    const int sample_size = decoded_picture.stats.bitdepth == 8 ? 1 : 2;
+    std::vector<char> packed;
+    for (int c = 0; c < 3; c++) {
+      const int plane_width = (c == 0 ? width : width / 2) * sample_size;
+      const int plane_height = c == 0 ? height : height / 2;
+      for (int y = 0; y < plane_height; y++) {
+        const char *src =
+          decoded_picture.planes[c] + y * decoded_picture.stride[c];
+        packed.insert(packed.end(), src, src + plane_width);
+      }
+    }
+    return packed;
+  }
+
+  void VerifyZeroCopyPicture(int width, int height,
+                             const xvc_decoded_picture &decoded_picture) {
+    const int sample_size = decoded_picture.stats.bitdepth == 8 ? 1 : 2;
+    std::vector<char> packed = PackPicture(width, height, decoded_picture);
+    xvc_decoded_picture packed_picture = decoded_picture;
+    packed_picture.bytes = &packed[0];
+    packed_picture.size = packed.size();
+    packed_picture.stride[0] = width * sample_size;
+    packed_picture.stride[1] = width / 2 * sample_size;
+    packed_picture.stride[2] = width / 2 * sample_size;
+    packed_picture.planes[0] = packed_picture.bytes;
+    packed_picture.planes[1] =
+      packed_picture.planes[0] + packed_picture.stride[0] * height;
+    packed_picture.planes[2] =
+      packed_picture.planes[1] + packed_picture.stride[1] * height / 2;
+    VerifyPicture(width, height, packed_picture);
+  }
+
   std::vector<xvc_test::TestYuvPic> orig_pics_;
   std::vector<bool> verified_;
   std::list<int> encoded_pocs_;
@@ -137,6 +296,197 @@ TEST_P(EncodeDecodeTest, LowDelayTwoSubGop24x24) {
   Decode(24, 24, nbr_pictures);
 }
 
+TEST_P(EncodeDecodeTest, TwoSubGop24x24ReferencedInput) {
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  EncodeReferenced(24, 24, nbr_pictures);
+  Decode(24, 24, nbr_pictures);
+}
+
+TEST_P(EncodeDecodeTest, TwoSubGop24x24ReferencedInputLookahead) {
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  xvc::EncoderSettings encoder_settings = GetTestEncoderSettings();
+  encoder_settings.lookahead = 1;
+  SetupEncoder(encoder_settings);
+  EncodeReferenced(24, 24, nbr_pictures);
+  Decode(24, 24, nbr_pictures);
+}
+
+TEST_P(EncodeDecodeTest, TwoSubGop20x24ReferencedInputWithoutPadding) {
+  // Internal width is rounded up, so the input can not be used in place
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  xvc::EncoderSettings encoder_settings = GetTestEncoderSettings();
+  encoder_settings.source_padding = 0;
+  SetupEncoder(encoder_settings);
+  EncodeReferenced(20, 24, nbr_pictures);
+  // Reconstruction is output at the internal size, only verify the quality
+  DecodeSegmentHeaderSuccess(GetNextNalToDecode());
+  encoded_pocs_.pop_front();
+  int num_decoded = 0;
+  auto verify_picture = [&](const xvc_decoded_picture &decoded_picture) {
+    const int poc = decoded_picture.stats.poc;
+    ASSERT_NO_FATAL_FAILURE(AssertValidPicture420(20, 24, decoded_picture));
+    EXPECT_GE(orig_pics_[poc].CalcPsnr(decoded_picture.bytes), kPsnrThreshold)
+      << "Picture poc " << poc;
+    verified_[poc] = true;
+    num_decoded++;
+  };
+  for (int i = 0; i < nbr_pictures; i++) {
+    int64_t user_data = kPocOffset + encoded_pocs_.front();
+    encoded_pocs_.pop_front();
+    if (DecodePictureSuccess(GetNextNalToDecode(), user_data)) {
+      verify_picture(last_decoded_picture_);
+    }
+  }
+  while (DecoderFlushAndGet()) {
+    verify_picture(last_decoded_picture_);
+  }
+  EXPECT_EQ(nbr_pictures, num_decoded);
+}
+
+TEST_P(EncodeDecodeTest, TwoSubGop24x24ZeroCopyOutput) {
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  decoder_->SetZeroCopyOutput(true);
+  Encode(24, 24, nbr_pictures);
+  DecodeSegmentHeaderSuccess(GetNextNalToDecode());
+  encoded_pocs_.pop_front();
+  // Hold on to all pictures output without copy until the end
+  std::vector<xvc_decoded_picture> held_pictures;
+  auto verify_picture = [&](const xvc_decoded_picture &decoded_picture) {
+    if (decoded_picture.size == 0 && decoded_picture.planes[0]) {
+      VerifyZeroCopyPicture(24, 24, decoded_picture);
+      held_pictures.push_back(decoded_picture);
+    } else {
+      VerifyPicture(24, 24, decoded_picture);
+    }
+  };
+  for (int i = 0; i < nbr_pictures; i++) {
+    int64_t user_data = kPocOffset + encoded_pocs_.front();
+    encoded_pocs_.pop_front();
+    if (DecodePictureSuccess(GetNextNalToDecode(), user_data)) {
+      verify_picture(last_decoded_picture_);
+    }
+  }
+  while (DecoderFlushAndGet()) {
+    verify_picture(last_decoded_picture_);
+  }
+  if ((GetParam().internal_bitdepth > 8) == (sizeof(xvc::Sample) > 1)) {
+    EXPECT_EQ(nbr_pictures, static_cast<int>(held_pictures.size()));
+  }
+  // Pictures must remain intact while held by application
+  for (const xvc_decoded_picture &held_picture : held_pictures) {
+    const int poc = held_picture.stats.poc;
+    std::vector<char> packed = PackPicture(24, 24, held_picture);
+    EXPECT_TRUE(xvc_test::TestYuvPic::SamePictureBytes(
+      &rec_pics_[poc][0], rec_pics_[poc].size(),
+      reinterpret_cast<const uint8_t*>(&packed[0]), packed.size()));
+  }
+  for (const xvc_decoded_picture &held_picture : held_pictures) {
+    EXPECT_TRUE(decoder_->ReleaseDecodedPicture(&held_picture));
+    EXPECT_FALSE(decoder_->ReleaseDecodedPicture(&held_picture));
+  }
+}
+
+TEST_P(EncodeDecodeTest, TwoSubGop24x24MemoryLimit) {
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  const int sample_size = GetParam().internal_bitdepth == 8 ? 1 : 2;
+  const size_t output_pic_bytes = 24 * 24 * 3 / 2 * sample_size;
+  // Only the pictures of one sub gop and their references must be buffered
+  const size_t min_num_pics = kSubGopLength + 1 + encoder_->GetNumRefPics();
+  decoder_->SetAdditionalDecoderBuffers(4);
+  // Smaller than any picture, only the required buffering is kept
+  decoder_->SetMaxMemory(1);
+  Encode(24, 24, nbr_pictures);
+  std::vector<size_t> num_rec_pics = GetNumRecPics(
+    DecodeWithMemoryUsage(24, 24, nbr_pictures, [](int pic_idx) {}));
+  for (size_t num_pics : num_rec_pics) {
+    EXPECT_LE(num_pics, min_num_pics);
+  }
+  xvc_dec_memory_usage usage;
+  decoder_->GetMemoryUsage(&usage);
+  EXPECT_GT(usage.reconstructed_pictures, 0U);
+  EXPECT_EQ(output_pic_bytes, usage.output_pictures);
+  EXPECT_EQ(usage.reconstructed_pictures + usage.alternative_pictures +
+            usage.picture_data + usage.output_pictures + usage.nal_units,
+            usage.total);
+}
+
+TEST_P(EncodeDecodeTest, TwoSubGop24x24MemoryLimitChanged) {
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  const int sample_size = GetParam().internal_bitdepth == 8 ? 1 : 2;
+  const size_t output_pic_bytes = 24 * 24 * 3 / 2 * sample_size;
+  const size_t min_num_pics = kSubGopLength + 1 + encoder_->GetNumRefPics();
+  // Set once more pictures are buffered than allowed by the limit
+  const int limit_begin = kSubGopLength + 4;
+  const int limit_end = nbr_pictures - 2;
+  decoder_->SetAdditionalDecoderBuffers(kSubGopLength);
+  Encode(24, 24, nbr_pictures);
+  std::vector<xvc_dec_memory_usage> usage =
+    DecodeWithMemoryUsage(24, 24, nbr_pictures, [&](int pic_idx) {
+    if (pic_idx == limit_begin) {
+      decoder_->SetMaxMemory(1);
+    } else if (pic_idx == limit_end) {
+      decoder_->SetMaxMemory(0);
+    }
+  });
+  std::vector<size_t> num_rec_pics = GetNumRecPics(usage);
+  // Buffering above the limit is released as soon as the pictures have
+  // been output, pictures waiting for output when the limit is set are kept
+  EXPECT_GT(num_rec_pics[limit_begin - 1], min_num_pics);
+  EXPECT_LE(num_rec_pics[limit_begin], num_rec_pics[limit_begin - 1]);
+  for (int i = limit_begin + 1; i < limit_end; i++) {
+    EXPECT_LE(num_rec_pics[i], min_num_pics) << "Picture " << i;
+  }
+  // Output conversion is no longer deferred once the limit is lifted
+  for (int i = limit_end; i < nbr_pictures; i++) {
+    EXPECT_EQ(usage[i - 1].output_pictures + output_pic_bytes,
+              usage[i].output_pictures) << "Picture " << i;
+  }
+}
+
+TEST_P(EncodeDecodeTest, TwoSubGop24x24ReferencedNals) {
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  Encode(24, 24, nbr_pictures);
+  // Each nal is decoded from its own buffer that is cleared when released
+  std::vector<std::vector<uint8_t>> nal_buffers(encoded_nal_units_.begin(),
+                                                encoded_nal_units_.end());
+  auto release = [](void *opaque, const uint8_t *nal_unit) {
+    auto *buffers = reinterpret_cast<std::vector<std::vector<uint8_t>>*>(
+      opaque);
+    for (std::vector<uint8_t> &buffer : *buffers) {
+      if (!buffer.empty() && &buffer[0] == nal_unit) {
+        buffer.clear();
+        return;
+      }
+    }
+    FAIL() << "Unknown nal released";
+  };
+  for (size_t i = 0; i < nal_buffers.size(); i++) {
+    std::vector<uint8_t> &buffer = nal_buffers[i];
+    const size_t nal_size = buffer.size();
+    xvc::NalBuffer nal_buffer(&buffer[0], nal_size, release, &nal_buffers);
+    int64_t user_data = kPocOffset + encoded_pocs_.front();
+    encoded_pocs_.pop_front();
+    EXPECT_EQ(nal_size, decoder_->DecodeNal(&nal_buffer, user_data));
+    // First nal is the segment header
+    if (i > 0 && decoder_->GetDecodedPicture(&last_decoded_picture_)) {
+      VerifyPicture(24, 24, last_decoded_picture_);
+    }
+  }
+  while (DecoderFlushAndGet()) {
+    VerifyPicture(24, 24, last_decoded_picture_);
+  }
+  for (const std::vector<uint8_t> &buffer : nal_buffers) {
+    EXPECT_TRUE(buffer.empty());
+  }
+}
+
 TEST_P(EncodeDecodeTest, SingleSegment16x16) {
   if (!GetParam().use_leading_pictures) {
     Encode(16, 16, kSegmentLength + 1);
@@ -148,13 +498,140 @@ TEST_P(EncodeDecodeTest, SingleSegment16x16) {
   }
 }
 
+class EncoderSettingsTest : public ::testing::Test,
+  public ::xvc_test::EncoderHelper {
+protected:
+  static xvc::EncoderSettings
+    GetEncoderSettings(xvc::SpeedMode speed_mode,
+                       const std::string &explicit_settings) {
+    xvc::EncoderSettings encoder_settings;
+    encoder_settings.Initialize(speed_mode);
+    encoder_settings.Tune(xvc::TuneMode::kPsnr);
+    encoder_settings.ParseExplicitSettings(explicit_settings);
+    return encoder_settings;
+  }
+
+  std::vector<xvc_test::NalUnit>
+    EncodeTwoSubGops(const xvc::EncoderSettings &encoder_settings) {
+    SetupEncoder(encoder_settings, 24, 24, 8, kQp);
+    encoder_->SetSubGopLength(kSubGopLength);
+    encoder_->SetSegmentLength(kSegmentLength);
+    encoded_nal_units_.clear();
+    for (int i = 0; i < kSubGopLength * 2 + 1; i++) {
+      xvc_test::TestYuvPic orig_pic(24, 24, 8, i, i);
+      EncodeOneFrame(orig_pic.GetBytes(), orig_pic.GetBitdepth());
+    }
+    EncoderFlush();
+    return encoded_nal_units_;
+  }
+};
+
+TEST_F(EncoderSettingsTest, UltraFastDisablesAffine) {
+  SetupEncoder(GetEncoderSettings(xvc::SpeedMode::kUltraFast, ""), 24, 24, 8,
+               kQp);
+  EXPECT_TRUE(encoder_->GetCurrentSegment()->restrictions
+              .disable_ext2_inter_affine);
+  SetupEncoder(GetEncoderSettings(xvc::SpeedMode::kUltraFast,
+                                  "fast_inter_affine 0"), 24, 24, 8, kQp);
+  EXPECT_FALSE(encoder_->GetCurrentSegment()->restrictions
+               .disable_ext2_inter_affine);
+}
+
+TEST_F(EncoderSettingsTest, UltraFastDisablesRdoQuant) {
+  xvc::EncoderSettings ultra_fast =
+    GetEncoderSettings(xvc::SpeedMode::kUltraFast, "");
+  EXPECT_EQ(0, ultra_fast.rdo_quant);
+  EXPECT_NE(EncodeTwoSubGops(ultra_fast),
+            EncodeTwoSubGops(GetEncoderSettings(xvc::SpeedMode::kUltraFast,
+                                                "rdo_quant 1")));
+}
+
+TEST_F(EncoderSettingsTest, InterPredCacheDoesNotChangeBitstream) {
+  for (xvc::SpeedMode speed_mode : { xvc::SpeedMode::kSlow,
+                                     xvc::SpeedMode::kFast }) {
+    xvc::EncoderSettings cached = GetEncoderSettings(speed_mode, "");
+    EXPECT_EQ(1, cached.inter_pred_cache);
+    EXPECT_EQ(EncodeTwoSubGops(cached),
+              EncodeTwoSubGops(GetEncoderSettings(speed_mode,
+                                                  "inter_pred_cache 0")));
+  }
+}
+
+TEST_F(EncoderSettingsTest, BipredUniCostRatioSkipsBipredSearch) {
+  xvc::EncoderSettings all_bipred =
+    GetEncoderSettings(xvc::SpeedMode::kSlow, "");
+  EXPECT_EQ(0, all_bipred.fast_bipred_uni_cost_ratio);
+  // Only evaluate bi-prediction when both lists give the same cost
+  EXPECT_NE(EncodeTwoSubGops(all_bipred),
+            EncodeTwoSubGops(GetEncoderSettings(xvc::SpeedMode::kSlow,
+              "fast_bipred_uni_cost_ratio 100")));
+  EXPECT_EQ(EncodeTwoSubGops(all_bipred),
+            EncodeTwoSubGops(GetEncoderSettings(xvc::SpeedMode::kSlow,
+              "fast_bipred_uni_cost_ratio 1000000")));
+}
+
+TEST_F(EncoderSettingsTest, BipredRefinementRatioStopsRefinement) {
+  xvc::EncoderSettings placebo =
+    GetEncoderSettings(xvc::SpeedMode::kPlacebo, "");
+  EXPECT_GT(placebo.bipred_refinement_iterations, 1);
+  EXPECT_GT(placebo.fast_bipred_refinement_ratio, 0);
+  // Stop refining as soon as bi-prediction is worse than uni-prediction
+  EXPECT_NE(EncodeTwoSubGops(placebo),
+            EncodeTwoSubGops(GetEncoderSettings(xvc::SpeedMode::kPlacebo,
+              "fast_bipred_refinement_ratio 1")));
+  EXPECT_EQ(EncodeTwoSubGops(GetEncoderSettings(xvc::SpeedMode::kPlacebo,
+              "fast_bipred_refinement_ratio 0")),
+            EncodeTwoSubGops(GetEncoderSettings(xvc::SpeedMode::kPlacebo,
+              "fast_bipred_refinement_ratio 1000000")));
+}
+
+// Runs with each of the encoder speed settings in addition to the defaults
+class EncodeDecodeSettingsTest : public EncodeDecodeTest {
+};
+
+TEST_P(EncodeDecodeSettingsTest, TwoSubGop24x24) {
+  const int nbr_pictures = kSubGopLength * 2 +
+    (!GetParam().use_leading_pictures ? 1 : 0);
+  Encode(24, 24, nbr_pictures);
+  Decode(24, 24, nbr_pictures);
+}
+
+std::vector<TestParam> GetSettingsTestParams(int internal_bitdepth) {
+  static const xvc::SpeedMode kSlow = xvc::SpeedMode::kSlow;
+  static const std::vector<std::pair<xvc::SpeedMode, const char*>>
+    kSettings = {
+    { kSlow, "fast_rate_estimation 1" },
+    { xvc::SpeedMode::kUltraFast, "" },
+    { kSlow, "fast_cu_split_prediction 1" },
+    { kSlow, "fast_skip_detection 64" },
+    { kSlow, "fast_bipred_uni_cost_ratio 150" },
+    { kSlow, "lookahead 1" },
+    { kSlow, "lookahead 1 lookahead_depth 5" },
+    { kSlow, "subpel_plane_cache 2" },
+  };
+  std::vector<TestParam> params;
+  for (const auto &settings : kSettings) {
+    for (bool use_leading_pictures : { false, true }) {
+      params.push_back({ internal_bitdepth, use_leading_pictures,
+                       settings.first, settings.second });
+    }
+  }
+  return params;
+}
+
 INSTANTIATE_TEST_CASE_P(NormalBitdepth, EncodeDecodeTest,
-                        ::testing::Values(TestParam({ 8, false }),
-                                          TestParam({ 8, true })));
+                        ::testing::Values(
+                          TestParam({ 8, false, xvc::SpeedMode::kSlow, "" }),
+                          TestParam({ 8, true, xvc::SpeedMode::kSlow, "" })));
+INSTANTIATE_TEST_CASE_P(NormalBitdepth, EncodeDecodeSettingsTest,
+                        ::testing::ValuesIn(GetSettingsTestParams(8)));
 #if XVC_HIGH_BITDEPTH
 INSTANTIATE_TEST_CASE_P(HighBitdepth, EncodeDecodeTest,
-                        ::testing::Values(TestParam({ 10, false }),
-                                          TestParam({ 10, true })));
+                        ::testing::Values(
+                          TestParam({ 10, false, xvc::SpeedMode::kSlow, "" }),
+                          TestParam({ 10, true, xvc::SpeedMode::kSlow, "" })));
+INSTANTIATE_TEST_CASE_P(HighBitdepth, EncodeDecodeSettingsTest,
+                        ::testing::ValuesIn(GetSettingsTestParams(10)));
 #endif
 
 }   // namespace
@@ -19,10 +19,18 @@
 * Please visit https://xvc.io/license/ for more information.
 ******************************************************************************/
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "googletest/include/gtest/gtest.h"
 
 #include "xvc_common_lib/common.h"
 #include "xvc_common_lib/checksum.h"
+#include "xvc_common_lib/picture_types.h"
+#include "xvc_dec_lib/xvcdec.h"
 #include "xvc_enc_lib/xvcenc.h"
 
 namespace {
@@ -170,6 +178,37 @@ TEST(EncoderAPI, ParamCheck) {
   params->checksum_mode = static_cast<int>(xvc::Checksum::Mode::kTotalNumber);
   EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
 
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->picture_alloc = [](void *opaque, size_t size, size_t alignment) {
+    return static_cast<void*>(nullptr);
+  };
+  EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
+
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->lookahead = 2;
+  EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
+
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->lookahead_depth = -1;
+  EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
+
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->leading_pictures = 2;
+  EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
+
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->target_bitrate = -1;
+  EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
+
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->target_bitrate = 2000;
+  params->max_bitrate = 1000;
+  EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
+
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->vbv_buffer_size = 1000;
+  EXPECT_EQ(XVC_ENC_INVALID_PARAMETER, api->parameters_check(params));
+
   EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
   EXPECT_EQ(XVC_ENC_OK, api->parameters_check(params));
   EXPECT_EQ(XVC_ENC_OK, api->parameters_destroy(params));
@@ -224,6 +263,154 @@ TEST(EncoderAPI, EncoderEncode) {
   EXPECT_EQ(XVC_ENC_OK, api->encoder_destroy(encoder));
 }
 
+TEST(EncoderAPI, EncoderPictureAllocator) {
+  struct AllocStats {
+    int num_alloc = 0;
+    int num_free = 0;
+    bool aligned = true;
+  } stats;
+  const xvc_encoder_api *api = xvc_encoder_api_get();
+  xvc_encoder_parameters *params = api->parameters_create();
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->width = 176;
+  params->height = 144;
+  params->picture_alloc_opaque = &stats;
+  params->picture_alloc = [](void *opaque, size_t size, size_t alignment) {
+    AllocStats *alloc_stats = static_cast<AllocStats*>(opaque);
+    alloc_stats->num_alloc++;
+    alloc_stats->aligned &= alignment >= 64;
+    // Over-allocate and keep the original pointer just before the result
+    void *base = malloc(size + alignment + sizeof(void*));
+    uintptr_t addr = reinterpret_cast<uintptr_t>(base) + sizeof(void*);
+    addr = (addr + alignment - 1) & ~(alignment - 1);
+    reinterpret_cast<void**>(addr)[-1] = base;
+    return reinterpret_cast<void*>(addr);
+  };
+  params->picture_free = [](void *opaque, void *ptr) {
+    static_cast<AllocStats*>(opaque)->num_free++;
+    free(static_cast<void**>(ptr)[-1]);
+  };
+  xvc_encoder *encoder = api->encoder_create(params);
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_destroy(params));
+  ASSERT_NE(encoder, nullptr);
+  std::vector<uint8_t> pic(176 * 144 * 3 / 2, 128);
+  xvc_enc_nal_unit *nal_units;
+  int num_nal_units;
+  EXPECT_EQ(XVC_ENC_OK, api->encoder_encode(encoder, &pic[0], &nal_units,
+                                            &num_nal_units, nullptr));
+  EXPECT_EQ(XVC_ENC_OK, api->encoder_destroy(encoder));
+  EXPECT_GT(stats.num_alloc, 0);
+  EXPECT_EQ(stats.num_alloc, stats.num_free);
+  EXPECT_TRUE(stats.aligned);
+}
+
+TEST(EncoderAPI, EncoderCuSplitStats) {
+  const int kWidth = 64;
+  const int kHeight = 64;
+  std::vector<xvc_enc_cu_split_stats> stats;
+  const xvc_encoder_api *api = xvc_encoder_api_get();
+  xvc_encoder_parameters *params = api->parameters_create();
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->width = kWidth;
+  params->height = kHeight;
+  params->cu_split_stats_opaque = &stats;
+  params->cu_split_stats = [](void *opaque,
+                              const xvc_enc_cu_split_stats *cu_stats) {
+    static_cast<std::vector<xvc_enc_cu_split_stats>*>(opaque)
+      ->push_back(*cu_stats);
+  };
+  xvc_encoder *encoder = api->encoder_create(params);
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_destroy(params));
+  ASSERT_NE(encoder, nullptr);
+  std::vector<uint8_t> pic(kWidth * kHeight * 3 / 2, 128);
+  for (int y = 0; y < kHeight; y++) {
+    for (int x = 0; x < kWidth; x++) {
+      pic[y * kWidth + x] = static_cast<uint8_t>(x < y ? 2 * x : 255 - 3 * y);
+    }
+  }
+  xvc_enc_nal_unit *nal_units;
+  int num_nal_units;
+  EXPECT_EQ(XVC_ENC_OK, api->encoder_encode(encoder, &pic[0], &nal_units,
+                                            &num_nal_units, nullptr));
+  while (api->encoder_flush(encoder, &nal_units, &num_nal_units,
+                            nullptr) == XVC_ENC_OK) {
+  }
+  EXPECT_EQ(XVC_ENC_OK, api->encoder_destroy(encoder));
+  ASSERT_FALSE(stats.empty());
+  for (const xvc_enc_cu_split_stats &cu_stats : stats) {
+    EXPECT_EQ(1, cu_stats.intra_pic);
+    EXPECT_GE(cu_stats.log2_area, 4);
+    EXPECT_LE(cu_stats.log2_area, 12);
+    EXPECT_GE(cu_stats.cost_per_sample, 0);
+    EXPECT_LE(cu_stats.split_gain, 1000);
+  }
+}
+
+std::vector<xvc_enc_cu_split_stats>
+EncodeStaticPictures(int num_pics, const std::string &explicit_settings) {
+  const int kWidth = 64;
+  const int kHeight = 64;
+  std::vector<xvc_enc_cu_split_stats> stats;
+  std::string settings(explicit_settings);
+  const xvc_encoder_api *api = xvc_encoder_api_get();
+  xvc_encoder_parameters *params = api->parameters_create();
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_set_default(params));
+  params->width = kWidth;
+  params->height = kHeight;
+  params->explicit_encoder_settings = &settings[0];
+  params->cu_split_stats_opaque = &stats;
+  params->cu_split_stats = [](void *opaque,
+                              const xvc_enc_cu_split_stats *cu_stats) {
+    static_cast<std::vector<xvc_enc_cu_split_stats>*>(opaque)
+      ->push_back(*cu_stats);
+  };
+  xvc_encoder *encoder = api->encoder_create(params);
+  EXPECT_EQ(XVC_ENC_OK, api->parameters_destroy(params));
+  EXPECT_NE(encoder, nullptr);
+  if (!encoder) {
+    return stats;
+  }
+  std::vector<uint8_t> pic(kWidth * kHeight * 3 / 2, 128);
+  for (int y = 0; y < kHeight; y++) {
+    for (int x = 0; x < kWidth; x++) {
+      pic[y * kWidth + x] = static_cast<uint8_t>((x * x + 3 * y * y) >> 3);
+    }
+  }
+  xvc_enc_nal_unit *nal_units;
+  int num_nal_units;
+  for (int poc = 0; poc < num_pics; poc++) {
+    EXPECT_EQ(XVC_ENC_OK, api->encoder_encode(encoder, &pic[0], &nal_units,
+                                              &num_nal_units, nullptr));
+  }
+  while (api->encoder_flush(encoder, &nal_units, &num_nal_units,
+                            nullptr) == XVC_ENC_OK) {
+  }
+  EXPECT_EQ(XVC_ENC_OK, api->encoder_destroy(encoder));
+  return stats;
+}
+
+TEST(EncoderAPI, EarlySkipTerminatesStaticPictures) {
+  const int kNumPics = 5;
+  const std::vector<xvc_enc_cu_split_stats> stats_off =
+    EncodeStaticPictures(kNumPics, "fast_skip_detection 0");
+  const std::vector<xvc_enc_cu_split_stats> stats_on =
+    EncodeStaticPictures(kNumPics, "fast_skip_detection 64");
+  int num_inter_cus = 0;
+  int num_early_skip = 0;
+  for (const xvc_enc_cu_split_stats &cu_stats : stats_on) {
+    if (!cu_stats.intra_pic) {
+      num_inter_cus++;
+      num_early_skip += cu_stats.early_skip_termination;
+      EXPECT_TRUE(!cu_stats.early_skip_termination || cu_stats.skip);
+    }
+  }
+  ASSERT_GT(num_inter_cus, 0);
+  EXPECT_GT(num_early_skip, 0);
+  for (const xvc_enc_cu_split_stats &cu_stats : stats_off) {
+    EXPECT_EQ(0, cu_stats.early_skip_termination);
+  }
+}
+
 TEST(EncoderAPI, EncoderFlush) {
   const xvc_encoder_api *api = xvc_encoder_api_get();
 
@@ -251,4 +438,304 @@ TEST(EncoderAPI, EncoderFlush) {
   EXPECT_EQ(XVC_ENC_OK, api->encoder_destroy(encoder));
 }
 
+TEST(EncoderAPI, EncodeDecodeInternalBitdepth) {
+  const int kWidth = 32;
+  const int kHeight = 32;
+  const int kNumPics = 3;
+  const xvc_encoder_api *enc_api = xvc_encoder_api_get();
+  const xvc_decoder_api *dec_api = xvc_decoder_api_get();
+  const int max_bitdepth = sizeof(xvc::Sample) > 1 ? 10 : 8;
+  // 8bit content is handled by a separate sample pipeline when available,
+  // the reconstruction must still match the decoder output in both cases
+  for (int bitdepth = 8; bitdepth <= max_bitdepth; bitdepth += 2) {
+    xvc_encoder_parameters *enc_params = enc_api->parameters_create();
+    EXPECT_EQ(XVC_ENC_OK, enc_api->parameters_set_default(enc_params));
+    enc_params->width = kWidth;
+    enc_params->height = kHeight;
+    enc_params->input_bitdepth = 8;
+    enc_params->internal_bitdepth = bitdepth;
+    enc_params->sub_gop_length = 1;
+    enc_params->speed_mode = 2;
+    xvc_encoder *encoder = enc_api->encoder_create(enc_params);
+    EXPECT_EQ(XVC_ENC_OK, enc_api->parameters_destroy(enc_params));
+    ASSERT_NE(encoder, nullptr);
+
+    xvc_decoder_parameters *dec_params = dec_api->parameters_create();
+    EXPECT_EQ(XVC_DEC_OK, dec_api->parameters_set_default(dec_params));
+    dec_params->output_bitdepth = bitdepth;
+    xvc_decoder *decoder = dec_api->decoder_create(dec_params);
+    EXPECT_EQ(XVC_DEC_OK, dec_api->parameters_destroy(dec_params));
+    ASSERT_NE(decoder, nullptr);
+
+    std::vector<std::vector<uint8_t>> rec_pics;
+    std::vector<uint8_t> pic(kWidth * kHeight * 3 / 2);
+    xvc_enc_nal_unit *nal_units;
+    int num_nal_units;
+    xvc_enc_pic_buffer rec_pic = { 0 };
+    for (int poc = 0; poc <= kNumPics; poc++) {
+      xvc_enc_return_code ret;
+      if (poc < kNumPics) {
+        for (size_t i = 0; i < pic.size(); i++) {
+          pic[i] = static_cast<uint8_t>((i * 7 + poc * 13) & 255);
+        }
+        ret = enc_api->encoder_encode(encoder, &pic[0], &nal_units,
+                                      &num_nal_units, &rec_pic);
+        EXPECT_EQ(XVC_ENC_OK, ret);
+      } else {
+        ret = enc_api->encoder_flush(encoder, &nal_units, &num_nal_units,
+                                     &rec_pic);
+      }
+      do {
+        for (int i = 0; i < num_nal_units; i++) {
+          EXPECT_EQ(XVC_DEC_OK,
+                    dec_api->decoder_decode_nal(decoder, nal_units[i].bytes,
+                                                nal_units[i].size, 0));
+        }
+        if (rec_pic.size > 0) {
+          rec_pics.emplace_back(rec_pic.pic, rec_pic.pic + rec_pic.size);
+          rec_pic.size = 0;
+        }
+      } while (poc == kNumPics && ret == XVC_ENC_OK &&
+               (ret = enc_api->encoder_flush(encoder, &nal_units,
+                                             &num_nal_units, &rec_pic)) ==
+               XVC_ENC_OK);
+    }
+    EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_flush(decoder));
+    ASSERT_EQ(kNumPics, static_cast<int>(rec_pics.size()));
+
+    xvc_decoded_picture *dec_pic = dec_api->picture_create(decoder);
+    for (int poc = 0; poc < kNumPics; poc++) {
+      ASSERT_EQ(XVC_DEC_OK, dec_api->decoder_get_picture(decoder, dec_pic));
+      EXPECT_EQ(bitdepth, dec_pic->stats.bitstream_bitdepth);
+      ASSERT_EQ(rec_pics[poc].size(), dec_pic->size);
+      EXPECT_EQ(0, std::memcmp(&rec_pics[poc][0], dec_pic->bytes,
+                               dec_pic->size));
+    }
+    EXPECT_EQ(XVC_DEC_OK, dec_api->picture_destroy(dec_pic));
+    EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_check_conformance(decoder,
+                                                              nullptr));
+    EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_destroy(decoder));
+    EXPECT_EQ(XVC_ENC_OK, enc_api->encoder_destroy(encoder));
+  }
+}
+
+static void EncodeSegment(int bitdepth, int num_pics,
+                          std::vector<std::vector<uint8_t>> *nals,
+                          std::vector<std::vector<uint8_t>> *rec_pics,
+                          int sub_gop_length = 1,
+                          int max_keypic_distance = 640) {
+  const int kWidth = 32;
+  const int kHeight = 32;
+  const xvc_encoder_api *enc_api = xvc_encoder_api_get();
+  xvc_encoder_parameters *enc_params = enc_api->parameters_create();
+  EXPECT_EQ(XVC_ENC_OK, enc_api->parameters_set_default(enc_params));
+  enc_params->width = kWidth;
+  enc_params->height = kHeight;
+  enc_params->input_bitdepth = 8;
+  enc_params->internal_bitdepth = bitdepth;
+  enc_params->sub_gop_length = sub_gop_length;
+  enc_params->max_keypic_distance = max_keypic_distance;
+  enc_params->speed_mode = 2;
+  xvc_encoder *encoder = enc_api->encoder_create(enc_params);
+  EXPECT_EQ(XVC_ENC_OK, enc_api->parameters_destroy(enc_params));
+  ASSERT_NE(encoder, nullptr);
+  std::vector<uint8_t> pic(kWidth * kHeight * 3 / 2);
+  xvc_enc_nal_unit *nal_units;
+  int num_nal_units;
+  xvc_enc_pic_buffer rec_pic = { 0 };
+  xvc_enc_return_code ret = XVC_ENC_OK;
+  for (int poc = 0; poc <= num_pics && ret == XVC_ENC_OK; poc++) {
+    if (poc < num_pics) {
+      for (size_t i = 0; i < pic.size(); i++) {
+        pic[i] = static_cast<uint8_t>((i * 5 + poc * 11 + bitdepth) & 255);
+      }
+      EXPECT_EQ(XVC_ENC_OK,
+                enc_api->encoder_encode(encoder, &pic[0], &nal_units,
+                                        &num_nal_units, &rec_pic));
+    } else {
+      ret = enc_api->encoder_flush(encoder, &nal_units, &num_nal_units,
+                                   &rec_pic);
+      poc--;
+    }
+    for (int i = 0; i < num_nal_units; i++) {
+      nals->emplace_back(nal_units[i].bytes,
+                         nal_units[i].bytes + nal_units[i].size);
+    }
+    if (rec_pic.size > 0) {
+      rec_pics->emplace_back(rec_pic.pic, rec_pic.pic + rec_pic.size);
+      rec_pic.size = 0;
+    }
+  }
+  EXPECT_EQ(XVC_ENC_OK, enc_api->encoder_destroy(encoder));
+}
+
+TEST(EncoderAPI, DecodeHigherBitdepthSegment) {
+  if (sizeof(xvc::Sample) == 1) {
+    return;
+  }
+  const int kNumPics = 3;
+  const int kBitdepths[] = { 8, 10 };
+  const xvc_decoder_api *dec_api = xvc_decoder_api_get();
+  std::vector<std::vector<uint8_t>> nals;
+  std::vector<std::vector<uint8_t>> rec_pics;
+  for (int bitdepth : kBitdepths) {
+    EncodeSegment(bitdepth, kNumPics, &nals, &rec_pics);
+  }
+  ASSERT_EQ(2 * kNumPics, static_cast<int>(rec_pics.size()));
+
+  // With the 8bit pipeline compiled in the second segment is decoded by
+  // another decoder, the output must not depend on that
+  xvc_decoder_parameters *dec_params = dec_api->parameters_create();
+  EXPECT_EQ(XVC_DEC_OK, dec_api->parameters_set_default(dec_params));
+  dec_params->output_bitdepth = 10;
+  xvc_decoder *decoder = dec_api->decoder_create(dec_params);
+  EXPECT_EQ(XVC_DEC_OK, dec_api->parameters_destroy(dec_params));
+  ASSERT_NE(decoder, nullptr);
+  xvc_decoded_picture *dec_pic = dec_api->picture_create(decoder);
+  int num_dec_pics = 0;
+  auto check_output = [&]() {
+    while (dec_api->decoder_get_picture(decoder, dec_pic) == XVC_DEC_OK) {
+      ASSERT_LT(num_dec_pics, 2 * kNumPics);
+      const int bitdepth = kBitdepths[num_dec_pics / kNumPics];
+      EXPECT_EQ(bitdepth, dec_pic->stats.bitstream_bitdepth);
+      const std::vector<uint8_t> &rec_pic = rec_pics[num_dec_pics++];
+      const uint16_t *dec_samples =
+        reinterpret_cast<const uint16_t*>(dec_pic->bytes);
+      if (bitdepth == 8) {
+        ASSERT_EQ(2 * rec_pic.size(), dec_pic->size);
+        for (size_t i = 0; i < rec_pic.size(); i++) {
+          ASSERT_EQ(rec_pic[i] << 2, dec_samples[i]);
+        }
+      } else {
+        ASSERT_EQ(rec_pic.size(), dec_pic->size);
+        EXPECT_EQ(0, std::memcmp(&rec_pic[0], dec_samples, dec_pic->size));
+      }
+    }
+  };
+  for (auto &nal : nals) {
+    EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_decode_nal(decoder, &nal[0],
+                                                      nal.size(), 0));
+    check_output();
+  }
+  EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_flush(decoder));
+  check_output();
+  EXPECT_EQ(2 * kNumPics, num_dec_pics);
+  EXPECT_EQ(XVC_DEC_OK, dec_api->picture_destroy(dec_pic));
+  EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_check_conformance(decoder,
+                                                            nullptr));
+  EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_destroy(decoder));
+}
+
+static bool IsSegmentHeader(const std::vector<uint8_t> &nal) {
+  return ((nal[0] >> 1) & 31) ==
+    static_cast<int>(xvc::NalUnitType::kSegmentHeader);
+}
+
+static bool IsTailPicture(const std::vector<uint8_t> &nal) {
+  return !IsSegmentHeader(nal) && (nal[1] >> 7) != 0;
+}
+
+TEST(EncoderAPI, DecodeHigherBitdepthOpenGopSegment) {
+  if (sizeof(xvc::Sample) == 1) {
+    return;
+  }
+#if XVC_LOW_BITDEPTH_PIPELINE
+  const bool kLowbdDelegate = true;
+#else
+  const bool kLowbdDelegate = false;
+#endif
+  const int kNumPics = 13;
+  const int kSubGopLength = 4;
+  const int kKeyPicDistance = 8;
+  const xvc_decoder_api *dec_api = xvc_decoder_api_get();
+  std::vector<std::vector<uint8_t>> nals8, nals10;
+  std::vector<std::vector<uint8_t>> rec_pics8, rec_pics10;
+  EncodeSegment(8, kNumPics, &nals8, &rec_pics8, kSubGopLength,
+                kKeyPicDistance);
+  EncodeSegment(10, kNumPics, &nals10, &rec_pics10, kSubGopLength,
+                kKeyPicDistance);
+  ASSERT_EQ(kNumPics, static_cast<int>(rec_pics8.size()));
+  ASSERT_EQ(kNumPics, static_cast<int>(rec_pics10.size()));
+
+  // First segment of the 8bit bitstream, including the open gop tail
+  // pictures that precede the next segment header, followed by the remaining
+  // segments of the 10bit bitstream
+  auto find_second_segment = [](const std::vector<std::vector<uint8_t>> &v) {
+    size_t idx = 1;
+    while (idx < v.size() && !IsSegmentHeader(v[idx])) {
+      idx++;
+    }
+    return idx;
+  };
+  const size_t switch_idx8 = find_second_segment(nals8);
+  const size_t switch_idx10 = find_second_segment(nals10);
+  ASSERT_LT(switch_idx8, nals8.size());
+  ASSERT_LT(switch_idx10, nals10.size());
+  int num_tail_pics = 0;
+  while (IsTailPicture(nals8[switch_idx8 - num_tail_pics - 1])) {
+    num_tail_pics++;
+  }
+  ASSERT_GT(num_tail_pics, 0);
+  std::vector<std::vector<uint8_t>> nals(nals8.begin(),
+                                         nals8.begin() + switch_idx8);
+  nals.insert(nals.end(), nals10.begin() + switch_idx10, nals10.end());
+
+  xvc_decoder_parameters *dec_params = dec_api->parameters_create();
+  EXPECT_EQ(XVC_DEC_OK, dec_api->parameters_set_default(dec_params));
+  dec_params->output_bitdepth = 10;
+  xvc_decoder *decoder = dec_api->decoder_create(dec_params);
+  EXPECT_EQ(XVC_DEC_OK, dec_api->parameters_destroy(dec_params));
+  ASSERT_NE(decoder, nullptr);
+  xvc_decoded_picture *dec_pic = dec_api->picture_create(decoder);
+  const int num_lowbd_pics = kKeyPicDistance - num_tail_pics;
+  int num_dec_pics = 0;
+  auto check_output = [&]() {
+    while (dec_api->decoder_get_picture(decoder, dec_pic) == XVC_DEC_OK) {
+      ASSERT_LT(num_dec_pics, kNumPics);
+      if (!kLowbdDelegate) {
+        // Tail pictures are decoded from the 10bit key picture
+        num_dec_pics++;
+        continue;
+      }
+      const bool lowbd = num_dec_pics < num_lowbd_pics;
+      const int poc = lowbd ? num_dec_pics : num_dec_pics + num_tail_pics;
+      const std::vector<uint8_t> &rec_pic =
+        lowbd ? rec_pics8[poc] : rec_pics10[poc];
+      EXPECT_EQ(lowbd ? 8 : 10, dec_pic->stats.bitstream_bitdepth);
+      const uint16_t *dec_samples =
+        reinterpret_cast<const uint16_t*>(dec_pic->bytes);
+      if (lowbd) {
+        ASSERT_EQ(2 * rec_pic.size(), dec_pic->size);
+        for (size_t i = 0; i < rec_pic.size(); i++) {
+          ASSERT_EQ(rec_pic[i] << 2, dec_samples[i]);
+        }
+      } else {
+        ASSERT_EQ(rec_pic.size(), dec_pic->size);
+        EXPECT_EQ(0, std::memcmp(&rec_pic[0], dec_samples, dec_pic->size));
+      }
+      num_dec_pics++;
+    }
+  };
+  int num_reported_losses = 0;
+  for (auto &nal : nals) {
+    xvc_dec_return_code ret =
+      dec_api->decoder_decode_nal(decoder, &nal[0], nal.size(), 0);
+    if (ret == XVC_DEC_TAIL_PICTURES_LOST_AT_BITDEPTH_SWITCH) {
+      EXPECT_TRUE(IsSegmentHeader(nal));
+      num_reported_losses++;
+    } else {
+      EXPECT_EQ(XVC_DEC_OK, ret);
+    }
+    check_output();
+  }
+  EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_flush(decoder));
+  check_output();
+  // Tail pictures are never dropped without being reported
+  EXPECT_EQ(kLowbdDelegate ? 1 : 0, num_reported_losses);
+  EXPECT_EQ(kLowbdDelegate ? kNumPics - num_tail_pics : kNumPics,
+            num_dec_pics);
+  EXPECT_EQ(XVC_DEC_OK, dec_api->picture_destroy(dec_pic));
+  EXPECT_EQ(XVC_DEC_OK, dec_api->decoder_destroy(decoder));
+}
+
 }   // namespace
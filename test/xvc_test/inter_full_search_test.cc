@@ -0,0 +1,236 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <set>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/picture_data.h"
+#include "xvc_common_lib/quantize.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/inter_full_search.h"
+#include "xvc_enc_lib/inter_search.h"
+#include "xvc_enc_lib/sample_metric.h"
+
+namespace {
+
+static const int kWidth = 160;
+static const int kHeight = 160;
+static const int kMargin = 16;
+
+struct TestParam {
+  int bitdepth;
+  xvc::MetricType metric_type;
+};
+
+class InterFullSearchTest : public ::testing::TestWithParam<TestParam> {
+protected:
+  void SetUp() override {
+    const int bitdepth = GetParam().bitdepth;
+    std::set<xvc::CpuCapability> caps = xvc::SimdCpu::GetRuntimeCapabilities();
+    simd_.reset(new xvc::EncoderSimdFunctions(caps, bitdepth));
+    pic_data_.reset(new xvc::PictureData(xvc::ChromaFormat::k420, kWidth,
+                                         kHeight, bitdepth));
+    ref_pic_.reset(new xvc::YuvPicture(xvc::ChromaFormat::k420, kWidth,
+                                       kHeight, bitdepth, false, kWidth,
+                                       kHeight));
+    // Smooth texture with noise, gives many positions with similar cost
+    for (int y = 0; y < kHeight; y++) {
+      xvc::Sample *dst = ref_pic_->GetSamplePtr(xvc::YuvComponent::kY, 0, y);
+      for (int x = 0; x < kWidth; x++) {
+        const double val = 128 + 50 * std::sin(x * 0.11) +
+          40 * std::sin(y * 0.07 + x * 0.03) + Hash(x, y) % 17;
+        dst[x] = static_cast<xvc::Sample>(val * (1 << (bitdepth - 8)));
+      }
+    }
+  }
+
+  static uint32_t Hash(int x, int y) {
+    uint32_t h = static_cast<uint32_t>(x) * 73856093u ^
+      static_cast<uint32_t>(y) * 19349663u;
+    h ^= h >> 13;
+    return h * 0x5bd1e995u;
+  }
+
+  // Original block as seen by bi-prediction refinement, may be negative and
+  // exceed the sample range
+  void CreateOrig(const xvc::CodingUnit &cu, const xvc::MvFullpel &mv,
+                  int seed, xvc::ResidualBufferStorage *orig) {
+    const int bitdepth = GetParam().bitdepth;
+    const int width = cu.GetWidth(xvc::YuvComponent::kY);
+    const int height = cu.GetHeight(xvc::YuvComponent::kY);
+    for (int y = 0; y < height; y++) {
+      const xvc::Sample *src = ref_pic_->GetSamplePtr(
+        xvc::YuvComponent::kY, cu.GetPosX(xvc::YuvComponent::kY) + mv.x,
+        cu.GetPosY(xvc::YuvComponent::kY) + mv.y + y);
+      xvc::Residual *dst = orig->GetDataPtr() + y * orig->GetStride();
+      for (int x = 0; x < width; x++) {
+        const int noise = static_cast<int>(Hash(x + seed, y) % 41) - 20;
+        dst[x] = static_cast<xvc::Residual>(src[x] +
+                                            noise * (1 << (bitdepth - 8)));
+      }
+    }
+  }
+
+  xvc::MvFullpel
+    BruteForceSearch(const xvc::CodingUnit &cu, const xvc::Qp &qp,
+                     const xvc::SampleMetric &metric,
+                     const xvc::ResidualBufferConst &orig,
+                     const xvc::MotionVector &mvp, const xvc::MvFullpel &mv_min,
+                     const xvc::MvFullpel &mv_max) {
+    const xvc::YuvComponent comp = xvc::YuvComponent::kY;
+    const uint32_t lambda =
+      static_cast<uint32_t>(std::floor(65536.0 * qp.GetLambdaSqrt()));
+    xvc::Distortion cost_best = std::numeric_limits<xvc::Distortion>::max();
+    xvc::MvFullpel mv_best;
+    for (int mv_y = mv_min.y; mv_y <= mv_max.y; mv_y++) {
+      for (int mv_x = mv_min.x; mv_x <= mv_max.x; mv_x++) {
+        const xvc::Sample *ref =
+          ref_pic_->GetSamplePtr(comp, cu.GetPosX(comp) + mv_x,
+                                 cu.GetPosY(comp) + mv_y);
+        xvc::Distortion dist =
+          metric.CompareSample(qp, comp, cu.GetWidth(comp), cu.GetHeight(comp),
+                               orig.GetDataPtr(), orig.GetStride(), ref,
+                               ref_pic_->GetStride(comp));
+        xvc::Bits bits =
+          xvc::InterSearch::GetMvdBitsFullpel(mvp, mv_x, mv_y, 0);
+        xvc::Distortion cost = dist + ((lambda * bits) >> 16);
+        if (cost < cost_best) {
+          cost_best = cost;
+          mv_best = xvc::MvFullpel(mv_x, mv_y);
+        }
+      }
+    }
+    return mv_best;
+  }
+
+  std::unique_ptr<xvc::EncoderSimdFunctions> simd_;
+  std::unique_ptr<xvc::PictureData> pic_data_;
+  std::unique_ptr<xvc::YuvPicture> ref_pic_;
+};
+
+TEST_P(InterFullSearchTest, MatchesBruteForceSearch) {
+  const int bitdepth = GetParam().bitdepth;
+  const int kSizes[][2] = { { 8, 8 }, { 16, 8 }, { 8, 32 }, { 32, 32 },
+                            { 64, 16 }, { 4, 8 } };
+  const double kLambdas[] = { 0, 20, 200 };
+  xvc::SampleMetric metric(simd_->sample_metric, bitdepth,
+                           GetParam().metric_type);
+  xvc::FullSearch full_search(bitdepth);
+  xvc::ResidualBufferStorage orig(xvc::constants::kMaxBlockSize,
+                                  xvc::constants::kMaxBlockSize);
+  int seed = 0;
+  for (const auto &size : kSizes) {
+    for (double lambda : kLambdas) {
+      for (int iter = 0; iter < 8; iter++, seed++) {
+        const int width = size[0];
+        const int height = size[1];
+        const int pos_x = kMargin +
+          static_cast<int>(Hash(seed, 1) % (kWidth - width - 2 * kMargin));
+        const int pos_y = kMargin +
+          static_cast<int>(Hash(seed, 2) % (kHeight - height - 2 * kMargin));
+        xvc::CodingUnit *cu =
+          pic_data_->CreateCu(xvc::CuTree::Primary, 0, pos_x, pos_y, width,
+                              height);
+        // Window sizes both multiple and not multiple of the offset group
+        const xvc::MvFullpel mv_min(-4 - iter % 3, -4);
+        const xvc::MvFullpel mv_max(4 + iter % 2, 3 + iter % 4);
+        const xvc::MvFullpel mv_true(static_cast<int>(Hash(seed, 3) % 9) - 4,
+                                     static_cast<int>(Hash(seed, 4) % 8) - 4);
+        const xvc::MotionVector mvp(
+          static_cast<int>(Hash(seed, 5) % 160) - 80,
+          static_cast<int>(Hash(seed, 6) % 160) - 80);
+        xvc::Qp qp(32, xvc::ChromaFormat::k420, bitdepth, lambda);
+        CreateOrig(*cu, mv_true, seed, &orig);
+        xvc::MvFullpel expected =
+          BruteForceSearch(*cu, qp, metric, orig, mvp, mv_min, mv_max);
+        xvc::MvFullpel actual =
+          full_search.Search(*cu, qp, metric, orig, mvp, *ref_pic_, mv_min,
+                             mv_max);
+        EXPECT_EQ(expected.x, actual.x) << width << "x" << height
+          << " lambda " << lambda << " iter " << iter;
+        EXPECT_EQ(expected.y, actual.y) << width << "x" << height
+          << " lambda " << lambda << " iter " << iter;
+        pic_data_->ReleaseCu(cu);
+      }
+    }
+  }
+}
+
+TEST_P(InterFullSearchTest, CompareSampleX4MatchesCompareSample) {
+  const int bitdepth = GetParam().bitdepth;
+  const xvc::YuvComponent comp = xvc::YuvComponent::kY;
+  const std::set<xvc::CpuCapability> no_caps;
+  xvc::EncoderSimdFunctions simd_c(no_caps, bitdepth);
+  xvc::SampleMetric metric_simd(simd_->sample_metric, bitdepth,
+                                GetParam().metric_type);
+  xvc::SampleMetric metric_c(simd_c.sample_metric, bitdepth,
+                             GetParam().metric_type);
+  xvc::Qp qp(32, xvc::ChromaFormat::k420, bitdepth, 0);
+  xvc::ResidualBufferStorage orig(xvc::constants::kMaxBlockSize,
+                                  xvc::constants::kMaxBlockSize);
+  for (int width = 4; width <= 64; width *= 2) {
+    for (int height = 4; height <= 64; height *= 2) {
+      xvc::CodingUnit *cu =
+        pic_data_->CreateCu(xvc::CuTree::Primary, 0, kMargin, kMargin, width,
+                            height);
+      CreateOrig(*cu, xvc::MvFullpel(1, -2), width + height, &orig);
+      const xvc::Sample *ref = ref_pic_->GetSamplePtr(comp, kMargin - 3,
+                                                      kMargin + 1);
+      const ptrdiff_t ref_stride = ref_pic_->GetStride(comp);
+      xvc::Distortion dist_simd[4];
+      xvc::Distortion dist_c[4];
+      metric_simd.CompareSampleX4(qp, comp, width, height, orig.GetDataPtr(),
+                                  orig.GetStride(), ref, ref_stride,
+                                  dist_simd);
+      metric_c.CompareSampleX4(qp, comp, width, height, orig.GetDataPtr(),
+                               orig.GetStride(), ref, ref_stride, dist_c);
+      for (int i = 0; i < 4; i++) {
+        xvc::Distortion expected =
+          metric_c.CompareSample(qp, comp, width, height, orig.GetDataPtr(),
+                                 orig.GetStride(), ref + i, ref_stride);
+        EXPECT_EQ(expected, dist_c[i]) << width << "x" << height << " " << i;
+        EXPECT_EQ(expected, dist_simd[i])
+          << width << "x" << height << " " << i;
+      }
+      pic_data_->ReleaseCu(cu);
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(NormalBitdepth, InterFullSearchTest,
+                        ::testing::Values(
+                          TestParam({ 8, xvc::MetricType::kSad }),
+                          TestParam({ 8, xvc::MetricType::kSadFast })));
+#if XVC_HIGH_BITDEPTH
+INSTANTIATE_TEST_CASE_P(HighBitdepth, InterFullSearchTest,
+                        ::testing::Values(
+                          TestParam({ 10, xvc::MetricType::kSad }),
+                          TestParam({ 10, xvc::MetricType::kSadFast })));
+#endif
+
+}   // namespace
@@ -0,0 +1,271 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/simd_functions.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/lookahead.h"
+#include "xvc_test/encoder_helper.h"
+
+namespace {
+
+static const int kBitdepth = 8;
+static const int kWidth = 128;
+static const int kHeight = 128;
+
+// Smooth texture for the first scene and noise for any later scene
+int GetTextureSample(int scene, int x, int y) {
+  if (scene == 0) {
+    const double val = 128 + 40 * std::sin(x * 0.13) +
+      40 * std::sin(y * 0.09 + x * 0.04) + 30 * std::sin((x - y) * 0.21);
+    return static_cast<int>(val);
+  }
+  uint32_t hash = static_cast<uint32_t>(x * 7919 + y * 104729 + scene);
+  hash = (hash ^ (hash >> 13)) * 1274126177u;
+  return 48 + static_cast<int>((hash ^ (hash >> 16)) % 160);
+}
+
+class LookaheadTest : public ::testing::Test,
+  public ::xvc_test::EncoderHelper {
+protected:
+  void SetUp() override {
+    std::set<xvc::CpuCapability> caps = xvc::SimdCpu::GetRuntimeCapabilities();
+    simd_.reset(new xvc::EncoderSimdFunctions(caps, kBitdepth));
+    lookahead_.reset(new xvc::Lookahead(simd_->sample_metric, kWidth, kHeight,
+                                        kBitdepth));
+  }
+
+  void PushPicture(xvc::PicNum poc, int scene) {
+    std::shared_ptr<xvc::YuvPicture> pic =
+      std::make_shared<xvc::YuvPicture>(xvc::ChromaFormat::k420, kWidth,
+                                        kHeight, kBitdepth, false, kWidth,
+                                        kHeight);
+    for (int y = 0; y < kHeight; y++) {
+      xvc::Sample *dst = pic->GetSamplePtr(xvc::YuvComponent::kY, 0, y);
+      for (int x = 0; x < kWidth; x++) {
+        dst[x] = static_cast<xvc::Sample>(GetTextureSample(scene, x, y));
+      }
+    }
+    lookahead_->Push(poc, pic);
+  }
+
+  static std::vector<uint8_t> CreatePictureBytes(int scene) {
+    std::vector<uint8_t> pic_bytes(kWidth * kHeight * 3 / 2, 128);
+    for (int y = 0; y < kHeight; y++) {
+      for (int x = 0; x < kWidth; x++) {
+        pic_bytes[y * kWidth + x] =
+          static_cast<uint8_t>(GetTextureSample(scene, x, y));
+      }
+    }
+    return pic_bytes;
+  }
+
+  // Encodes one picture of the given scene per entry and flushes
+  std::vector<xvc_enc_nal_stats> EncodeScenes(const std::vector<int> &scenes) {
+    std::vector<xvc_enc_nal_stats> nal_stats;
+    for (int scene : scenes) {
+      std::vector<xvc_enc_nal_stats> pic_nal_stats =
+        EncodeOneFrame(CreatePictureBytes(scene), kBitdepth);
+      nal_stats.insert(nal_stats.end(), pic_nal_stats.begin(),
+                       pic_nal_stats.end());
+    }
+    std::vector<xvc_enc_nal_stats> flush_nal_stats = EncoderFlush();
+    nal_stats.insert(nal_stats.end(), flush_nal_stats.begin(),
+                     flush_nal_stats.end());
+    return nal_stats;
+  }
+
+  static xvc::PicNum
+    GetFirstAccessPoc(const std::vector<xvc_enc_nal_stats> &nal_stats) {
+    for (const xvc_enc_nal_stats &stats : nal_stats) {
+      if (static_cast<xvc::NalUnitType>(stats.nal_unit_type) ==
+          xvc::NalUnitType::kIntraAccessPicture) {
+        return stats.poc;
+      }
+    }
+    return static_cast<xvc::PicNum>(-1);
+  }
+
+  std::unique_ptr<xvc::EncoderSimdFunctions> simd_;
+  std::unique_ptr<xvc::Lookahead> lookahead_;
+};
+
+TEST_F(LookaheadTest, ReferencedStaticPicturesGetNegativeOffset) {
+  const xvc::PicNum kLastPoc = 8;
+  for (xvc::PicNum poc = 0; poc <= kLastPoc; poc++) {
+    PushPicture(poc, 0);
+  }
+  EXPECT_FALSE(lookahead_->HasSceneCut(0, kLastPoc));
+  lookahead_->Propagate(0, kLastPoc);
+  int prev_offset = std::numeric_limits<int>::min();
+  for (xvc::PicNum poc = 0; poc < kLastPoc; poc++) {
+    xvc::Lookahead::QpOffsets qp_offsets = lookahead_->GetQpOffsets(poc);
+    EXPECT_LT(qp_offsets.pic_offset, 0) << "Poc " << poc;
+    // Earlier pictures are referenced by more pictures
+    EXPECT_GE(qp_offsets.pic_offset, prev_offset) << "Poc " << poc;
+    prev_offset = qp_offsets.pic_offset;
+  }
+  // Not referenced by any picture in the range
+  xvc::Lookahead::QpOffsets qp_offsets = lookahead_->GetQpOffsets(kLastPoc);
+  EXPECT_EQ(0, qp_offsets.pic_offset);
+  for (int ctu_offset : qp_offsets.ctu_offsets) {
+    EXPECT_EQ(0, ctu_offset);
+  }
+}
+
+TEST_F(LookaheadTest, NoPropagationAcrossSceneCut) {
+  const xvc::PicNum kSceneCutPoc = 4;
+  const xvc::PicNum kLastPoc = 8;
+  for (xvc::PicNum poc = 0; poc <= kLastPoc; poc++) {
+    PushPicture(poc, poc < kSceneCutPoc ? 0 : 1);
+  }
+  EXPECT_FALSE(lookahead_->HasSceneCut(0, kSceneCutPoc - 1));
+  EXPECT_FALSE(lookahead_->HasSceneCut(kSceneCutPoc + 1, kLastPoc));
+  EXPECT_TRUE(lookahead_->HasSceneCut(kSceneCutPoc, kSceneCutPoc));
+  lookahead_->Propagate(0, kLastPoc);
+  for (xvc::PicNum poc = 0; poc <= kLastPoc; poc++) {
+    xvc::Lookahead::QpOffsets qp_offsets = lookahead_->GetQpOffsets(poc);
+    if (poc == kSceneCutPoc - 1 || poc == kLastPoc) {
+      EXPECT_EQ(0, qp_offsets.pic_offset) << "Poc " << poc;
+    } else {
+      EXPECT_LT(qp_offsets.pic_offset, 0) << "Poc " << poc;
+    }
+  }
+}
+
+TEST_F(LookaheadTest, SceneCutStartsNewSegment) {
+  const int kSubGopLength = 4;
+  const int kSegmentLength = kSubGopLength * 4;
+  // Detected at the end of the sub-gop containing the scene cut
+  const xvc::PicNum kSceneCutPoc = 6;
+  const xvc::PicNum kSegmentStartPoc = 8;
+  const int kNumPictures = kSegmentStartPoc + kSegmentLength + 1;
+  xvc::EncoderSettings encoder_settings = GetDefaultEncoderSettings();
+  encoder_settings.Initialize(xvc::SpeedMode::kUltraFast);
+  encoder_settings.leading_pictures = 0;
+  encoder_settings.lookahead = 1;
+  SetupEncoder(encoder_settings, kWidth, kHeight, kBitdepth, kDefaultQp);
+  encoder_->SetSubGopLength(kSubGopLength);
+  encoder_->SetSegmentLength(kSegmentLength);
+  std::vector<xvc_enc_nal_stats> nal_stats;
+  for (int i = 0; i < kNumPictures; i++) {
+    std::vector<xvc_enc_nal_stats> pic_nal_stats = EncodeOneFrame(
+      CreatePictureBytes(static_cast<xvc::PicNum>(i) < kSceneCutPoc ? 0 : 1),
+      kBitdepth);
+    nal_stats.insert(nal_stats.end(), pic_nal_stats.begin(),
+                     pic_nal_stats.end());
+  }
+  std::vector<xvc_enc_nal_stats> flush_nal_stats = EncoderFlush();
+  nal_stats.insert(nal_stats.end(), flush_nal_stats.begin(),
+                   flush_nal_stats.end());
+
+  int num_segment_headers = 0;
+  std::vector<xvc::PicNum> access_pocs;
+  for (const xvc_enc_nal_stats &stats : nal_stats) {
+    const xvc::NalUnitType nal_type =
+      static_cast<xvc::NalUnitType>(stats.nal_unit_type);
+    if (nal_type == xvc::NalUnitType::kSegmentHeader) {
+      num_segment_headers++;
+    } else if (nal_type == xvc::NalUnitType::kIntraAccessPicture) {
+      access_pocs.push_back(stats.poc);
+    }
+  }
+  // The following segment starts a full segment length after the scene cut
+  const std::vector<xvc::PicNum> expected_access_pocs = {
+    0, kSegmentStartPoc, kSegmentStartPoc + kSegmentLength
+  };
+  EXPECT_EQ(expected_access_pocs, access_pocs);
+  EXPECT_EQ(3, num_segment_headers);
+}
+
+TEST_F(LookaheadTest, DelayedEncodingOutputsAllPictures) {
+  const int kSubGopLength = 4;
+  const int kLookaheadDepth = 6;
+  const int kNumPictures = 2 * kSubGopLength + 1;
+  xvc::EncoderSettings encoder_settings = GetDefaultEncoderSettings();
+  encoder_settings.Initialize(xvc::SpeedMode::kUltraFast);
+  encoder_settings.leading_pictures = 0;
+  encoder_settings.lookahead = 1;
+  encoder_settings.lookahead_depth = kLookaheadDepth;
+  SetupEncoder(encoder_settings, kWidth, kHeight, kBitdepth, kDefaultQp);
+  encoder_->SetSubGopLength(kSubGopLength);
+  std::vector<xvc_enc_nal_stats> nal_stats;
+  for (int i = 0; i < kNumPictures; i++) {
+    std::vector<xvc_enc_nal_stats> pic_nal_stats =
+      EncodeOneFrame(CreatePictureBytes(0), kBitdepth);
+    // Nothing is encoded until the lookahead window has been filled
+    if (i < kLookaheadDepth) {
+      EXPECT_TRUE(pic_nal_stats.empty()) << "Picture " << i;
+    }
+    nal_stats.insert(nal_stats.end(), pic_nal_stats.begin(),
+                     pic_nal_stats.end());
+  }
+  std::vector<xvc_enc_nal_stats> flush_nal_stats = EncoderFlush();
+  nal_stats.insert(nal_stats.end(), flush_nal_stats.begin(),
+                   flush_nal_stats.end());
+  std::set<xvc::PicNum> pocs;
+  for (const xvc_enc_nal_stats &stats : nal_stats) {
+    if (static_cast<xvc::NalUnitType>(stats.nal_unit_type) !=
+        xvc::NalUnitType::kSegmentHeader) {
+      pocs.insert(stats.poc);
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumPictures), pocs.size());
+  EXPECT_EQ(0, *pocs.begin());
+  EXPECT_EQ(kNumPictures - 1, *pocs.rbegin());
+}
+
+TEST_F(LookaheadTest, LeadingPicturesDeterminedFromFirstSubGop) {
+  const int kSubGopLength = 8;
+  xvc::EncoderSettings encoder_settings = GetDefaultEncoderSettings();
+  encoder_settings.Initialize(xvc::SpeedMode::kUltraFast);
+  encoder_settings.leading_pictures = -1;
+  encoder_settings.lookahead = 1;
+  encoder_settings.lookahead_depth = kSubGopLength - 1;
+
+  // Only the first picture differs from the rest of the sub-gop
+  std::vector<int> scenes(2 * kSubGopLength, 0);
+  scenes[0] = 1;
+  SetupEncoder(encoder_settings, kWidth, kHeight, kBitdepth, kDefaultQp);
+  encoder_->SetSubGopLength(kSubGopLength);
+  // Reported pocs are in input order
+  EXPECT_EQ(kSubGopLength - 1, GetFirstAccessPoc(EncodeScenes(scenes)));
+  EXPECT_EQ(1, encoder_->GetCurrentSegment()->leading_pictures);
+
+  // Only the last picture of the sub-gop differs from the preceding ones
+  scenes.assign(2 * kSubGopLength, 0);
+  scenes[kSubGopLength - 1] = 1;
+  SetupEncoder(encoder_settings, kWidth, kHeight, kBitdepth, kDefaultQp);
+  encoder_->SetSubGopLength(kSubGopLength);
+  EXPECT_EQ(0, GetFirstAccessPoc(EncodeScenes(scenes)));
+  EXPECT_EQ(0, encoder_->GetCurrentSegment()->leading_pictures);
+}
+
+}   // namespace
@@ -0,0 +1,124 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include <memory>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/motion_field.h"
+#include "xvc_common_lib/picture_data.h"
+
+namespace {
+
+static const int kWidth = 72;
+static const int kHeight = 64;
+
+class MotionFieldTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    double lambda = 0;
+    qp_.reset(new xvc::Qp(32, xvc::ChromaFormat::k420, 8, lambda));
+    ref_pic_data_ = CreatePictureData(xvc::NalUnitType::kIntraAccessPicture, 0);
+    ref_pic_data_->Init(segment_, *qp_, true);
+    pic_data_ = CreatePictureData(xvc::NalUnitType::kPredictedPicture, 2);
+    pic_data_->GetRefPicLists()->SetRefPic(xvc::RefPicList::kL0, 0, 0,
+                                           ref_pic_data_, nullptr, nullptr);
+    pic_data_->Init(segment_, *qp_, true);
+  }
+
+  std::shared_ptr<xvc::PictureData>
+    CreatePictureData(xvc::NalUnitType nal_type, xvc::PicNum poc) {
+    std::shared_ptr<xvc::PictureData> pic_data =
+      std::make_shared<xvc::PictureData>(xvc::ChromaFormat::k420, kWidth,
+                                         kHeight, 8);
+    pic_data->SetNalType(nal_type);
+    pic_data->SetPoc(poc);
+    pic_data->GetRefPicLists()->Reset(poc);
+    return pic_data;
+  }
+
+  static void SetInter(xvc::CodingUnit *cu, const xvc::MotionVector &mv,
+                       bool use_lic) {
+    cu->SetPredMode(xvc::PredictionMode::kInter);
+    cu->SetInterDir(xvc::InterDir::kL0);
+    cu->SetRefIdx(0, xvc::RefPicList::kL0);
+    cu->SetRefIdx(-1, xvc::RefPicList::kL1);
+    cu->SetMv(mv, xvc::RefPicList::kL0);
+    cu->SetUseLic(use_lic);
+  }
+
+  xvc::SegmentHeader segment_;
+  std::unique_ptr<xvc::Qp> qp_;
+  std::shared_ptr<xvc::PictureData> ref_pic_data_;
+  std::shared_ptr<xvc::PictureData> pic_data_;
+};
+
+TEST_F(MotionFieldTest, IntraPictureHasNoMotion) {
+  ref_pic_data_->ReleaseCuTree();
+  const xvc::MotionField &field = ref_pic_data_->GetMotionField();
+  EXPECT_EQ(0, field.GetPoc());
+  EXPECT_EQ(nullptr, field.GetMotionAt(0, 0));
+}
+
+TEST_F(MotionFieldTest, SampledAtSmallestBlockSize) {
+  const xvc::MotionVector mv_inter(5, -3);
+  const xvc::MotionVector mv_lic(-8, 12);
+  // Inter cu of 8x32 samples at (24, 0) and 32x32 lic cu at (32, 32),
+  // everything else including the partial ctu to the right is intra
+  xvc::CodingUnit *ctu = pic_data_->GetCtu(xvc::CuTree::Primary, 0);
+  ctu->Split(xvc::SplitType::kQuad);
+  ctu->GetSubCu(0)->Split(xvc::SplitType::kVertical);
+  xvc::CodingUnit *half = ctu->GetSubCu(0)->GetSubCu(1);
+  half->Split(xvc::SplitType::kVertical);
+  SetInter(half->GetSubCu(1), mv_inter, false);
+  SetInter(ctu->GetSubCu(3), mv_lic, true);
+  for (int rsaddr = 0; rsaddr < pic_data_->GetNumberOfCtu(); rsaddr++) {
+    pic_data_->MarkUsedInPic(pic_data_->GetCtu(xvc::CuTree::Primary, rsaddr));
+  }
+  pic_data_->ReleaseCuTree();
+
+  const xvc::MotionField &field = pic_data_->GetMotionField();
+  EXPECT_EQ(2, field.GetPoc());
+  EXPECT_EQ(0, field.GetRefPoc(xvc::RefPicList::kL0, 0));
+  EXPECT_EQ(nullptr, field.GetMotionAt(kWidth, 0));
+  EXPECT_EQ(nullptr, field.GetMotionAt(0, kHeight));
+  for (int y = 0; y < kHeight; y++) {
+    for (int x = 0; x < kWidth; x++) {
+      const xvc::MotionField::Motion *motion = field.GetMotionAt(x, y);
+      ASSERT_NE(nullptr, motion);
+      const bool is_inter = x >= 24 && x < 32 && y < 32;
+      const bool is_lic = x >= 32 && x < 64 && y >= 32;
+      ASSERT_EQ(is_inter || is_lic, motion->IsInter()) << x << "," << y;
+      if (!motion->IsInter()) {
+        continue;
+      }
+      EXPECT_TRUE(motion->HasMv(xvc::RefPicList::kL0));
+      EXPECT_FALSE(motion->HasMv(xvc::RefPicList::kL1));
+      EXPECT_EQ(0, motion->GetRefIdx(xvc::RefPicList::kL0));
+      EXPECT_EQ(is_inter ? mv_inter : mv_lic,
+                motion->GetMv(xvc::RefPicList::kL0));
+      EXPECT_EQ(is_lic, motion->use_lic);
+    }
+  }
+}
+
+}   // namespace
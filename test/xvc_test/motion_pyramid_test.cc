@@ -0,0 +1,113 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include <cmath>
+#include <memory>
+#include <set>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/simd_functions.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/motion_pyramid.h"
+
+namespace {
+
+static const int kBitdepth = 8;
+static const int kSearchRange = 64;
+
+class MotionPyramidTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::set<xvc::CpuCapability> caps = xvc::SimdCpu::GetRuntimeCapabilities();
+    simd_.reset(new xvc::EncoderSimdFunctions(caps, kBitdepth));
+  }
+
+  // Smooth texture where each picture shows the area at the given offset
+  std::unique_ptr<xvc::YuvPicture> CreatePicture(int width, int height,
+                                                 int offset_x, int offset_y) {
+    std::unique_ptr<xvc::YuvPicture> pic(
+      new xvc::YuvPicture(xvc::ChromaFormat::k420, width, height, kBitdepth,
+                          false, width, height));
+    for (int y = 0; y < height; y++) {
+      xvc::Sample *dst = pic->GetSamplePtr(xvc::YuvComponent::kY, 0, y);
+      for (int x = 0; x < width; x++) {
+        const double u = x + offset_x;
+        const double v = y + offset_y;
+        const double val = 128 + 40 * std::sin(u * 0.13) +
+          40 * std::sin(v * 0.09 + u * 0.04) + 30 * std::sin((u - v) * 0.21);
+        dst[x] = static_cast<xvc::Sample>(val);
+      }
+    }
+    return pic;
+  }
+
+  std::unique_ptr<xvc::EncoderSimdFunctions> simd_;
+};
+
+TEST_F(MotionPyramidTest, FindsGlobalMotion) {
+  const int kWidth = 256;
+  const int kHeight = 192;
+  const int kMvX = 40;
+  const int kMvY = -24;
+  auto ref_pic = CreatePicture(kWidth, kHeight, 0, 0);
+  auto cur_pic = CreatePicture(kWidth, kHeight, kMvX, kMvY);
+  xvc::MotionPyramid ref(simd_->sample_metric, kWidth, kHeight, kBitdepth);
+  xvc::MotionPyramid cur(simd_->sample_metric, kWidth, kHeight, kBitdepth);
+  ref.Build(*ref_pic);
+  cur.Build(*cur_pic);
+  xvc::MotionPyramid::MotionField field;
+  EXPECT_TRUE(field.IsEmpty());
+  cur.EstimateMotion(ref, kSearchRange, &field);
+  ASSERT_FALSE(field.IsEmpty());
+  const int block_size = xvc::MotionPyramid::kFieldBlockSize;
+  // Only blocks that are fully visible in the reference picture
+  for (int y = 2 * block_size; y + block_size <= kHeight; y += block_size) {
+    for (int x = 0; x + block_size + kMvX <= kWidth; x += block_size) {
+      xvc::MvFullpel mv = field.GetMv(x, y, block_size, block_size);
+      EXPECT_EQ(kMvX, mv.x) << "block at " << x << "," << y;
+      EXPECT_EQ(kMvY, mv.y) << "block at " << x << "," << y;
+    }
+  }
+}
+
+TEST_F(MotionPyramidTest, ZeroMotionForOddPictureSize) {
+  const int kWidth = 100;
+  const int kHeight = 62;
+  auto pic = CreatePicture(kWidth, kHeight, 0, 0);
+  xvc::MotionPyramid ref(simd_->sample_metric, kWidth, kHeight, kBitdepth);
+  xvc::MotionPyramid cur(simd_->sample_metric, kWidth, kHeight, kBitdepth);
+  ref.Build(*pic);
+  cur.Build(*pic);
+  xvc::MotionPyramid::MotionField field;
+  cur.EstimateMotion(ref, kSearchRange, &field);
+  for (int y = 0; y < kHeight; y += 8) {
+    for (int x = 0; x < kWidth; x += 8) {
+      xvc::MvFullpel mv = field.GetMv(x, y, 8, 8);
+      EXPECT_EQ(0, mv.x);
+      EXPECT_EQ(0, mv.y);
+    }
+  }
+}
+
+}   // namespace
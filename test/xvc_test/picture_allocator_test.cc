@@ -0,0 +1,115 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include <cstdint>
+#include <memory>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/picture_allocator.h"
+#include "xvc_common_lib/yuv_pic.h"
+
+namespace {
+
+static const size_t kPoolLimit = 64 * 1024 * 1024;
+
+class PictureAllocatorTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    xvc::PictureAllocator::SetPoolLimit(0);
+    xvc::PictureAllocator::SetPoolLimit(kPoolLimit);
+    pool_reference_.reset(new xvc::BufferPoolReference());
+  }
+  void TearDown() override {
+    pool_reference_.reset();
+    xvc::PictureAllocator::SetPoolLimit(0);
+    xvc::PictureAllocator::SetPoolLimit(kPoolLimit);
+  }
+
+  static bool IsAligned(const void *ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) %
+      xvc::PictureAllocator::kAlignment == 0;
+  }
+
+  // Buffers are only pooled while a decoder or encoder is alive
+  std::unique_ptr<xvc::BufferPoolReference> pool_reference_;
+};
+
+TEST_F(PictureAllocatorTest, AlignedPlanes) {
+  for (bool padding : { false, true }) {
+    xvc::YuvPicture pic(xvc::ChromaFormat::k420, 100, 58, 8, padding, 0, 0);
+    for (int c = 0; c < xvc::constants::kMaxYuvComponents; c++) {
+      const xvc::YuvComponent comp = xvc::YuvComponent(c);
+      EXPECT_TRUE(IsAligned(pic.GetSamplePtr(comp, 0, 0)));
+      EXPECT_TRUE(IsAligned(pic.GetSamplePtr(comp, 0, 1)));
+      EXPECT_GE(pic.GetStride(comp), pic.GetWidth(comp));
+    }
+  }
+}
+
+TEST_F(PictureAllocatorTest, ReuseAcrossPictures) {
+  const xvc::Sample *first_ptr;
+  {
+    xvc::YuvPicture pic(xvc::ChromaFormat::k420, 176, 144, 8, true, 0, 0);
+    first_ptr = pic.GetSamplePtr(xvc::YuvComponent::kY, 0, 0);
+  }
+  EXPECT_GT(xvc::PictureAllocator::GetPooledBytes(), 0U);
+  // A slightly smaller picture falls into the same size class
+  xvc::YuvPicture pic(xvc::ChromaFormat::k420, 168, 144, 8, true, 0, 0);
+  EXPECT_EQ(first_ptr, pic.GetSamplePtr(xvc::YuvComponent::kY, 0, 0));
+  EXPECT_EQ(0U, xvc::PictureAllocator::GetPooledBytes());
+}
+
+TEST_F(PictureAllocatorTest, PoolLimit) {
+  xvc::PictureAllocator::SetPoolLimit(0);
+  {
+    xvc::YuvPicture pic(xvc::ChromaFormat::k420, 176, 144, 8, true, 0, 0);
+  }
+  EXPECT_EQ(0U, xvc::PictureAllocator::GetPooledBytes());
+  xvc::PictureAllocator::SetPoolLimit(kPoolLimit);
+  {
+    xvc::YuvPicture pic(xvc::ChromaFormat::k420, 176, 144, 8, true, 0, 0);
+  }
+  EXPECT_GT(xvc::PictureAllocator::GetPooledBytes(), 0U);
+  xvc::PictureAllocator::SetPoolLimit(0);
+  EXPECT_EQ(0U, xvc::PictureAllocator::GetPooledBytes());
+}
+
+TEST_F(PictureAllocatorTest, EmptiedWithLastReference) {
+  std::unique_ptr<xvc::BufferPoolReference> other_reference(
+    new xvc::BufferPoolReference());
+  {
+    xvc::YuvPicture pic(xvc::ChromaFormat::k420, 176, 144, 8, true, 0, 0);
+  }
+  const size_t pooled_bytes = xvc::PictureAllocator::GetPooledBytes();
+  EXPECT_GT(pooled_bytes, 0U);
+  other_reference.reset();
+  EXPECT_EQ(pooled_bytes, xvc::PictureAllocator::GetPooledBytes());
+  pool_reference_.reset();
+  EXPECT_EQ(0U, xvc::PictureAllocator::GetPooledBytes());
+  {
+    xvc::YuvPicture pic(xvc::ChromaFormat::k420, 176, 144, 8, true, 0, 0);
+  }
+  EXPECT_EQ(0U, xvc::PictureAllocator::GetPooledBytes());
+}
+
+}   // namespace
@@ -0,0 +1,110 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include <cstdint>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_enc_lib/rate_control.h"
+
+namespace {
+
+static const double kFramerate = 30;
+static const double kBitrate = 300000;
+static const int kQp = 32;
+
+class RateControlTest : public ::testing::Test {
+protected:
+  // Encodes one picture per sub-gop with feedback given immediately
+  int EncodePictures(xvc::RateControl *rc, int num_pics, size_t bits) {
+    int qp = rc->GetQp();
+    for (int i = 0; i < num_pics; i++) {
+      qp = rc->StartSubGop(1, poc_ == 0, poc_);
+      rc->OnPictureEncoded(poc_, poc_, bits, poc_ == 0, qp, qp);
+      poc_++;
+    }
+    return rc->StartSubGop(1, false, poc_);
+  }
+
+  xvc::PicNum poc_ = 0;
+};
+
+TEST_F(RateControlTest, ConstantQpWithoutTarget) {
+  xvc::RateControl rc(0, 0, 0, kFramerate, 64, kQp);
+  EXPECT_EQ(kQp, EncodePictures(&rc, 8, 50000));
+  EXPECT_EQ(kQp, EncodePictures(&rc, 8, 500));
+}
+
+TEST_F(RateControlTest, OverspendRaisesQp) {
+  xvc::RateControl rc(kBitrate, 0, 0, kFramerate, 64, kQp);
+  // Ten times the per picture budget at any qp
+  EXPECT_GT(EncodePictures(&rc, 32, 100000), kQp + 6);
+}
+
+TEST_F(RateControlTest, UnderspendLowersQp) {
+  xvc::RateControl rc(kBitrate, 0, 0, kFramerate, 64, kQp);
+  EXPECT_LT(EncodePictures(&rc, 32, 1000), kQp - 6);
+}
+
+TEST_F(RateControlTest, QpStepIsLimited) {
+  xvc::RateControl rc(kBitrate, 0, 0, kFramerate, 64, kQp);
+  int prev_qp = EncodePictures(&rc, 2, 1000000);
+  for (xvc::PicNum poc = poc_; poc < poc_ + 8; poc++) {
+    rc.OnPictureEncoded(poc, poc, 1000000, false, prev_qp, prev_qp);
+    const int qp = rc.StartSubGop(1, false, poc + 1);
+    EXPECT_LE(qp - prev_qp, 3);
+    prev_qp = qp;
+  }
+}
+
+TEST_F(RateControlTest, FeedbackIsOrderedByPoc) {
+  xvc::RateControl rc(kBitrate, 0, 0, kFramerate, 64, kQp);
+  EXPECT_EQ(kQp, rc.StartSubGop(1, true, 0));
+  rc.OnPictureEncoded(0, 0, 10000, true, kQp, kQp);
+  EXPECT_EQ(kQp, rc.StartSubGop(2, false, 1));
+  // Feedback beyond the end poc is not used yet
+  rc.OnPictureEncoded(2, 2, 1000, false, kQp, kQp);
+  rc.OnPictureEncoded(1, 1, 1000, false, kQp, kQp);
+  EXPECT_EQ(kQp, rc.StartSubGop(2, false, 1));
+  EXPECT_LT(rc.StartSubGop(2, false, 3), kQp);
+}
+
+TEST_F(RateControlTest, BufferIsDrainedInCodingOrder) {
+  const double fill = 3 * kBitrate / kFramerate;
+  xvc::RateControl rc(0, 3 * kBitrate, kBitrate, kFramerate, 64, kQp);
+  EXPECT_EQ(kQp, rc.StartSubGop(2, false, 1));
+  rc.OnPictureEncoded(1, 2, 1000, false, kQp, kQp + 2);
+  rc.OnPictureEncoded(2, 1, 100000, false, kQp, kQp + 1);
+  rc.StartSubGop(2, false, 3);
+  // In poc order the buffer would overflow before the larger picture
+  EXPECT_DOUBLE_EQ(0.9 * kBitrate + 2 * fill - 101000,
+                   rc.GetBufferFullness());
+}
+
+TEST_F(RateControlTest, BufferConstraintRaisesQp) {
+  // Without a target bitrate the qp is only raised to avoid underflow
+  xvc::RateControl rc(0, kBitrate, kBitrate, kFramerate, 64, kQp);
+  EXPECT_EQ(kQp, EncodePictures(&rc, 2, 40000));
+  EXPECT_GT(rc.StartSubGop(8, false, poc_), kQp);
+  EXPECT_GE(rc.GetBufferFullness(), 0);
+}
+
+}   // namespace
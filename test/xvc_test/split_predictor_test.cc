@@ -0,0 +1,153 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include <memory>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/picture_data.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/split_predictor.h"
+
+namespace {
+
+static const int kWidth = 64;
+static const int kHeight = 32;
+static const int kBitdepth = 8;
+
+class SplitPredictorTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    pic_data_.reset(new xvc::PictureData(xvc::ChromaFormat::k420, kWidth,
+                                         kHeight, kBitdepth));
+    orig_pic_.reset(new xvc::YuvPicture(xvc::ChromaFormat::k420, kWidth,
+                                        kHeight, kBitdepth, false, kWidth,
+                                        kHeight));
+    predictor_.reset(new xvc::SplitPredictor(*pic_data_, *orig_pic_));
+  }
+
+  void TearDown() override {
+    for (xvc::CodingUnit *cu : cus_) {
+      pic_data_->ClearMarkCuInPic(cu);
+      pic_data_->ReleaseCu(cu);
+    }
+  }
+
+  void AddCu(int posx, int posy, int width, int height) {
+    xvc::CodingUnit *cu = pic_data_->CreateCu(xvc::CuTree::Primary, 0, posx,
+                                              posy, width, height);
+    pic_data_->MarkUsedInPic(cu);
+    cus_.push_back(cu);
+  }
+
+  static xvc::SplitPredictor::Features
+    GetFeatures(bool intra_pic, bool skip, int log2_area,
+                int num_smaller_neighbors, int cost_per_sample) {
+    xvc::SplitPredictor::Features features;
+    features.intra_pic = intra_pic;
+    features.skip = skip;
+    features.log2_area = log2_area;
+    features.num_smaller_neighbors = num_smaller_neighbors;
+    features.cost_per_sample = cost_per_sample;
+    return features;
+  }
+
+  std::unique_ptr<xvc::PictureData> pic_data_;
+  std::unique_ptr<xvc::YuvPicture> orig_pic_;
+  std::unique_ptr<xvc::SplitPredictor> predictor_;
+  std::vector<xvc::CodingUnit*> cus_;
+};
+
+TEST_F(SplitPredictorTest, CanSkipSplitAtOrBelowThreshold) {
+  // Inter without skip, 32 samples, no smaller neighbors
+  EXPECT_TRUE(predictor_->CanSkipSplit(GetFeatures(false, false, 5, 0, 0)));
+  EXPECT_TRUE(predictor_->CanSkipSplit(GetFeatures(false, false, 5, 0, 11)));
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(false, false, 5, 0, 12)));
+  // Inter with skip, 128 samples, one smaller neighbor
+  EXPECT_TRUE(predictor_->CanSkipSplit(GetFeatures(false, true, 7, 1, 1)));
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(false, true, 7, 1, 2)));
+  // Intra, 4096 samples
+  EXPECT_TRUE(predictor_->CanSkipSplit(GetFeatures(true, false, 12, 0, 28)));
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(true, false, 12, 0, 29)));
+  // Intra picture uses the intra table also for skip
+  EXPECT_TRUE(predictor_->CanSkipSplit(GetFeatures(true, true, 12, 0, 28)));
+}
+
+TEST_F(SplitPredictorTest, CanSkipSplitNeverForDisabledEntries) {
+  // Entries without calibrated threshold always evaluate splits
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(false, false, 5, 1, 0)));
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(false, false, 8, 0, 0)));
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(true, false, 11, 0, 0)));
+  // Two or more smaller neighbors share the last context
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(false, true, 7, 2, 0)));
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(false, true, 7, 3, 0)));
+  // Areas outside of the table
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(false, false, 4, 0, 0)));
+  EXPECT_FALSE(predictor_->CanSkipSplit(GetFeatures(true, false, 13, 0, 0)));
+}
+
+TEST_F(SplitPredictorTest, CuSizeMapStoresCuAreas) {
+  AddCu(0, 0, 32, 32);
+  AddCu(32, 0, 16, 8);
+  AddCu(48, 0, 16, 8);
+  AddCu(32, 8, 8, 4);
+  xvc::CuSizeMap map;
+  EXPECT_TRUE(map.IsEmpty());
+  map.Build(*pic_data_);
+  EXPECT_FALSE(map.IsEmpty());
+  EXPECT_EQ(10, map.GetLog2Area(0, 0));
+  EXPECT_EQ(10, map.GetLog2Area(31, 31));
+  EXPECT_EQ(7, map.GetLog2Area(32, 0));
+  EXPECT_EQ(7, map.GetLog2Area(63, 7));
+  EXPECT_EQ(5, map.GetLog2Area(39, 11));
+  // Areas not covered by any cu
+  EXPECT_EQ(-1, map.GetLog2Area(40, 8));
+  EXPECT_EQ(-1, map.GetLog2Area(32, 31));
+  // Outside of the picture
+  EXPECT_EQ(-1, map.GetLog2Area(-1, 0));
+  EXPECT_EQ(-1, map.GetLog2Area(0, -1));
+  EXPECT_EQ(-1, map.GetLog2Area(kWidth, 0));
+  EXPECT_EQ(-1, map.GetLog2Area(0, kHeight));
+}
+
+TEST_F(SplitPredictorTest, ColocatedSmallerCuIsCountedAsNeighbor) {
+  AddCu(0, 0, 32, 32);
+  AddCu(32, 0, 32, 32);
+  xvc::CuSizeMap colocated;
+  colocated.Build(*pic_data_);
+  for (xvc::CodingUnit *cu : cus_) {
+    pic_data_->ClearMarkCuInPic(cu);
+    pic_data_->ReleaseCu(cu);
+  }
+  cus_.clear();
+  AddCu(0, 0, 64, 32);
+  xvc::Qp qp(32, xvc::ChromaFormat::k420, kBitdepth, 1.0);
+  const xvc::CodingUnit &cu = *cus_[0];
+  EXPECT_EQ(0, predictor_->GetFeatures(cu, qp, 0).num_smaller_neighbors);
+  predictor_->SetColocatedCuSizes(&colocated);
+  EXPECT_EQ(1, predictor_->GetFeatures(cu, qp, 0).num_smaller_neighbors);
+  EXPECT_EQ(11, predictor_->GetFeatures(cu, qp, 0).log2_area);
+  EXPECT_EQ(16, predictor_->GetFeatures(cu, qp, 64 * 32).cost_per_sample);
+}
+
+}   // namespace
@@ -0,0 +1,173 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/inter_prediction.h"
+#include "xvc_common_lib/picture_allocator.h"
+#include "xvc_common_lib/picture_data.h"
+#include "xvc_common_lib/sample_buffer.h"
+#include "xvc_common_lib/yuv_pic.h"
+#include "xvc_enc_lib/encoder_simd_functions.h"
+#include "xvc_enc_lib/subpel_plane_cache.h"
+
+namespace {
+
+static const int kBitdepth = 8;
+static const int kWidth = 128;
+static const int kHeight = 64;
+
+class SubpelPlaneCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::set<xvc::CpuCapability> caps = xvc::SimdCpu::GetRuntimeCapabilities();
+    simd_.reset(new xvc::EncoderSimdFunctions(caps, kBitdepth));
+    ref_pic_.reset(new xvc::YuvPicture(xvc::ChromaFormat::k420, kWidth,
+                                       kHeight, kBitdepth, true, kWidth,
+                                       kHeight));
+    std::srand(1);
+    for (int y = 0; y < kHeight; y++) {
+      xvc::Sample *dst = ref_pic_->GetSamplePtr(xvc::YuvComponent::kY, 0, y);
+      for (int x = 0; x < kWidth; x++) {
+        dst[x] = static_cast<xvc::Sample>(std::rand() & 255);
+      }
+    }
+    ref_pic_->PadBorder();
+    pic_data_.reset(new xvc::PictureData(xvc::ChromaFormat::k420, kWidth,
+                                         kHeight, kBitdepth));
+    inter_pred_.reset(new xvc::InterPrediction(simd_->inter_prediction,
+                                               *ref_pic_, kBitdepth));
+  }
+
+  // Compares all cached phases against motion compensation of a block
+  void CheckBlock(const xvc::SubpelPlaneCache &cache, int posx, int posy,
+                  int size, int mv_x, int mv_y) {
+    const xvc::YuvComponent comp = xvc::YuvComponent::kY;
+    xvc::CodingUnit *cu = pic_data_->CreateCu(xvc::CuTree::Primary, 0, posx,
+                                              posy, size, size);
+    xvc::SampleBufferStorage pred(size, size);
+    for (int frac_y = 0; frac_y < 16; frac_y += 4) {
+      for (int frac_x = 0; frac_x < 16; frac_x += 4) {
+        xvc::MotionVector mv(mv_x * 16 + frac_x, mv_y * 16 + frac_y);
+        inter_pred_->MotionCompensationMv(*cu, comp, *ref_pic_, mv, false,
+                                          &pred);
+        inter_pred_->ClipMv(*cu, *ref_pic_, &mv);
+        xvc::SampleBufferConst cached =
+          cache.GetPrediction(posx, posy, mv);
+        const bool is_cached = cache.GetLevel() > 1 ||
+          ((frac_x & 7) == 0 && (frac_y & 7) == 0);
+        ASSERT_EQ(is_cached, cached.GetDataPtr() != nullptr);
+        if (!is_cached) {
+          continue;
+        }
+        for (int y = 0; y < size; y++) {
+          for (int x = 0; x < size; x++) {
+            ASSERT_EQ(pred.GetDataPtr()[y * pred.GetStride() + x],
+                      cached.GetDataPtr()[y * cached.GetStride() + x]);
+          }
+        }
+      }
+    }
+    pic_data_->ReleaseCu(cu);
+  }
+
+  std::unique_ptr<xvc::EncoderSimdFunctions> simd_;
+  std::unique_ptr<xvc::YuvPicture> ref_pic_;
+  std::unique_ptr<xvc::PictureData> pic_data_;
+  std::unique_ptr<xvc::InterPrediction> inter_pred_;
+};
+
+TEST_F(SubpelPlaneCacheTest, HalfSampleMatchesMotionCompensation) {
+  xvc::SubpelPlaneCache cache(kWidth, kHeight, 1);
+  cache.Build(simd_->inter_prediction, *ref_pic_);
+  CheckBlock(cache, 16, 8, 16, 3, -2);
+  CheckBlock(cache, 64, 32, 32, -7, 5);
+}
+
+TEST_F(SubpelPlaneCacheTest, QuarterSampleMatchesMotionCompensation) {
+  xvc::SubpelPlaneCache cache(kWidth, kHeight, 2);
+  cache.Build(simd_->inter_prediction, *ref_pic_);
+  CheckBlock(cache, 0, 0, 8, 1, 1);
+  CheckBlock(cache, 32, 16, 16, -5, 9);
+  CheckBlock(cache, 64, 0, 64, 2, -3);
+}
+
+TEST_F(SubpelPlaneCacheTest, ClippedMotionOutsidePicture) {
+  xvc::SubpelPlaneCache cache(kWidth, kHeight, 2);
+  cache.Build(simd_->inter_prediction, *ref_pic_);
+  CheckBlock(cache, 0, 0, 16, -200, -200);
+  CheckBlock(cache, 112, 48, 16, 200, 200);
+  CheckBlock(cache, 0, 0, 64, -70, 70);
+}
+
+TEST_F(SubpelPlaneCacheTest, PhasesAllocatedOnFirstUse) {
+  std::atomic<size_t> allocated_bytes(0);
+  xvc::PictureAllocator allocator;
+  allocator.allocated_bytes = &allocated_bytes;
+  {
+    xvc::SubpelPlaneCache cache(kWidth, kHeight, 2, allocator);
+    cache.Build(simd_->inter_prediction, *ref_pic_);
+    EXPECT_EQ(0, allocated_bytes);
+    // Full sample positions are read from the picture itself
+    cache.GetPrediction(0, 0, xvc::MotionVector(16, -32));
+    EXPECT_EQ(0, allocated_bytes);
+    cache.GetPrediction(0, 0, xvc::MotionVector(8, 0));
+    const size_t plane_bytes = allocated_bytes;
+    EXPECT_GT(plane_bytes, kWidth * kHeight * sizeof(xvc::Sample));
+    cache.GetPrediction(16, 16, xvc::MotionVector(24, 16));
+    EXPECT_EQ(plane_bytes, allocated_bytes);
+    cache.GetPrediction(0, 0, xvc::MotionVector(4, 4));
+    EXPECT_EQ(2 * plane_bytes, allocated_bytes);
+    // Memory is kept when the cache is reused for a new picture
+    cache.Build(simd_->inter_prediction, *ref_pic_);
+    CheckBlock(cache, 32, 16, 16, -5, 9);
+    EXPECT_EQ(15 * plane_bytes, allocated_bytes);
+  }
+  EXPECT_EQ(0, allocated_bytes);
+}
+
+TEST_F(SubpelPlaneCacheTest, ConcurrentFirstUse) {
+  xvc::SubpelPlaneCache cache(kWidth, kHeight, 2);
+  cache.Build(simd_->inter_prediction, *ref_pic_);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&cache]() {
+      for (int frac = 1; frac < 16; frac++) {
+        const xvc::MotionVector mv((frac & 3) * 4, (frac >> 2) * 4);
+        cache.GetPrediction(0, 0, mv);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  CheckBlock(cache, 64, 0, 64, 2, -3);
+}
+
+}   // namespace
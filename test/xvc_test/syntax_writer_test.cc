@@ -0,0 +1,192 @@
+/******************************************************************************
+* Copyright (C) 2018, Divideon.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* This library is also available under a commercial license.
+* Please visit https://xvc.io/license/ for more information.
+******************************************************************************/
+
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "googletest/include/gtest/gtest.h"
+
+#include "xvc_common_lib/coding_unit.h"
+#include "xvc_common_lib/picture_data.h"
+#include "xvc_common_lib/quantize.h"
+#include "xvc_enc_lib/bit_writer.h"
+#include "xvc_enc_lib/syntax_writer.h"
+
+namespace {
+
+static const int kNumBlocks = 64;
+
+class SyntaxWriterTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    double lambda = 0;
+    qp_.reset(new xvc::Qp(32, kChromaFormat, kBitdepth, lambda));
+    pic_data_.reset(new xvc::PictureData(kChromaFormat, kSize, kSize,
+                                         kBitdepth));
+    cu_ = pic_data_->CreateCu(xvc::CuTree::Primary, 0, 0, 0, kSize, kSize);
+    cu_->SetPredMode(xvc::PredictionMode::kInter);
+    std::srand(1);
+    blocks_.resize(kNumBlocks);
+    for (auto &block : blocks_) {
+      block.fill(0);
+      for (int i = 0; i < kSize * kSize / 4; i++) {
+        int pos = std::rand() % (kSize * kSize);
+        int level = 1 + (std::rand() % 16 == 0 ? std::rand() % 64 :
+                         std::rand() % 3);
+        block[pos] =
+          static_cast<xvc::Coeff>(std::rand() & 1 ? level : -level);
+      }
+    }
+  }
+
+  void TearDown() override {
+    pic_data_->ReleaseCu(cu_);
+  }
+
+  void WriteBlocks(xvc::SyntaxWriter *writer, int num_blocks) {
+    for (int i = 0; i < num_blocks; i++) {
+      writer->WriteCoefficients(*cu_, xvc::YuvComponent::kY, &blocks_[i][0],
+                                kSize);
+    }
+  }
+
+  static std::vector<uint8_t> GetStates(const xvc::Contexts &contexts) {
+    const uint8_t *begin =
+      reinterpret_cast<const uint8_t*>(&contexts.cu_cbf_luma);
+    const uint8_t *end =
+      reinterpret_cast<const uint8_t*>(&contexts.transform_select_idx + 1);
+    return std::vector<uint8_t>(begin, end);
+  }
+
+  static uint64_t GetEstimatedBits(const xvc::SyntaxWriter &writer) {
+    return (static_cast<uint64_t>(writer.GetNumWrittenBits()) << 15) +
+      writer.GetFractionalBits();
+  }
+
+  static const int kSize = 16;
+  static const int kBitdepth = 8;
+  const xvc::ChromaFormat kChromaFormat = xvc::ChromaFormat::k420;
+  const xvc::PicturePredictionType kPicType = xvc::PicturePredictionType::kBi;
+  std::unique_ptr<xvc::Qp> qp_;
+  std::unique_ptr<xvc::PictureData> pic_data_;
+  xvc::CodingUnit *cu_;
+  std::vector<std::array<xvc::Coeff, kSize * kSize>> blocks_;
+};
+
+TEST_F(SyntaxWriterTest, AdaptiveEstimateMatchesWrittenBits) {
+  xvc::BitWriter bit_writer;
+  xvc::SyntaxWriter writer(*qp_, kPicType, &bit_writer);
+  xvc::RdoSyntaxWriter rdo_writer(writer, 0, 0, false);
+  WriteBlocks(&writer, kNumBlocks);
+  WriteBlocks(&rdo_writer, kNumBlocks);
+  writer.Finish();
+  double written_bits = 8.0 * bit_writer.GetBytes()->size();
+  double estimated_bits = rdo_writer.GetNumWrittenBits();
+  EXPECT_NEAR(written_bits, estimated_bits, 16 + written_bits / 100);
+}
+
+TEST_F(SyntaxWriterTest, FrozenEstimateMatchesWrittenBits) {
+  for (int i = 0; i < kNumBlocks; i++) {
+    xvc::BitWriter bit_writer;
+    xvc::SyntaxWriter writer(*qp_, kPicType, &bit_writer);
+    xvc::RdoSyntaxWriter rdo_writer(writer, 0, 0, true);
+    writer.WriteCoefficients(*cu_, xvc::YuvComponent::kY, &blocks_[i][0],
+                             kSize);
+    rdo_writer.WriteCoefficients(*cu_, xvc::YuvComponent::kY, &blocks_[i][0],
+                                 kSize);
+    writer.Finish();
+    // Without context adaptation within the block the estimate is expected
+    // to be slightly lower than the actual number of bits
+    double written_bits = 8.0 * bit_writer.GetBytes()->size();
+    double estimated_bits = rdo_writer.GetNumWrittenBits();
+    EXPECT_NEAR(written_bits, estimated_bits, 16 + written_bits * 0.15)
+      << "block " << i;
+  }
+}
+
+TEST_F(SyntaxWriterTest, FrozenContextsAreNotUpdated) {
+  xvc::BitWriter bit_writer;
+  xvc::SyntaxWriter writer(*qp_, kPicType, &bit_writer);
+  xvc::RdoSyntaxWriter adaptive_before(writer, 0, 0, false);
+  WriteBlocks(&adaptive_before, kNumBlocks);
+
+  xvc::RdoSyntaxWriter frozen_once(writer, 0, 0, true);
+  WriteBlocks(&frozen_once, 1);
+  xvc::RdoSyntaxWriter frozen_all(writer, 0, 0, true);
+  WriteBlocks(&frozen_all, kNumBlocks);
+  WriteBlocks(&frozen_all, 1);
+  xvc::RdoSyntaxWriter frozen_rest(writer, 0, 0, true);
+  WriteBlocks(&frozen_rest, kNumBlocks);
+  EXPECT_EQ(GetEstimatedBits(frozen_rest) + GetEstimatedBits(frozen_once),
+            GetEstimatedBits(frozen_all));
+
+  xvc::RdoSyntaxWriter adaptive_after(writer, 0, 0, false);
+  WriteBlocks(&adaptive_after, kNumBlocks);
+  EXPECT_EQ(GetEstimatedBits(adaptive_before),
+            GetEstimatedBits(adaptive_after));
+}
+
+TEST_F(SyntaxWriterTest, RollbackAndDeltaMatchContextCopy) {
+  xvc::BitWriter bit_writer;
+  xvc::SyntaxWriter writer(*qp_, kPicType, &bit_writer);
+  xvc::EntropyEncoder::ContextJournal journal;
+  xvc::RdoSyntaxWriter rdo_writer(writer, 0, 0, false);
+  rdo_writer.SetContextJournal(&journal);
+  xvc::RdoSyntaxWriter::ContextDelta delta;
+  for (int iter = 0; iter < 16; iter++) {
+    WriteBlocks(&rdo_writer, std::rand() % 4);
+    const xvc::RdoSyntaxWriter::Checkpoint checkpoint =
+      rdo_writer.GetCheckpoint();
+    const std::vector<uint8_t> states_before =
+      GetStates(rdo_writer.GetContexts());
+    const uint64_t bits_before = GetEstimatedBits(rdo_writer);
+    for (int i = 0; i < 1 + std::rand() % 4; i++) {
+      const int block_idx = std::rand() % kNumBlocks;
+      rdo_writer.WriteCoefficients(*cu_, xvc::YuvComponent::kY,
+                                   &blocks_[block_idx][0], kSize);
+      rdo_writer.WriteMergeFlag((std::rand() & 1) != 0);
+      rdo_writer.WriteRootCbf((std::rand() & 1) != 0);
+    }
+    const std::vector<uint8_t> states_after =
+      GetStates(rdo_writer.GetContexts());
+    const uint64_t bits_after = GetEstimatedBits(rdo_writer);
+    rdo_writer.SaveDeltaTo(checkpoint, &delta);
+    std::set<const xvc::ContextModel*> unique_contexts;
+    for (const auto &entry : delta.contexts) {
+      EXPECT_TRUE(unique_contexts.insert(entry.ctx).second);
+    }
+
+    rdo_writer.Rollback(checkpoint);
+    EXPECT_EQ(states_before, GetStates(rdo_writer.GetContexts()));
+    EXPECT_EQ(bits_before, GetEstimatedBits(rdo_writer));
+    rdo_writer.LoadDeltaFrom(delta);
+    EXPECT_EQ(states_after, GetStates(rdo_writer.GetContexts()));
+    EXPECT_EQ(bits_after, GetEstimatedBits(rdo_writer));
+    rdo_writer.Rollback(checkpoint);
+    EXPECT_EQ(states_before, GetStates(rdo_writer.GetContexts()));
+    rdo_writer.LoadDeltaFrom(delta);
+  }
+}
+
+}   // namespace